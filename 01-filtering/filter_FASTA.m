@@ -9,15 +9,27 @@
 % This function implements filtering based on FASTA file. See `filter_MSA` for
 % details.
 %
+% The FASTA file may be gzip-compressed (`.gz`) or BGZF-compressed (`bgzip`);
+% it is read without a temporary file. `numThread` (optional, default 1) is
+% the number of threads inflating BGZF blocks.
+%
 % HISTORY
 % ===
+% - 2018-05-04  v1.2
+%   - gzip/BGZF input, optional `numThread`
+%
 % - 2017-10-24  v1.1
 %   - add check on filename
 %
 % - 2017-10-17  v1
 %   - adapted from `01filter.cpp`
 
-function [MSA_f, idx_f] = filter_FASTA(filename, letter_N_max, MAF_min)
+function [MSA_f, idx_f] = filter_FASTA(filename, letter_N_max, MAF_min, ...
+  numThread)
+
+if nargin < 4
+  numThread = 1;
+end
 
 checkFilename(filename)
 
@@ -28,8 +40,8 @@ end
 
 fprintf('Reading FASTA file ...\n');
 tic
-% [MSA, len_seq, num_seq, num_dat] = fasta2matrix_mex(filename);
-[MSA, len_seq, num_seq, ~] = fasta2matrix_mex(filename);
+% [MSA, len_seq, num_seq, num_dat] = fasta2matrix_mex(filename, numThread);
+[MSA, len_seq, num_seq, ~] = fasta2matrix_mex(filename, numThread);
 time_readFASTA = toc;
 fprintf('\tFinished in %.2f s.\n', time_readFASTA);
 
@@ -0,0 +1,78 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% Description
+% ===
+% `filter_FASTA`, removal of duplicate sequences (`unique(MSA_f,'rows')`) and
+% MI of all pairs of loci (as `CC_MSA`) in one native pipeline (see
+% `fasta_pipeline.hpp`): sequences are counted chunk by chunk while the file
+% is still being read, the whole-genome MSA is kept packed (two sites per
+% byte) instead of as a uint8 matrix, and MI of a tile of pairs starts as
+% soon as its two blocks of loci are ready.
+%
+% INPUT
+% ===
+% | name         | note                                                    |
+% | ------------ | ------------------------------------------------------- |
+% | filename     | FASTA file (plain, gzip or BGZF)                        |
+% | letter_N_max | as `filter_FASTA`                                       |
+% | MAF_min      | as `filter_FASTA`                                       |
+% | numThread    | number of native threads                                |
+% | useMult      | optional (default false), true to weight sequences in   |
+% |              | MI by mult/max(mult) instead of 1 (cf. `Compress`)      |
+%
+% OUTPUT
+% ===
+% `MSA_u`: distinct filtered sequences (N/major/minor as 123), sorted rows.
+% `idx_f`: indices of loci selected (1-based).
+% `idx_row`: `MSA_f = MSA_u(idx_row,:)`, as the 3rd output of `unique`.
+% `list_MI`, `list_sub`: MI of all pairs and the pairs, in the order of
+% `CC_MSA` (before sorting).
+% `time_MI`: seconds spent in the pipeline.
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1
+
+function [MSA_u, idx_f, idx_row, list_MI, list_sub, time_MI] = ...
+  filter_FASTA_MI(filename, letter_N_max, MAF_min, numThread, useMult)
+
+if nargin < 5
+  useMult = false;
+end
+
+if ~ischar(filename)
+  error('filter_FASTA_MI:filename', ...
+    'filename should be provided as a char vector.\n  e.g. ''path/to/file''')
+end
+
+% search path
+if exist('fasta_pipeline_mex','file') ~= 3
+  addpath(genpath(pwd))
+end
+
+fprintf('Reading, filtering FASTA file and calculating Mutual Information ...\n');
+tic
+[MSA_u, idx_f, idx_row, ~, list_MI, list_sub, numbers, timing] = ...
+  fasta_pipeline_mex(filename, letter_N_max, MAF_min, numThread, ...
+  logical(useMult));
+time_MI = toc;
+fprintf('\tread: %.2f s, filter: %.2f s, MI: %.2f s\n', timing);
+fprintf('\tB: %d -> %d distinct, N: %d\n', numel(idx_row), size(MSA_u,1), ...
+  numel(idx_f));
+fprintf('\tFinished in %.2f s.\n', time_MI);
+
+%
+fprintf('Numbers for 8 types:\n')
+for i = 0:1
+  for j = 0:1
+    for k = 0:1
+      fprintf('%d %d %d\t%d\n',i,j,k,numbers(4*i+2*j+k+1));
+    end
+  end
+end
+
+end
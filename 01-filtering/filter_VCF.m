@@ -0,0 +1,72 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% Description
+% ===
+% This function implements filtering based on a multi-sample VCF file (plain,
+% gzip or BGZF). The criteria are those of `filter_MSA` (see `filter_locus`),
+% but only sites present in the VCF are visited, thus the whole-genome MSA
+% (mostly invariant sites) is never built. See `vcf2matrix_mex.cpp` for how
+% genotypes are mapped to NACGT.
+%
+% Invariant sites are absent from a VCF file; they are dropped by `filter_MSA`
+% as minor-poor whenever `MAF_min > 0`, so the result agrees with that of
+% `filter_FASTA` on the corresponding FASTA file in that case.
+%
+% INPUT
+% ===
+% | name         | note                                                  |
+% | ------------ | ----------------------------------------------------- |
+% | filename     | VCF file                                              |
+% | letter_N_max | as `filter_FASTA`                                     |
+% | MAF_min      | as `filter_FASTA`                                     |
+% | numThread    | optional (default 1), threads inflating BGZF blocks   |
+%
+% OUTPUT
+% ===
+% `MSA_f`: filtered MSA, rows as samples, N/major/minor as 123.
+% `idx_f`: POS of the sites selected (1-based).
+% `chrom_f`: index of the CHROM of each site selected in `chrom_names`.
+%
+% HISTORY
+% ===
+% - 2018-05-05  v1
+
+function [MSA_f, idx_f, chrom_f, chrom_names] = filter_VCF(filename, ...
+  letter_N_max, MAF_min, numThread)
+
+if nargin < 4
+  numThread = 1;
+end
+
+if ~ischar(filename)
+  error('filter_VCF:filename', ...
+    'filename should be provided as a char vector.\n  e.g. ''path/to/file''')
+end
+
+% search path
+if exist('vcf2matrix_mex','file') ~= 3
+  addpath(genpath(pwd))
+end
+
+fprintf('Reading and filtering VCF file ...\n');
+tic
+[MSA_f, idx_f, chrom_f, chrom_names, numbers] = vcf2matrix_mex(filename, ...
+  letter_N_max, MAF_min, numThread);
+time_readVCF = toc;
+fprintf('\tFinished in %.2f s.\n', time_readVCF);
+
+%
+fprintf('Numbers for 8 types (sites in the VCF file):\n')
+for i = 0:1
+  for j = 0:1
+    for k = 0:1
+      fprintf('%d %d %d\t%d\n',i,j,k,numbers(4*i+2*j+k+1));
+    end
+  end
+end
+
+end
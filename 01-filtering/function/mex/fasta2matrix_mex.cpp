@@ -13,9 +13,18 @@
  * This function reads FASTA file for DNA sequences. Supported nucleic acid
  * codes are: N and ATGC. Assume that size_t is equal to uint64_t
  *
+ * The file may be plain text, gzip or BGZF (`bgzip`), detected from its first
+ * bytes; see `fasta_reader.hpp`. `numThread` (optional, default 1) is the
+ * number of threads inflating BGZF blocks.
+ *
  *
  * HISTORY
  * ===
+ * - 2018-05-04  v3
+ *   - gzip and BGZF input, parser moved to `fasta_reader.hpp`
+ *   - optional `numThread`
+ *   - a trailing '\r' of a line is ignored
+ *
  * - 2017-10-17  v2
  *   - NACGT-01234 --> NACGT-12345
  *
@@ -23,12 +32,10 @@
  *  - initial draft
  */
 
-#include <iostream> // test
-#include <fstream>
 #include <string>
 #include <vector>
-// #include <cstdint>
 #include "mex.h"
+#include "fasta_reader.hpp"
 
 using namespace std;
 
@@ -40,99 +47,48 @@ typedef uint8_T Type;                   // type of number representation
 
 
 
-// letter to number: NACGT -> 12345
-template <class T>
-inline T let2num(const char& let) {
-  T num;
-  switch(let) {
-    case 'N' :
-    case 'n' : num = 1; break;
-    case 'A' :
-    case 'a' : num = 2; break;
-    case 'C' :
-    case 'c' : num = 3; break;
-    case 'G' :
-    case 'g' : num = 4; break;
-    case 'T' :
-    case 't' : num = 5; break;
-    default :
-      // error
-      mexErrMsgIdAndTxt("fasta2matrix:let2num",
-        "Unsupported letter: %c\n", let);
-  }
-  return num;
-}
-
-
-
-// string sequence to number sequence
-inline vector<Type> str2vec(const string& seq_str) {
-  vector<Type> seq_num;
-  seq_num.reserve(seq_str.length());
-  for (const auto &c : seq_str) {
-    seq_num.emplace_back(let2num<Type>(c));
-  }
-  return seq_num;
-}
-
-
-
 // given filename of MSA in FASTA, return the corresponding numeric matrix
 inline void fasta2mxArray(
-  const char* filename_in,
+  const char* filename_in, size_t numThread,
   mxArray* &pm_MSA,
   mxArray* &pm_len_seq, mxArray* &pm_num_seq, mxArray* &pm_num_dat)
 {
-  ifstream fin(filename_in);
-  if(!fin) {
-    mexErrMsgIdAndTxt("fasta2matrix:file",
-      "Could not read file '%s'.\n", filename_in);
-  }
-
   /* FASTA -> number sequences */
-  size_t num_seq = 0; // number of sequences processed
-  size_t num_dat = 0; // number of data lines processed
-  typedef vector<Type> seqType;
-  vector<seqType> msa_num;
-  for(string line_str; getline(fin, line_str); ) {
-    // skip empty lines
-    if (line_str.length() == 0) {
-      continue;
-    }
-
-    // a comment line precedes a sequence
-    if (line_str[0] == '>') {
-      num_seq++;
-      msa_num.emplace_back(seqType());
-      continue;
-    }
-
-    if (num_seq == 0) {
+  FastaParser parser;
+  switch (read_fasta(filename_in, parser, numThread)) {
+    case FA_OK :
+      break;
+    case FA_ERR_OPEN :
+      mexErrMsgIdAndTxt("fasta2matrix:file",
+        "Could not read file '%s'.\n", filename_in);
+      break;
+    case FA_ERR_READ :
+      mexErrMsgIdAndTxt("fasta2matrix:file",
+        "File parsing stops before reaching EOF.\n");
+      break;
+    case FA_ERR_GZIP :
+      mexErrMsgIdAndTxt("fasta2matrix:gzip",
+        "'%s' is not a valid gzip/BGZF file.\n", filename_in);
+      break;
+    case FA_ERR_NO_HEADER :
       // first data line without comment header
       mexErrMsgIdAndTxt("fasta2matrix:FASTA",
         "FASTA file is illegal---no comment precedes the first data line.\n");
-    }
-    else {
-      // merge consecutive data lines to one sequence
-      num_dat++;
-      auto &seq_num = msa_num[num_seq-1];
-      const auto &line_num = str2vec(line_str);
-      seq_num.reserve(seq_num.size() + line_num.size());
-      seq_num.insert(seq_num.end(), line_num.begin(), line_num.end());
-    }
-  }
-  // check EOF
-  if (!fin.eof()) {
-    mexErrMsgIdAndTxt("fasta2matrix:file",
-      "File parsing stops before reaching EOF.\n");
+      break;
+    case FA_ERR_LETTER :
+      mexErrMsgIdAndTxt("fasta2matrix:let2num",
+        "Unsupported letter: %c\n", parser.bad_letter);
+      break;
   }
+  const vector<FastaParser::seqType> &msa_num = parser.msa;
+  const size_t num_seq = msa_num.size();  // number of sequences processed
+  const size_t num_dat = parser.num_dat;  // number of data lines processed
 
   /* check */
   if (num_seq == 0) {
     mexErrMsgIdAndTxt("fasta2matrix:FASTA:NoSequence",
       "'%s' contains no sequence.\n", filename_in);
   }
-
   const size_t len_seq = msa_num[0].size(); // msa_num.size() >= 1
 
   if (len_seq == 0) {
@@ -182,14 +138,14 @@ inline void fasta2mxArray(
 }
 
 
-/* [MSA, len_seq, num_seq, num_dat] = fasta2matrix_mex(filename) */
+/* [MSA, len_seq, num_seq, num_dat] = fasta2matrix_mex(filename[, numThread]) */
 void mexFunction(
   int nlhs, mxArray *plhs[],
   int nrhs, const mxArray *prhs[])
 {
   // validation
-  if (nrhs != 1) {
-    mexErrMsgTxt("This function accepts 1 argument.");
+  if (nrhs != 1 && nrhs != 2) {
+    mexErrMsgTxt("This function accepts 1 or 2 arguments.");
   }
   if (nlhs > 4) {
     mexErrMsgTxt("This function produces at most 4 outputs.");
@@ -198,6 +154,14 @@ void mexFunction(
   if (!mxIsChar(pfilename)) {
     mexErrMsgTxt("`filename` should be provided as a string.");
   }
+  size_t numThread = 1;
+  if (nrhs == 2) {
+    if (!mxIsDouble(prhs[1]) || mxGetNumberOfElements(prhs[1]) != 1) {
+      mexErrMsgTxt("`numThread` should be a double scalar.");
+    }
+    const double d = mxGetScalar(prhs[1]);
+    numThread = d < 1 ? 1 : size_t(d);
+  }
 
   char* pc = mxArrayToString(pfilename);
   if (pc == NULL) {
@@ -205,7 +169,7 @@ void mexFunction(
   }
 
   // real work
-  fasta2mxArray(pc, plhs[0], plhs[1], plhs[2], plhs[3]);
+  fasta2mxArray(pc, numThread, plhs[0], plhs[1], plhs[2], plhs[3]);
 
   mxFree(pc);
 }
\ No newline at end of file
@@ -0,0 +1,501 @@
+#ifndef FASTA_PIPELINE_HPP
+#define FASTA_PIPELINE_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * FASTA file -> filtered MSA without duplicate sequences -> MI of all pairs of
+ * loci, as `filter_FASTA`, `unique(MSA_f,'rows')` and `CC_MSA` do one after
+ * another, but without materializing the whole-genome MSA as uint8 and with the
+ * stages overlapped where their data allow it:
+ *
+ *  1. `stream`: bytes are decompressed (see `text_stream.hpp`) and parsed on
+ *     the calling thread; every sequence is encoded (NACGT as 12345), packed
+ *     two sites per byte into chunks of about 64 MB, and a full chunk is
+ *     handed over a bounded queue to a counting thread, which adds it to the
+ *     per-site counts of NACGT on the pool while the next chunk is parsed.
+ *  2. `filter_dedup`: every site is labelled from its counts as
+ *     `filter_locus.m` does; the sites kept are split into blocks of columns,
+ *     and every block is extracted from the chunks (N/major/minor as 123)
+ *     together with a hash of every row of the block, in parallel. Duplicate
+ *     sequences are then found by the hash of whole rows (and verified), and
+ *     the distinct rows sorted as `unique(...,'rows')`. This needs all columns,
+ *     as the filter needs all rows: these are the two barriers of the
+ *     pipeline.
+ *  3. `compact_MI`: every block is compacted to the distinct rows and its
+ *     1-point frequencies calculated; as soon as both blocks of a tile of
+ *     pairs are compacted, MI of the tile is calculated (`calc_MI_pair`), so
+ *     that tiles overlap with the compaction of other blocks: tiles go to the
+ *     front of the `TaskQueue`, ahead of the blocks still to be compacted.
+ *
+ * Pairs (i,j), i < j, are in the order of `CC_MSA`: (1,2), (1,3), ..., (1,N_f),
+ * (2,3), ...
+ *
+ * No MATLAB API is called; outputs of `compact_MI` are allocated by the
+ * caller. Link with zlib (`-lz`) and compile with `-pthread`.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v1
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "filter_site.hpp"
+#include "text_stream.hpp"
+#include "../../../Correlation-Compression/function/mex/calc_MI_pairs.hpp"
+
+
+enum FastaPipelineStatus {
+  FP_OK = 0,
+  FP_ERR_OPEN,        // file can not be opened
+  FP_ERR_READ,        // reading stops before EOF
+  FP_ERR_GZIP,        // corrupted gzip/BGZF data
+  FP_ERR_NO_HEADER,   // data line before the first comment line
+  FP_ERR_LETTER,      // unsupported letter, see `bad_letter`
+  FP_ERR_LENGTH,      // length differs from the first, see `bad_seq`
+  FP_ERR_EMPTY        // no sequence, or the first one is void
+};
+
+
+class FastaPipeline {
+public:
+  // results of `stream`
+  size_t B;                       // number of sequences
+  size_t N;                       // length of sequences
+  char bad_letter;
+  size_t bad_seq;                 // 1-based
+
+  // results of `filter_dedup`
+  std::vector<size_t> idx_f;      // sites kept, 0-based
+  double numbers[8];              // number of sites of each label
+  size_t B_u;                     // number of distinct rows
+  std::vector<size_t> idx_row;    // row of every sequence, 0-based
+  std::vector<double> mult;       // multiplicity of every distinct row
+
+  FastaPipeline(double letter_N_max, double MAF_min, size_t numThread,
+    size_t blockSize)
+    : B(0), N(0), bad_letter(0), bad_seq(0), B_u(0),
+      N_max_(letter_N_max), MAF_min_(MAF_min),
+      blockSize_(blockSize > 0 ? blockSize : 1), pool_(numThread),
+      status_(FP_OK), hasSeq_(false), stride_(0), chunkRows_(0)
+  {
+    std::fill(numbers, numbers + 8, 0.0);
+    std::memset(code_, 0, sizeof(code_));
+    const char *let = "NACGT";
+    for (int k = 0; k < 5; k++) {
+      code_[uint8_t(let[k])]      = uint8_t(k+1);
+      code_[uint8_t(let[k] + 32)] = uint8_t(k+1);   // lower case
+    }
+  }
+
+  FastaPipeline(const FastaPipeline&) = delete;
+  FastaPipeline& operator=(const FastaPipeline&) = delete;
+
+  size_t N_f() const { return idx_f.size(); }
+
+
+  /* stage 1: parse, encode, pack and count */
+  FastaPipelineStatus stream(const char *filename) {
+    isQueueDone_ = false;
+    std::thread counter(&FastaPipeline::count_loop, this);
+
+    LineSplitter<FastaPipeline> splitter(*this);
+    const TextStreamStatus ts = text_stream(filename, splitter, pool_.size());
+    if (ts == TS_OK) {
+      splitter.finish();
+      if (status_ == FP_OK) {
+        end_sequence();
+      }
+      if (status_ == FP_OK && !cur_chunk_empty()) {
+        push_chunk();
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      isQueueDone_ = true;
+    }
+    cv_.notify_all();
+    counter.join();
+
+    switch (ts) {
+      case TS_OK       : break;
+      case TS_ERR_OPEN : return FP_ERR_OPEN;
+      case TS_ERR_READ : return FP_ERR_READ;
+      case TS_ERR_GZIP : return FP_ERR_GZIP;
+    }
+    if (status_ == FP_OK && (B == 0 || N == 0)) {
+      status_ = FP_ERR_EMPTY;
+    }
+    return status_;
+  }
+
+
+  /* stage 2: filter, extract blocks of columns, find distinct rows */
+  void filter_dedup() {
+    // labels
+    std::vector<uint8_t> rep;       // new codes of the sites kept, 8 per site
+    for (size_t s = 0; s < N; s++) {
+      double counter[6] = {0, 0, 0, 0, 0, 0};
+      for (int k = 0; k < 5; k++) {
+        counter[k+1] = double(counts_[5*s + k]);
+      }
+      uint8_t newRep[6];
+      const int label = filter_site_label(counter, N_max_, MAF_min_, newRep);
+      numbers[label]++;
+      if (label == 0) {
+        idx_f.push_back(s);
+        rep.insert(rep.end(), newRep, newRep + 6);
+        rep.insert(rep.end(), 2, 0);
+      }
+    }
+    std::vector<uint32_t>().swap(counts_);
+
+    // blocks of columns and hashes of their rows
+    const size_t numBlock = (N_f() + blockSize_ - 1) / blockSize_;
+    block_.assign(numBlock, std::vector<uint8_t>());
+    std::vector<std::vector<uint64_t> > hash(numBlock);
+    pool_.parallel_for(numBlock, 1, [&](size_t begin, size_t end, size_t) {
+      for (size_t k = begin; k < end; k++) {
+        extract_block(k, rep, &hash[k]);
+      }
+    });
+    chunks_.clear();                // the packed MSA is not needed any more
+
+    // hash of whole rows
+    std::vector<uint64_t> rowHash(B, 14695981039346656037ULL);
+    pool_.parallel_for(B, 4096, [&](size_t begin, size_t end, size_t) {
+      for (size_t k = 0; k < numBlock; k++) {
+        for (size_t b = begin; b < end; b++) {
+          rowHash[b] = (rowHash[b] ^ hash[k][b]) * 1099511628211ULL;
+        }
+      }
+    });
+
+    // distinct rows: group by hash, verify, then sort as `unique(...,'rows')`
+    std::vector<size_t> order(B);
+    for (size_t b = 0; b < B; b++) {
+      order[b] = b;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t x, size_t y) {
+      return rowHash[x] < rowHash[y] || (rowHash[x] == rowHash[y] && x < y);
+    });
+    std::vector<size_t> first(B);   // first row equal to row b
+    std::vector<size_t> distinct;
+    for (size_t g = 0; g < B; ) {
+      size_t e = g + 1;
+      while (e < B && rowHash[order[e]] == rowHash[order[g]]) {
+        e++;
+      }
+      const size_t d0 = distinct.size();
+      for (size_t k = g; k < e; k++) {
+        const size_t b = order[k];
+        size_t d = d0;
+        while (d < distinct.size() && compare_rows(distinct[d], b) != 0) {
+          d++;
+        }
+        if (d == distinct.size()) {
+          distinct.push_back(b);
+        }
+        first[b] = distinct[d];
+      }
+      g = e;
+    }
+    std::sort(distinct.begin(), distinct.end(), [&](size_t x, size_t y) {
+      return compare_rows(x, y) < 0;
+    });
+
+    B_u = distinct.size();
+    rows_.swap(distinct);
+    std::vector<size_t> rank(B);
+    for (size_t u = 0; u < B_u; u++) {
+      rank[rows_[u]] = u;
+    }
+    idx_row.resize(B);
+    mult.assign(B_u, 0.0);
+    for (size_t b = 0; b < B; b++) {
+      idx_row[b] = rank[first[b]];
+      mult[idx_row[b]]++;
+    }
+  }
+
+
+  /**
+   * stage 3: compact blocks into MSA_u (B_u-by-N_f, column-major) and MI of
+   * all N_f*(N_f-1)/2 pairs into MI and sub (2-by-.., 1-based loci); distinct
+   * rows are weighted by `w` (B_u elements)
+   */
+  void compact_MI(uint8_t *MSA_u, const double *w, double *MI, uint32_t *sub) {
+    const size_t numBlock = block_.size();
+    const size_t q = 3;
+    double B_eff = 0.0;
+    for (size_t u = 0; u < B_u; u++) {
+      B_eff += w[u];
+    }
+    std::vector<double> f1(q*N_f(), 0.0);
+    std::vector<char> isReady(numBlock, 0);
+    std::vector<std::vector<double> > work(pool_.size(),
+      std::vector<double>(q*q));
+
+    TaskQueue tasks;
+    std::mutex readyMtx;
+
+    auto tile = [&, MSA_u, w, MI, sub, B_eff](size_t I, size_t J, size_t tid) {
+      double *fij = work[tid].data();
+      const size_t Nf = N_f();
+      for (size_t i = I*blockSize_; i < std::min((I+1)*blockSize_, Nf); i++) {
+        const size_t j0 = std::max(J*blockSize_, i+1);
+        const size_t j1 = std::min((J+1)*blockSize_, Nf);
+        for (size_t j = j0; j < j1; j++) {
+          const size_t l = i*(2*Nf - i - 1)/2 + (j - i - 1);
+          double var_L;
+          calc_MI_pair(MSA_u + B_u*i, MSA_u + B_u*j, q, B_u, w, B_eff,
+            f1.data() + q*i, f1.data() + q*j, fij, MI + l, &var_L);
+          sub[2*l]   = uint32_t(i+1);
+          sub[2*l+1] = uint32_t(j+1);
+        }
+      }
+    };
+
+    for (size_t k = 0; k < numBlock; k++) {
+      tasks.push([&, k, MSA_u, w, B_eff](size_t) {
+        const size_t c0 = k*blockSize_;
+        const size_t n = std::min(blockSize_, N_f() - c0);
+        const uint8_t *blk = block_[k].data();
+        for (size_t c = 0; c < n; c++) {
+          uint8_t *dst = MSA_u + B_u*(c0 + c);
+          const uint8_t *src = blk + B*c;
+          double *fi = f1.data() + q*(c0 + c);
+          for (size_t u = 0; u < B_u; u++) {
+            dst[u] = src[rows_[u]];
+            fi[dst[u]-1] += w[u];
+          }
+          for (size_t a = 0; a < q; a++) {
+            fi[a] /= B_eff;
+          }
+        }
+        std::vector<uint8_t>().swap(block_[k]);
+
+        // tiles whose two blocks are ready
+        std::lock_guard<std::mutex> lock(readyMtx);
+        isReady[k] = 1;
+        for (size_t I = 0; I < numBlock; I++) {
+          if (isReady[I]) {
+            const size_t a = std::min(I, k), b = std::max(I, k);
+            tasks.push_front([&, a, b](size_t tid) { tile(a, b, tid); });
+          }
+        }
+      });
+    }
+    tasks.run(pool_);
+    block_.clear();
+  }
+
+
+  /* line parser, see `LineSplitter` */
+  bool operator()(const char *b, const char *e) {
+    if (e == b) {
+      return true;
+    }
+    if (*b == '>') {
+      end_sequence();
+      hasSeq_ = true;
+      return status_ == FP_OK;
+    }
+    if (!hasSeq_) {
+      status_ = FP_ERR_NO_HEADER;
+      return false;
+    }
+    const size_t n0 = seq_.size();
+    seq_.resize(n0 + (e - b));
+    uint8_t *out = seq_.data() + n0;
+    for (const char *c = b; c < e; c++) {
+      const uint8_t num = code_[uint8_t(*c)];
+      if (num == 0) {
+        status_ = FP_ERR_LETTER;
+        bad_letter = *c;
+        return false;
+      }
+      *out++ = num;
+    }
+    return true;
+  }
+
+private:
+  struct Chunk {
+    size_t numRow;
+    std::vector<uint8_t> packed;  // numRow rows of `stride_` bytes
+  };
+
+  const double N_max_, MAF_min_;
+  const size_t blockSize_;
+  ThreadPool pool_;
+  FastaPipelineStatus status_;
+  uint8_t code_[256];
+
+  // parsing
+  bool hasSeq_;
+  std::vector<uint8_t> seq_;      // the current sequence, encoded
+  size_t stride_;                 // bytes of a packed row
+  size_t chunkRows_;              // rows of a full chunk
+  std::unique_ptr<Chunk> cur_;
+
+  // packed MSA and counts of NACGT per site
+  std::vector<std::unique_ptr<Chunk> > chunks_;
+  std::vector<uint32_t> counts_;  // 5*N
+
+  // hand-over to the counting thread
+  std::deque<const Chunk *> queue_;
+  bool isQueueDone_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+
+  // extracted blocks (B-by-n, column-major) and distinct rows
+  std::vector<std::vector<uint8_t> > block_;
+  std::vector<size_t> rows_;
+
+  bool cur_chunk_empty() const { return !cur_ || cur_->numRow == 0; }
+
+  // pack the current sequence into the current chunk
+  void end_sequence() {
+    if (!hasSeq_) {
+      return;
+    }
+    if (B == 0) {
+      N = seq_.size();
+      if (N == 0) {
+        status_ = FP_ERR_EMPTY;
+        return;
+      }
+      stride_ = (N + 1) / 2;
+      chunkRows_ = std::max(size_t(1), (size_t(64) << 20) / stride_);
+      counts_.assign(5*N, 0);
+    }
+    if (seq_.size() != N) {
+      status_ = FP_ERR_LENGTH;
+      bad_seq = B + 1;
+      return;
+    }
+    if (!cur_) {
+      cur_.reset(new Chunk);
+      cur_->numRow = 0;
+      cur_->packed.resize(chunkRows_*stride_);
+    }
+    uint8_t *row = cur_->packed.data() + cur_->numRow*stride_;
+    for (size_t s = 0; s + 1 < N; s += 2) {
+      row[s/2] = uint8_t(seq_[s] | (seq_[s+1] << 4));
+    }
+    if (N % 2) {
+      row[N/2] = seq_[N-1];
+    }
+    cur_->numRow++;
+    B++;
+    seq_.clear();
+    if (cur_->numRow == chunkRows_) {
+      push_chunk();
+    }
+  }
+
+  // hand the current chunk to the counting thread; waits if 4 are pending
+  void push_chunk() {
+    cur_->packed.resize(cur_->numRow*stride_);
+    const Chunk *chunk = cur_.get();
+    chunks_.push_back(std::move(cur_));
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [&]{ return queue_.size() < 4; });
+    queue_.push_back(chunk);
+    cv_.notify_all();
+  }
+
+  void count_loop() {
+    for (;;) {
+      const Chunk *chunk;
+      {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [&]{ return !queue_.empty() || isQueueDone_; });
+        if (queue_.empty()) {
+          return;
+        }
+        chunk = queue_.front();
+      }
+      // ranges of sites, even-aligned so that no byte is shared
+      pool_.parallel_for((N + 1) / 2, 2048,
+        [&](size_t begin, size_t end, size_t) {
+          for (size_t r = 0; r < chunk->numRow; r++) {
+            const uint8_t *row = chunk->packed.data() + r*stride_;
+            for (size_t k = begin; k < end; k++) {
+              counts_[10*k + (row[k] & 15) - 1]++;
+              if (2*k + 1 < N) {
+                counts_[10*k + 5 + (row[k] >> 4) - 1]++;
+              }
+            }
+          }
+        });
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        queue_.pop_front();
+      }
+      cv_.notify_all();
+    }
+  }
+
+  // block k of the sites kept, re-encoded, and FNV-1a hash of its rows
+  void extract_block(size_t k, const std::vector<uint8_t> &rep,
+    std::vector<uint64_t> *hash)
+  {
+    const size_t c0 = k*blockSize_;
+    const size_t n = std::min(blockSize_, N_f() - c0);
+    std::vector<uint8_t> &blk = block_[k];
+    blk.resize(B*n);
+    size_t b = 0;
+    for (const auto &chunk : chunks_) {
+      for (size_t r = 0; r < chunk->numRow; r++, b++) {
+        const uint8_t *row = chunk->packed.data() + r*stride_;
+        for (size_t c = 0; c < n; c++) {
+          const size_t s = idx_f[c0 + c];
+          const uint8_t let = (s % 2) ? (row[s/2] >> 4) : (row[s/2] & 15);
+          blk[B*c + b] = rep[8*(c0 + c) + let];
+        }
+      }
+    }
+    hash->assign(B, 14695981039346656037ULL);
+    for (size_t c = 0; c < n; c++) {
+      const uint8_t *col = blk.data() + B*c;
+      for (size_t b = 0; b < B; b++) {
+        (*hash)[b] = ((*hash)[b] ^ col[b]) * 1099511628211ULL;
+      }
+    }
+  }
+
+  // lexicographic order of rows x and y of the filtered MSA
+  int compare_rows(size_t x, size_t y) const {
+    for (size_t k = 0; k < block_.size(); k++) {
+      const uint8_t *blk = block_[k].data();
+      const size_t n = block_[k].size() / B;
+      for (size_t c = 0; c < n; c++) {
+        const uint8_t a = blk[B*c + x], b = blk[B*c + y];
+        if (a != b) {
+          return a < b ? -1 : 1;
+        }
+      }
+    }
+    return 0;
+  }
+};
+
+#endif // FASTA_PIPELINE_HPP
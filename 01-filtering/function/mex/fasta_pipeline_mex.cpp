@@ -0,0 +1,197 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * DESCRIPTION
+ * ===
+ * MEX wrapper of `fasta_pipeline.hpp`
+ *
+ * This function reads a FASTA file (plain, gzip or BGZF), filters it as
+ * `filter_FASTA`, removes duplicate sequences as `unique(MSA_f,'rows')` and
+ * calculates MI of all pairs of loci as `CC_MSA`, in one pipeline. Assume that
+ * size_t is equal to uint64_t
+ *
+ * [MSA_u, idx_f, idx_row, mult, list_MI, list_sub, numbers, timing] = ...
+ *   fasta_pipeline_mex(filename, letter_N_max, MAF_min, numThread, ...
+ *   useMult[, blockSize])
+ *
+ *  MSA_u        uint8, B_u-by-N_f, distinct filtered sequences (N/major/minor
+ *               as 123), sorted as `unique(MSA_f,'rows')`
+ *  idx_f        double, N_f-by-1, loci kept (1-based)
+ *  idx_row      double, B-by-1, MSA_f = MSA_u(idx_row,:)
+ *  mult         double, B_u-by-1, multiplicity of every row of MSA_u
+ *  list_MI      double, 1-by-N_f*(N_f-1)/2, MI (bits) of every pair
+ *  list_sub     uint32, 2-by-N_f*(N_f-1)/2, the pairs, in the order of `CC_MSA`
+ *  numbers      double, 8-by-1, number of loci of each label of
+ *               `filter_locus` (label+1)
+ *  timing       double, 1-by-3, seconds spent in reading and counting, in
+ *               filtering and removing duplicates, and in MI
+ *
+ * Rows of MSA_u are weighted by 1 in MI, or by mult/max(mult) with
+ * `useMult = true` (cf. `Compress` of `paper_CC_PLM_DCA`). `numThread` native
+ * threads count, extract and calculate MI; they also inflate BGZF blocks.
+ * `blockSize` (default 512) is the number of loci of a block of columns; MI
+ * is calculated in tiles of blockSize-by-blockSize pairs.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v1
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "mex.h"
+#include "fasta_pipeline.hpp"
+
+using namespace std;
+
+
+static double seconds_since(chrono::steady_clock::time_point t0)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  // validation
+  if (nrhs != 5 && nrhs != 6) {
+    mexErrMsgTxt("This function accepts 5 or 6 arguments.");
+  }
+  if (nlhs > 8) {
+    mexErrMsgTxt("This function produces at most 8 outputs.");
+  }
+  if (!mxIsChar(prhs[0])) {
+    mexErrMsgTxt("`filename` should be provided as a string.");
+  }
+  for (int k = 1; k < nrhs; k++) {
+    if (k == 4) {
+      continue;
+    }
+    if (!mxIsDouble(prhs[k]) || mxGetNumberOfElements(prhs[k]) != 1) {
+      mexErrMsgTxt("{letter_N_max, MAF_min, numThread, blockSize} should be "
+        "double scalars.");
+    }
+  }
+  if (!mxIsLogicalScalar(prhs[4])) {
+    mexErrMsgTxt("`useMult` should be a logical scalar.");
+  }
+  const double letter_N_max = mxGetScalar(prhs[1]);
+  const double MAF_min      = mxGetScalar(prhs[2]);
+  const size_t numThread = mxGetScalar(prhs[3]) >= 1
+    ? size_t(mxGetScalar(prhs[3])) : 1;
+  const bool useMult = mxIsLogicalScalarTrue(prhs[4]);
+  const size_t blockSize = nrhs == 6 && mxGetScalar(prhs[5]) >= 1
+    ? size_t(mxGetScalar(prhs[5])) : 512;
+
+  char* pc = mxArrayToString(prhs[0]);
+  if (pc == NULL) {
+    mexErrMsgTxt("`mxArrayToString` failed.");
+  }
+  const string filename(pc);
+  mxFree(pc);
+
+  // stage 1
+  FastaPipeline pl(letter_N_max, MAF_min, numThread, blockSize);
+  chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+  switch (pl.stream(filename.c_str())) {
+    case FP_OK :
+      break;
+    case FP_ERR_OPEN :
+      mexErrMsgIdAndTxt("fasta_pipeline:file",
+        "Could not read file '%s'.\n", filename.c_str());
+      break;
+    case FP_ERR_READ :
+      mexErrMsgIdAndTxt("fasta_pipeline:file",
+        "File parsing stops before reaching EOF.\n");
+      break;
+    case FP_ERR_GZIP :
+      mexErrMsgIdAndTxt("fasta_pipeline:gzip",
+        "'%s' is not a valid gzip/BGZF file.\n", filename.c_str());
+      break;
+    case FP_ERR_NO_HEADER :
+      mexErrMsgIdAndTxt("fasta_pipeline:FASTA",
+        "FASTA file is illegal---no comment precedes the first data line.\n");
+      break;
+    case FP_ERR_LETTER :
+      mexErrMsgIdAndTxt("fasta_pipeline:let2num",
+        "Unsupported letter: %c\n", pl.bad_letter);
+      break;
+    case FP_ERR_LENGTH :
+      mexErrMsgIdAndTxt("fasta_pipeline:MSA",
+        "The length of sequence %ld doesn't match that of sequence 1.",
+        (long) pl.bad_seq);
+      break;
+    case FP_ERR_EMPTY :
+      mexErrMsgIdAndTxt("fasta_pipeline:FASTA:NoSequence",
+        "'%s' contains no sequence, or the first one is void.\n",
+        filename.c_str());
+      break;
+  }
+  double timing[3];
+  timing[0] = seconds_since(t0);
+
+  // stage 2
+  t0 = chrono::steady_clock::now();
+  pl.filter_dedup();
+  timing[1] = seconds_since(t0);
+
+  // outputs, allocated here since MATLAB API is not thread-safe
+  const size_t N_f = pl.N_f();
+  const size_t B_u = pl.B_u;
+  const size_t numPair = N_f*(N_f - (N_f > 0 ? 1 : 0))/2;
+  plhs[0] = mxCreateNumericMatrix(B_u, N_f, mxUINT8_CLASS, mxREAL);
+  mxArray *pm_MI  = mxCreateDoubleMatrix(1, numPair, mxREAL);
+  mxArray *pm_sub = mxCreateNumericMatrix(2, numPair, mxUINT32_CLASS, mxREAL);
+
+  vector<double> w(B_u, 1.0);
+  if (useMult) {
+    const double m = *max_element(pl.mult.begin(), pl.mult.end());
+    for (size_t u = 0; u < B_u; u++) {
+      w[u] = pl.mult[u] / m;
+    }
+  }
+
+  // stage 3
+  t0 = chrono::steady_clock::now();
+  pl.compact_MI((uint8_t *) mxGetData(plhs[0]), w.data(), mxGetPr(pm_MI),
+    (uint32_t *) mxGetData(pm_sub));
+  timing[2] = seconds_since(t0);
+
+  // the other outputs
+  mxArray *outs[8];
+  outs[0] = plhs[0];
+  outs[1] = mxCreateDoubleMatrix(N_f, 1, mxREAL);
+  for (size_t c = 0; c < N_f; c++) {
+    mxGetPr(outs[1])[c] = double(pl.idx_f[c] + 1);
+  }
+  outs[2] = mxCreateDoubleMatrix(pl.B, 1, mxREAL);
+  for (size_t b = 0; b < pl.B; b++) {
+    mxGetPr(outs[2])[b] = double(pl.idx_row[b] + 1);
+  }
+  outs[3] = mxCreateDoubleMatrix(B_u, 1, mxREAL);
+  copy(pl.mult.begin(), pl.mult.end(), mxGetPr(outs[3]));
+  outs[4] = pm_MI;
+  outs[5] = pm_sub;
+  outs[6] = mxCreateDoubleMatrix(8, 1, mxREAL);
+  copy(pl.numbers, pl.numbers + 8, mxGetPr(outs[6]));
+  outs[7] = mxCreateDoubleMatrix(1, 3, mxREAL);
+  copy(timing, timing + 3, mxGetPr(outs[7]));
+
+  for (int k = 1; k < 8; k++) {
+    if (k < nlhs) {
+      plhs[k] = outs[k];
+    }
+    else {
+      mxDestroyArray(outs[k]);
+    }
+  }
+}
@@ -0,0 +1,124 @@
+#ifndef FASTA_READER_HPP
+#define FASTA_READER_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Reader of FASTA files of DNA sequences (see `README.md` for the supported
+ * subset of FASTA), from plain text, gzip or BGZF files (see
+ * `text_stream.hpp`).
+ *
+ * Residues NACGT (either case) are encoded as 12345; a trailing '\r' of a line
+ * is ignored.
+ *
+ * No MATLAB API is called; errors are reported by `FastaStatus` (see
+ * `fasta2matrix_mex.cpp`). Link with zlib (`-lz`) and compile with `-pthread`.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-05  v1.1
+ *
+ * - streaming of compressed input moved to `text_stream.hpp`
+ *
+ * ## 2018-05-04  v1
+ *
+ * - parser moved from `fasta2matrix_mex.cpp`; gzip and BGZF input
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "text_stream.hpp"
+
+
+enum FastaStatus {
+  FA_OK = 0,
+  FA_ERR_OPEN,        // file can not be opened
+  FA_ERR_READ,        // reading stops before EOF
+  FA_ERR_GZIP,        // corrupted gzip/BGZF data
+  FA_ERR_NO_HEADER,   // data line before the first comment line
+  FA_ERR_LETTER       // unsupported letter
+};
+
+
+/* Line parser, see `LineSplitter` */
+class FastaParser {
+public:
+  typedef std::vector<uint8_t> seqType;
+
+  std::vector<seqType> msa;   // sequences, encoded
+  size_t num_dat;             // number of data lines
+  FastaStatus status;
+  char bad_letter;            // with FA_ERR_LETTER
+
+  FastaParser() : num_dat(0), status(FA_OK), bad_letter(0) {
+    std::memset(code_, 0, sizeof(code_));
+    const char *let = "NACGT";
+    for (int k = 0; k < 5; k++) {
+      code_[uint8_t(let[k])]      = uint8_t(k+1);
+      code_[uint8_t(let[k] + 32)] = uint8_t(k+1);   // lower case
+    }
+  }
+
+  // line [b, e); false on error
+  bool operator()(const char *b, const char *e) {
+    // skip empty lines
+    if (e == b) {
+      return true;
+    }
+    // a comment line precedes a sequence
+    if (*b == '>') {
+      msa.emplace_back();
+      return true;
+    }
+    if (msa.empty()) {
+      status = FA_ERR_NO_HEADER;
+      return false;
+    }
+    // merge consecutive data lines to one sequence
+    num_dat++;
+    seqType &seq = msa.back();
+    const size_t n0 = seq.size();
+    seq.resize(n0 + (e - b));
+    uint8_t *out = seq.data() + n0;
+    for (const char *c = b; c < e; c++) {
+      const uint8_t num = code_[uint8_t(*c)];
+      if (num == 0) {
+        status = FA_ERR_LETTER;
+        bad_letter = *c;
+        return false;
+      }
+      *out++ = num;
+    }
+    return true;
+  }
+
+private:
+  uint8_t code_[256];
+};
+
+
+/* parse `filename` (plain, gzip or BGZF) */
+inline FastaStatus read_fasta(const char *filename, FastaParser &parser,
+  size_t numThread)
+{
+  LineSplitter<FastaParser> splitter(parser);
+  switch (text_stream(filename, splitter, numThread)) {
+    case TS_OK       : break;
+    case TS_ERR_OPEN : return FA_ERR_OPEN;
+    case TS_ERR_READ : return FA_ERR_READ;
+    case TS_ERR_GZIP : return FA_ERR_GZIP;
+  }
+  splitter.finish();
+  return parser.status;
+}
+
+#endif // FASTA_READER_HPP
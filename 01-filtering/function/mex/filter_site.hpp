@@ -0,0 +1,64 @@
+#ifndef FILTER_SITE_HPP
+#define FILTER_SITE_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Label of one site from its counts of NACGT, exactly as `filter_locus.m`:
+ * gap-rich, minor-poor and multi-allelic bits, ties of counts broken in the
+ * order ACGT (stable as MATLAB's `sort`). A site with label 0 is kept and
+ * re-encoded as N/major/minor (123) by `newRep`.
+ *
+ *  counter  6 elements, counter[k] is the count of letter k (NACGT as 12345);
+ *           counter[0] is not used
+ *  newRep   6 elements (output), new code of letter k; set for label 0 only
+ *
+ * No MATLAB API is called.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v1
+ *
+ * - moved from `vcf_reader.hpp`, shared with `fasta_pipeline.hpp`
+ */
+
+#include <algorithm>
+#include <cstdint>
+
+
+inline int filter_site_label(const double counter[6],
+  double letter_N_max, double MAF_min, uint8_t newRep[6])
+{
+  // ACGT in descending order of counts, stable as MATLAB's `sort`
+  int sidx[4] = {2, 3, 4, 5};
+  std::stable_sort(sidx, sidx + 4,
+    [&](int x, int y) { return counter[x] > counter[y]; });
+  const double c1 = counter[sidx[0]];
+  const double c2 = counter[sidx[1]];
+
+  const bool gapRich = counter[1] > letter_N_max;
+  const bool multiAllelic = counter[sidx[2]] > 0;
+  // c1 + c2 == 0 gives NaN in MATLAB, which is not minor-poor
+  const bool minorPoor = c1 + c2 > 0 && c2 / (c1 + c2) < MAF_min;
+  const int label = gapRich*4 + minorPoor*2 + multiAllelic;
+  if (label != 0) {
+    return label;
+  }
+
+  newRep[0] = 0;
+  newRep[1] = 1;
+  for (int k = 0; k < 4; k++) {
+    newRep[sidx[k]] = uint8_t(k+2);
+  }
+  return 0;
+}
+
+#endif // FILTER_SITE_HPP
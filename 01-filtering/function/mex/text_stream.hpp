@@ -0,0 +1,347 @@
+#ifndef TEXT_STREAM_HPP
+#define TEXT_STREAM_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Streaming of the bytes of a plain text, gzip or BGZF file to a sink, in
+ * chunks of any size:
+ *
+ *  - plain text is read in large chunks;
+ *  - gzip is decompressed by a dedicated thread (zlib `gzread`) into a small
+ *    queue of chunks, so that decompression overlaps with the work of the sink
+ *    on the calling thread;
+ *  - BGZF (blocked gzip, as written by `bgzip`) consists of independent
+ *    deflate blocks of at most 64 KiB; batches of blocks are inflated in
+ *    parallel by a thread pool and passed to the sink in order.
+ *
+ * The format is detected from the first bytes of the file, not from its name.
+ * The sink is called on the calling thread only, as `bool sink(p, n)`, and
+ * returns false to stop reading.
+ *
+ * No MATLAB API is called. Link with zlib (`-lz`) and compile with `-pthread`.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v1.1
+ *
+ * - a BGZF block claiming more than 64 KiB of data is rejected
+ * - a truncated gzip file is an error, not EOF
+ *
+ * ## 2018-05-05  v1
+ *
+ * - moved from `fasta_reader.hpp`, shared with `vcf_reader.hpp`
+ */
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include "../../../common/mex/thread_pool.hpp"
+
+
+enum TextStreamStatus {
+  TS_OK = 0,          // EOF reached, or stopped by the sink
+  TS_ERR_OPEN,        // file can not be opened
+  TS_ERR_READ,        // reading stops before EOF
+  TS_ERR_GZIP         // corrupted gzip/BGZF data
+};
+
+
+/* plain text */
+template <class Sink>
+inline TextStreamStatus text_stream_plain(FILE *fp, Sink &sink)
+{
+  std::vector<char> buf(1 << 22);
+  size_t n;
+  while ((n = fread(buf.data(), 1, buf.size(), fp)) > 0) {
+    if (!sink(buf.data(), n)) {
+      return TS_OK;
+    }
+  }
+  return feof(fp) ? TS_OK : TS_ERR_READ;
+}
+
+
+/* gzip: decompression on a dedicated thread, the sink on the calling one */
+template <class Sink>
+inline TextStreamStatus text_stream_gzip(const char *filename, Sink &sink)
+{
+  gzFile gz = gzopen(filename, "rb");
+  if (gz == NULL) {
+    return TS_ERR_OPEN;
+  }
+  gzbuffer(gz, 1 << 20);
+
+  const size_t chunkSize = 1 << 22;
+  const size_t maxQueued = 4;
+  std::deque<std::vector<char> > queue;
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool isDone = false;
+  bool isFailed = false;
+  bool isStopped = false;   // the sink gave up
+
+  std::thread producer([&]() {
+    for (;;) {
+      std::vector<char> chunk(chunkSize);
+      const int n = gzread(gz, chunk.data(), unsigned(chunkSize));
+      // a truncated file ends as EOF, with Z_BUF_ERROR ("unexpected end of
+      // file") left in the state
+      int err = Z_OK;
+      if (n == 0) {
+        gzerror(gz, &err);
+      }
+      std::unique_lock<std::mutex> lock(mtx);
+      if (n < 0 || err != Z_OK) {
+        isFailed = true;
+      }
+      if (n <= 0 || isStopped) {
+        isDone = true;
+        cv.notify_all();
+        return;
+      }
+      chunk.resize(size_t(n));
+      cv.wait(lock, [&]{ return queue.size() < maxQueued || isStopped; });
+      queue.push_back(std::move(chunk));
+      cv.notify_all();
+    }
+  });
+
+  for (;;) {
+    std::vector<char> chunk;
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cv.wait(lock, [&]{ return !queue.empty() || isDone; });
+      if (queue.empty()) {
+        break;
+      }
+      chunk = std::move(queue.front());
+      queue.pop_front();
+      cv.notify_all();
+    }
+    if (!sink(chunk.data(), chunk.size())) {
+      std::lock_guard<std::mutex> lock(mtx);
+      isStopped = true;
+      cv.notify_all();
+      break;
+    }
+  }
+  producer.join();
+  gzclose(gz);
+
+  return isFailed && !isStopped ? TS_ERR_GZIP : TS_OK;
+}
+
+
+// whether the 18 bytes `h` begin a BGZF block; if so, `bsize` is its size
+inline bool text_stream_is_bgzf(const uint8_t *h, size_t *bsize)
+{
+  if (h[0] != 0x1f || h[1] != 0x8b || h[2] != 8 || !(h[3] & 4)) {
+    return false;
+  }
+  const size_t xlen = h[10] | (h[11] << 8);
+  if (xlen != 6 || h[12] != 'B' || h[13] != 'C' || h[14] != 2 || h[15] != 0) {
+    return false;
+  }
+  *bsize = size_t(h[16] | (h[17] << 8)) + 1;
+  return true;
+}
+
+
+// inflate one BGZF block (`size` bytes at `block`) into `out`; false if it is
+// invalid, e.g. claims more than the 64 KiB allowed by the format
+inline bool text_stream_inflate_bgzf(const uint8_t *block, size_t size,
+  std::vector<char> &out)
+{
+  if (size < 26) {
+    return false;
+  }
+  const uint8_t *tail = block + size - 8;
+  const uint32_t crc   = tail[0] | (tail[1] << 8) | (tail[2] << 16)
+                       | (uint32_t(tail[3]) << 24);
+  const uint32_t isize = tail[4] | (tail[5] << 8) | (tail[6] << 16)
+                       | (uint32_t(tail[7]) << 24);
+  if (isize > 65536) {
+    return false;
+  }
+  out.resize(isize);
+  if (isize == 0) {
+    return true;
+  }
+
+  z_stream zs;
+  std::memset(&zs, 0, sizeof(zs));
+  if (inflateInit2(&zs, -15) != Z_OK) {   // raw deflate
+    return false;
+  }
+  zs.next_in   = (Bytef *) (block + 18);
+  zs.avail_in  = uInt(size - 26);
+  zs.next_out  = (Bytef *) out.data();
+  zs.avail_out = uInt(isize);
+  const int ret = inflate(&zs, Z_FINISH);
+  inflateEnd(&zs);
+  if (ret != Z_STREAM_END || zs.total_out != isize) {
+    return false;
+  }
+  return crc32(0L, (const Bytef *) out.data(), isize) == crc;
+}
+
+
+/* BGZF: batches of blocks inflated in parallel, passed to the sink in order */
+template <class Sink>
+inline TextStreamStatus text_stream_bgzf(FILE *fp, Sink &sink,
+  size_t numThread)
+{
+  ThreadPool pool(numThread);
+  const size_t batchBlocks = 16*pool.size();
+
+  std::vector<std::vector<uint8_t> > comp(batchBlocks);
+  std::vector<std::vector<char> > plain(batchBlocks);
+  std::vector<char> isBad(batchBlocks);
+
+  bool isEOF = false;
+  while (!isEOF) {
+    /* read a batch of compressed blocks */
+    size_t numBlock = 0;
+    while (numBlock < batchBlocks) {
+      uint8_t h[18];
+      const size_t n = fread(h, 1, 18, fp);
+      if (n == 0 && feof(fp)) {
+        isEOF = true;
+        break;
+      }
+      size_t bsize = 0;
+      if (n != 18 || !text_stream_is_bgzf(h, &bsize) || bsize < 26) {
+        return TS_ERR_GZIP;
+      }
+      std::vector<uint8_t> &block = comp[numBlock];
+      block.resize(bsize);
+      std::memcpy(block.data(), h, 18);
+      if (fread(block.data() + 18, 1, bsize - 18, fp) != bsize - 18) {
+        return TS_ERR_GZIP;
+      }
+      numBlock++;
+    }
+
+    /* inflate in parallel */
+    pool.parallel_for(numBlock, 1, [&](size_t begin, size_t end, size_t) {
+      for (size_t k = begin; k < end; k++) {
+        isBad[k] = !text_stream_inflate_bgzf(comp[k].data(), comp[k].size(),
+          plain[k]);
+      }
+    });
+
+    /* sink in order */
+    for (size_t k = 0; k < numBlock; k++) {
+      if (isBad[k]) {
+        return TS_ERR_GZIP;
+      }
+      if (!sink(plain[k].data(), plain[k].size())) {
+        return TS_OK;
+      }
+    }
+  }
+  return TS_OK;
+}
+
+
+/* detect the format of `filename` and stream its bytes to `sink` */
+template <class Sink>
+inline TextStreamStatus text_stream(const char *filename, Sink &sink,
+  size_t numThread)
+{
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    return TS_ERR_OPEN;
+  }
+  uint8_t h[18];
+  const size_t n = fread(h, 1, 18, fp);
+  size_t bsize = 0;
+
+  TextStreamStatus st;
+  if (n == 18 && text_stream_is_bgzf(h, &bsize)) {
+    rewind(fp);
+    st = text_stream_bgzf(fp, sink, numThread);
+    fclose(fp);
+  }
+  else if (n >= 2 && h[0] == 0x1f && h[1] == 0x8b) {
+    fclose(fp);
+    st = text_stream_gzip(filename, sink);
+  }
+  else {
+    rewind(fp);
+    st = text_stream_plain(fp, sink);
+    fclose(fp);
+  }
+  return st;
+}
+
+
+/**
+ * Splitting of chunks into lines (without '\n' and a trailing '\r'), passed
+ * to `bool line(b, e)` as [b, e); a line spanning chunks is reassembled. Use
+ * as the sink of `text_stream`, then call `finish()` for the last line.
+ */
+template <class LineFn>
+class LineSplitter {
+public:
+  explicit LineSplitter(LineFn &fn) : fn_(fn), isStopped_(false) {}
+
+  bool operator()(const char *p, size_t n) {
+    const char *end = p + n;
+    while (p < end && !isStopped_) {
+      const char *eol = (const char *) std::memchr(p, '\n', end - p);
+      if (eol == NULL) {
+        partial_.insert(partial_.end(), p, end);
+        return true;
+      }
+      if (partial_.empty()) {
+        emit(p, eol);
+      }
+      else {
+        partial_.insert(partial_.end(), p, eol);
+        emit(partial_.data(), partial_.data() + partial_.size());
+        partial_.clear();
+      }
+      p = eol + 1;
+    }
+    return !isStopped_;
+  }
+
+  // the last line may lack '\n'
+  bool finish() {
+    if (!isStopped_ && !partial_.empty()) {
+      emit(partial_.data(), partial_.data() + partial_.size());
+      partial_.clear();
+    }
+    return !isStopped_;
+  }
+
+private:
+  LineFn &fn_;
+  bool isStopped_;
+  std::vector<char> partial_;
+
+  void emit(const char *b, const char *e) {
+    if (e > b && e[-1] == '\r') {
+      e--;
+    }
+    isStopped_ = !fn_(b, e);
+  }
+};
+
+#endif // TEXT_STREAM_HPP
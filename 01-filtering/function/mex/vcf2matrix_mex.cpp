@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * DESCRIPTION
+ * ===
+ * MEX wrapper of `vcf_reader.hpp`
+ *
+ * This function reads a multi-sample VCF file (plain, gzip or BGZF) and returns
+ * the MSA filtered as `filter_MSA` with `letter_N_max` and `MAF_min`, i.e.
+ * bi-allelic sites encoded as N/major/minor (123), rows as samples. Only the
+ * sites present in the VCF are visited. Assume that size_t is equal to
+ * uint64_t
+ *
+ * [MSA_f, idx_f, chrom_f, chrom_names, numbers] = vcf2matrix_mex(filename, ...
+ *   letter_N_max, MAF_min[, numThread])
+ *
+ *  MSA_f        uint8, B-by-N_f
+ *  idx_f        double, N_f-by-1, POS of the sites kept (1-based)
+ *  chrom_f      uint32, N_f-by-1, index of CHROM in `chrom_names` (1-based)
+ *  chrom_names  cell, CHROM in the order of appearance
+ *  numbers      double, 8-by-1, number of sites of each label of
+ *               `filter_locus` (label+1)
+ *
+ * `numThread` (optional, default 1) is the number of threads inflating BGZF
+ * blocks.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-05  v1
+ */
+
+#include <string>
+#include <vector>
+#include "mex.h"
+#include "vcf_reader.hpp"
+
+using namespace std;
+
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  // validation
+  if (nrhs != 3 && nrhs != 4) {
+    mexErrMsgTxt("This function accepts 3 or 4 arguments.");
+  }
+  if (nlhs > 5) {
+    mexErrMsgTxt("This function produces at most 5 outputs.");
+  }
+  if (!mxIsChar(prhs[0])) {
+    mexErrMsgTxt("`filename` should be provided as a string.");
+  }
+  for (int k = 1; k < nrhs; k++) {
+    if (!mxIsDouble(prhs[k]) || mxGetNumberOfElements(prhs[k]) != 1) {
+      mexErrMsgTxt("{letter_N_max, MAF_min, numThread} should be double "
+        "scalars.");
+    }
+  }
+  const double letter_N_max = mxGetScalar(prhs[1]);
+  const double MAF_min      = mxGetScalar(prhs[2]);
+  size_t numThread = 1;
+  if (nrhs == 4 && mxGetScalar(prhs[3]) >= 1) {
+    numThread = size_t(mxGetScalar(prhs[3]));
+  }
+
+  char* pc = mxArrayToString(prhs[0]);
+  if (pc == NULL) {
+    mexErrMsgTxt("`mxArrayToString` failed.");
+  }
+  const string filename(pc);
+  mxFree(pc);
+
+  // real work
+  VcfFilter filter(letter_N_max, MAF_min);
+  switch (read_vcf(filename.c_str(), filter, numThread)) {
+    case VCF_OK :
+      break;
+    case VCF_ERR_OPEN :
+      mexErrMsgIdAndTxt("vcf2matrix:file",
+        "Could not read file '%s'.\n", filename.c_str());
+      break;
+    case VCF_ERR_READ :
+      mexErrMsgIdAndTxt("vcf2matrix:file",
+        "File parsing stops before reaching EOF.\n");
+      break;
+    case VCF_ERR_GZIP :
+      mexErrMsgIdAndTxt("vcf2matrix:gzip",
+        "'%s' is not a valid gzip/BGZF file.\n", filename.c_str());
+      break;
+    case VCF_ERR_NO_HEADER :
+      mexErrMsgIdAndTxt("vcf2matrix:VCF",
+        "VCF file is illegal---no `#CHROM` line with samples precedes the "
+        "first record.\n");
+      break;
+    case VCF_ERR_RECORD :
+      mexErrMsgIdAndTxt("vcf2matrix:VCF",
+        "Malformed record at line %lu.\n", (unsigned long) filter.line_no);
+      break;
+  }
+
+  // output
+  const size_t B = filter.B;
+  const size_t N_f = filter.pos_f.size();
+
+  plhs[0] = mxCreateNumericMatrix(B, N_f, mxUINT8_CLASS, mxREAL);
+  if (N_f > 0) {
+    memcpy(mxGetData(plhs[0]), filter.msa_f.data(), B*N_f);
+  }
+
+  if (nlhs > 1) {
+    plhs[1] = mxCreateDoubleMatrix(N_f, 1, mxREAL);
+    double* idx_f = mxGetPr(plhs[1]);
+    for (size_t l = 0; l < N_f; l++) {
+      idx_f[l] = double(filter.pos_f[l]);
+    }
+  }
+
+  if (nlhs > 2) {
+    plhs[2] = mxCreateNumericMatrix(N_f, 1, mxUINT32_CLASS, mxREAL);
+    uint32_t* chrom_f = (uint32_t*) mxGetData(plhs[2]);
+    for (size_t l = 0; l < N_f; l++) {
+      chrom_f[l] = filter.chrom_f[l] + 1;
+    }
+  }
+
+  if (nlhs > 3) {
+    const size_t numChrom = filter.chrom_names.size();
+    plhs[3] = mxCreateCellMatrix(numChrom, 1);
+    for (size_t k = 0; k < numChrom; k++) {
+      mxSetCell(plhs[3], k, mxCreateString(filter.chrom_names[k].c_str()));
+    }
+  }
+
+  if (nlhs > 4) {
+    plhs[4] = mxCreateDoubleMatrix(8, 1, mxREAL);
+    memcpy(mxGetPr(plhs[4]), filter.numbers, 8*sizeof(double));
+  }
+}
@@ -0,0 +1,365 @@
+#ifndef VCF_READER_HPP
+#define VCF_READER_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Streaming filter of a multi-sample VCF file (plain, gzip or BGZF, see
+ * `text_stream.hpp`) to the filtered MSA of `filter_MSA`, without building the
+ * whole-genome MSA.
+ *
+ * Every site (consecutive records at the same CHROM and POS) becomes a column
+ * of letters NACGT (12345), one per sample, from the GT field:
+ *
+ *  - allele 0 is REF, allele k is the k-th ALT; an allele which is not a single
+ *    nucleotide (indel, `*`, symbolic) counts as N;
+ *  - a missing call (`.`) or a heterozygous call (e.g. `0/1`) counts as N; a
+ *    homozygous call (e.g. `1/1`) counts as its allele, so haploid and
+ *    diploid VCF are accepted;
+ *  - a record without GT (first FORMAT key) counts as N for all samples;
+ *  - when a site is split over several records, a sample takes the letter of
+ *    the first record in which it carries a non-REF allele, otherwise that of
+ *    the first record; REF is the single nucleotide of the first record which
+ *    has one (e.g. the SNV of the site), so that a preceding indel record does
+ *    not turn the REF carriers into N.
+ *
+ * The column is labelled exactly as `filter_locus.m` does (gap-rich, minor-poor,
+ * multi-allelic bits; ties of counts broken in the order ACGT); a column with
+ * label 0 is kept, re-encoded as N/major/minor (123). Sites absent from the VCF
+ * (invariant) are not visited, thus not counted in `numbers`.
+ *
+ * No MATLAB API is called; errors are reported by `VcfStatus` (see
+ * `vcf2matrix_mex.cpp`).
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v1.1
+ *
+ * - labelling of a site moved to `filter_site.hpp`
+ * - REF of a site from its first record with a single-nucleotide REF
+ * - every allele of a record with a multi-base REF counts as N
+ *
+ * ## 2018-05-05  v1
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "filter_site.hpp"
+#include "text_stream.hpp"
+
+
+enum VcfStatus {
+  VCF_OK = 0,
+  VCF_ERR_OPEN,       // file can not be opened
+  VCF_ERR_READ,       // reading stops before EOF
+  VCF_ERR_GZIP,       // corrupted gzip/BGZF data
+  VCF_ERR_NO_HEADER,  // record before the `#CHROM` line, or no sample
+  VCF_ERR_RECORD      // malformed record, see `line_no`
+};
+
+
+/* Line parser, see `LineSplitter` */
+class VcfFilter {
+public:
+  size_t B;                             // number of samples
+  std::vector<uint8_t> msa_f;           // B*N_f, site after site, [1,3]
+  std::vector<uint64_t> pos_f;          // POS of the sites kept
+  std::vector<uint32_t> chrom_f;        // CHROM of the sites kept, 0-based
+  std::vector<std::string> chrom_names;
+  double numbers[8];                    // number of sites of each label
+  size_t line_no;                       // current line, 1-based
+  VcfStatus status;
+
+  VcfFilter(double letter_N_max, double MAF_min)
+    : B(0), line_no(0), status(VCF_OK),
+      N_max_(letter_N_max), MAF_min_(MAF_min), hasSite_(false)
+  {
+    std::fill(numbers, numbers + 8, 0.0);
+    std::memset(code_, 1, sizeof(code_));   // N
+    const char *let = "NACGT";
+    for (int k = 0; k < 5; k++) {
+      code_[uint8_t(let[k])]      = uint8_t(k+1);
+      code_[uint8_t(let[k] + 32)] = uint8_t(k+1);   // lower case
+    }
+  }
+
+  // line [b, e); false on error
+  bool operator()(const char *b, const char *e) {
+    line_no++;
+    if (e == b) {
+      return true;
+    }
+    if (*b == '#') {
+      if (e - b >= 6 && std::strncmp(b, "#CHROM", 6) == 0) {
+        // fixed columns CHROM ... FORMAT, then samples
+        const size_t numCol = size_t(std::count(b, e, '\t')) + 1;
+        B = numCol > 9 ? numCol - 9 : 0;
+        if (B == 0) {
+          status = VCF_ERR_NO_HEADER;
+          return false;
+        }
+        site_.resize(B);
+        call_.resize(B);
+        rec_.resize(B);
+        recCall_.resize(B);
+      }
+      return true;
+    }
+    if (B == 0) {
+      status = VCF_ERR_NO_HEADER;
+      return false;
+    }
+    if (!parse_record(b, e)) {
+      status = VCF_ERR_RECORD;
+      return false;
+    }
+    return true;
+  }
+
+  // process the last site
+  void finish() {
+    if (status == VCF_OK && hasSite_) {
+      flush();
+      hasSite_ = false;
+    }
+  }
+
+private:
+  uint8_t code_[256];
+  double N_max_;
+  double MAF_min_;
+
+  // call of a sample in a record
+  enum { CALL_NONE = 0, CALL_REF, CALL_ALT };  // missing or heterozygous
+
+  // current site
+  bool hasSite_;
+  uint32_t siteChrom_;
+  uint64_t sitePos_;
+  uint8_t siteRef_;                     // letter of REF, N if not yet known
+  std::vector<uint8_t> site_;
+  std::vector<char> call_;
+
+  // current record
+  std::vector<uint8_t> rec_;
+  std::vector<char> recCall_;
+  std::vector<uint8_t> allele_;         // letters of REF, ALT...
+
+  uint32_t chrom_index(const char *b, const char *e) {
+    const size_t n = e - b;
+    if (!chrom_names.empty()) {
+      const std::string &last = chrom_names.back();
+      if (last.size() == n && std::memcmp(last.data(), b, n) == 0) {
+        return uint32_t(chrom_names.size() - 1);
+      }
+    }
+    for (size_t k = 0; k < chrom_names.size(); k++) {
+      if (chrom_names[k].size() == n
+        && std::memcmp(chrom_names[k].data(), b, n) == 0)
+      {
+        return uint32_t(k);
+      }
+    }
+    chrom_names.emplace_back(b, n);
+    return uint32_t(chrom_names.size() - 1);
+  }
+
+  // letter of an allele string [b, e)
+  uint8_t allele_code(const char *b, const char *e) const {
+    return e - b == 1 ? code_[uint8_t(*b)] : uint8_t(1);
+  }
+
+  // GT [b, e) (up to ':' or the end of the field) -> letter, call
+  bool parse_GT(const char *b, const char *e, uint8_t *let, char *call) const {
+    long a0 = -2;   // -2: none yet, -1: missing or heterozygous
+    const char *p = b;
+    while (p < e && *p != ':') {
+      long a;
+      if (*p == '.') {
+        a = -1;
+        p++;
+      }
+      else if (*p >= '0' && *p <= '9') {
+        a = 0;
+        while (p < e && *p >= '0' && *p <= '9') {
+          a = 10*a + (*p - '0');
+          p++;
+        }
+        if (size_t(a) >= allele_.size()) {
+          return false;
+        }
+      }
+      else {
+        return false;
+      }
+      a0 = (a0 == -2 || a0 == a) ? a : -1;
+      if (p < e && (*p == '/' || *p == '|')) {
+        p++;
+      }
+      else if (p < e && *p != ':') {
+        return false;
+      }
+    }
+    if (a0 < 0) {
+      *let = 1;
+      *call = CALL_NONE;
+    }
+    else {
+      *let = allele_[a0];
+      *call = a0 > 0 ? CALL_ALT : CALL_REF;
+    }
+    return true;
+  }
+
+  bool parse_record(const char *b, const char *e) {
+    // fixed columns
+    const char *col[9];
+    const char *p = b;
+    for (int k = 0; k < 9; k++) {
+      col[k] = p;
+      p = (const char *) std::memchr(p, '\t', e - p);
+      if (p == NULL) {
+        return false;
+      }
+      p++;
+    }
+    const uint32_t chrom = chrom_index(col[0], col[1] - 1);
+    char *endPos;
+    const uint64_t pos = std::strtoull(col[1], &endPos, 10);
+    if (endPos != col[2] - 1 || pos == 0) {
+      return false;
+    }
+
+    // alleles; with a multi-base REF (indel) every allele is N, also an ALT
+    // of one letter such as `A` of `AT`
+    const bool isSNV = col[4] - col[3] == 2;
+    allele_.clear();
+    allele_.push_back(allele_code(col[3], col[4] - 1));
+    if (!(col[5] - col[4] == 2 && col[4][0] == '.')) {
+      const char *a = col[4];
+      const char *aEnd = col[5] - 1;
+      while (a <= aEnd) {
+        const char *c = std::find(a, aEnd, ',');
+        allele_.push_back(isSNV ? allele_code(a, c) : uint8_t(1));
+        a = c + 1;
+      }
+    }
+    const char *fmtEnd = p - 1;
+    const bool hasGT = fmtEnd - col[8] >= 2 && col[8][0] == 'G'
+      && col[8][1] == 'T' && (fmtEnd - col[8] == 2 || col[8][2] == ':');
+
+    // samples
+    for (size_t s = 0; s < B; s++) {
+      if (p > e) {
+        return false;
+      }
+      const char *f = p;
+      const char *fEnd = (const char *) std::memchr(f, '\t', e - f);
+      if (fEnd == NULL) {
+        fEnd = e;
+      }
+      if ((fEnd == e) != (s == B-1)) {
+        return false;   // wrong number of columns
+      }
+      if (hasGT) {
+        if (!parse_GT(f, fEnd, &rec_[s], &recCall_[s])) {
+          return false;
+        }
+      }
+      else {
+        rec_[s] = 1;
+        recCall_[s] = CALL_NONE;
+      }
+      p = fEnd + 1;
+    }
+
+    // merge into the current site or start a new one
+    if (hasSite_ && chrom == siteChrom_ && pos == sitePos_) {
+      // REF carriers of earlier records (e.g. an indel) get the first
+      // single-nucleotide REF
+      if (siteRef_ == 1 && allele_[0] != 1) {
+        siteRef_ = allele_[0];
+        for (size_t s = 0; s < B; s++) {
+          if (call_[s] == CALL_REF) {
+            site_[s] = siteRef_;
+          }
+        }
+      }
+      for (size_t s = 0; s < B; s++) {
+        if (call_[s] != CALL_ALT && recCall_[s] == CALL_ALT) {
+          site_[s] = rec_[s];
+          call_[s] = CALL_ALT;
+        }
+      }
+    }
+    else {
+      if (hasSite_) {
+        flush();
+      }
+      hasSite_ = true;
+      siteChrom_ = chrom;
+      sitePos_ = pos;
+      siteRef_ = allele_[0];
+      site_.swap(rec_);
+      call_.swap(recCall_);
+    }
+    return true;
+  }
+
+  // label the current site as `filter_locus`, keep it if label is 0
+  void flush() {
+    double counter[6] = {0, 0, 0, 0, 0, 0};
+    for (size_t s = 0; s < B; s++) {
+      counter[site_[s]]++;
+    }
+
+    uint8_t newRep[6];
+    const int label = filter_site_label(counter, N_max_, MAF_min_, newRep);
+    numbers[label]++;
+    if (label != 0) {
+      return;
+    }
+
+    const size_t n0 = msa_f.size();
+    msa_f.resize(n0 + B);
+    for (size_t s = 0; s < B; s++) {
+      msa_f[n0 + s] = newRep[site_[s]];
+    }
+    pos_f.push_back(sitePos_);
+    chrom_f.push_back(siteChrom_);
+  }
+};
+
+
+/* filter `filename` (plain, gzip or BGZF) */
+inline VcfStatus read_vcf(const char *filename, VcfFilter &filter,
+  size_t numThread)
+{
+  LineSplitter<VcfFilter> splitter(filter);
+  switch (text_stream(filename, splitter, numThread)) {
+    case TS_OK       : break;
+    case TS_ERR_OPEN : return VCF_ERR_OPEN;
+    case TS_ERR_READ : return VCF_ERR_READ;
+    case TS_ERR_GZIP : return VCF_ERR_GZIP;
+  }
+  splitter.finish();
+  if (filter.status == VCF_OK && filter.B == 0) {
+    filter.status = VCF_ERR_NO_HEADER;
+  }
+  filter.finish();
+  return filter.status;
+}
+
+#endif // VCF_READER_HPP
@@ -7,5 +7,16 @@ if exist('function/compiled', 'dir') ~= 7
 end
 
 fprintf('Compiling `fasta2matrix_mex.cpp` ...\n')
-mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+  LDFLAGS='$LDFLAGS -pthread' -lz ...
   -outdir function/compiled function/mex/fasta2matrix_mex.cpp
+
+fprintf('Compiling `vcf2matrix_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+  LDFLAGS='$LDFLAGS -pthread' -lz ...
+  -outdir function/compiled function/mex/vcf2matrix_mex.cpp
+
+fprintf('Compiling `fasta_pipeline_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+  LDFLAGS='$LDFLAGS -pthread' -lz ...
+  -outdir function/compiled function/mex/fasta_pipeline_mex.cpp
@@ -27,6 +27,29 @@
 % | numWorker  |         | number of workers in parfor              |
 % | outputPath |         | path for output file storing MI table    |
 % | NoLoad     | logical | true to re-calculate                     |
+% | Compress   | logical | (optional) true to compress patterns     |
+% | Sampled    | struct  | (optional) prefilter pairs by subsample  |
+%
+% With `Compress = true`, identical sequences are collapsed into weighted rows
+% and loci are grouped into site classes (see `compress_MSA`). 1-point
+% frequencies and MI are calculated once per class (pair), and then expanded to
+% all pairs of loci. The MI table is the same as without compression up to
+% round-off. Default: false.
+%
+% With `Sampled` (a struct with fields `numSub`, `alpha`, `seed` and
+% `numThread`), MI is calculated exactly only for pairs which may enter the top
+% `num_MI` (see `calc_MI_top`): pairs are pruned by exact bounds (entropies,
+% and minor frequencies of two-state loci) and by MI estimated on a subsample
+% of `numSub` sequences. `alpha = 0` guarantees the exact top `num_MI`, but
+% still bounds every pair and prunes only by the exact bounds: on loci of more
+% than two states it saves mostly memory. `alpha > 0` prunes harder and misses
+% a pair of the top with probability about `alpha`. Only the top `num_MI`
+% pairs are saved, in `<MSA_id>--MI-top.mat`. Default: [] (all pairs).
+% `Compress` is ignored.
+%
+% With numWorker > 1 (on Linux and macOS), MI of all pairs is calculated on a
+% copy of `MSA` in shared memory: `parfor` sends its handle to the workers and
+% columns are read in place (see `shm_msa_mex`).
 %
 % OUTPUT
 % ===
@@ -35,10 +58,29 @@
 %
 % HISTORY
 % ===
+% - 2018-05-10  v3.2
+%   - exact bound from minor frequencies in `Sampled`, note on its cost
+%
+% - 2018-05-08  v3.1
+%   - workers read `MSA` from shared memory
+%
+% - 2018-04-30  v3
+%   - add optional `Sampled`
+%
+% - 2018-04-02  v2
+%   - add optional `Compress`
+%
 % - 2017-10-24  v1
 
 function [MSA_cc,idx_cc] = CC_MSA(MSA, MSA_id, len_seq, num_seq, q, weights, ...
-  num_MI, numWorker, outputPath, NoLoad)
+  num_MI, numWorker, outputPath, NoLoad, Compress, Sampled)
+
+if nargin < 11
+  Compress = false;
+end
+if nargin < 12
+  Sampled = [];
+end
 
 %% check with little overhead
 % MSA
@@ -73,6 +115,17 @@ if ~islogical(NoLoad)
   error('`NoLoad` should be provided as logical.')
 end
 
+% Compress
+if ~islogical(Compress)
+  error('`Compress` should be provided as logical.')
+end
+
+% Sampled
+if ~isempty(Sampled) && (~isstruct(Sampled) ...
+    || ~all(isfield(Sampled, {'numSub', 'alpha', 'seed', 'numThread'})))
+  error('`Sampled` should be a struct with fields numSub, alpha, seed, numThread.')
+end
+
 
 %% check with acceptable overhead
 % range of MSA
@@ -91,67 +144,98 @@ end
 [B,N] = size(MSA);
 B_eff = sum(weights);
 
-filename_MI = sprintf('%s--MI.mat', MSA_id);
+if isempty(Sampled)
+  filename_MI = sprintf('%s--MI.mat', MSA_id);
+else
+  filename_MI = sprintf('%s--MI-top.mat', MSA_id);
+end
 filename_MI_full = fullfile(outputPath, filename_MI);
 
 if NoLoad || exist(filename_MI_full, 'file') ~= 2
-  %% calculate f_i(k)
-  tic
-
-  f1 = zeros(q,N);
-  if numWorker > 1
-    parfor (i = 1:N, numWorker)
-      f1(:,i) = calc_f1_w(MSA(:,i), B, q, weights, B_eff);
-    end
+  if ~isempty(Sampled)
+    fprintf('Calculating Mutual Information of the top %d pairs ...\n', num_MI)
+    tic
+
+    [list_MI, list_sub] = calc_MI_top(MSA, q, weights, num_MI, ...
+      Sampled.numSub, Sampled.alpha, Sampled.seed, Sampled.numThread);
+
+    time_MI = toc;
+    fprintf('\tFinished in %.2f s\n', time_MI);
+  elseif Compress
+    [list_MI, list_sub, time_MI] = calc_MI_compressed(MSA, q, weights, ...
+      numWorker);
   else
-    for i = 1:N
-      f1(:,i) = calc_f1_w(MSA(:,i), B, q, weights, B_eff);
+    %% calculate f_i(k)
+    tic
+
+    f1 = zeros(q,N);
+    if numWorker > 1
+      parfor (i = 1:N, numWorker)
+        f1(:,i) = calc_f1_w(MSA(:,i), B, q, weights, B_eff);
+      end
+    else
+      for i = 1:N
+        f1(:,i) = calc_f1_w(MSA(:,i), B, q, weights, B_eff);
+      end
     end
-  end
-
-  time_f1 = toc;
-  fprintf('Time for calculation of 1-point frequencies: %.2f s\n', time_f1);
 
-
-  %% calculate MI
-  fprintf('Calculating Mutual Information ...\n')
-  tic
-
-  q0 = uint64(q);
-  B0 = uint64(B);
-  N_lt = N-1; % lower triangle (off-diagonal)
-  num_lt = N_lt*(N_lt+1)/2;
-  list_MI  = zeros(1, num_lt);
-  list_sub = zeros(2, num_lt, 'uint32');
-  if numWorker > 1
-    parfor (l = 1:num_lt, numWorker)
-      sub = l2ij_off_lt(l,N_lt);
-      j = sub(1) + 1;
-      i = sub(2);
-      %% given (i,j) and MSA, calculate MI(i,j)
-      % datai = MSA(:,i);
-      % dataj = MSA(:,j);
-      fij = calc_f2_w_mex_uint8(MSA(:,i), MSA(:,j), B0, q0, weights, B_eff);
-      % fi = f1(:,i);
-      % fj = f1(:,j);
-      % I = calc_MI(f1(:,i), f1(:,j), fij);
-      list_MI(l) = calc_MI(f1(:,i), f1(:,j), fij, q);
-      list_sub(:,l) = [i; j];
-    end
-  else
-    for l = 1:num_lt
-      sub = l2ij_off_lt(l,N_lt);
-      j = sub(1) + 1;
-      i = sub(2);
-      %% given (i,j) and MSA, calculate MI(i,j)
-      fij = calc_f2_w_mex_uint8(MSA(:,i), MSA(:,j), B0, q0, weights, B_eff);
-      list_MI(l) = calc_MI(f1(:,i), f1(:,j), fij, q);
-      list_sub(:,l) = [i; j];
+    time_f1 = toc;
+    fprintf('Time for calculation of 1-point frequencies: %.2f s\n', time_f1);
+
+
+    %% calculate MI
+    fprintf('Calculating Mutual Information ...\n')
+    tic
+
+    q0 = uint64(q);
+    B0 = uint64(B);
+    N_lt = N-1; % lower triangle (off-diagonal)
+    num_lt = N_lt*(N_lt+1)/2;
+    list_MI  = zeros(1, num_lt);
+    list_sub = zeros(2, num_lt, 'uint32');
+    if numWorker > 1 && isunix
+      % columns are read in place from shared memory
+      MSA_shared = shm_msa_mex('create', MSA);
+      cleanupObj = onCleanup(@() shm_msa_mex('free', MSA_shared));
+      parfor (l = 1:num_lt, numWorker)
+        sub = l2ij_off_lt(l,N_lt);
+        j = sub(1) + 1;
+        i = sub(2);
+        fij = calc_f2_w_mex_uint8(MSA_shared, i, j, B0, q0, weights, B_eff);
+        list_MI(l) = calc_MI(f1(:,i), f1(:,j), fij, q);
+        list_sub(:,l) = [i; j];
+      end
+      clear cleanupObj
+    elseif numWorker > 1
+      parfor (l = 1:num_lt, numWorker)
+        sub = l2ij_off_lt(l,N_lt);
+        j = sub(1) + 1;
+        i = sub(2);
+        %% given (i,j) and MSA, calculate MI(i,j)
+        % datai = MSA(:,i);
+        % dataj = MSA(:,j);
+        fij = calc_f2_w_mex_uint8(MSA(:,i), MSA(:,j), B0, q0, weights, B_eff);
+        % fi = f1(:,i);
+        % fj = f1(:,j);
+        % I = calc_MI(f1(:,i), f1(:,j), fij);
+        list_MI(l) = calc_MI(f1(:,i), f1(:,j), fij, q);
+        list_sub(:,l) = [i; j];
+      end
+    else
+      for l = 1:num_lt
+        sub = l2ij_off_lt(l,N_lt);
+        j = sub(1) + 1;
+        i = sub(2);
+        %% given (i,j) and MSA, calculate MI(i,j)
+        fij = calc_f2_w_mex_uint8(MSA(:,i), MSA(:,j), B0, q0, weights, B_eff);
+        list_MI(l) = calc_MI(f1(:,i), f1(:,j), fij, q);
+        list_sub(:,l) = [i; j];
+      end
     end
-  end
 
-  time_MI = toc;
-  fprintf('\tFinished in %.2f s\n', time_MI);
+    time_MI = toc;
+    fprintf('\tFinished in %.2f s\n', time_MI);
+  end
 
 
   %% sort MI table in descending order
@@ -185,6 +269,10 @@ else
 
   % load(filename_MI_table, 'list_MI_sort', 'list_sub_sort', 'time_MI')
   MatFileObj = matfile(filename_MI_full);
+  if size(MatFileObj, 'list_sub_sort', 2) < num_MI
+    error('`%s` contains less than %d pairs; use `NoLoad = true`.', ...
+      filename_MI, num_MI)
+  end
   sub_MI_top = MatFileObj.list_sub_sort(:,1:num_MI);
 
   time_load = toc;
@@ -198,3 +286,91 @@ MSA_cc = MSA(:,idx_cc);
 
 
 end
+
+
+
+
+
+
+
+
+
+
+% MI of all pairs of loci, calculated once per pair of site classes
+function [list_MI, list_sub, time_MI] = calc_MI_compressed(MSA, q, weights, ...
+  numWorker)
+
+%% compression
+fprintf('Compressing MSA ...\n')
+tic
+
+N = size(MSA,2);
+B_eff = sum(weights);
+[MSA_u, weights_u, site_class, idx_rep] = compress_MSA(MSA, weights);
+B_u = size(MSA_u,1);
+C = numel(idx_rep);
+MSA_c = MSA_u(:,idx_rep);   % representative loci
+
+time_compress = toc;
+fprintf('\tB: %d -> %d, N: %d -> %d site classes\n', size(MSA,1), B_u, N, C);
+fprintf('\tFinished in %.2f s\n', time_compress);
+
+
+%% calculate f_i(k) of site classes
+tic
+
+f1 = zeros(q,C);
+for c = 1:C
+  f1(:,c) = calc_f1_w(MSA_c(:,c), B_u, q, weights_u, B_eff);
+end
+
+time_f1 = toc;
+fprintf('Time for calculation of 1-point frequencies: %.2f s\n', time_f1);
+
+
+%% calculate MI of pairs of site classes (c1 <= c2)
+fprintf('Calculating Mutual Information ...\n')
+tic
+
+q0 = uint64(q);
+B0 = uint64(B_u);
+num_c = C*(C+1)/2;  % lower triangle (diagonal included)
+list_MI_c = zeros(1, num_c);
+if numWorker > 1
+  parfor (l = 1:num_c, numWorker)
+    sub = l2ij_off_lt(l,C);
+    fij = calc_f2_w_mex_uint8(MSA_c(:,sub(2)), MSA_c(:,sub(1)), B0, q0, ...
+      weights_u, B_eff);
+    list_MI_c(l) = calc_MI(f1(:,sub(2)), f1(:,sub(1)), fij, q);
+  end
+else
+  for l = 1:num_c
+    sub = l2ij_off_lt(l,C);
+    fij = calc_f2_w_mex_uint8(MSA_c(:,sub(2)), MSA_c(:,sub(1)), B0, q0, ...
+      weights_u, B_eff);
+    list_MI_c(l) = calc_MI(f1(:,sub(2)), f1(:,sub(1)), fij, q);
+  end
+end
+
+MI_c = zeros(C);
+MI_c(tril(true(C))) = list_MI_c;  % column-major order of the lower triangle
+MI_c = MI_c + tril(MI_c,-1).';
+
+
+%% expand to pairs of loci, in the order of `CC_MSA` (cf. `l2ij_off_lt`)
+num_lt = N*(N-1)/2;
+list_MI  = zeros(1, num_lt);
+list_sub = zeros(2, num_lt, 'uint32');
+l = 0;
+for i = 1:N-1
+  idx = l+1 : l+N-i;
+  list_MI(idx) = MI_c(site_class(i+1:N), site_class(i));
+  list_sub(1,idx) = i;
+  list_sub(2,idx) = i+1:N;
+  l = l+N-i;
+end
+
+time_MI = toc;
+fprintf('\tFinished in %.2f s\n', time_MI);
+
+end
@@ -0,0 +1,141 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Incremental version of `CC_MSA` for an MSA which grows over time (e.g. new
+% isolates every week), with unit weights.
+%
+% The 1-point and 2-point counts of all sequences seen so far are kept in
+% `<MSA_id>--counts.bin` (uint32, see `function/mex/pair_counts.hpp`). Each
+% call adds the counts of `MSA_new` only (`pair_counts_update_mex`), then
+% refreshes MI of every pair from the counts (`MI_from_counts_mex`) and the
+% selection of loci, without reading old sequences. The cost of an update is
+% proportional to the new sequences; the refresh costs O(q^2 N^2) and reads
+% the file once.
+%
+% The MI table is saved as `<MSA_id>--MI.mat` in the format of `CC_MSA`, so
+% that `CC_MSA` with `NoLoad = false` and the same `MSA_id` loads it.
+%
+% INPUT
+% ===
+% | name       | type    | note                                        |
+% | ---------- | ------- | ------------------------------------------- |
+% | MSA_new    | uint8   | [1,q], rows as new sequences (may be empty) |
+% | MSA_id     | char    | a character vector, identifier of MSA       |
+% | len_seq    |         | length of sequences                         |
+% | q          |         | number of possible states on each locus     |
+% | num_MI     |         | loci are selected by `num_MI` largest MI    |
+% | numThread  |         | number of native threads                    |
+% | outputPath |         | path for the counts and the MI table        |
+%
+% The first call creates the file of counts, which needs
+% 4*(q*N + q^2*N*(N-1)/2) bytes for N = len_seq. An update writes a new copy
+% of it, which replaces the old one once complete, so that twice that space is
+% needed while it runs and an interrupted update can simply be repeated.
+%
+% OUTPUT
+% ===
+% `idx_cc` is the indices of selected loci (1-based); use `MSA(:,idx_cc)` on
+% the whole MSA to get `MSA_cc` of `CC_MSA`.
+% `num_seq` is the number of sequences counted so far.
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1.1
+%   - counts are updated into a copy which replaces the file
+%
+% - 2018-05-02  v1
+
+function [idx_cc, num_seq] = CC_MSA_incremental(MSA_new, MSA_id, len_seq, q, ...
+  num_MI, numThread, outputPath)
+
+%% check with little overhead
+% MSA_new
+if ~isa(MSA_new, 'uint8')
+  error('MSA should be provided as uint8. Use `MSA = uint8(MSA)` to convert.')
+end
+if size(MSA_new,2) ~= len_seq && ~isempty(MSA_new)
+  error('MSA should be provided as rows being sequences.')
+end
+
+% MSA_id
+if ~ischar(MSA_id)
+  error('`MSA_id` should be provided as a char vector.')
+end
+
+% outputPath
+if exist(outputPath,'dir') ~= 7
+  error('The folder `%s` does not exist.', outputPath)
+end
+
+
+%% check with acceptable overhead
+% range of MSA
+if ~isempty(MSA_new) ...
+    && (uint64(max(MSA_new(:))) > uint64(q) || uint64(min(MSA_new(:))) < 1)
+  error('q possible states in MSA should be encoded as integers in [1,q].')
+end
+
+
+%% search path
+if exist('pair_counts_update_mex','file') ~= 3
+  addpath(genpath(pwd))
+end
+
+
+%% update counts
+filename_counts = fullfile(outputPath, sprintf('%s--counts.bin', MSA_id));
+
+if ~isempty(MSA_new)
+  fprintf('Adding %d sequences to pair counts ...\n', size(MSA_new,1))
+  tic
+
+  num_seq = pair_counts_update_mex(filename_counts, MSA_new, q, numThread);
+
+  time_update = toc;
+  fprintf('\t%d sequences in total, finished in %.2f s\n', num_seq, time_update);
+end
+
+
+%% refresh MI from counts
+fprintf('Calculating Mutual Information from pair counts ...\n')
+tic
+
+[list_MI, list_sub, num_seq] = MI_from_counts_mex(filename_counts, numThread);
+
+time_MI = toc;
+fprintf('\tFinished in %.2f s\n', time_MI);
+
+
+%% sort MI table in descending order
+fprintf('Rearranging MI table in descending order ...\n')
+tic
+
+[list_MI_sort, sidx_MI] = sort(list_MI, 'descend');
+list_sub_sort = list_sub(:,sidx_MI);
+
+time_sort = toc;
+fprintf('\tFinished in %.2f s\n', time_sort);
+
+
+%% save to file
+fprintf('Saving to file ...\n')
+tic
+
+filename_MI_full = fullfile(outputPath, sprintf('%s--MI.mat', MSA_id));
+save(filename_MI_full, 'list_MI_sort', 'list_sub_sort', ...
+  'time_MI', 'time_sort', '-v7.3')
+
+time_save = toc;
+fprintf('\tFinished in %.2f s\n', time_save);
+
+
+%% select loci by `num_MI` largest MI
+idx_cc = union(list_sub_sort(:,1:num_MI), []);
+
+
+end
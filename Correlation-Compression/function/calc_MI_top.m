@@ -0,0 +1,224 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% The K pairs of loci with the largest weighted MI, without calculating the
+% exact MI of every pair (used by `CC_MSA` when `Sampled` is given).
+%
+% Two bounds prune pairs:
+%
+% 1. Exact: MI(i,j) <= min(H_i, H_j), where H_i is the entropy of locus i on
+%    the full MSA (O(NB) in total). If both loci have two observed states, with
+%    minor frequencies a and b, the joint frequencies form a 2x2 table with
+%    these marginals, determined by the frequency f of both minor states,
+%    0 <= f <= min(a,b). MI is convex in f, so MI(i,j) is at most the larger
+%    MI of the tables with f = 0 and f = min(a,b), which is usually far below
+%    min(H_i, H_j) when a and b differ. A pair whose bound is below a threshold
+%    `tau` that is known to be at most the K-th largest MI can not be in the
+%    top K.
+% 2. Estimated: MI on a random subsample of `numSub` sequences, with the
+%    delta-method standard error `sd` (`calc_MI_pairs_mex`). A pair whose
+%    upper confidence bound `MI_sub + z*sd` is below `tau` is dropped, where
+%    `z` is the (1-alpha) quantile of the normal distribution.
+%
+% With `alpha = 0`, only bound 1 prunes and the result is the exact top K:
+% the subsample picks K promising pairs, their exact MI sets `tau`, and all
+% pairs passing bound 1 are calculated exactly while `tau` rises. Every pair
+% is still visited (O(1) for its bound), and the exact MI (O(B)) is saved only
+% for pruned pairs: with loci of more than two states and similar entropies,
+% few pairs are pruned and exact mode saves mostly memory. With
+% `alpha > 0`, both bounds prune in a pass over the subsample, and the exact
+% MI is calculated only for the surviving candidates; every pair of the true
+% top K is missed with probability about `alpha` (normal approximation).
+%
+% Pairs are visited in blocks of loci, so that memory does not grow as N^2.
+%
+% INPUT
+% ===
+% | name       | note                                                 |
+% | ---------- | ---------------------------------------------------- |
+% | MSA        | uint8, [1,q], rows as sequences                      |
+% | q          | number of possible states on each locus              |
+% | weights    | weights of sequences                                 |
+% | K          | number of pairs wanted (`num_MI` of `CC_MSA`)        |
+% | numSub     | number of sequences in the subsample                 |
+% | alpha      | tolerated miss rate per pair, 0 for the exact top K  |
+% | seed       | seed of `rng` for the subsample                      |
+% | numThread  | native threads of `calc_MI_pairs_mex`                |
+%
+% OUTPUT
+% ===
+% `list_MI` (1-by-K, descending) and `list_sub` (2-by-K, uint32, i < j), in the
+% format of `list_MI_sort` and `list_sub_sort` of `CC_MSA`.
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1.1
+%   - exact bound from minor frequencies for pairs of two-state loci
+%
+% - 2018-04-30  v1
+
+function [list_MI, list_sub] = calc_MI_top(MSA, q, weights, K, numSub, alpha, ...
+  seed, numThread)
+
+[B,N] = size(MSA);
+weights = weights(:);
+B_eff = sum(weights);
+K = min(K, N*(N-1)/2);
+numPairBlock = 2^22;  % pairs per call of `calc_MI_pairs_mex`
+
+
+%% entropy and minor frequency of every locus on the full MSA (exact bound)
+H = zeros(1, N);
+maf = nan(1, N);    % only for loci with two observed states
+for i = 1:N
+  fi = accumarray(double(MSA(:,i)), weights, [q 1]) / B_eff;
+  fi = fi(fi > 0);
+  H(i) = -sum(fi .* log2(fi));
+  if numel(fi) == 2
+    maf(i) = min(fi);
+  end
+end
+
+
+%% subsample
+rng(seed);
+rows = sort(randperm(B, min(numSub, B)));
+MSA_sub = MSA(rows,:);
+w_sub = weights(rows);
+
+
+if alpha == 0
+  %% exact: seed `tau` with the K most promising pairs of the subsample
+  [~, cand_sub] = scan_pairs(MSA_sub, q, w_sub, H, maf, 0, K, 0, ...
+    numThread, numPairBlock);
+  MI_seed = calc_MI_pairs_mex(MSA, q, weights, cand_sub, numThread);
+  tau = min(MI_seed);
+
+  [list_MI, list_sub] = scan_pairs(MSA, q, weights, H, maf, tau, K, 0, ...
+    numThread, numPairBlock);
+else
+  %% estimated: candidates from the subsample, then exact MI of them
+  z = sqrt(2) * erfcinv(2*alpha);
+  [~, ~, cand_sub] = scan_pairs(MSA_sub, q, w_sub, H, maf, 0, K, z, ...
+    numThread, numPairBlock);
+  MI_cand = calc_MI_pairs_mex(MSA, q, weights, cand_sub, numThread);
+
+  [list_MI, idx] = sort(MI_cand, 'descend');
+  idx = idx(1:min(K, numel(idx)));
+  list_MI = list_MI(1:numel(idx));
+  list_sub = cand_sub(:,idx);
+end
+
+
+end
+
+
+
+
+
+
+
+
+
+
+% Visit all pairs (i<j) whose exact bound reaches tau, keep the top K by MI
+% (with `z = 0`) or the candidates whose upper bound MI+z*sd reaches the K-th
+% largest lower bound MI-z*sd (with `z > 0`). `tau` rises with the top K as it
+% fills.
+function [top_MI, top_sub, cand_sub] = scan_pairs(MSA, q, weights, H, maf, ...
+  tau, K, z, numThread, numPairBlock)
+
+N = size(MSA, 2);
+
+top_MI  = zeros(1, 0);
+top_sub = zeros(2, 0, 'uint32');
+cand_sub = zeros(2, 0, 'uint32');
+cand_ub  = zeros(1, 0);
+
+% loci in descending order of entropy: pairs (a,b), a<b in this order, have
+% min(H) = H(order(b)); once H(order(b)) < tau the rest of the row is skipped
+[H_sort, order] = sort(H, 'descend');
+
+a = 1;
+while a < N
+  % block of rows a..a_end with about `numPairBlock` pairs
+  sub = {};
+  numPair = 0;
+  while a < N && numPair < numPairBlock
+    b_end = find(H_sort(a+1:N) >= tau, 1, 'last');
+    if isempty(b_end)
+      break
+    end
+    b = a+1 : a+b_end;
+    sub{end+1} = uint32([repmat(order(a), 1, numel(b)); order(b)]); %#ok<AGROW>
+    numPair = numPair + numel(b);
+    a = a + 1;
+  end
+  if numPair == 0
+    break
+  end
+  sub = sort([sub{:}], 1);  % i < j
+  sub = sub(:, MI_bound(H, maf, sub) >= tau);
+  if isempty(sub)
+    continue
+  end
+
+  [MI, sd] = calc_MI_pairs_mex(MSA, q, weights, sub, numThread);
+
+  if z == 0
+    [top_MI, idx] = sort([top_MI, MI], 'descend');
+    top_sub = [top_sub, sub];
+    idx = idx(1:min(K, numel(idx)));
+    top_MI = top_MI(1:numel(idx));
+    top_sub = top_sub(:,idx);
+  else
+    lb = MI - z*sd;
+    top_MI = sort([top_MI, lb], 'descend');
+    top_MI = top_MI(1:min(K, numel(top_MI)));
+    cand_sub = [cand_sub, sub];         %#ok<AGROW>
+    cand_ub  = [cand_ub, MI + z*sd];    %#ok<AGROW>
+  end
+
+  if numel(top_MI) == K
+    tau = max(tau, top_MI(K));
+    if z > 0
+      isKept = cand_ub >= tau;
+      cand_sub = cand_sub(:,isKept);
+      cand_ub  = cand_ub(isKept);
+    end
+  end
+end
+
+end
+
+
+% exact upper bound of MI for pairs `sub` (see bound 1)
+function ub = MI_bound(H, maf, sub)
+i = sub(1,:);
+j = sub(2,:);
+ub = min(H(i), H(j));
+isTwo = ~isnan(maf(i)) & ~isnan(maf(j));
+a = maf(i(isTwo));
+b = maf(j(isTwo));
+% (plus round-off, since pairs at the bound are common: linked loci)
+ub(isTwo) = min(ub(isTwo), max(MI_2x2(a, b, zeros(size(a))), ...
+  MI_2x2(a, b, min(a, b))) + 1e-12);
+end
+
+
+% MI of the 2x2 table with marginals (1-a, a), (1-b, b) and f at (minor, minor)
+function I = MI_2x2(a, b, f)
+I = entropy2([a; 1-a]) + entropy2([b; 1-b]) ...
+  - entropy2([f; a-f; b-f; 1-a-b+f]);
+end
+
+
+function H = entropy2(p)
+p = max(p, 0);
+H = -sum(p .* log2(p + (p == 0)), 1);
+end
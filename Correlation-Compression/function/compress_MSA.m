@@ -0,0 +1,63 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Pattern compression of a MSA before the O(N^2 B) calculation of MI.
+%
+% 1. Identical sequences are collapsed into one row whose weight is the sum of
+%    their weights (the multiplicity if all weights are 1). Weighted
+%    frequencies, and thus MI, are unchanged.
+% 2. Loci are grouped into site classes. Two loci are in the same class if one
+%    column is obtained from the other by relabeling the states, e.g. identical
+%    loci or complementary bi-allelic loci (linkage). Columns are compared after
+%    a canonical relabeling where states are numbered by first appearance.
+%
+% Since MI is invariant under relabeling of the states of either variable,
+%
+%   MI(i,j) = MI(idx_rep(site_class(i)), idx_rep(site_class(j))),
+%
+% and MI of two loci of the same class is the entropy of that class.
+%
+% INPUT
+% ===
+% | name       | type    | note                                     |
+% | ---------- | ------- | ---------------------------------------- |
+% | MSA        | uint8   | [1,q], rows as sequences/samples         |
+% | weights    | double  | weights of sequences/samples             |
+%
+% OUTPUT
+% ===
+% | name       | note                                                       |
+% | ---------- | ---------------------------------------------------------- |
+% | MSA_u      | B_u-by-N, unique rows of `MSA` (same loci, same states)    |
+% | weights_u  | B_u-by-1, summed weights of the collapsed rows             |
+% | site_class | N-by-1, class of each locus, in [1,C]                      |
+% | idx_rep    | C-by-1, representative locus (first one) of each class     |
+% | idx_row    | B-by-1, `MSA = MSA_u(idx_row,:)`                           |
+%
+% HISTORY
+% ===
+% - 2018-04-02  v1
+
+function [MSA_u, weights_u, site_class, idx_rep, idx_row] = ...
+  compress_MSA(MSA, weights)
+
+%% sequences -> multiplicity-weighted rows
+[MSA_u, ~, idx_row] = unique(MSA, 'rows');
+weights_u = accumarray(idx_row(:), weights(:));
+
+
+%% loci -> site classes
+[B_u, N] = size(MSA_u);
+code = zeros(B_u, N, 'uint8');    % canonical labels, at most 256 states
+for i = 1:N
+  [~, ~, label] = unique(MSA_u(:,i), 'stable');
+  code(:,i) = label;
+end
+[~, idx_rep, site_class] = unique(code.', 'rows', 'stable');
+
+end
@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * [list_MI, list_sub, B] = MI_from_counts_mex(filename, numThread)
+ *
+ *  filename   char      file of counts (see `pair_counts.hpp`)
+ *  numThread  double    number of native threads
+ *
+ *  list_MI    1-by-N(N-1)/2, MI (bits) of every pair, unweighted
+ *  list_sub   uint32, 2-by-N(N-1)/2, loci (i < j) of every pair
+ *  B          number of sequences counted
+ *
+ * Pairs are in the order of `CC_MSA`. MI is the same as `calc_MI` on the
+ * frequencies of all counted sequences with unit weights.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-02  v1
+ */
+
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "mex.h"
+#include "pair_counts.hpp"
+#include "../../../common/mex/thread_pool.hpp"
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs > 3) {
+    mexErrMsgIdAndTxt(
+      "MI_from_counts_mex:nlhs",
+      "This function produces at most 3 outputs.");
+  }
+  if (nrhs != 2) {
+    mexErrMsgIdAndTxt(
+      "MI_from_counts_mex:nrhs",
+      "Number of arguments needed: 2\n"
+      "provided: %d", nrhs);
+  }
+  if (   !mxIsChar(prhs[0])
+      || !mxIsDouble(prhs[1]) || mxGetNumberOfElements(prhs[1]) != 1 )
+  {
+    mexErrMsgIdAndTxt(
+      "MI_from_counts_mex:prhs:WrongType",
+      "Requirement:\n"
+      "    char:    filename\n"
+      "  double:    numThread (scalar)");
+  }
+  size_t numThread = size_t(mxGetScalar(prhs[1]));
+  if (numThread < 1) {
+    numThread = 1;
+  }
+
+  char *filename = mxArrayToString(prhs[0]);
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    mexErrMsgIdAndTxt("MI_from_counts_mex:open",
+      "Can not open `%s`.", filename);
+  }
+  PairCountsHeader hdr;
+  if (fread(&hdr, sizeof(hdr), 1, fp) != 1
+    || std::memcmp(hdr.magic, PC_MAGIC, 8) != 0)
+  {
+    fclose(fp);
+    mexErrMsgIdAndTxt("MI_from_counts_mex:format",
+      "`%s` is not a file of pair counts.", filename);
+  }
+  const uint64_t N = hdr.N;
+  const uint64_t q = hdr.q;
+  const uint64_t B = hdr.B;
+  const uint64_t L = N*(N-1)/2;
+  if (B == 0) {
+    fclose(fp);
+    mexErrMsgIdAndTxt("MI_from_counts_mex:empty",
+      "`%s` contains no sequence.", filename);
+  }
+
+  std::vector<uint32_t> site(q*N);
+  PairCountsStatus st = pc_read(fp, PC_OFFSET_SITE, site.data(), site.size());
+
+  plhs[0] = mxCreateDoubleMatrix(1, L, mxREAL);
+  double *MI = mxGetPr(plhs[0]);
+
+  if (st == PC_OK) {
+    ThreadPool pool(numThread);
+    st = pc_for_each_chunk(fp, NULL, N, q, uint64_t(1) << 22,
+      [&](uint64_t i0, uint64_t i1, uint64_t l0, uint32_t *block) {
+        pool.parallel_for(i1 - i0, 1, [&](size_t begin, size_t end, size_t) {
+          for (size_t i = i0 + begin; i < i0 + end; i++) {
+            const uint64_t l = pc_pair_index(N, i);
+            pc_MI_rows(MI + l, block + q*q*(l - l0), site.data(),
+              B, N, q, i, i+1);
+          }
+        });
+      });
+  }
+  fclose(fp);
+  if (st != PC_OK) {
+    mexErrMsgIdAndTxt("MI_from_counts_mex:io",
+      "Reading `%s` failed.", filename);
+  }
+  mxFree(filename);
+
+  if (nlhs > 1) {
+    plhs[1] = mxCreateNumericMatrix(2, L, mxUINT32_CLASS, mxREAL);
+    uint32_t *sub = (uint32_t *) mxGetData(plhs[1]);
+    for (uint64_t i = 0; i+1 < N; i++) {
+      for (uint64_t j = i+1; j < N; j++) {
+        *sub++ = uint32_t(i+1);
+        *sub++ = uint32_t(j+1);
+      }
+    }
+  }
+  if (nlhs > 2) {
+    plhs[2] = mxCreateDoubleScalar(double(B));
+  }
+}
@@ -0,0 +1,90 @@
+#ifndef CALC_MI_PAIRS_HPP
+#define CALC_MI_PAIRS_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Weighted mutual information (in bits, see `calc_MI.m`) of one pair of loci,
+ * together with the delta-method standard error of the plug-in estimate
+ *
+ * $$
+ * \mathrm{sd}^2 = \frac{1}{n_{\text{eff}}} \left( \sum_{k,l} f_{ij}(k,l)
+ *   L_{kl}^2 - I^2 \right), \quad
+ * L_{kl} = \log_2 \frac{f_{ij}(k,l)}{f_i(k) f_j(l)}
+ * $$
+ *
+ * where $n_{\text{eff}} = (\sum_b w_b)^2 / \sum_b w_b^2$. The standard error
+ * is meaningful when the loci are a random subsample of the sequences (see
+ * `calc_MI_top.m`).
+ *
+ *
+ * # Input
+ *
+ *  datai, dataj : B elements, states in [1,q]
+ *  q, B         : number of states (<= 256) and of sequences
+ *  w, B_eff     : weights, B_eff = \sum_b w_b
+ *  fi, fj       : q elements, 1-point frequencies of locus i and j
+ *  fij          : q*q elements, work space (overwritten)
+ *
+ *
+ * # Output (by pointer)
+ *
+ *  I            : MI, in bits
+ *  var_L        : $\sum_{k,l} f_{ij}(k,l) L_{kl}^2 - I^2$, to be divided by
+ *                 $n_{\text{eff}}$ for the variance
+ *
+ * No MATLAB API is called.
+ *
+ *
+ * # History
+ *
+ * ## 2018-04-30  v1
+ */
+
+#include <math.h>   // log2()
+#include <stdint.h> // uint8_t
+
+
+inline void calc_MI_pair(
+  const uint8_t *datai, const uint8_t *dataj,
+  const size_t q, const size_t B,
+  const double *w, const double B_eff,
+  const double *fi, const double *fj,
+  double *fij,
+  double *I, double *var_L)
+{
+  for (size_t k = 0; k < q*q; k++) {
+    fij[k] = 0.0;
+  }
+  for (size_t b = 0; b < B; b++) {
+    fij[(datai[b]-1) + q*(dataj[b]-1)] += w[b];
+  }
+
+  double sum_L = 0.0;
+  double sum_L2 = 0.0;
+  for (size_t l = 0; l < q; l++) {
+    for (size_t k = 0; k < q; k++) {
+      const double f = fij[k + q*l] / B_eff;
+      if (f > 0.0) {
+        const double L = log2(f / fi[k] / fj[l]);
+        sum_L  += f * L;
+        sum_L2 += f * L * L;
+      }
+    }
+  }
+
+  *I = sum_L;
+  *var_L = sum_L2 - sum_L*sum_L;
+  if (*var_L < 0.0) {   // round-off
+    *var_L = 0.0;
+  }
+}
+
+#endif // CALC_MI_PAIRS_HPP
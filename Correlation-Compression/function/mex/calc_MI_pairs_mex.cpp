@@ -0,0 +1,177 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * [MI, sd] = calc_MI_pairs_mex(MSA, q, weights, pairs, numThread)
+ *
+ *  MSA        uint8     B rows (sequences), N columns (loci), states in [1,q]
+ *  q          double    number of states, <= 256
+ *  weights    double    B elements, weights of sequences
+ *  pairs      uint32    2-by-L, loci (1-based) of the L pairs
+ *  numThread  double    number of native threads
+ *
+ *  MI         1-by-L, weighted MI (bits) of every pair, as `calc_MI`
+ *  sd         1-by-L, delta-method standard error of MI when the rows of
+ *             `MSA` are a random subsample (see `calc_MI_pairs.hpp`)
+ *
+ * 1-point frequencies are calculated once per locus appearing in `pairs`, and
+ * pairs are distributed to the threads dynamically. The range of `MSA` is not
+ * checked here (see `CC_MSA`).
+ *
+ * When `numThread` exceeds the CPUs of one NUMA node, threads are pinned and
+ * spread over the nodes, and every node scans its own copy of `MSA`.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-09  v1.1  NUMA placement
+ * - 2018-04-30  v1
+ */
+
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "mex.h"
+#include "calc_MI_pairs.hpp"
+#include "../../../common/mex/thread_pool.hpp"
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs > 2) {
+    mexErrMsgIdAndTxt(
+      "calc_MI_pairs_mex:nlhs",
+      "This function produces at most 2 outputs.");
+  }
+  if (nrhs != 5) {
+    mexErrMsgIdAndTxt(
+      "calc_MI_pairs_mex:nrhs",
+      "Number of arguments needed: 5\n"
+      "provided: %d", nrhs);
+  }
+
+  const mxArray *pm_MSA     = prhs[0];
+  const mxArray *pm_w       = prhs[2];
+  const mxArray *pm_pairs   = prhs[3];
+
+  /* type check */
+  if (   !mxIsUint8(pm_MSA)
+      || !mxIsDouble(pm_w)
+      || !mxIsUint32(pm_pairs) )
+  {
+    mexErrMsgIdAndTxt(
+      "calc_MI_pairs_mex:prhs:WrongType",
+      "Requirement:\n"
+      "   uint8:    MSA\n"
+      "  double:    q,  weights,  numThread\n"
+      "  uint32:    pairs");
+  }
+  if (   !mxIsDouble(prhs[1]) || mxGetNumberOfElements(prhs[1]) != 1
+      || !mxIsDouble(prhs[4]) || mxGetNumberOfElements(prhs[4]) != 1 )
+  {
+    mexErrMsgIdAndTxt(
+      "calc_MI_pairs_mex:prhs:ScalarWrong",
+      "Both of {q, numThread} should be double scalars.");
+  }
+
+  const size_t B = mxGetM(pm_MSA);
+  const size_t N = mxGetN(pm_MSA);
+  const size_t q = size_t(mxGetScalar(prhs[1]));
+  const size_t L = mxGetN(pm_pairs);
+  size_t numThread = size_t(mxGetScalar(prhs[4]));
+
+  if (q < 2 || q > 256) {
+    mexErrMsgIdAndTxt(
+      "calc_MI_pairs_mex:prhs:q",
+      "Requirement on q:\n"
+      "\tq >= 2 since 1-state case is trivial.\n"
+      "\tq <= 256 since data can only stores 0~255.\n");
+  }
+  if (mxGetNumberOfElements(pm_w) != B) {
+    mexErrMsgIdAndTxt(
+      "calc_MI_pairs_mex:prhs:weights",
+      "`weights` does not match `MSA`.");
+  }
+  if (L > 0 && mxGetM(pm_pairs) != 2) {
+    mexErrMsgIdAndTxt(
+      "calc_MI_pairs_mex:prhs:pairs",
+      "`pairs` should be a 2-by-L matrix.");
+  }
+  const uint32_t *pairs = (uint32_t *) mxGetData(pm_pairs);
+  for (size_t l = 0; l < 2*L; l++) {
+    if (pairs[l] < 1 || pairs[l] > N) {
+      mexErrMsgIdAndTxt(
+        "calc_MI_pairs_mex:prhs:pairs",
+        "Loci in `pairs` should be in [1,N].");
+    }
+  }
+  if (numThread < 1) {
+    numThread = 1;
+  }
+
+  const uint8_t *MSA = (uint8_t *) mxGetData(pm_MSA);
+  const double  *w   = mxGetPr(pm_w);
+
+  double B_eff = 0.0;
+  double sum_w2 = 0.0;
+  for (size_t b = 0; b < B; b++) {
+    B_eff  += w[b];
+    sum_w2 += w[b]*w[b];
+  }
+  if (!(B_eff > 0.0)) {
+    mexErrMsgIdAndTxt(
+      "calc_MI_pairs_mex:prhs:weights",
+      "The sum of `weights` should be positive.");
+  }
+  const double n_eff = B_eff*B_eff / sum_w2;
+
+  /* 1-point frequencies of the loci in `pairs` */
+  std::vector<char> isUsed(N, 0);
+  for (size_t l = 0; l < 2*L; l++) {
+    isUsed[pairs[l]-1] = 1;
+  }
+  std::vector<double> f1(q*N, 0.0);
+  for (size_t i = 0; i < N; i++) {
+    if (!isUsed[i]) {
+      continue;
+    }
+    const uint8_t *datai = MSA + B*i;
+    double *fi = f1.data() + q*i;
+    for (size_t b = 0; b < B; b++) {
+      fi[datai[b]-1] += w[b];
+    }
+    for (size_t k = 0; k < q; k++) {
+      fi[k] /= B_eff;
+    }
+  }
+
+  plhs[0] = mxCreateDoubleMatrix(1, L, mxREAL);
+  plhs[1] = mxCreateDoubleMatrix(1, L, mxREAL);
+  double *MI = mxGetPr(plhs[0]);
+  double *sd = mxGetPr(plhs[1]);
+
+  ThreadPool pool(numThread, numa_spans_nodes(numThread));
+  const NodeReplicas<uint8_t> MSA_node(pool, MSA, B*N);
+  std::vector<std::vector<double> > work(pool.size(),
+    std::vector<double>(q*q));
+  pool.parallel_for(L, 64, [&](size_t begin, size_t end, size_t tid) {
+    const uint8_t *MSA_t = MSA_node.get(tid);
+    double *fij = work[tid].data();
+    for (size_t l = begin; l < end; l++) {
+      const size_t i = pairs[2*l] - 1;
+      const size_t j = pairs[2*l+1] - 1;
+      double var_L = 0.0;
+      calc_MI_pair(MSA_t + B*i, MSA_t + B*j, q, B, w, B_eff,
+        f1.data() + q*i, f1.data() + q*j, fij, MI + l, &var_L);
+      sd[l] = std::sqrt(var_L / n_eff);
+    }
+  });
+}
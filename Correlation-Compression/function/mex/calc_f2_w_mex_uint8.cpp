@@ -1,6 +1,7 @@
 /**
  * 
  * MATLAB syntax: fij = calc_f2_w(datai, dataj, B, q, weights, B_eff)
+ *                fij = calc_f2_w(handle, i, j, B, q, weights, B_eff)
  * 
  * # INPUT type
  * 
@@ -19,6 +20,13 @@
  * Also, this implementation assumes that size_t is equal to uint64_t.
  * 
  *
+ * # Shared MSA
+ *
+ * With `handle` of a B-by-N MSA in shared memory (see `shm_msa_mex`), columns
+ * i and j (1-based, double) are read in place: `parfor` sends the handle to
+ * the workers instead of the MSA, and no column is copied per pair.
+ * 
+ *
  * # FORMAT
  * 
  * fij(k,l) contains $f_{ij}(k,l)$, the 2-point frequency of site i and site j.
@@ -39,6 +47,7 @@
  * 
  * # HISTORY
  * 
+ * 2018-05-08  v2  `handle, i, j` of a shared MSA
  * 2017-10-20  v1
  * 
  */
@@ -46,6 +55,11 @@
 #include <cstdint>
 #include "mex.h"
 #include "calc_f2_w_col.hpp"
+#include "../../../common/mex/shm_msa.hpp"
+
+
+// shared MSAs mapped by this process
+static ShmMsaCache shmCache;
 
 void mexFunction(
   int nlhs, mxArray *plhs[],
@@ -56,24 +70,27 @@ void mexFunction(
       "calc_f2_w_mex_uint8:nlhs",
       "This function produces 1 output.");
   }
-  if (nrhs != 6 && nrhs != 7) { // 7-th aguments as Flag to skip check
+  // a shared MSA takes one more argument
+  const bool isShared = nrhs > 0 && mxIsChar(prhs[0]);
+  const int numArg = isShared ? 7 : 6;
+  if (nrhs != numArg && nrhs != numArg+1) { // last aguments as Flag to skip check
     mexErrMsgIdAndTxt(
       "calc_f2_w_mex_uint8:nrhs",
-      "Number of arguments needed: 6\n"
-      "provided: %d", nrhs);
+      "Number of arguments needed: %d\n"
+      "provided: %d", numArg, nrhs);
   }
 
-  const mxArray *pm_datai = prhs[0];
-  const mxArray *pm_dataj = prhs[1];
-  const mxArray *pm_B     = prhs[2];
-  const mxArray *pm_q     = prhs[3];
-  const mxArray *pm_w     = prhs[4];
-  const mxArray *pm_B_eff = prhs[5];
+  const mxArray *pm_datai = prhs[numArg-6];
+  const mxArray *pm_dataj = prhs[numArg-5];
+  const mxArray *pm_B     = prhs[numArg-4];
+  const mxArray *pm_q     = prhs[numArg-3];
+  const mxArray *pm_w     = prhs[numArg-2];
+  const mxArray *pm_B_eff = prhs[numArg-1];
 
-  if (nrhs == 6) {  // default to check
+  if (nrhs == numArg) {  // default to check
     // class of mxArray
-    if (   !mxIsUint8(pm_datai)
-        || !mxIsUint8(pm_dataj)
+    if (   (isShared ? !mxIsDouble(pm_datai) : !mxIsUint8(pm_datai))
+        || (isShared ? !mxIsDouble(pm_dataj) : !mxIsUint8(pm_dataj))
         || !mxIsUint64(pm_B)
         || !mxIsUint64(pm_q)
         || !mxIsDouble(pm_w)
@@ -82,18 +99,18 @@ void mexFunction(
       mexErrMsgIdAndTxt(
         "calc_f2_w_mex_uint8:prhs:WrongType",
         "Requirement:\n"
-        "   uint8:    datai,  dataj\n"
+        "   uint8:    datai,  dataj (double: i,  j)\n"
         "  uint64:    B,  q\n"
         "  double:    w,  B_eff");
     }
 
     // all inputs should be real
-    if (   mxIsComplex(prhs[0])
-        || mxIsComplex(prhs[1])
-        || mxIsComplex(prhs[2])
-        || mxIsComplex(prhs[3])
-        || mxIsComplex(prhs[4])
-        || mxIsComplex(prhs[5]) )
+    if (   mxIsComplex(pm_datai)
+        || mxIsComplex(pm_dataj)
+        || mxIsComplex(pm_B)
+        || mxIsComplex(pm_q)
+        || mxIsComplex(pm_w)
+        || mxIsComplex(pm_B_eff) )
     {
       mexErrMsgIdAndTxt(
         "calc_f2_w_mex_uint8:prhs:IsComplex",
@@ -104,9 +121,45 @@ void mexFunction(
   const size_t B = *((uint64_t *) mxGetData(pm_B));
   const size_t q = *((uint64_t *) mxGetData(pm_q));
 
-  if (nrhs == 6) {  // default to check
-    const size_t B_i = mxGetNumberOfElements(pm_datai);
-    const size_t B_j = mxGetNumberOfElements(pm_dataj);
+  // columns i and j of a shared MSA; indices and B are always checked
+  const uint8_t* datai;
+  const uint8_t* dataj;
+  size_t B_i, B_j;
+  if (isShared) {
+    char name[SHM_MSA_MAX_HANDLE];
+    if (mxGetString(prhs[0], name, sizeof(name)) != 0) {
+      mexErrMsgIdAndTxt(
+        "calc_f2_w_mex_uint8:prhs:handle",
+        "Invalid handle of the MSA.");
+    }
+    int st;
+    const ShmMsa *msa = shmCache.get(name, &st);
+    if (msa == NULL) {
+      mexErrMsgIdAndTxt(
+        "calc_f2_w_mex_uint8:prhs:handle",
+        "`%s`: %s.", name, shm_msa_strerror(st));
+    }
+    const double i = mxGetScalar(pm_datai);
+    const double j = mxGetScalar(pm_dataj);
+    if (!(i >= 1 && i <= double(msa->K)) || !(j >= 1 && j <= double(msa->K))
+      || msa->M != B)
+    {
+      mexErrMsgIdAndTxt(
+        "calc_f2_w_mex_uint8:prhs:index",
+        "`i` and `j` should be columns of the B-by-N MSA.");
+    }
+    datai = msa->data + (size_t(i) - 1)*msa->M;
+    dataj = msa->data + (size_t(j) - 1)*msa->M;
+    B_i = B_j = size_t(msa->M);
+  }
+  else {
+    datai = (uint8_t*) mxGetData(pm_datai);
+    dataj = (uint8_t*) mxGetData(pm_dataj);
+    B_i = mxGetNumberOfElements(pm_datai);
+    B_j = mxGetNumberOfElements(pm_dataj);
+  }
+
+  if (nrhs == numArg) {  // default to check
     const size_t B_w = mxGetNumberOfElements(pm_w);
 
     // dimension
@@ -137,8 +190,6 @@ void mexFunction(
       "calc_f2_w_mex_uint8:OutOfMemory",
       "`mxCreateDoubleMatrix` failed.");
   }
-  const uint8_t* datai = (uint8_t*) mxGetData(pm_datai);
-  const uint8_t* dataj = (uint8_t*) mxGetData(pm_dataj);
   const double* w = mxGetPr(pm_w);
   const double B_eff = mxGetPr(pm_B_eff)[0];
   double* fij = mxGetPr(pm_fij);
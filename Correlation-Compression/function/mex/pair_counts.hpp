@@ -0,0 +1,298 @@
+#ifndef PAIR_COUNTS_HPP
+#define PAIR_COUNTS_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Persistent table of unweighted 1-point and 2-point counts of an MSA, so that
+ * new sequences only add to the counts, and MI of all pairs can be refreshed
+ * without reading old sequences (see `CC_MSA_incremental.m`).
+ *
+ *
+ * # File format (little-endian, as written by the host)
+ *
+ *  offset 0   char[8]   "CCPC1\0\0\0"
+ *  offset 8   uint64    N, number of loci
+ *  offset 16  uint64    q, number of states
+ *  offset 24  uint64    B, number of sequences counted
+ *  offset 32  uint64[4] reserved, 0
+ *  offset 64  uint32    c_i(k): q*N counts, c_i(k) at [k + q*i]
+ *  then       uint32    c_ij(k,l): q*q counts per pair (i<j), pairs in the
+ *                       order of `CC_MSA` ((1,2), (1,3), ..., (1,N), (2,3),
+ *                       ...), c_ij(k,l) at [k + q*l] of the block
+ *
+ * States k are 0-based here; in MATLAB they are [1,q]. The file needs
+ * 4*(qN + q^2 N(N-1)/2) bytes. Counts are uint32; an update which would
+ * exceed 2^32-1 sequences is refused.
+ *
+ * Pairs are processed in chunks of whole rows i (all j > i), which are read,
+ * updated and written to a copy (`<filename>.tmp`); the caller supplies a
+ * function that processes a chunk (e.g. with threads). The copy replaces the
+ * file once it is complete and on disk (`pc_commit`), so that an update which
+ * fails or is killed leaves the old counts intact and can simply be repeated.
+ * An update thus needs free space for a second copy of the file. No MATLAB
+ * API is called.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v1.1
+ *
+ * - updates are written to a copy which replaces the file, not in place
+ *
+ * ## 2018-05-02  v1
+ */
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+  #include <io.h>         // _commit()
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>    // MoveFileExA()
+  #define PC_FSEEK _fseeki64
+#else
+  #include <unistd.h>     // fsync()
+  #define PC_FSEEK fseeko
+#endif
+
+
+enum PairCountsStatus {
+  PC_OK = 0,
+  PC_ERR_OPEN,
+  PC_ERR_FORMAT,
+  PC_ERR_MISMATCH,
+  PC_ERR_OVERFLOW,
+  PC_ERR_IO
+};
+
+
+struct PairCountsHeader {
+  char     magic[8];
+  uint64_t N;
+  uint64_t q;
+  uint64_t B;
+  uint64_t reserved[4];
+};
+
+static const char PC_MAGIC[8] = {'C', 'C', 'P', 'C', '1', 0, 0, 0};
+static const uint64_t PC_OFFSET_SITE = sizeof(PairCountsHeader);
+
+
+inline uint64_t pc_offset_pair(uint64_t N, uint64_t q, uint64_t l) {
+  return PC_OFFSET_SITE + 4*(q*N + q*q*l);
+}
+
+// index of the first pair of row i (0-based), i.e. pair (i, i+1)
+inline uint64_t pc_pair_index(uint64_t N, uint64_t i) {
+  return i*(N-1) - i*(i-1)/2;
+}
+
+
+// open the file for reading the counts to update; if it does not exist,
+// `*fp` is NULL and `hdr` is that of a table of zero counts
+inline PairCountsStatus pc_open(
+  FILE **fp, PairCountsHeader *hdr,
+  const char *filename, uint64_t N, uint64_t q)
+{
+  *fp = fopen(filename, "rb");
+  if (*fp == NULL) {
+    if (errno != ENOENT) {    // exists, but can not be read
+      return PC_ERR_OPEN;
+    }
+    std::memset(hdr, 0, sizeof(*hdr));
+    std::memcpy(hdr->magic, PC_MAGIC, 8);
+    hdr->N = N;
+    hdr->q = q;
+    return PC_OK;
+  }
+
+  if (fread(hdr, sizeof(*hdr), 1, *fp) != 1
+    || std::memcmp(hdr->magic, PC_MAGIC, 8) != 0)
+  {
+    return PC_ERR_FORMAT;
+  }
+  if ((N > 0 && hdr->N != N) || (q > 0 && hdr->q != q)) {
+    return PC_ERR_MISMATCH;
+  }
+  return PC_OK;
+}
+
+
+inline PairCountsStatus pc_write_header(FILE *fp, const PairCountsHeader &hdr)
+{
+  if (PC_FSEEK(fp, 0, SEEK_SET) != 0 || fwrite(&hdr, sizeof(hdr), 1, fp) != 1) {
+    return PC_ERR_IO;
+  }
+  return PC_OK;
+}
+
+
+// a NULL `fp` reads zero counts (a table not created yet)
+inline PairCountsStatus pc_read(FILE *fp, uint64_t offset, uint32_t *buf,
+  size_t n)
+{
+  if (fp == NULL) {
+    std::memset(buf, 0, 4*n);
+    return PC_OK;
+  }
+  if (PC_FSEEK(fp, offset, SEEK_SET) != 0 || fread(buf, 4, n, fp) != n) {
+    return PC_ERR_IO;
+  }
+  return PC_OK;
+}
+
+
+inline PairCountsStatus pc_write(FILE *fp, uint64_t offset,
+  const uint32_t *buf, size_t n)
+{
+  if (PC_FSEEK(fp, offset, SEEK_SET) != 0 || fwrite(buf, 4, n, fp) != n) {
+    return PC_ERR_IO;
+  }
+  return PC_OK;
+}
+
+
+/**
+ * Visit the pair counts of `fp` in chunks of rows [i0, i1) of about
+ * `chunkPairs` pairs. `fn(i0, i1, l0, buf)` gets the counts of pairs l0,
+ * l0+1, ... (row i0 first); unless `out` is NULL, `buf` is written to `out`
+ * at the same offset afterwards.
+ */
+inline PairCountsStatus pc_for_each_chunk(
+  FILE *fp, FILE *out, uint64_t N, uint64_t q, uint64_t chunkPairs,
+  const std::function<void(uint64_t, uint64_t, uint64_t, uint32_t *)> &fn)
+{
+  std::vector<uint32_t> buf;
+  uint64_t i0 = 0;
+  while (i0 + 1 < N) {
+    uint64_t i1 = i0;
+    uint64_t numPair = 0;
+    while (i1 + 1 < N && (numPair == 0 || numPair + (N-1-i1) <= chunkPairs)) {
+      numPair += N-1-i1;
+      i1++;
+    }
+    const uint64_t l0 = pc_pair_index(N, i0);
+    buf.resize(size_t(q*q*numPair));
+    PairCountsStatus st = pc_read(fp, pc_offset_pair(N, q, l0), buf.data(),
+      buf.size());
+    if (st != PC_OK) {
+      return st;
+    }
+    fn(i0, i1, l0, buf.data());
+    if (out != NULL) {
+      st = pc_write(out, pc_offset_pair(N, q, l0), buf.data(), buf.size());
+      if (st != PC_OK) {
+        return st;
+      }
+    }
+    i0 = i1;
+  }
+  return PC_OK;
+}
+
+
+// name of the copy an update is written to
+inline std::string pc_temp_name(const char *filename)
+{
+  return std::string(filename) + ".tmp";
+}
+
+
+// put the copy `out` (complete) on disk and let it replace `filename`; `out`
+// is closed
+inline PairCountsStatus pc_commit(FILE *out, const char *filename)
+{
+  const std::string tmp = pc_temp_name(filename);
+#if defined(_WIN32)
+  bool isSynced = fflush(out) == 0 && _commit(_fileno(out)) == 0;
+#else
+  bool isSynced = fflush(out) == 0 && fsync(fileno(out)) == 0;
+#endif
+  isSynced = fclose(out) == 0 && isSynced;
+  if (!isSynced) {
+    return PC_ERR_IO;
+  }
+#if defined(_WIN32)
+  // `rename` does not replace an existing file on Windows
+  if (!MoveFileExA(tmp.c_str(), filename,
+    MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+  {
+    return PC_ERR_IO;
+  }
+#else
+  if (std::rename(tmp.c_str(), filename) != 0) {
+    return PC_ERR_IO;
+  }
+#endif
+  return PC_OK;
+}
+
+
+// add the B sequences of `MSA` (B-by-N, column-major, states in [1,q]) to the
+// counts of the pairs of rows [i0, i1); `block` starts at pair (i0, i0+1)
+inline void pc_add_rows(
+  uint32_t *block,
+  const uint8_t *MSA, uint64_t B, uint64_t N, uint64_t q,
+  uint64_t i0, uint64_t i1)
+{
+  uint32_t *c = block;
+  for (uint64_t i = i0; i < i1; i++) {
+    const uint8_t *datai = MSA + B*i;
+    for (uint64_t j = i+1; j < N; j++) {
+      const uint8_t *dataj = MSA + B*j;
+      for (uint64_t b = 0; b < B; b++) {
+        c[(datai[b]-1) + q*(dataj[b]-1)]++;
+      }
+      c += q*q;
+    }
+  }
+}
+
+
+// MI (bits, as `calc_MI.m`) of the pairs of rows [i0, i1) from their counts
+inline void pc_MI_rows(
+  double *MI,
+  const uint32_t *block, const uint32_t *site,
+  uint64_t B, uint64_t N, uint64_t q,
+  uint64_t i0, uint64_t i1)
+{
+  const double inv_B = 1.0 / double(B);
+  const uint32_t *c = block;
+  for (uint64_t i = i0; i < i1; i++) {
+    const uint32_t *ci = site + q*i;
+    for (uint64_t j = i+1; j < N; j++) {
+      const uint32_t *cj = site + q*j;
+      double I = 0.0;
+      for (uint64_t l = 0; l < q; l++) {
+        for (uint64_t k = 0; k < q; k++) {
+          const uint32_t n = c[k + q*l];
+          if (n > 0) {
+            // f_ij / (f_i f_j) = n B / (c_i c_j)
+            I += n * inv_B * log2(double(n) * double(B)
+              / (double(ci[k]) * double(cj[l])));
+          }
+        }
+      }
+      *MI++ = I;
+      c += q*q;
+    }
+  }
+}
+
+#endif // PAIR_COUNTS_HPP
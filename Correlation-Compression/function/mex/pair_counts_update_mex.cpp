@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * B_total = pair_counts_update_mex(filename, MSA, q, numThread)
+ *
+ *  filename   char      file of counts (see `pair_counts.hpp`), created with
+ *                       zero counts if it does not exist
+ *  MSA        uint8     B rows (new sequences), N columns, states in [1,q]
+ *  q          double    number of states, <= 256
+ *  numThread  double    number of native threads
+ *
+ *  B_total    number of sequences counted in the file after the update
+ *
+ * Only the new sequences are read; the counts are updated chunk by chunk into
+ * a copy which replaces the file at the end, so that the file holds either
+ * the old or the new counts, never a mix (an interrupted update can be
+ * repeated). The range of `MSA` is not checked here (see
+ * `CC_MSA_incremental`).
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v1.1  update written to a copy which replaces the file
+ * - 2018-05-02  v1
+ */
+
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "mex.h"
+#include "pair_counts.hpp"
+#include "../../../common/mex/thread_pool.hpp"
+
+static void pc_raise(PairCountsStatus st, const char *filename)
+{
+  switch (st) {
+    case PC_ERR_OPEN:
+      mexErrMsgIdAndTxt("pair_counts_update_mex:open",
+        "Can not open or create `%s`.", filename);
+      break;
+    case PC_ERR_FORMAT:
+      mexErrMsgIdAndTxt("pair_counts_update_mex:format",
+        "`%s` is not a file of pair counts.", filename);
+      break;
+    case PC_ERR_MISMATCH:
+      mexErrMsgIdAndTxt("pair_counts_update_mex:mismatch",
+        "N or q of `MSA` mismatches `%s`.", filename);
+      break;
+    case PC_ERR_OVERFLOW:
+      mexErrMsgIdAndTxt("pair_counts_update_mex:overflow",
+        "Counts of `%s` would exceed 2^32-1.", filename);
+      break;
+    case PC_ERR_IO:
+      mexErrMsgIdAndTxt("pair_counts_update_mex:io",
+        "Reading or writing `%s` failed.", filename);
+      break;
+    default:
+      break;
+  }
+}
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs > 1) {
+    mexErrMsgIdAndTxt(
+      "pair_counts_update_mex:nlhs",
+      "This function produces 1 output.");
+  }
+  if (nrhs != 4) {
+    mexErrMsgIdAndTxt(
+      "pair_counts_update_mex:nrhs",
+      "Number of arguments needed: 4\n"
+      "provided: %d", nrhs);
+  }
+
+  /* type check */
+  if (   !mxIsChar(prhs[0])
+      || !mxIsUint8(prhs[1])
+      || !mxIsDouble(prhs[2]) || mxGetNumberOfElements(prhs[2]) != 1
+      || !mxIsDouble(prhs[3]) || mxGetNumberOfElements(prhs[3]) != 1 )
+  {
+    mexErrMsgIdAndTxt(
+      "pair_counts_update_mex:prhs:WrongType",
+      "Requirement:\n"
+      "    char:    filename\n"
+      "   uint8:    MSA\n"
+      "  double:    q,  numThread (scalars)");
+  }
+
+  const size_t B = mxGetM(prhs[1]);
+  const size_t N = mxGetN(prhs[1]);
+  const size_t q = size_t(mxGetScalar(prhs[2]));
+  size_t numThread = size_t(mxGetScalar(prhs[3]));
+  if (q < 2 || q > 256) {
+    mexErrMsgIdAndTxt(
+      "pair_counts_update_mex:prhs:q",
+      "Requirement on q:\n"
+      "\tq >= 2 since 1-state case is trivial.\n"
+      "\tq <= 256 since data can only stores 0~255.\n");
+  }
+  if (N < 2) {
+    mexErrMsgIdAndTxt(
+      "pair_counts_update_mex:prhs:MSA",
+      "`MSA` should contain at least 2 loci.");
+  }
+  if (numThread < 1) {
+    numThread = 1;
+  }
+
+  char *filename = mxArrayToString(prhs[0]);
+  const uint8_t *MSA = (uint8_t *) mxGetData(prhs[1]);
+
+  FILE *fp = NULL;
+  PairCountsHeader hdr;
+  PairCountsStatus st = pc_open(&fp, &hdr, filename, N, q);
+  if (st == PC_OK && hdr.B + B > UINT32_MAX) {
+    st = PC_ERR_OVERFLOW;
+  }
+
+  /* the copy, with the header of the update */
+  const std::string tmpName = pc_temp_name(filename);
+  FILE *out = NULL;
+  if (st == PC_OK) {
+    out = fopen(tmpName.c_str(), "wb");
+    if (out == NULL) {
+      st = PC_ERR_OPEN;
+    }
+  }
+  if (st == PC_OK) {
+    hdr.B += B;
+    st = pc_write_header(out, hdr);
+  }
+
+  /* 1-point counts */
+  if (st == PC_OK) {
+    std::vector<uint32_t> site(q*N);
+    st = pc_read(fp, PC_OFFSET_SITE, site.data(), site.size());
+    if (st == PC_OK) {
+      for (size_t i = 0; i < N; i++) {
+        const uint8_t *datai = MSA + B*i;
+        for (size_t b = 0; b < B; b++) {
+          site[(datai[b]-1) + q*i]++;
+        }
+      }
+      st = pc_write(out, PC_OFFSET_SITE, site.data(), site.size());
+    }
+  }
+
+  /* 2-point counts, rows of a chunk in parallel */
+  if (st == PC_OK) {
+    ThreadPool pool(numThread);
+    st = pc_for_each_chunk(fp, out, N, q, uint64_t(1) << 22,
+      [&](uint64_t i0, uint64_t i1, uint64_t l0, uint32_t *block) {
+        pool.parallel_for(i1 - i0, 1, [&](size_t begin, size_t end, size_t) {
+          for (size_t i = i0 + begin; i < i0 + end; i++) {
+            pc_add_rows(block + q*q*(pc_pair_index(N, i) - l0),
+              MSA, B, N, q, i, i+1);
+          }
+        });
+      });
+  }
+
+  if (fp != NULL) {
+    fclose(fp);
+  }
+  if (st == PC_OK) {
+    st = pc_commit(out, filename);    // closes `out`
+  }
+  else if (out != NULL) {
+    fclose(out);
+  }
+  if (st != PC_OK) {
+    remove(tmpName.c_str());
+    pc_raise(st, filename);
+  }
+  mxFree(filename);
+
+  plhs[0] = mxCreateDoubleScalar(double(hdr.B));
+}
@@ -7,5 +7,30 @@ if exist('function/compiled', 'dir') ~= 7
 end
 
 fprintf('Compiling `calc_f2_w_mex_uint8.cpp` ...\n')
-mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
-  -outdir function/compiled function/mex/calc_f2_w_mex_uint8.cpp
+if isunix && ~ismac  % `shm_open` is in librt before glibc 2.34
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+    -outdir function/compiled function/mex/calc_f2_w_mex_uint8.cpp -lrt
+else
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+    -outdir function/compiled function/mex/calc_f2_w_mex_uint8.cpp
+end
+fprintf('Compiling `shm_msa_mex.cpp` ...\n')
+if isunix && ~ismac
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+    -outdir function/compiled ../common/mex/shm_msa_mex.cpp -lrt
+else
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+    -outdir function/compiled ../common/mex/shm_msa_mex.cpp
+end
+fprintf('Compiling `calc_MI_pairs_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+  LDFLAGS='$LDFLAGS -pthread' ...
+  -outdir function/compiled function/mex/calc_MI_pairs_mex.cpp
+fprintf('Compiling `pair_counts_update_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+  LDFLAGS='$LDFLAGS -pthread' ...
+  -outdir function/compiled function/mex/pair_counts_update_mex.cpp
+fprintf('Compiling `MI_from_counts_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+  LDFLAGS='$LDFLAGS -pthread' ...
+  -outdir function/compiled function/mex/MI_from_counts_mex.cpp
@@ -4,11 +4,33 @@
 % ===
 % See 'LICENSE.txt' in the outermost folder
 %
+% DESCRIPTION
+% ===
+% See `README.md`. With the optional `Symmetric = true` (default false), the
+% symmetric version of PLM (`PLM_L2_Sym`) is used instead of the asymmetric
+% one, and `numWorker` is the number of native threads. Fields of the
+% optional `extra` (struct) are set in the options of `minFunc` below, e.g.
+% `extra.Method = 'newton0'` or `extra.active` (see `PLM_L2_Asym`).
+%
 % HISTORY
 % ===
+% - 2018-05-10  v1.2
+%   - optional `extra`
+%
+% - 2018-05-06  v1.1
+%   - optional `Symmetric`
+%
 % - 2017-10-24  v1
 
-function table_i_j_score = PLM_DCA(S,N,B,q,weights,lambda,numWorker)
+function table_i_j_score = PLM_DCA(S,N,B,q,weights,lambda,numWorker,Symmetric, ...
+  extra)
+
+if nargin < 8
+  Symmetric = false;
+end
+if nargin < 9
+  extra = struct();
+end
 
 % search path
 addpath(genpath(pwd))
@@ -24,16 +46,29 @@ options.Method  = 'lbfgs';  % L-BFGS (2nd-order method)
 % number of corrections to store in memory, used to construct a approximation of
 % Hessian, more corrections result in faster convergence but use more memory
 options.Corr    = 100;      % (default: 100)
+names = fieldnames(extra);
+for k = 1:numel(names)
+  options.(names{k}) = extra.(names{k});
+end
 
-lambdas = [lambda lambda/2];  % Every J_{ij}(a,b) counts twice in the asymmetric version.
 skip = false;
-h_and_J = PLM_L2_Asym(S,N,B,q,weights,lambdas,skip,options,numWorker);
+if Symmetric
+  lambdas = [lambda lambda];  % J_{ij}(a,b) is shared by g_i and g_j.
+  [~, J] = PLM_L2_Sym(S,N,B,q,weights,lambdas,skip,options,numWorker);
+else
+  lambdas = [lambda lambda/2];  % Every J_{ij}(a,b) counts twice in the asymmetric version.
+  h_and_J = PLM_L2_Asym(S,N,B,q,weights,lambdas,skip,options,numWorker);
+end
 
 
 %% Scoring couplings
 fprintf('Scoring the coupling ...\n')
 timer = tic;
-table_i_j_score = score_coupling_L2_no_gap(h_and_J,q,N);
+if Symmetric
+  table_i_j_score = score_coupling_L2_no_gap_sym(J,q,N);
+else
+  table_i_j_score = score_coupling_L2_no_gap(h_and_J,q,N);
+end
 time = toc(timer);
 fprintf('\tFinished in %.2f s.\n', time);
 
@@ -0,0 +1,186 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `PLM_DCA` with adaptive per-node tolerance, for the case where only the top
+% `topK` couplings matter.
+%
+% Every node is first minimized loosely (`optTolLoose`). Since g_r is strongly
+% convex with modulus 2*min(lambdas), the distance between the parameters of
+% node r and the exact minimizer is at most
+%
+%   delta_r = norm(grad_r) / (2*min(lambdas))
+%
+% where grad_r is the gradient of g_r at the current point. The gauge
+% transformation and the score are non-expansive, thus the exact score of
+% (i,j) is within (delta_i + delta_j)/2 of the provisional score. Pairs whose
+% interval lies above the (K+1)-th largest upper bound are certainly in the
+% top K; those below the K-th largest lower bound are certainly not. Only the
+% endpoints of the remaining pairs are minimized further, with 10 times smaller
+% tolerance (warm start), until no pair is uncertain or `optTolTight` is
+% reached. Nodes whose couplings never approach the boundary are not polished.
+% (With lambda = 0 the bound is infinite and every node is refined.)
+%
+% INPUT
+% ===
+% Same as `PLM_DCA`, plus
+%
+% optTolLoose   tolerance of the first pass, e.g. 1e-3
+% optTolTight   smallest tolerance, e.g. 1e-5 (`optTol` of `PLM_DCA`)
+% topK          number of top-ranked couplings whose ranks should be settled
+%
+% OUTPUT
+% ===
+% `table_i_j_score`: same as `PLM_DCA`.
+% `optTol_node`: 1-by-N, final tolerance of every node.
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1.1
+%   - check `lambda` and `topK`; no NaN bound for a zero gradient with
+%     lambda = 0
+%
+% - 2018-04-27  v1
+
+function [table_i_j_score, optTol_node] = PLM_DCA_adaptive(S,N,B,q,weights, ...
+  lambda,numWorker,optTolLoose,optTolTight,topK)
+
+%% check with little overhead
+if ~isscalar(lambda) || ~(lambda >= 0)
+  error('lambda should be a non-negative scalar.')
+end
+if ~isscalar(topK) || ~(topK >= 1) || topK ~= floor(topK)
+  error('`topK` should be a positive integer.')
+end
+
+% search path
+addpath(genpath(pwd))
+
+
+%% PLM
+% see `PLM_DCA.m`
+options.Display = 'off';
+options.progTol = -0;
+options.optTol  = optTolLoose;
+options.useMEX  = true;
+options.Method  = 'lbfgs';
+options.Corr    = 100;
+
+lambdas = [lambda lambda/2];  % see `PLM_DCA.m`
+skip = false;
+
+% If no pool exists, a new one is created when necessary
+if numWorker > 1
+  poolobj = gcp('nocreate');
+  if isempty(poolobj)
+    parpool(numWorker);
+  end
+end
+
+B_eff = sum(weights);
+P = q + q*q*(N-1);
+h_and_J = zeros(P, N);      % raw parameters, warm start of later passes
+delta = zeros(1, N);        % bound on the distance to the minimizer
+optTol_node = optTolLoose*ones(1, N);
+mu = 2*min(lambdas);        % modulus of strong convexity
+
+rlist = 1:N;
+optTol = optTolLoose;
+pass = 1;
+while true
+  fprintf('Performing L2-regularized PLM, pass %d: %d nodes, optTol = %g ...\n', ...
+    pass, numel(rlist), optTol)
+  timer = tic;
+
+  options.optTol = optTol;
+  h_and_J_sub = h_and_J(:, rlist);
+  gnorm_sub = zeros(1, numel(rlist));
+  if numWorker > 1
+    parfor (t = 1:numel(rlist), numWorker)
+      [h_and_J_sub(:,t), gnorm_sub(t)] = min_node(S,N,B,q,weights,B_eff, ...
+        rlist(t),lambdas,skip,options,h_and_J_sub(:,t));
+    end
+  else
+    for t = 1:numel(rlist)
+      [h_and_J_sub(:,t), gnorm_sub(t)] = min_node(S,N,B,q,weights,B_eff, ...
+        rlist(t),lambdas,skip,options,h_and_J_sub(:,t));
+    end
+  end
+  h_and_J(:, rlist) = h_and_J_sub;
+  delta(rlist) = gnorm_sub / mu;   % Inf for lambda = 0, unless at the minimizer
+  delta(rlist(gnorm_sub == 0)) = 0;
+  optTol_node(rlist) = optTol;
+
+  fprintf('\tFinished in %.2f s.\n', toc(timer));
+
+
+  %% provisional scores and nodes near the top-K boundary
+  table_i_j_score = score_Ising(h_and_J, q, N, numWorker);
+  if optTol <= optTolTight
+    break
+  end
+
+  i = table_i_j_score(1,:);
+  j = table_i_j_score(2,:);
+  err = (delta(i) + delta(j)) / 2;
+  lb = table_i_j_score(3,:) - err;
+  ub = table_i_j_score(3,:) + err;
+
+  K = min(topK, numel(lb));
+  lb_sort = sort(lb, 'descend');
+  ub_sort = sort(ub, 'descend');
+  theta_lo = lb_sort(K);
+  if K < numel(ub)
+    theta_hi = ub_sort(K+1);
+  else
+    theta_hi = -Inf;
+  end
+  isUncertain = ub >= theta_lo & lb <= theta_hi;
+
+  rlist = unique([i(isUncertain), j(isUncertain)]);
+  fprintf('\t%d pairs near the top-%d boundary, %d nodes to refine\n', ...
+    nnz(isUncertain), K, numel(rlist))
+  if isempty(rlist)
+    break
+  end
+
+  optTol = max(optTol/10, optTolTight);
+  pass = pass + 1;
+end
+
+
+end
+
+
+%% minimize g_r from `wr0`, return the 2-norm of the gradient at the result
+function [r_h_and_J, gnorm] = min_node(S,N,B,q,weights,B_eff,r,lambdas,skip, ...
+  options,wr0)
+
+r_h_and_J = min_g_r(S,uint64(N),uint64(B),uint64(q),weights,B_eff,uint64(r), ...
+  lambdas,skip,options,wr0);
+[~, grad] = g_r_mex_v2(S,uint64(N),uint64(B),uint64(q),weights,B_eff, ...
+  uint64(r),r_h_and_J,lambdas,'SkipCheckFlag');
+gnorm = norm(grad);
+
+end
+
+
+%% gauge a copy of the raw parameters and score
+function table_i_j_score = score_Ising(h_and_J, q, N, numWorker)
+
+if numWorker > 1
+  parfor (r = 1:N, numWorker)
+    h_and_J(:,r) = gauge_shift_Ising(h_and_J(:,r), q, N);
+  end
+else
+  for r = 1:N
+    h_and_J(:,r) = gauge_shift_Ising(h_and_J(:,r), q, N);
+  end
+end
+table_i_j_score = score_coupling_L2_no_gap(h_and_J,q,N);
+
+end
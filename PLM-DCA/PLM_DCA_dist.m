@@ -0,0 +1,72 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `PLM_DCA` out of core: `S` is written to `[filePrefix '-MSA.bin']`
+% (`write_MSA_bin`), nodes are minimized by `numWorker` local worker processes
+% of `PLM_L2_Asym_dist` and written to `[filePrefix '-h_and_J.bin']` as they
+% are done, and couplings are scored from that file
+% (`score_coupling_L2_no_gap_dist`). No process holds the whole `h_and_J`;
+% a rerun with the same `filePrefix` resumes. An existing `parpool` is not
+% used. POSIX only.
+%
+% `Method` (optional, default 'lbfgs') is `options.Method`; 'newton0' keeps no
+% L-BFGS history (see `PLM_L2_Asym`).
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1
+
+function table_i_j_score = PLM_DCA_dist(S,N,B,q,weights,lambda,numWorker, ...
+  filePrefix,Method)
+
+if nargin < 9
+  Method = 'lbfgs';
+end
+if ~isunix
+  error('`PLM_DCA_dist` needs POSIX (Unix socket and shared files).')
+end
+if numel(weights) ~= B
+  error('weights should contains B numbers.')
+end
+
+% search path
+addpath(genpath(pwd))
+
+
+%% PLM
+% see `PLM_DCA.m`
+options.Display = 'off';
+options.progTol = -0;
+options.optTol  = 1e-5;
+options.useMEX  = true;
+options.Method  = Method;
+options.Corr    = 100;
+
+skip = false;
+lambdas = [lambda lambda/2];  % Every J_{ij}(a,b) counts twice in the asymmetric version.
+
+msaFile = [filePrefix '-MSA.bin'];
+outFile = [filePrefix '-h_and_J.bin'];
+write_MSA_bin(msaFile, S, q);
+
+address = ['unix://' tempname];
+rangeSize = 16;
+timeout = 600;
+PLM_L2_Asym_dist(msaFile,weights,lambdas,skip,options, ...
+  address,outFile,numWorker,rangeSize,timeout);
+
+
+%% Scoring couplings
+fprintf('Scoring the coupling ...\n')
+timer = tic;
+table_i_j_score = score_coupling_L2_no_gap_dist(outFile,q,N);
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+end
@@ -31,9 +31,22 @@
 % My test suggest that it is acceptable that `optTol=1e-3` but not further
 % relaxed. (For small system, default value of `optTol` is 1e-5.)
 %
+% On POSIX systems, the progress of PLM (nodes done, ETA, nodes which are stuck
+% or divergent) is written to `[filePrefix '-opt_<optTolNew>-status.txt']` in
+% `PLM_out_path` while it runs (see `PLM_L2_Asym_file`), and the result of
+% every node is checkpointed in the background to segment files
+% `[filePrefix '-opt_<optTolNew>--ckpt-*']` (see `ckpt_mex`); MAT-files of
+% earlier runs are still loaded.
+%
 %
 % HISTORY
 % ===
+% - 2018-05-10  v1.3
+%   - checkpoints by `ckpt_mex` on POSIX systems
+%
+% - 2018-05-10  v1.2
+%   - status file of PLM
+%
 % - 2017-11-17  v1.1
 %   - PLM_L2_Asym_resume -> PLM_L2_Asym_file
 %
@@ -63,8 +76,12 @@ LoadIP = true;
 SaveFP = true;
 filePrefixLoad = sprintf('%s-opt_%g',filePrefix,optTolOld);
 filePrefixSave = sprintf('%s-opt_%g',filePrefix,optTolNew);
+statusFile = '';
+if isunix
+  statusFile = fullfile(PLM_out_path, [filePrefixSave '-status.txt']);
+end
 h_and_J = PLM_L2_Asym_file(S,N,B,q,weights,lambdas,skip,options,numWorker, ...
-  LoadIP,SaveFP,PLM_out_path,filePrefixLoad,filePrefixSave);
+  LoadIP,SaveFP,PLM_out_path,filePrefixLoad,filePrefixSave,statusFile);
 
 
 %% Scoring couplings
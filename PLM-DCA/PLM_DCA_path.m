@@ -0,0 +1,55 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `PLM_DCA` for several values of lambda in one run (regularization path,
+% see `PLM_L2_Asym_path`).
+%
+% OUTPUT
+% ===
+% `table_i_j_score` is a (2+L)-by-N(N-1)/2 matrix. In each column, the first
+% two elements are the coupling's endpoints (1-based) and element 2+l is the
+% score for lambda_list(l).
+%
+% HISTORY
+% ===
+% - 2018-04-19  v1
+
+function table_i_j_score = PLM_DCA_path(S,N,B,q,weights,lambda_list,numWorker)
+
+% search path
+addpath(genpath(pwd))
+
+
+%% PLM
+% see `PLM_DCA.m`
+options.Display = 'off';
+options.progTol = -0;
+options.optTol  = 1e-5;
+options.useMEX  = true;
+options.Method  = 'lbfgs';
+options.Corr    = 100;
+
+skip = false;
+h_and_J = PLM_L2_Asym_path(S,N,B,q,weights,lambda_list,skip,options,numWorker);
+
+
+%% Scoring couplings
+fprintf('Scoring the coupling ...\n')
+timer = tic;
+L = numel(lambda_list);
+table_i_j_score = zeros(2+L, N*(N-1)/2);
+for l = 1:L
+  table_l = score_coupling_L2_no_gap(h_and_J(:,:,l),q,N);
+  table_i_j_score(2+l,:) = table_l(3,:);
+end
+table_i_j_score(1:2,:) = table_l(1:2,:);
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+end
@@ -0,0 +1,53 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `PLM_DCA` with per-site alphabets: every site keeps only the states observed
+% on it (`remap_states`), and PLM is performed on the packed parameters
+% (`PLM_L2_Asym_var`). Input and output are the same as `PLM_DCA`; the gap state
+% should be mapped to 0.
+%
+% HISTORY
+% ===
+% - 2018-04-09  v1
+
+function table_i_j_score = PLM_DCA_var(S,N,B,q,weights,lambda,numWorker)
+
+% search path
+addpath(genpath(pwd))
+
+
+%% per-site alphabets
+[S_loc, qlist, present] = remap_states(S, q);
+fprintf('Parameters per node: %d (per-site q) instead of %d\n', ...
+  round(mean(qlist .* (1 + sum(qlist) - qlist))), q + q*q*(N-1));
+
+
+%% PLM
+% see `PLM_DCA.m`
+options.Display = 'off';
+options.progTol = -0;
+options.optTol  = 1e-5;
+options.useMEX  = true;
+options.Method  = 'lbfgs';
+options.Corr    = 100;
+
+lambdas = [lambda lambda/2];  % Every J_{ij}(a,b) counts twice in the asymmetric version.
+skip = false;
+h_and_J = PLM_L2_Asym_var(S_loc,N,B,double(qlist),weights,lambdas,skip, ...
+  options,numWorker);
+
+
+%% Scoring couplings
+fprintf('Scoring the coupling ...\n')
+timer = tic;
+table_i_j_score = score_coupling_L2_no_gap_var(h_and_J,qlist,present(1,:));
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+end
@@ -19,15 +19,38 @@
 % weights     [0,1]  sequences can be weigted
 % lambdas     [lambda_h lambda_J]
 % skip        non-zero to skip built-in check of `g_r_mex_v2`
-% options     passed to `minFunc`
+% options     passed to `minFunc`; with `options.useStats = true`, each node
+%             is minimized on its sufficient statistics (`min_g_r_stats`);
+%             with `options.Method = 'newton0'`, by truncated Newton with exact
+%             Hessian-vector products (`min_g_r_newton`); with an N-by-N
+%             logical `options.active`, on the active couplings first and
+%             checked against the full gradient at the end (`min_g_r_act`)
 % numWorker   number of workers used in parfor
 %
 % OUTPUT
 % ===
 % h_and_J(:,r) represents [h_r(:); J_r(:)], where h_r and J_r are in Ising gauge
 %
+% With numWorker > 1 (on Linux and macOS), `min_g_r` workers read `S` from
+% shared memory (see `shm_msa_mex`) instead of a copy each.
+%
 % HISTORY
 % ===
+% - 2018-05-10  v2.6
+%   - every node gets only its column of `options.active`
+%
+% - 2018-05-08  v2.5
+%   - workers of `min_g_r` read `S` from shared memory
+%
+% - 2018-04-25  v2.4
+%   - add `options.active`
+%
+% - 2018-04-16  v2.3
+%   - 'newton0' uses `min_g_r_newton`
+%
+% - 2018-04-05  v2.2
+%   - add `options.useStats`
+%
 % - 2017-11-16  v2.1
 %   - add check for limitation
 %
@@ -84,6 +107,12 @@ if options.useMEX && strcmp(options.Method, 'lbfgs') ...
   error('Limitation is reached; extra work needed; see `README.md`.')
 end
 
+% active set of couplings
+if isfield(options, 'active') ...
+    && (~islogical(options.active) || ~isequal(size(options.active), [N N]))
+  error('`options.active` should be a N-by-N logical matrix.')
+end
+
 
 %% check with acceptable overhead
 
@@ -121,22 +150,48 @@ end
 B_eff = sum(weights);
 h_and_J = zeros(q + q*q*(N-1), N);
 
+if strcmp(options.Method, 'newton0')
+  min_node = @min_g_r_newton;
+elseif isfield(options, 'active')
+  min_node = @min_g_r_act;
+elseif isfield(options, 'useStats') && options.useStats
+  min_node = @min_g_r_stats;
+else
+  min_node = @min_g_r;
+end
+
+% every node gets only its own column of `options.active` (sliced in parfor)
+% instead of every worker a copy of the N-by-N matrix
+if isfield(options, 'active')
+  active = options.active;
+  options = rmfield(options, 'active');
+else
+  active = false(0, N);
+end
+
 
 %% PLM
 fprintf('Performing L2-regularized PLM (asymmetric version) ...\n')
 timer = tic;
 
 if numWorker > 1
+  % a handle of `S` in shared memory is sent instead of `S` (`g_r_mex_v2`)
+  S_ref = S;
+  if isunix && isequal(min_node, @min_g_r)
+    S_ref = shm_msa_mex('create', S);
+    cleanupObj = onCleanup(@() shm_msa_mex('free', S_ref));
+  end
   parfor (r = 1:N, numWorker)
-    h_and_J(:,r) = min_g_r( ...
-      S, uint64(N),uint64(B),uint64(q), ...
-      weights,B_eff,uint64(r),lambdas,skip,options);
+    h_and_J(:,r) = min_node( ...
+      S_ref, uint64(N),uint64(B),uint64(q), ...
+      weights,B_eff,uint64(r),lambdas,skip,node_options(options, active(:,r)));
   end
+  clear cleanupObj
 else
   for r = 1:N
-    h_and_J(:,r) = min_g_r( ...
+    h_and_J(:,r) = min_node( ...
       S, uint64(N),uint64(B),uint64(q), ...
-      weights,B_eff,uint64(r),lambdas,skip,options);
+      weights,B_eff,uint64(r),lambdas,skip,node_options(options, active(:,r)));
   end
 end
 
@@ -163,3 +218,12 @@ fprintf('\tFinished in %.2f s.\n', time);
 
 
 end
+
+
+function options = node_options(options, active_r)
+% `options` of node r, with its column of `options.active` if any
+if ~isempty(active_r)
+  options.active = active_r;
+end
+
+end
@@ -0,0 +1,164 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `PLM_L2_Asym` in coordinator/worker mode, for systems too large for one
+% `parpool` on one host, without MATLAB Distributed Computing Server.
+%
+% The calling MATLAB session is the coordinator (`dist_coord_mex`): it holds
+% neither `S` nor `h_and_J`. Workers are separate MATLAB processes running
+% `PLM_worker(address)`, on this host or on others, connected by TCP
+% (`tcp://host:port`) or by a Unix socket (`unix:///path`, this host only).
+% Every worker
+%
+%   1. loads the job specification `[outFile '.spec.mat']` (weights, lambdas,
+%      options, the binary MSA file `msaFile`); with `min_g_r` (L-BFGS), the
+%      MSA file (`write_MSA_bin`) is mapped read-only by `g_r_mex_v2` and
+%      shared by the workers of a host, otherwise each worker reads a copy;
+%   2. pulls ranges of `rangeSize` nodes, minimizes every node of the range
+%      (as `PLM_L2_Asym`), shifts it to Ising gauge and streams it back;
+%   3. sends heartbeats from a native thread while it computes.
+%
+% A worker which disconnects, or sends nothing for `timeout` seconds, is
+% considered lost and its unfinished nodes are handed to other workers. Every
+% node is written to `outFile` (see `dist_protocol.hpp`) as soon as it
+% arrives; calling this function again with the same `outFile` resumes.
+% `msaFile`, `outFile` and the specification must be reachable at the same
+% path by every worker (shared file system).
+%
+% INPUT
+% ===
+% msaFile         MSA in the native binary format (`write_MSA_bin`), gap as 0
+% weights         [0,1], B numbers
+% lambdas         [lambda_h lambda_J]
+% skip            non-zero to skip built-in check of `g_r_mex_v2`
+% options         passed to `minFunc` (same choices as `PLM_L2_Asym`)
+% address         e.g. 'tcp://*:47000' (all interfaces) or 'unix:///tmp/plm'
+% outFile         result file
+% numLocalWorker  number of worker processes started on this host (0 if
+%                 workers are started by hand: `matlab -r "PLM_worker(...)"`);
+%                 they connect to `localhost` when `address` listens on all
+%                 interfaces
+% rangeSize       number of nodes per request, e.g. 16
+% timeout         seconds, e.g. 600 (at least a few heartbeats, see
+%                 `PLM_worker`); the coordinator also gives up when no worker
+%                 has been connected for `timeout` seconds
+% maxTime         (optional) seconds after which the coordinator gives up,
+%                 default Inf (Ctrl-C does not stop it)
+%
+% OUTPUT
+% ===
+% h_and_J (optional): as `PLM_L2_Asym`, read from `outFile`; for large systems
+% call without output and use `score_coupling_L2_no_gap_dist`.
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1.1
+%   - local workers connect to `localhost` for a listening address `*`
+%   - optional `maxTime`; the coordinator gives up without workers
+%   - workers map the MSA file with `min_g_r`
+%
+% - 2018-05-07  v1
+
+function h_and_J = PLM_L2_Asym_dist(msaFile,weights,lambdas,skip,options, ...
+  address,outFile,numLocalWorker,rangeSize,timeout,maxTime)
+
+if nargin ~= 10 && nargin ~= 11
+  error('Not enough input arguments.')
+end
+if nargin < 11
+  maxTime = Inf;
+end
+
+%% check with very little overhead
+if ~ischar(msaFile) || ~ischar(address) || ~ischar(outFile)
+  error('`msaFile`, `address` and `outFile` should be char vectors.')
+end
+
+fid = fopen(msaFile, 'r', 'l');
+if fid < 0
+  error('Could not open `%s` for reading.', msaFile)
+end
+magic = fread(fid, [1 8], 'char*1=>char');
+fread(fid, 1, 'uint32');
+q = fread(fid, 1, 'uint32');
+N = fread(fid, 1, 'uint64');
+B = fread(fid, 1, 'uint64');
+fclose(fid);
+if ~strcmp(magic, 'CCPLMMSA')
+  error('`%s` is not a MSA in the native binary format.', msaFile)
+end
+
+if numel(weights) ~= B
+  error('weights should contains B numbers.')
+end
+if any(weights(:) < 0 | weights(:) > 1)
+  error('`weights` may not exceeds [0,1].')
+end
+if q > 256
+  error('At most 256 states are supported.')
+end
+P = q + q*q*(N-1);
+if options.useMEX && strcmp(options.Method, 'lbfgs') ...
+    && options.Corr*P >= 2^31
+  error('Limitation is reached; extra work needed; see `README.md`.')
+end
+
+
+%% search path
+
+if exist('dist_coord_mex', 'file') ~= 3
+  addpath(genpath(pwd))
+end
+
+
+%% job specification, read by every worker
+specFile = [outFile '.spec.mat'];
+weights = weights(:);
+save(specFile, 'msaFile', 'weights', 'lambdas', 'skip', 'options', ...
+  'N', 'B', 'q', '-v7.3')
+
+
+%% local workers
+% a listening host (`*`, empty or 0.0.0.0) is no address to connect to
+localAddress = regexprep(address, '^tcp://(\*|0\.0\.0\.0)?:', ...
+  'tcp://localhost:');
+here = fileparts(mfilename('fullpath'));
+for k = 1:numLocalWorker
+  logFile = sprintf('%s.worker-%d.log', outFile, k);
+  cmd = sprintf(['"%s" -nodisplay -nosplash -nodesktop -r ' ...
+    '"cd(''%s''); try, PLM_worker(''%s''); catch e, disp(getReport(e)); end; exit" ' ...
+    '> "%s" 2>&1 &'], ...
+    fullfile(matlabroot, 'bin', 'matlab'), here, localAddress, logFile);
+  system(cmd);
+end
+
+
+%% PLM
+fprintf('Performing L2-regularized PLM (asymmetric version, distributed) ...\n')
+timer = tic;
+
+numDone = dist_coord_mex(address, specFile, outFile, N, P, rangeSize, ...
+  timeout, maxTime);
+if numDone ~= N
+  error(['Only %d of %d nodes are done; call again with the same ' ...
+    '`outFile` to resume.'], numDone, N)
+end
+
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+%% read the result (already in Ising gauge)
+if nargout > 0
+  offset = 64 + ceil(N/8)*8;
+  m = memmapfile(outFile, 'Offset', offset, 'Format', {'double', [P N], 'x'}, ...
+    'Repeat', 1);
+  h_and_J = m.Data.x;
+end
+
+end
@@ -21,13 +21,41 @@
 % skip        non-zero to skip built-in check of `g_r_mex_v2`
 % options     passed to `minFunc`
 % numWorker   number of workers used in parfor
+% statusFile  (optional) live state of the nodes is written to this file
 %
 % OUTPUT
 % ===
 % h_and_J(:,r) represents [h_r(:); J_r(:)], where h_r and J_r are in Ising gauge
 %
+% On Linux and macOS, the result of every node is checkpointed by
+% `min_g_r_ckpt` (`ckpt_mex`, written from a background thread, flushed at the
+% end of the PLM stage) instead of one `save` per node by `min_g_r_file`, so
+% that `parfor` never waits on the file system. MAT-files of earlier runs are
+% still loaded as initial points.
+%
+% With numWorker > 1 (on Linux and macOS), `S` is copied once into shared
+% memory and `parfor` sends its handle to the workers instead (see
+% `shm_msa_mex`), so that the memory of the workers does not grow with `S`.
+%
+% With `statusFile` (POSIX only), every worker reports its node and each
+% iteration of `minFunc` to shared memory, and a native thread of the client
+% rewrites `statusFile` every 10 s: nodes done and in flight, iteration and
+% max |g| of every node in flight, evaluations per second, ETA, and nodes
+% which are stuck (no iteration for 10 min), divergent or lost (see
+% `telemetry_mex`). Watch it with e.g. `watch cat statusFile`.
+%
 % HISTORY
 % ===
+% - 2018-05-10  v5
+%   - checkpoints by `min_g_r_ckpt` on POSIX systems (replaces
+%     `PLM_L2_Asym_ckpt`)
+%
+% - 2018-05-10  v4
+%   - optional `statusFile`
+%
+% - 2018-05-08  v3
+%   - workers read `S` from shared memory
+%
 % - 2017-11-16  v2
 %   - change `min_g_r_resume` to `min_g_r_file`
 %   - add check for limitation (as `PLM_L2_Asym`)
@@ -36,11 +64,14 @@
 %   - adapted from `PLM_L2_Asym.m`
 
 function h_and_J = PLM_L2_Asym_file(S,N,B,q,weights,lambdas,skip,options,numWorker, ...
-  LoadIP,SaveFP,filePath,filePrefixLoad,filePrefixSave)
+  LoadIP,SaveFP,filePath,filePrefixLoad,filePrefixSave,statusFile)
 
-if nargin ~= 14
+if nargin ~= 14 && nargin ~= 15
   error('Not enough input arguments.')
 end
+if nargin < 15
+  statusFile = '';
+end
 
 %% check with very little overhead
 % type
@@ -117,24 +148,67 @@ end
 B_eff = sum(weights);
 h_and_J = zeros(q + q*q*(N-1), N);
 
+% checkpoints in the background where `ckpt_mex` is available
+min_g_r_fun = @min_g_r_file;
+if isunix
+  min_g_r_fun = @min_g_r_ckpt;
+  flush_ckpt(numWorker);  % drop indexes of checkpoints cached by a previous run
+end
+
 
 %% PLM
 fprintf('Performing L2-regularized PLM (asymmetric version) ...\n')
 timer = tic;
 
+% live state of the nodes (`telemetry_mex`)
+tele = '';
+if ~isempty(statusFile)
+  try
+    tele = telemetry_mex('start', statusFile, N);
+    teleCleanupObj = onCleanup(@() telemetry_mex('stop', tele));
+    fprintf('\tProgress is written to `%s`.\n', statusFile);
+  catch err
+    warning('PLM_L2_Asym_file:telemetry', 'No telemetry: %s', err.message)
+  end
+end
+
 if numWorker > 1
+  % a handle of `S` in shared memory is sent instead of `S`
+  S_ref = S;
+  if isunix
+    S_ref = shm_msa_mex('create', S);
+    cleanupObj = onCleanup(@() shm_msa_mex('free', S_ref));
+  end
   parfor (r = 1:N, numWorker)
-    h_and_J(:,r) = min_g_r_file( ...
-      S, uint64(N),uint64(B),uint64(q),weights,B_eff,uint64(r),lambdas,skip,options, ...
+    options_r = telemetry_options(options, tele, r);
+    h_and_J(:,r) = min_g_r_fun( ...
+      S_ref, uint64(N),uint64(B),uint64(q),weights,B_eff,uint64(r),lambdas,skip,options_r, ...
       LoadIP,SaveFP,filePath,filePrefixLoad,filePrefixSave);
+    if ~isempty(tele)
+      telemetry_mex('end', tele);
+    end
   end
+  clear cleanupObj
 else
   for r = 1:N
-    h_and_J(:,r) = min_g_r_file( ...
-      S, uint64(N),uint64(B),uint64(q),weights,B_eff,uint64(r),lambdas,skip,options, ...
+    options_r = telemetry_options(options, tele, r);
+    h_and_J(:,r) = min_g_r_fun( ...
+      S, uint64(N),uint64(B),uint64(q),weights,B_eff,uint64(r),lambdas,skip,options_r, ...
       LoadIP,SaveFP,filePath,filePrefixLoad,filePrefixSave);
+    if ~isempty(tele)
+      telemetry_mex('end', tele);
+    end
+  end
+end
+
+% stage boundary: all checkpoints on disk
+if isunix
+  if SaveFP
+    fprintf('\tFlushing checkpoints ...\n');
   end
+  flush_ckpt(numWorker);
 end
+clear teleCleanupObj  % the status file is written a last time
 
 time = toc(timer);
 fprintf('\tFinished in %.2f s.\n', time);
@@ -0,0 +1,163 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `PLM_L2_Asym` along a regularization path. Every node is minimized for all
+% lambdas in `lambda_list`, from the strongest to the weakest, each warm-started
+% from the previous solution (`min_g_r_path`). Data are checked and sent to the
+% workers once for the whole path.
+%
+% As in `PLM_DCA`, lambda_h = lambda and lambda_J = lambda/2 for every lambda.
+% The output needs L times the memory of `PLM_L2_Asym`.
+%
+% INPUT
+% ===
+% Same as `PLM_L2_Asym`, except that `lambda_list` (L elements, any order)
+% replaces `lambdas`.
+%
+% OUTPUT
+% ===
+% h_and_J(:,r,l) represents [h_r(:); J_r(:)] for lambda_list(l), in Ising gauge
+%
+% HISTORY
+% ===
+% - 2018-04-19  v1
+%   - adapted from `PLM_L2_Asym.m`
+
+function h_and_J = PLM_L2_Asym_path(S,N,B,q,weights,lambda_list,skip,options, ...
+  numWorker)
+
+if nargin ~= 9
+  error('Not enough input arguments.')
+end
+
+%% check with very little overhead
+% type
+if ~isa(S,'uint8') ...
+    || ~isa(N, 'double') || ~isa(B, 'double') || ~isa(q, 'double') ...
+    || ~isa(weights, 'double') || ~isa(lambda_list, 'double') ...
+    || ~isa(numWorker, 'double')
+  error(...
+    ['%s:\n' ...
+    '   uint8:    S\n' ...
+    '  double:    N, B, q, weights, lambda_list, numWorker'], ...
+    'Requirement on type');
+end
+
+% orientation of S
+if size(S,1) ~= N || size(S,2) ~= B
+  error('`S` should be a N-by-B matrix.')
+end
+
+% dimension of weights
+if numel(weights) ~= B
+  error('weights should contains B numbers.')
+end
+
+% check whether N/B/q is a integer
+if round(N) ~= N || round(B) ~= B || round(q) ~= q ...
+    || round(numWorker) ~= numWorker
+  error('N, B, q and numWorker should be integers.')
+end
+
+% lambda_list
+if isempty(lambda_list) || any(lambda_list < 0)
+  error('`lambda_list` should contain non-negative numbers.')
+end
+
+% check if limitation is reached
+if q > 256
+  error('At most 256 states are supported.')
+end
+if options.useMEX && strcmp(options.Method, 'lbfgs') ...
+    && options.Corr*(q + q*q*(N-1)) >= 2^31
+  error('Limitation is reached; extra work needed; see `README.md`.')
+end
+
+
+%% check with acceptable overhead
+
+% range of S
+if double(max(S(:))) > q-1
+  error('q possible states should be mapped to integers in [0,q-1].')
+end
+
+% range of weights
+if any(weights < 0 | weights > 1)
+  error('`weights` may not exceeds [0,1].')
+end
+
+
+%% search path
+
+if exist('min_g_r_path', 'file') ~= 2
+  addpath(genpath(pwd))
+end
+
+
+%% real work
+
+% If no pool exists, a new one is created when necessary
+if numWorker > 1
+  poolobj = gcp('nocreate');
+  if isempty(poolobj)
+    parpool(numWorker);
+  end
+end
+
+
+B_eff = sum(weights);
+P = q + q*q*(N-1);
+L = numel(lambda_list);
+h_and_J = zeros(P, N, L);
+
+
+%% PLM
+fprintf('Performing L2-regularized PLM (asymmetric version) for %d lambdas ...\n', L)
+timer = tic;
+
+if numWorker > 1
+  parfor (r = 1:N, numWorker)
+    h_and_J(:,r,:) = reshape(min_g_r_path( ...
+      S, uint64(N),uint64(B),uint64(q), ...
+      weights,B_eff,uint64(r),lambda_list,skip,options), [P 1 L]);
+  end
+else
+  for r = 1:N
+    h_and_J(:,r,:) = reshape(min_g_r_path( ...
+      S, uint64(N),uint64(B),uint64(q), ...
+      weights,B_eff,uint64(r),lambda_list,skip,options), [P 1 L]);
+  end
+end
+
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+%% Gauge Transformation
+fprintf('Shifting parameters of Potts model to Ising gauge ...\n');
+timer = tic;
+
+for l = 1:L
+  h_and_J_l = h_and_J(:,:,l);
+  if numWorker > 1
+    parfor (r = 1:N, numWorker)
+      h_and_J_l(:,r) = gauge_shift_Ising(h_and_J_l(:,r), q, N);
+    end
+  else
+    for r = 1:N
+      h_and_J_l(:,r) = gauge_shift_Ising(h_and_J_l(:,r), q, N);
+    end
+  end
+  h_and_J(:,:,l) = h_and_J_l;
+end
+
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+end
@@ -0,0 +1,166 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Same as `PLM_L2_Asym`, but nodes are optimized in tiles of `tileSize` nodes:
+% the objectives and gradients of all nodes of a tile are evaluated in one
+% sweep over `S` by `g_R_mex` (see `min_g_R`). This divides the number of full
+% reads of the MSA per L-BFGS iteration by `tileSize`, which pays off when `S`
+% does not fit in cache (large B). The price is that nodes of a tile share
+% line searches and stop together.
+%
+% INPUT
+% ===
+% Same as `PLM_L2_Asym`, plus
+%
+% tileSize    number of nodes optimized together (e.g. 4 to 16)
+%
+% OUTPUT
+% ===
+% h_and_J(:,r) represents [h_r(:); J_r(:)], where h_r and J_r are in Ising gauge
+%
+% HISTORY
+% ===
+% - 2018-03-28  v1
+%   - adapted from `PLM_L2_Asym.m`
+
+function h_and_J = PLM_L2_Asym_tile(S,N,B,q,weights,lambdas,skip,options,numWorker, ...
+  tileSize)
+
+if nargin ~= 10
+  error('Not enough input arguments.')
+end
+
+%% check with very little overhead
+% type
+if ~isa(S,'uint8') ...
+    || ~isa(N, 'double') || ~isa(B, 'double') || ~isa(q, 'double') ...
+    || ~isa(weights, 'double') || ~isa(lambdas, 'double') ...
+    || ~isa(numWorker, 'double') || ~isa(tileSize, 'double')
+  error(...
+    ['%s:\n' ...
+    '   uint8:    S\n' ...
+    '  double:    N, B, q, r, weights, lambdas, numWorker, tileSize'], ...
+    'Requirement on type');
+end
+
+% orientation of S
+if size(S,1) ~= N || size(S,2) ~= B
+  error('`S` should be a N-by-B matrix.')
+end
+
+% dimension of weights
+if numel(weights) ~= B
+  error('weights should contains B numbers.')
+end
+
+% check whether N/B/q is a integer
+if round(N) ~= N || round(B) ~= B || round(q) ~= q ...
+    || round(numWorker) ~= numWorker || round(tileSize) ~= tileSize ...
+    || tileSize < 1
+  error('N, B, q, numWorker and tileSize should be (positive) integers.')
+end
+
+% check if limitation is reached
+if q > 256
+  error('At most 256 states are supported.')
+end
+if options.useMEX && strcmp(options.Method, 'lbfgs') ...
+    && options.Corr*tileSize*(q + q*q*(N-1)) >= 2^31
+  error('Limitation is reached; use a smaller `tileSize`; see `README.md`.')
+end
+
+
+%% check with acceptable overhead
+
+% range of S
+if double(max(S(:))) > q-1
+  error('q possible states should be mapped to integers in [0,q-1].')
+end
+
+% range of weights
+for b = 1:B
+  if weights(b) < 0 || weights(b) > 1
+    error('`weights` may not exceeds [0,1].')
+  end
+end
+
+
+%% search path
+
+if exist('min_g_R', 'file') ~= 2
+  addpath(genpath(pwd))
+end
+
+
+%% real work
+
+% If no pool exists, a new one is created when necessary
+if numWorker > 1
+  poolobj = gcp('nocreate');
+  if isempty(poolobj)
+    parpool(numWorker);
+  end
+end
+
+
+B_eff = sum(weights);
+h_and_J = zeros(q + q*q*(N-1), N);
+
+numTile = ceil(N/tileSize);
+h_and_J_tile = cell(1, numTile);
+
+
+%% PLM
+fprintf('Performing L2-regularized PLM (asymmetric version, %d nodes per tile) ...\n', ...
+  tileSize)
+timer = tic;
+
+if numWorker > 1
+  parfor (t = 1:numTile, numWorker)
+    rlist = uint64((t-1)*tileSize+1 : min(t*tileSize, N));
+    h_and_J_tile{t} = min_g_R( ...
+      S, uint64(N),uint64(B),uint64(q), ...
+      weights,B_eff,rlist,lambdas,skip,options);
+  end
+else
+  for t = 1:numTile
+    rlist = uint64((t-1)*tileSize+1 : min(t*tileSize, N));
+    h_and_J_tile{t} = min_g_R( ...
+      S, uint64(N),uint64(B),uint64(q), ...
+      weights,B_eff,rlist,lambdas,skip,options);
+  end
+end
+
+for t = 1:numTile
+  h_and_J(:, (t-1)*tileSize+1 : min(t*tileSize, N)) = h_and_J_tile{t};
+  h_and_J_tile{t} = [];
+end
+
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+%% Gauge Transformation
+fprintf('Shifting parameters of Potts model to Ising gauge ...\n');
+timer = tic;
+
+if numWorker > 1
+  parfor (r = 1:N, numWorker)
+    h_and_J(:,r) = gauge_shift_Ising(h_and_J(:,r), q, N);
+  end
+else
+  for r = 1:N
+    h_and_J(:,r) = gauge_shift_Ising(h_and_J(:,r), q, N);
+  end
+end
+
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+end
@@ -0,0 +1,166 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `PLM_L2_Asym` for a Potts model whose alphabet size depends on the site.
+% Site i takes q_i states, so that node r has
+%
+%   q_r + q_r * sum_{i ~= r} q_i
+%
+% parameters instead of q + q^2 (N-1). This reduces memory, gradient traffic
+% and the L-BFGS history (`Corr` copies of the parameters) when many sites show
+% fewer than q states, e.g. bi-allelic loci after filtering. Use `remap_states`
+% to get `S` and `qlist` from a MSA with a global alphabet.
+%
+% INPUT
+% ===
+% S  (uint8)  S(i,b) in [0,qlist(i)-1], columns as sequences/samples
+% N           length of sequences (number of nodes/spins)
+% B           number of sequences/samples/configurations
+% qlist       N elements, number of states of each site, <= 256
+% weights     [0,1]  sequences can be weigted
+% lambdas     [lambda_h lambda_J]
+% skip        non-zero to skip built-in check of `g_r_var_mex`
+% options     passed to `minFunc`
+% numWorker   number of workers used in parfor
+%
+% OUTPUT
+% ===
+% h_and_J{r} represents [h_r; J_r] in the packed layout (see `g_r_var.hpp`),
+% where h_r and J_r are in Ising gauge
+%
+% HISTORY
+% ===
+% - 2018-04-09  v1
+%   - adapted from `PLM_L2_Asym.m`
+
+function h_and_J = PLM_L2_Asym_var(S,N,B,qlist,weights,lambdas,skip,options, ...
+  numWorker)
+
+if nargin ~= 9
+  error('Not enough input arguments.')
+end
+
+%% check with very little overhead
+% type
+if ~isa(S,'uint8') ...
+    || ~isa(N, 'double') || ~isa(B, 'double') || ~isa(qlist, 'double') ...
+    || ~isa(weights, 'double') || ~isa(lambdas, 'double') ...
+    || ~isa(numWorker, 'double')
+  error(...
+    ['%s:\n' ...
+    '   uint8:    S\n' ...
+    '  double:    N, B, qlist, weights, lambdas, numWorker'], ...
+    'Requirement on type');
+end
+
+% orientation of S
+if size(S,1) ~= N || size(S,2) ~= B
+  error('`S` should be a N-by-B matrix.')
+end
+
+% dimension of weights and qlist
+if numel(weights) ~= B
+  error('weights should contains B numbers.')
+end
+if numel(qlist) ~= N
+  error('qlist should contains N numbers.')
+end
+
+% check whether N/B/qlist is a integer
+if round(N) ~= N || round(B) ~= B || any(round(qlist) ~= qlist) ...
+    || round(numWorker) ~= numWorker
+  error('N, B, qlist and numWorker should be integers.')
+end
+
+% check if limitation is reached
+qlist = qlist(:);
+if any(qlist > 256) || any(qlist < 1)
+  error('Every site should have 1 to 256 states.')
+end
+P_max = max(qlist .* (1 + sum(qlist) - qlist));
+if options.useMEX && strcmp(options.Method, 'lbfgs') ...
+    && options.Corr*P_max >= 2^31
+  error('Limitation is reached; extra work needed; see `README.md`.')
+end
+
+
+%% check with acceptable overhead
+
+% range of S
+if any(double(max(S,[],2)) > qlist-1)
+  error('States of site i should be mapped to integers in [0,qlist(i)-1].')
+end
+
+% range of weights
+if any(weights < 0 | weights > 1)
+  error('`weights` may not exceeds [0,1].')
+end
+
+
+%% search path
+
+if exist('min_g_r_var', 'file') ~= 2
+  addpath(genpath(pwd))
+end
+
+
+%% real work
+
+% If no pool exists, a new one is created when necessary
+if numWorker > 1
+  poolobj = gcp('nocreate');
+  if isempty(poolobj)
+    parpool(numWorker);
+  end
+end
+
+
+B_eff = sum(weights);
+qlist0 = uint64(qlist);
+h_and_J = cell(1, N);
+
+
+%% PLM
+fprintf('Performing L2-regularized PLM (asymmetric version, per-site q) ...\n')
+timer = tic;
+
+if numWorker > 1
+  parfor (r = 1:N, numWorker)
+    h_and_J{r} = min_g_r_var( ...
+      S, qlist0, weights,B_eff,uint64(r),lambdas,skip,options);
+  end
+else
+  for r = 1:N
+    h_and_J{r} = min_g_r_var( ...
+      S, qlist0, weights,B_eff,uint64(r),lambdas,skip,options);
+  end
+end
+
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+%% Gauge Transformation
+fprintf('Shifting parameters of Potts model to Ising gauge ...\n');
+timer = tic;
+
+if numWorker > 1
+  parfor (r = 1:N, numWorker)
+    h_and_J{r} = gauge_shift_Ising_var(h_and_J{r}, qlist, r);
+  end
+else
+  for r = 1:N
+    h_and_J{r} = gauge_shift_Ising_var(h_and_J{r}, qlist, r);
+  end
+end
+
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+end
@@ -0,0 +1,147 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Given B weighted samples, this function performs the symmetric version of
+% L2-regularized pseudo-likelihood maximization (PLM) for q-state Potts model:
+% one coupling matrix J_ij = J_ji^T per pair is shared by g_i and g_j, and the
+% sum of all g_r is minimized at once (`g_sym_mex`). The inferred parameters
+% are transformed to Ising gauge (zero-sum gauge).
+%
+% Compared with `PLM_L2_Asym`, the model takes half the memory and every
+% coupling is computed once per sample instead of twice, but it is a single
+% global optimization: nodes are not independent jobs, and parallelism comes
+% from `numThread` native threads splitting the samples of every evaluation.
+% (Every thread but one keeps a private gradient of the model size.)
+%
+% INPUT
+% ===
+% S  (uint8)  [0,q-1], columns as sequences/samples/configurations; gap state should be mapped to 0
+% N           length of sequences (number of nodes/spins)
+% B           number of sequences/samples/configurations
+% q           number of possible states
+% weights     [0,1]  sequences can be weigted
+% lambdas     [lambda_h lambda_J], every J_ij is penalized once (cf.
+%             `PLM_DCA`, where the asymmetric version uses lambda_J/2)
+% skip        non-zero to skip built-in check of `g_sym_mex`
+% options     passed to `minFunc`
+% numThread   number of native threads
+%
+% OUTPUT
+% ===
+% h (q-by-N): h(:,r) is h_r, in Ising gauge
+% J (q*q-by-N(N-1)/2): J(:,p) is J_ij(:) (column-major, rows as states of i)
+% of the p-th pair (i<j) in the order (1,2), (1,3), ..., (1,N), (2,3), ...,
+% in Ising gauge
+%
+% HISTORY
+% ===
+% - 2018-05-06  v1
+
+function [h, J] = PLM_L2_Sym(S,N,B,q,weights,lambdas,skip,options,numThread)
+
+if nargin ~= 9
+  error('Not enough input arguments.')
+end
+
+%% check with very little overhead
+% type
+if ~isa(S,'uint8') ...
+    || ~isa(N, 'double') || ~isa(B, 'double') || ~isa(q, 'double') ...
+    || ~isa(weights, 'double') || ~isa(lambdas, 'double') ...
+    || ~isa(numThread, 'double')
+  error(...
+    ['%s:\n' ...
+    '   uint8:    S\n' ...
+    '  double:    N, B, q, weights, lambdas, numThread'], ...
+    'Requirement on type');
+end
+
+% orientation of S
+if size(S,1) ~= N || size(S,2) ~= B
+  error('`S` should be a N-by-B matrix.')
+end
+
+% dimension of weights
+if numel(weights) ~= B
+  error('weights should contains B numbers.')
+end
+
+% check whether N/B/q is a integer
+if round(N) ~= N || round(B) ~= B || round(q) ~= q ...
+    || round(numThread) ~= numThread
+  error('N, B, q and numThread should be integers.')
+end
+
+% check if limitation is reached
+P = q*N + q*q*N*(N-1)/2;
+if q > 256
+  error('At most 256 states are supported.')
+end
+if options.useMEX && strcmp(options.Method, 'lbfgs') ...
+    && options.Corr*P >= 2^31
+  error('Limitation is reached; extra work needed; see `README.md`.')
+end
+
+
+%% check with acceptable overhead
+
+% range of S
+if double(max(S(:))) > q-1
+  error('q possible states should be mapped to integers in [0,q-1].')
+end
+
+% range of weights
+if any(weights(:) < 0 | weights(:) > 1)
+  error('`weights` may not exceeds [0,1].')
+end
+
+
+%% search path
+
+if exist('g_sym_mex', 'file') ~= 3
+  addpath(genpath(pwd))
+end
+
+
+%% PLM
+fprintf('Performing L2-regularized PLM (symmetric version) ...\n')
+timer = tic;
+
+B_eff = sum(weights);
+if skip
+  funObj = @(x) g_sym_mex(S,uint64(N),uint64(B),uint64(q),weights,B_eff, ...
+    x,lambdas,numThread,'SkipCheckFlag');
+else
+  funObj = @(x) g_sym_mex(S,uint64(N),uint64(B),uint64(q),weights,B_eff, ...
+    x,lambdas,numThread);
+end
+h_and_J = minFunc(funObj, zeros(P,1), options);
+
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+%% Gauge Transformation
+% same as `gauge_shift_Ising`, block by block
+fprintf('Shifting parameters of Potts model to Ising gauge ...\n');
+timer = tic;
+
+h = reshape(h_and_J(1:q*N), [q N]);
+h = h - mean(h,1);
+
+J = reshape(h_and_J(q*N+1:end), [q q N*(N-1)/2]);
+clear h_and_J
+J_avg_col = mean(J,1);
+J = J - J_avg_col - mean(J,2) + mean(J_avg_col,2);
+J = reshape(J, [q*q N*(N-1)/2]);
+
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+end
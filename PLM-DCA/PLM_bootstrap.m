@@ -0,0 +1,193 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Bootstrap of `PLM_DCA`: the mean and the variance of the score of every pair
+% over `numRep` bootstrap replicates of the MSA.
+%
+% A replicate resamples the B sequences with replacement; it is represented by
+% the multiplicities of the sequences, so that replicate t has the weights
+% `weights .* count(:,t)` on the same `S`. For every node, the replicates of a
+% batch (`repBatch` replicates) are minimized together (`min_g_r_rep`), which
+% reads `S` and computes the indices of the couplings once per sample for the
+% whole batch. Running mean and variance are updated batch by batch, thus the
+% memory needed is that of `repBatch` runs of `PLM_L2_Asym`.
+%
+% INPUT
+% ===
+% Same as `PLM_DCA`, plus
+%
+% numRep      number of bootstrap replicates (>= 2)
+% seed        seed of `rng` to draw the replicates (reproducible)
+% repBatch    (optional) replicates per batch, default min(numRep, 10)
+%
+% OUTPUT
+% ===
+% `table_i_j_mean_var` is a 4-by-N(N-1)/2 matrix. Every column, formatted as
+% `[i; j; mean; var]`, contains the pair (i,j), the mean and the (unbiased)
+% variance of its score over the replicates.
+%
+% HISTORY
+% ===
+% - 2018-04-23  v1
+
+function table_i_j_mean_var = PLM_bootstrap(S,N,B,q,weights,lambda,numWorker, ...
+  numRep,seed,repBatch)
+
+if nargin < 9
+  error('Not enough input arguments.')
+end
+if nargin < 10
+  repBatch = min(numRep, 10);
+end
+
+% search path
+addpath(genpath(pwd))
+
+
+%% check with very little overhead
+% type
+if ~isa(S,'uint8') ...
+    || ~isa(N, 'double') || ~isa(B, 'double') || ~isa(q, 'double') ...
+    || ~isa(weights, 'double') || ~isa(lambda, 'double') ...
+    || ~isa(numWorker, 'double') || ~isa(numRep, 'double') ...
+    || ~isa(repBatch, 'double')
+  error(...
+    ['%s:\n' ...
+    '   uint8:    S\n' ...
+    '  double:    N, B, q, weights, lambda, numWorker, numRep, repBatch'], ...
+    'Requirement on type');
+end
+
+% orientation of S
+if size(S,1) ~= N || size(S,2) ~= B
+  error('`S` should be a N-by-B matrix.')
+end
+
+% dimension of weights
+if numel(weights) ~= B
+  error('weights should contains B numbers.')
+end
+
+% check whether N/B/q is a integer
+if round(N) ~= N || round(B) ~= B || round(q) ~= q ...
+    || round(numWorker) ~= numWorker ...
+    || round(numRep) ~= numRep || numRep < 2 ...
+    || round(repBatch) ~= repBatch || repBatch < 1
+  error('N, B, q, numWorker, numRep (>= 2) and repBatch should be integers.')
+end
+
+% check if limitation is reached
+if q > 256
+  error('At most 256 states are supported.')
+end
+
+
+%% check with acceptable overhead
+
+% range of S
+if double(max(S(:))) > q-1
+  error('q possible states should be mapped to integers in [0,q-1].')
+end
+
+% range of weights
+if any(weights < 0 | weights > 1)
+  error('`weights` may not exceeds [0,1].')
+end
+
+
+%% replicates
+% multiplicities of the sequences in each replicate, drawn at once so that the
+% replicates only depend on `seed`
+rng(seed);
+count = zeros(B, numRep);
+for t = 1:numRep
+  count(:,t) = accumarray(randi(B, B, 1), 1, [B 1]);
+end
+
+
+%% PLM
+% see `PLM_DCA.m`
+options.Display = 'off';
+options.progTol = -0;
+options.optTol  = 1e-5;
+options.useMEX  = true;
+options.Method  = 'lbfgs';
+options.Corr    = 100;
+
+if options.Corr*repBatch*(q + q*q*(N-1)) >= 2^31
+  error('Limitation is reached; use a smaller `repBatch`; see `README.md`.')
+end
+
+% If no pool exists, a new one is created when necessary
+if numWorker > 1
+  poolobj = gcp('nocreate');
+  if isempty(poolobj)
+    parpool(numWorker);
+  end
+end
+
+lambdas = [lambda lambda/2];  % see `PLM_DCA.m`
+skip = false;
+P = q + q*q*(N-1);
+
+score_mean = zeros(1, N*(N-1)/2);
+score_M2   = zeros(1, N*(N-1)/2);  % sum of squared deviations (Welford)
+numDone = 0;
+
+fprintf('Performing L2-regularized PLM (asymmetric version) for %d replicates ...\n', ...
+  numRep)
+timer = tic;
+
+for t0 = 1:repBatch:numRep
+  tlist = t0 : min(t0+repBatch-1, numRep);
+  R = numel(tlist);
+  W = bsxfun(@times, weights(:), count(:,tlist));
+  B_eff = sum(W, 1);
+
+  h_and_J = zeros(P, N, R);
+  if numWorker > 1
+    parfor (r = 1:N, numWorker)
+      h_and_J(:,r,:) = reshape(min_g_r_rep( ...
+        S, uint64(N),uint64(B),uint64(q), ...
+        W,B_eff,uint64(r),lambdas,skip,options), [P 1 R]);
+    end
+  else
+    for r = 1:N
+      h_and_J(:,r,:) = reshape(min_g_r_rep( ...
+        S, uint64(N),uint64(B),uint64(q), ...
+        W,B_eff,uint64(r),lambdas,skip,options), [P 1 R]);
+    end
+  end
+
+  % gauge and score every replicate
+  for t = 1:R
+    h_and_J_t = h_and_J(:,:,t);
+    if numWorker > 1
+      parfor (r = 1:N, numWorker)
+        h_and_J_t(:,r) = gauge_shift_Ising(h_and_J_t(:,r), q, N);
+      end
+    else
+      for r = 1:N
+        h_and_J_t(:,r) = gauge_shift_Ising(h_and_J_t(:,r), q, N);
+      end
+    end
+    table_t = score_coupling_L2_no_gap(h_and_J_t,q,N);
+
+    numDone = numDone + 1;
+    delta = table_t(3,:) - score_mean;
+    score_mean = score_mean + delta/numDone;
+    score_M2   = score_M2 + delta .* (table_t(3,:) - score_mean);
+  end
+
+  fprintf('\t%d/%d replicates finished in %.2f s.\n', numDone, numRep, toc(timer));
+end
+
+table_i_j_mean_var = [table_t(1:2,:); score_mean; score_M2/(numDone-1)];
+
+
+end
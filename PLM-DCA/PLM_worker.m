@@ -0,0 +1,107 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Worker of `PLM_L2_Asym_dist`: connects to the coordinator at `address`,
+% minimizes the nodes handed out and streams them back, until there is no
+% more work. Start it in a separate MATLAB process (on any host which can
+% reach `address` and the shared files), e.g.
+%
+%   matlab -nodisplay -r "PLM_worker('tcp://coordinator-host:47000'); exit"
+%
+% A heartbeat is sent every `heartbeat` seconds (default 30) by a native
+% thread; the `timeout` of the coordinator should cover a few of them. The
+% worker retries to connect for `wait` seconds (default 120), so that it may
+% be started before the coordinator listens, and gives up when it hears
+% nothing from the coordinator for `timeout` seconds (default 600) while it
+% waits for work.
+%
+% With `min_g_r` (L-BFGS, the default), the MSA file is not read into the
+% worker: `g_r_mex_v2` gets the handle `['file:' msaFile]` and maps the file
+% read-only (see `shm_msa.hpp`), so that the workers of a host share its pages
+% in the page cache. The other variants of `options` need `S` in memory and
+% read the file into a copy of N*B bytes per worker. Besides `S`, the worker
+% holds one node, never the whole `h_and_J`.
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1.2
+%   - `wait`: connecting is retried
+%   - `timeout`: a lost coordinator is noticed
+%   - the MSA file is mapped by `g_r_mex_v2`, not copied, with `min_g_r`
+%
+% - 2018-05-10  v1.1
+%   - the description of how `S` is held
+%
+% - 2018-05-07  v1
+
+function PLM_worker(address, heartbeat, wait, timeout)
+
+if nargin < 2
+  heartbeat = 30;
+end
+if nargin < 3
+  wait = 120;
+end
+if nargin < 4
+  timeout = 600;
+end
+
+% search path
+if exist('dist_worker_mex', 'file') ~= 3
+  addpath(genpath(fileparts(mfilename('fullpath'))))
+end
+
+specFile = dist_worker_mex('connect', address, heartbeat, wait, timeout);
+spec = load(specFile);
+cleanup = onCleanup(@() dist_worker_mex('close'));
+
+N = spec.N;
+B = spec.B;
+q = spec.q;
+
+% see `PLM_L2_Asym`
+options = spec.options;
+if strcmp(options.Method, 'newton0')
+  min_node = @min_g_r_newton;
+elseif isfield(options, 'active')
+  min_node = @min_g_r_act;
+elseif isfield(options, 'useStats') && options.useStats
+  min_node = @min_g_r_stats;
+else
+  min_node = @min_g_r;
+end
+
+% `g_r_mex_v2` maps the file itself; the others need a copy of `S`
+if isequal(min_node, @min_g_r)
+  S = ['file:' spec.msaFile];
+else
+  m = memmapfile(spec.msaFile, 'Offset', 32, 'Format', {'uint8', [N B], 'S'}, ...
+    'Repeat', 1);
+  S = m.Data.S;
+end
+
+B_eff = sum(spec.weights);
+numNode = 0;
+timer = tic;
+while true
+  nodes = dist_worker_mex('next');
+  if isempty(nodes)
+    break
+  end
+  for r = nodes(1):nodes(2)
+    r_h_and_J = min_node(S,uint64(N),uint64(B),uint64(q), ...
+      spec.weights,B_eff,uint64(r),spec.lambdas,spec.skip,options);
+    r_h_and_J = gauge_shift_Ising(r_h_and_J, q, N);
+    dist_worker_mex('send', r, r_h_and_J);
+    numNode = numNode + 1;
+  end
+end
+
+fprintf('Worker finished: %d nodes in %.2f s.\n', numNode, toc(timer));
+
+end
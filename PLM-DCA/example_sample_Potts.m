@@ -0,0 +1,28 @@
+clear
+
+%% synthetic MSA with planted couplings
+N = 50;
+B = 5000;
+q = 3;
+numEdge = 40;
+sigma_J = 1;
+sigma_h = 0.5;
+numThread = 2;
+seed = 1;
+
+[S, model] = sample_Potts_MSA(N, B, q, numEdge, sigma_J, sigma_h, ...
+  numThread, seed);
+
+%% PLM
+weights = ones(B,1);
+lambda = 0.01;
+numWorker = 2;
+
+table_i_j_score = PLM_DCA(S,N,B,q,weights,lambda,numWorker);
+
+%% recovery of planted couplings: precision of the top `numEdge` scores
+[~, sidx] = sort(table_i_j_score(3,:), 'descend');
+top = table_i_j_score(1:2, sidx(1:numEdge));
+numTrue = sum(ismember(top.', double(model.edges).', 'rows'));
+fprintf('%d of the top %d scored pairs are planted couplings.\n', ...
+  numTrue, numEdge);
@@ -0,0 +1,45 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Convert a sparse Potts model (see `gen_Potts_sparse`) to the dense layout of
+% `PLM_L2_Asym`: h_and_J(:,r) represents [h_r(:); J_r(:)], where J_r is a
+% q-by-q-by-(N-1) array and J_r(:,:,i) = J_{ri} for i < r while
+% J_r(:,:,i-1) = J_{ri} for i > r.
+%
+% Since J_{ji} = J_{ij}.', every planted coupling appears in two columns.
+% Memory is (q + q*q*(N-1))*N doubles; use it for small systems only.
+%
+% HISTORY
+% ===
+% - 2018-03-20  v1
+
+function h_and_J = Potts_sparse2h_and_J(model)
+
+N = double(model.N);
+q = double(model.q);
+
+h_and_J = zeros(q + q*q*(N-1), N);
+h_and_J(1:q,:) = model.h;
+
+edges = double(model.edges);
+for e = 1:size(edges,2)
+  i = edges(1,e);
+  j = edges(2,e);
+  J_ij = model.J(:,:,e);
+
+  % column i, neighbour j (j > i)
+  offset = q + q*q*(j-2);
+  h_and_J(offset+1:offset+q*q, i) = J_ij(:);
+
+  % column j, neighbour i (i < j)
+  J_ji = J_ij.';
+  offset = q + q*q*(i-1);
+  h_and_J(offset+1:offset+q*q, j) = J_ji(:);
+end
+
+end
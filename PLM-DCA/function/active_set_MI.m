@@ -0,0 +1,51 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Active set of couplings for `min_g_r_act`, from the MI table of CC (see
+% `CC_MSA` in Correlation-Compression): the `numPairs` pairs with the largest
+% MI among the loci in `idx` are active.
+%
+% INPUT
+% ===
+% list_MI     MI of pairs, e.g. `list_MI_sort` saved by `CC_MSA`
+% list_sub    2-by-(number of pairs), loci of the pairs (`list_sub_sort`)
+% idx         loci of the N sites of `S`, in the indexing of `list_sub`
+%             (`idx_cc` returned by `CC_MSA`, or 1:N)
+% numPairs    number of active pairs
+%
+% OUTPUT
+% ===
+% `active` is a symmetric N-by-N logical matrix; `active(i,r)` is true if J_ri
+% is optimized from the start. Pass it as `options.active` to `PLM_L2_Asym`.
+%
+% HISTORY
+% ===
+% - 2018-04-25  v1
+
+function active = active_set_MI(list_MI, list_sub, idx, numPairs)
+
+N = numel(idx);
+sub = double(list_sub);
+
+% position of every locus among the sites of `S`, 0 if absent
+pos = zeros(1, max([sub(:); idx(:)]));
+pos(idx) = 1:N;
+i = pos(sub(1,:));
+j = pos(sub(2,:));
+isKept = i > 0 & j > 0;
+
+[~, order] = sort(list_MI(isKept), 'descend');
+order = order(1:min(numPairs, numel(order)));
+i = i(isKept);
+j = j(isKept);
+
+active = false(N, N);
+active(sub2ind([N N], i(order), j(order))) = true;
+active = active | active.';
+
+end
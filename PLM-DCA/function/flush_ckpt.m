@@ -0,0 +1,30 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `ckpt_mex('flush')` on the client and on every worker of the current pool,
+% so that all results handed to `min_g_r_ckpt` are on disk (and no index of
+% an earlier run stays cached) when it returns.
+%
+% INPUT
+% ===
+% numWorker   number of workers used in parfor
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1
+%   - moved out of `PLM_L2_Asym_file.m`
+
+function flush_ckpt(numWorker)
+
+ckpt_mex('flush');
+poolobj = gcp('nocreate');
+if numWorker > 1 && ~isempty(poolobj)
+  fetchOutputs(parfevalOnAll(poolobj, @ckpt_mex, 0, 'flush'));
+end
+
+end
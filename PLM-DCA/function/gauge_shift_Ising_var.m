@@ -0,0 +1,42 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Shift `h_r` and `J_r` to Ising gauge (zero-sum gauge), for per-site alphabet
+% sizes `qlist` and the packed layout of `g_r_var_mex`. Blocks of the same
+% size are shifted together.
+
+function r_h_and_J_Ising = gauge_shift_Ising_var(r_h_and_J, qlist, r)
+
+qlist = double(qlist(:));
+r = double(r);
+q_r = qlist(r);
+q_nbr = qlist([1:r-1, r+1:end]);
+
+% offset of $J_{ri}$ in `r_h_and_J`
+start = q_r + q_r*[0; cumsum(q_nbr(1:end-1))];
+
+r_h_and_J_Ising = r_h_and_J;
+
+%% shift to Ising gauge
+h_r = r_h_and_J(1:q_r);
+r_h_and_J_Ising(1:q_r) = h_r - mean(h_r);
+
+for v = unique(q_nbr).'
+  blocks = find(q_nbr == v);
+  idx = (1:q_r*v).' + start(blocks).';   % (q_r*v)-by-(number of blocks)
+  J_v = reshape(r_h_and_J(idx), [q_r v numel(blocks)]);
+
+  J_v_avg_col = mean(J_v,1);
+
+  % 2016b and later: implicit expansion
+  J_v = J_v - J_v_avg_col - mean(J_v,2) + mean(J_v_avg_col, 2);
+
+  r_h_and_J_Ising(idx) = J_v(:);
+end
+
+end
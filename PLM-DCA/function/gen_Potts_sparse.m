@@ -0,0 +1,71 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Generate a q-state Potts model with `numEdge` planted couplings between
+% distinct random pairs of nodes. Both J_ij and h_i are Gaussian and shifted
+% to Ising gauge (zero-sum gauge), thus the score of a planted coupling by
+% `score_coupling_L2_no_gap` is non-zero while that of any other pair is zero.
+%
+% INPUT
+% ===
+% N         number of nodes
+% q         number of states, [2,256]
+% numEdge   number of planted couplings, at most N*(N-1)/2
+% sigma_J   standard deviation of J_ij(k,l) (before gauge shift)
+% sigma_h   standard deviation of h_i(k) (before gauge shift)
+% seed      seed of `rng`
+%
+% OUTPUT
+% ===
+% `model` is a struct with fields
+%
+% | name  | description                                                   |
+% | ----- | ------------------------------------------------------------- |
+% | N, q  | size of the model                                             |
+% | h     | q-by-N, h(k,i) = h_i(k)                                       |
+% | edges | uint32, 2-by-numEdge, (i,j) with i < j (1-based), sorted      |
+% | J     | q-by-q-by-numEdge, J(k,l,e) = J_ij(k,l) for (i,j) = edges(:,e)|
+%
+% See `Potts_sparse2h_and_J` for the dense layout used by `g_r_mex_v2`.
+%
+% HISTORY
+% ===
+% - 2018-03-20  v1
+
+function model = gen_Potts_sparse(N, q, numEdge, sigma_J, sigma_h, seed)
+
+if numEdge > N*(N-1)/2
+  error('At most N*(N-1)/2 couplings can be planted.')
+end
+if q < 2 || q > 256
+  error('q should be in [2,256].')
+end
+
+rng(seed);
+
+%% distinct pairs (i,j), i < j
+edges = zeros(0,2);
+while size(edges,1) < numEdge
+  num = 2*(numEdge - size(edges,1));
+  ij = randi(N, num, 2);
+  ij = ij(ij(:,1) ~= ij(:,2), :);
+  edges = unique([edges; sort(ij,2)], 'rows');
+end
+edges = edges(randperm(size(edges,1), numEdge), :);
+edges = sortrows(edges).';
+
+%% parameters in Ising gauge
+h = sigma_h * randn(q, N);
+h = h - mean(h,1);
+
+J = sigma_J * randn(q, q, numEdge);
+J = J - mean(J,1) - mean(J,2) + mean(mean(J,1),2);
+
+model = struct('N',N, 'q',q, 'h',h, 'edges',uint32(edges), 'J',J);
+
+end
@@ -0,0 +1,132 @@
+#ifndef HV_G_R_HPP
+#define HV_G_R_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Exact Hessian-vector product of `g_r` (see `g_r.v02.h`).
+ *
+ * For sample b, the parameters enter `g_r` only through the q fields
+ * $z_k = h_r(k) + \sum_{i \neq r} J_{ri}(k, s_i^b)$, a linear map
+ * $z = A_b \theta$, and the Hessian of $-\log P(s_r^b)$ with respect to z is
+ * $\mathrm{diag}(P) - P P^T$. Thus
+ *
+ * $$
+ * H v = \frac{1}{B_eff} \sum_b w_b A_b^T \left( \mathrm{diag}(P^b) -
+ *   P^b {P^b}^T \right) A_b v + 2 \lambda v
+ * $$
+ *
+ * where $A_b v$ is a gather of v with the same indices as `Num` in `g_r`, and
+ * $A_b^T$ is a scatter with the same indices as the gradient. Given the
+ * conditional probabilities `Prob_all` at the current point (cf. `g_r_value`),
+ * one product costs about as much as one evaluation of `g_r`, and needs no
+ * storage besides `Prob_all`.
+ *
+ *
+ * # Output (by pointer)
+ *
+ *  *Initialization* needed: Hv[] (q + q*q*(N-1) elements) should be 0.
+ *
+ *
+ * # Input
+ *
+ *  B, N, q, S, w, B_eff, r, l_h, l_J : same as `g_r`
+ *  Prob_all : q*B elements, $P(s_r^b = k | \cdot)$ at `Prob_all[k + q*b]`
+ *  v        : q + q*q*(N-1) elements, [v_h; v_J] in the layout of [h_r; J_r]
+ *
+ * No MATLAB API is called.
+ *
+ *
+ * # History
+ *
+ * ## 2018-04-16  v1
+ */
+
+#include <stdint.h> // uint8_t
+
+
+inline void Hv_g_r(
+  double *Hv,
+  const size_t B, const size_t N, const size_t q,
+  const uint8_t *S,
+  const double *w, const double B_eff,
+  const size_t r,
+  const double *Prob_all,
+  const double *v,
+  const double l_h, const double l_J)
+{
+  const double *v_h  = v;
+  const double *v_J  = v + q;
+  double       *Hv_h = Hv;
+  double       *Hv_J = Hv + q;
+
+  double u[256];
+
+  for (size_t b = 0; b < B; b++) {
+    const uint8_t *s    = S + N*b;
+    const double  *Prob = Prob_all + q*b;
+
+    /* u = A_b v */
+    for (size_t k = 0; k < q; k++) {
+      u[k] = v_h[k];
+    }
+    for (size_t i = 0; i < r; i++) {
+      const double *v_J_ri_s = v_J + q*(s[i] + q*i);
+      for (size_t k = 0; k < q; k++) {
+        u[k] += v_J_ri_s[k];
+      }
+    }
+    for (size_t i = r+1; i < N; i++) {
+      const double *v_J_ri_s = v_J + q*(s[i] + q*(i-1));
+      for (size_t k = 0; k < q; k++) {
+        u[k] += v_J_ri_s[k];
+      }
+    }
+
+    /* u <- w_b (diag(P) - P P^T) u */
+    double Pu = 0;
+    for (size_t k = 0; k < q; k++) {
+      Pu += Prob[k] * u[k];
+    }
+    for (size_t k = 0; k < q; k++) {
+      u[k] = w[b] * Prob[k] * (u[k] - Pu);
+    }
+
+    /* Hv += A_b^T u */
+    for (size_t k = 0; k < q; k++) {
+      Hv_h[k] += u[k];
+    }
+    for (size_t i = 0; i < r; i++) {
+      double *Hv_J_ri_s = Hv_J + q*(s[i] + q*i);
+      for (size_t k = 0; k < q; k++) {
+        Hv_J_ri_s[k] += u[k];
+      }
+    }
+    for (size_t i = r+1; i < N; i++) {
+      double *Hv_J_ri_s = Hv_J + q*(s[i] + q*(i-1));
+      for (size_t k = 0; k < q; k++) {
+        Hv_J_ri_s[k] += u[k];
+      }
+    }
+  }
+
+
+  /*************************************************
+   *    from sum to mean, and add L2 regulator
+   *************************************************/
+  for (size_t k = 0; k < q; k++) {
+    Hv_h[k] = Hv_h[k] / B_eff + 2*l_h*v_h[k];
+  }
+  for (size_t p = 0; p < q*q*(N-1); p++) {
+    Hv_J[p] = Hv_J[p] / B_eff + 2*l_J*v_J[p];
+  }
+}
+
+#endif // HV_G_R_HPP
@@ -0,0 +1,229 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * Hv = Hv_g_r_mex(...
+ *   v, r_h_and_J, ...
+ *   S, ...
+ *   N, B, q, ...
+ *   w, B_eff, ...
+ *   r, ...
+ *   lambda, ...
+ *   SkipCheckFlag)
+ *
+ *  v          double    $q + q^2(N-1)$ rows, 1 column
+ *  others     same as `g_r_mex_v2`
+ *
+ *  Hv         exact product of the Hessian of `g_r` at `r_h_and_J` and `v`
+ *
+ * The order of inputs follows `HvFunc(v,x,varargin{:})` of `minFunc` (method
+ * 'newton0'). The conditional probabilities at `r_h_and_J` (q*B doubles) are
+ * kept with a copy of `r_h_and_J`, so that the conjugate-gradient iterations
+ * at the same point only pay for the product itself (see `Hv_g_r.hpp`). The
+ * data are identified by hashes of `S` and `w` and the sizes, not by their
+ * addresses (see `data_key.hpp`).
+ *
+ * `SkipCheckFlag` is a placeholder as in `g_r_mex_v2`.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v1.1  the cache is keyed on the data, not on their addresses
+ * - 2018-04-16  v1
+ */
+
+
+#include <string.h> // memcmp()
+#include <vector>
+#include "mex.h"
+#include "g_r.v02.h"
+#include "Hv_g_r.hpp"
+#include "data_key.hpp"
+
+
+// probabilities at the point of the last call
+static struct {
+  bool valid;
+  DataKey data;
+  size_t r;
+  std::vector<double> h_r_and_J_r;
+  std::vector<double> Prob;
+} cache = {};
+
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs > 1) {
+    mexErrMsgIdAndTxt(
+      "Hv_g_r_mex:nlhs",
+      "This function only calculates the Hessian-vector product.");
+  }
+  // default to check, 11-th arugment is a placeholder to skip check
+  if (nrhs != 10 && nrhs != 11) {
+    mexErrMsgIdAndTxt(
+      "Hv_g_r_mex:nrhs",
+      "Number of arguments supported: 10, 11\n"
+      "provided: %d", nrhs);
+  }
+
+  const mxArray *pm_v           = prhs[0];
+  const mxArray *pm_h_r_and_J_r = prhs[1];
+  const mxArray *pm_S           = prhs[2];
+  const mxArray *pm_N           = prhs[3];
+  const mxArray *pm_B           = prhs[4];
+  const mxArray *pm_q           = prhs[5];
+  const mxArray *pm_w           = prhs[6];
+  const mxArray *pm_B_eff       = prhs[7];
+  const mxArray *pm_r           = prhs[8];
+  const mxArray *pm_lambda      = prhs[9];
+
+  // check when only 10 arguments are provided
+  if (nrhs == 10) {
+    /* type check */
+    if (   !mxIsUint8(pm_S)
+        || !mxIsUint64(pm_N)
+        || !mxIsUint64(pm_B)
+        || !mxIsUint64(pm_q)
+        || !mxIsUint64(pm_r)
+        || !mxIsDouble(pm_v)
+        || !mxIsDouble(pm_w)
+        || !mxIsDouble(pm_B_eff)
+        || !mxIsDouble(pm_h_r_and_J_r)
+        || !mxIsDouble(pm_lambda) )
+    {
+      mexErrMsgIdAndTxt(
+        "Hv_g_r_mex:prhs:WrongType",
+        "Requirement:\n"
+        "   uint8:    S\n"
+        "  uint64:    N,  B,  q,  r\n"
+        "  double:    v,  h_r_and_J_r,  w,  B_eff,  lambda");
+    }
+
+    for (int k = 0; k < 10; k++) {
+      if (mxIsComplex(prhs[k])) {
+        mexErrMsgIdAndTxt(
+          "Hv_g_r_mex:prhs:IsComplex",
+          "\tAll inputs should be real.");
+      }
+    }
+
+    if ( mxGetNumberOfElements(pm_N) != 1
+      || mxGetNumberOfElements(pm_B) != 1
+      || mxGetNumberOfElements(pm_q) != 1
+      || mxGetNumberOfElements(pm_r) != 1
+      || mxGetNumberOfElements(pm_B_eff) != 1 )
+    {
+      mexErrMsgIdAndTxt(
+        "Hv_g_r_mex:prhs:ScalarWrong",
+        "\tAll of {N, B, q, r, B_eff} should be scalar.");
+    }
+
+    const size_t N0 = *((uint64_t *) mxGetData(pm_N));
+    const size_t B0 = *((uint64_t *) mxGetData(pm_B));
+    const size_t q0 = *((uint64_t *) mxGetData(pm_q));
+    const size_t r0 = *((uint64_t *) mxGetData(pm_r));
+
+    if ( mxGetM(pm_S) != N0
+      || mxGetN(pm_S) != B0 )
+    {
+      mexErrMsgIdAndTxt(
+        "Hv_g_r_mex:prhs:S",
+        "\tColumns of `S` are considered as sequences.\n"
+        "\tThus `S` should be a matrix consists of `N` rows and `B` columns");
+    }
+
+    if (q0 < 2 || q0 > 256) {
+        mexErrMsgIdAndTxt(
+          "Hv_g_r_mex:prhs:q",
+          "Requirement on q:\n"
+          "\tq >= 2 since 1-state Potts model is trivial.\n"
+          "\tq <= 256 since `S` can only stores 0~255.\n");
+    }
+
+    if (mxGetNumberOfElements(pm_w) != B0) {
+      mexErrMsgIdAndTxt(
+        "Hv_g_r_mex:prhs:w",
+        "\t`w`, which contains weights of sequences, mismatches `S`.\n");
+    }
+
+    if (r0 > N0 || r0 == 0) {
+      mexErrMsgIdAndTxt(
+        "Hv_g_r_mex:prhs:r",
+        "\t`r` should be integers in [1,N].");
+    }
+
+    if ( mxGetM(pm_h_r_and_J_r) != (q0 + q0*q0*(N0-1))
+      || mxGetN(pm_h_r_and_J_r) != 1
+      || mxGetM(pm_v) != (q0 + q0*q0*(N0-1))
+      || mxGetN(pm_v) != 1 )
+    {
+      mexErrMsgIdAndTxt(
+        "Hv_g_r_mex:prhs:h_r_and_J_r",
+        "\t`v` and `h_r_and_J_r` should be (q + q*q*(N-1)) * 1 matrices\n");
+    }
+
+    if (mxGetNumberOfElements(pm_lambda) != 2) {
+      mexErrMsgIdAndTxt(
+        "Hv_g_r_mex:prhs:lambda",
+        "\t`lambda`, which contains lambda_h and lambda_J, "
+        "should contains 2 real numbers.");
+    }
+    if (mxGetPr(pm_lambda)[0] < 0.0 || mxGetPr(pm_lambda)[1] < 0.0) {
+      mexErrMsgIdAndTxt("Hv_g_r_mex:prhs:lambda",
+        "\t`lambda` may not be negative.");
+    }
+  }
+
+  const size_t   N     = mxGetM(pm_S);
+  const size_t   B     = mxGetN(pm_S);
+  const size_t   q     = *((uint64_t *) mxGetData(pm_q));
+  const size_t   r     = *((uint64_t *) mxGetData(pm_r));
+  const uint8_t *S     = (uint8_t *) mxGetData(pm_S);
+  const double  *w     = mxGetPr(pm_w);
+  const double   B_eff = mxGetPr(pm_B_eff)[0];
+  const double  *h_r   = mxGetPr(pm_h_r_and_J_r);
+  const double  *J_r   = h_r + q;
+  const double  *v     = mxGetPr(pm_v);
+  const double   l_h   = mxGetPr(pm_lambda)[0];
+  const double   l_J   = mxGetPr(pm_lambda)[1];
+  const size_t   P     = q + q*q*(N-1);
+
+  /* conditional probabilities at `r_h_and_J` */
+  if (!(cache.valid
+    && cache.data.N == N && cache.data.B == B && cache.data.q == q
+    && cache.r == r
+    && memcmp(cache.h_r_and_J_r.data(), h_r, P*sizeof(double)) == 0
+    && cache.data == DataKey("", S, w, N, B, q)))
+  {
+    cache.valid = false;
+    cache.Prob.resize(q*B);
+    double obj = 0.0;   // not used
+    if (g_r_value(&obj, B, N, q, S, w, B_eff, r-1, h_r, J_r, 0.0, 0.0,
+      cache.Prob.data()) >= 0)
+    {
+      mexErrMsgIdAndTxt(
+        "Hv_g_r_mex:overflow:exp",
+        "r = %lu:  "
+        "`Num[k]` is too large and likely to overflow `exp(Num[k])`\n",
+        (unsigned long) r);
+    }
+
+    cache.h_r_and_J_r.assign(h_r, h_r + P);
+    cache.data = DataKey("", S, w, N, B, q);
+    cache.r = r;
+    cache.valid = true;
+  }
+
+  // `mxCreateDoubleMatrix` initializes each element to 0, required by `Hv_g_r`
+  plhs[0] = mxCreateDoubleMatrix(P, 1, mxREAL);
+  Hv_g_r(mxGetPr(plhs[0]),
+    B, N, q, S, w, B_eff, r-1, cache.Prob.data(), v, l_h, l_J);
+}
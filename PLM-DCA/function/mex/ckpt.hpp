@@ -0,0 +1,486 @@
+#ifndef CKPT_HPP
+#define CKPT_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Checkpoints of the parameters of nodes (`r_h_and_J`), written by a
+ * background thread so that the optimization does not wait on the file
+ * system (see `ckpt_mex`).
+ *
+ * Every process appends to its own segments, named
+ *
+ *   <dir>/<prefix>--ckpt-<host>-<pid>-<k>.seg   records
+ *   <dir>/<prefix>--ckpt-<host>-<pid>-<k>.idx   index of the records
+ *
+ * A record is a 40-byte header {char[8] "CCPLMCKP", uint64 r, uint64 P,
+ * uint64 stamp, uint64 checksum} followed by P doubles; `stamp` is the time of
+ * `put` (ns since epoch) and `checksum` is FNV-1a over the 64-bit words of
+ * the doubles. An index entry is {uint64 r, uint64 offset, uint64 stamp} and
+ * is appended after its record is on disk (`fdatasync` of the segment), so
+ * that an entry never points at a record lost in a crash. A new segment is
+ * started once the current one exceeds `segmentBytes`.
+ *
+ * `CkptWriter::put` copies the parameters into a queue bounded by
+ * `queueBytes`; the writer thread takes everything queued at once and writes
+ * it with one `write` per file. `put` only blocks when the queue is full,
+ * i.e. when the file system is slower than the optimization on average.
+ * `flush` waits until everything queued before is written and `fsync`ed.
+ *
+ * Readers (`ckpt_scan`, `ckpt_read_latest`) take the record with the latest
+ * stamp of every node, skip a torn tail of an index, and reject a record whose
+ * header or checksum does not match; a node whose latest record is rejected
+ * falls back to its next older record.
+ *
+ *
+ * # Note for implementation
+ *
+ * Plain C++ and POSIX; no MATLAB API is called, errors are returned as a
+ * `CkptStatus`. All hosts sharing a directory should share the byte order.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v1.1
+ *
+ * - the segment is synced before index entries are appended
+ * - readers fall back to older records of a node
+ *
+ * ## 2018-05-10  v1
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+enum CkptStatus {
+  CKPT_OK          = 0,
+  CKPT_ERR_OPEN    = 1,
+  CKPT_ERR_WRITE   = 2,
+  CKPT_ERR_CORRUPT = 3
+};
+
+static const char CKPT_MAGIC[8] = {'C', 'C', 'P', 'L', 'M', 'C', 'K', 'P'};
+static const size_t CKPT_HEADER = 40;
+static const size_t CKPT_INDEX_ENTRY = 24;
+
+
+inline uint64_t ckpt_checksum(const double *x, size_t n)
+{
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t k = 0; k < n; k++) {
+    uint64_t u;
+    std::memcpy(&u, x + k, 8);
+    h ^= u;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+
+// data of `fd` on disk
+inline bool ckpt_datasync(int fd)
+{
+#if defined(__linux__)
+  return fdatasync(fd) == 0;
+#else
+  return fsync(fd) == 0;    // no `fdatasync` on macOS
+#endif
+}
+
+
+inline bool ckpt_write_all(int fd, const char *p, size_t n)
+{
+  while (n > 0) {
+    const ssize_t k = write(fd, p, n);
+    if (k < 0 && errno == EINTR) {
+      continue;
+    }
+    if (k <= 0) {
+      return false;
+    }
+    p += k;
+    n -= size_t(k);
+  }
+  return true;
+}
+
+
+/*************************************************
+ *    writer
+ *************************************************/
+
+class CkptWriter {
+public:
+  CkptWriter(const std::string &dir, const std::string &prefix, uint64_t P,
+    size_t queueBytes, size_t segmentBytes)
+    : dir_(dir), prefix_(prefix), P_(P),
+      queueBytes_(std::max(queueBytes, size_t(8*P + CKPT_HEADER))),
+      segmentBytes_(segmentBytes),
+      queued_(0), stop_(false), flushReq_(0), flushDone_(0),
+      status_(CKPT_OK), fdSeg_(-1), fdIdx_(-1), segSize_(0), segNo_(0)
+  {
+    thread_ = std::thread(&CkptWriter::loop, this);
+  }
+
+  ~CkptWriter() {
+    flush();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      stop_ = true;
+    }
+    cvWork_.notify_all();
+    thread_.join();
+    close_segment();
+  }
+
+  CkptWriter(const CkptWriter&) = delete;
+  CkptWriter& operator=(const CkptWriter&) = delete;
+
+  uint64_t P() const { return P_; }
+
+  // queue a copy of x (P doubles); blocks while the queue is full
+  int put(uint64_t r, const double *x) {
+    Item item;
+    item.r = r;
+    item.stamp = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+    item.x.assign(x, x + P_);
+    const size_t bytes = 8*P_ + CKPT_HEADER;
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    cvSpace_.wait(lock, [&]{
+      return status_ != CKPT_OK || queued_ + bytes <= queueBytes_; });
+    if (status_ != CKPT_OK) {
+      return status_;
+    }
+    queue_.push_back(std::move(item));
+    queued_ += bytes;
+    cvWork_.notify_one();
+    return CKPT_OK;
+  }
+
+  // everything queued before is written and on disk
+  int flush() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    const uint64_t gen = ++flushReq_;
+    cvWork_.notify_one();
+    cvFlushed_.wait(lock, [&]{
+      return status_ != CKPT_OK || flushDone_ >= gen; });
+    return status_;
+  }
+
+  int status() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return status_;
+  }
+
+private:
+  struct Item {
+    uint64_t r;
+    uint64_t stamp;
+    std::vector<double> x;
+  };
+
+  void loop() {
+    for (;;) {
+      std::deque<Item> batch;
+      uint64_t gen;
+      {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cvWork_.wait(lock, [&]{
+          return stop_ || !queue_.empty() || flushReq_ > flushDone_; });
+        if (stop_ && queue_.empty()) {
+          return;
+        }
+        batch.swap(queue_);
+        gen = flushReq_;
+      }
+
+      int st = write_batch(batch);
+      if (st == CKPT_OK && gen > flushDone_) {
+        st = sync();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        queued_ -= batch.size() * (8*P_ + CKPT_HEADER);
+        if (st != CKPT_OK && status_ == CKPT_OK) {
+          status_ = st;
+        }
+        if (gen > flushDone_) {
+          flushDone_ = gen;
+        }
+      }
+      cvSpace_.notify_all();
+      cvFlushed_.notify_all();
+    }
+  }
+
+  // one write per file for the whole batch
+  int write_batch(const std::deque<Item> &batch) {
+    size_t k = 0;
+    while (k < batch.size()) {
+      if (fdSeg_ < 0 || segSize_ >= segmentBytes_) {
+        const int st = open_segment();
+        if (st != CKPT_OK) {
+          return st;
+        }
+      }
+      std::vector<char> seg, idx;
+      for (; k < batch.size() && segSize_ + seg.size() < segmentBytes_; k++) {
+        const Item &it = batch[k];
+        const uint64_t offset = segSize_ + seg.size();
+        const uint64_t checksum = ckpt_checksum(it.x.data(), it.x.size());
+        char hdr[CKPT_HEADER];
+        std::memcpy(hdr, CKPT_MAGIC, 8);
+        std::memcpy(hdr + 8, &it.r, 8);
+        std::memcpy(hdr + 16, &P_, 8);
+        std::memcpy(hdr + 24, &it.stamp, 8);
+        std::memcpy(hdr + 32, &checksum, 8);
+        seg.insert(seg.end(), hdr, hdr + CKPT_HEADER);
+        const char *px = (const char *) it.x.data();
+        seg.insert(seg.end(), px, px + 8*it.x.size());
+
+        char ent[CKPT_INDEX_ENTRY];
+        std::memcpy(ent, &it.r, 8);
+        std::memcpy(ent + 8, &offset, 8);
+        std::memcpy(ent + 16, &it.stamp, 8);
+        idx.insert(idx.end(), ent, ent + CKPT_INDEX_ENTRY);
+      }
+      // the index after its records are on disk
+      if (!ckpt_write_all(fdSeg_, seg.data(), seg.size())
+        || !ckpt_datasync(fdSeg_)
+        || !ckpt_write_all(fdIdx_, idx.data(), idx.size()))
+      {
+        return CKPT_ERR_WRITE;
+      }
+      segSize_ += seg.size();
+    }
+    return CKPT_OK;
+  }
+
+  int sync() {
+    if (fdSeg_ >= 0 && (fsync(fdSeg_) != 0 || fsync(fdIdx_) != 0)) {
+      return CKPT_ERR_WRITE;
+    }
+    return CKPT_OK;
+  }
+
+  int open_segment() {
+    if (fdSeg_ >= 0) {
+      const int st = sync();
+      close_segment();
+      if (st != CKPT_OK) {
+        return st;
+      }
+    }
+    char host[64] = "host";
+    gethostname(host, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    for (int tries = 0; tries < 1000; tries++, segNo_++) {
+      char name[160];
+      std::snprintf(name, sizeof(name), "%s--ckpt-%s-%ld-%d", prefix_.c_str(),
+        host, (long) getpid(), segNo_);
+      const std::string base = dir_ + "/" + name;
+      fdSeg_ = open((base + ".seg").c_str(),
+        O_WRONLY | O_CREAT | O_EXCL | O_APPEND, 0644);
+      if (fdSeg_ < 0 && errno == EEXIST) {
+        continue;   // a previous process of the same pid
+      }
+      if (fdSeg_ < 0) {
+        return CKPT_ERR_OPEN;
+      }
+      fdIdx_ = open((base + ".idx").c_str(),
+        O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+      if (fdIdx_ < 0) {
+        close(fdSeg_);
+        fdSeg_ = -1;
+        return CKPT_ERR_OPEN;
+      }
+      segNo_++;
+      segSize_ = 0;
+      return CKPT_OK;
+    }
+    return CKPT_ERR_OPEN;
+  }
+
+  void close_segment() {
+    if (fdSeg_ >= 0) {
+      fsync(fdSeg_);
+      fsync(fdIdx_);
+      close(fdSeg_);
+      close(fdIdx_);
+      fdSeg_ = fdIdx_ = -1;
+    }
+  }
+
+  const std::string dir_, prefix_;
+  const uint64_t P_;
+  const size_t queueBytes_, segmentBytes_;
+
+  std::mutex mtx_;
+  std::condition_variable cvWork_, cvSpace_, cvFlushed_;
+  std::deque<Item> queue_;
+  size_t queued_;
+  bool stop_;
+  uint64_t flushReq_, flushDone_;
+  int status_;
+
+  // used by the writer thread only
+  int fdSeg_, fdIdx_;
+  uint64_t segSize_;
+  int segNo_;
+
+  std::thread thread_;
+};
+
+
+/*************************************************
+ *    readers
+ *************************************************/
+
+struct CkptLoc {
+  std::string seg;
+  uint64_t offset;
+  uint64_t stamp;
+};
+
+
+typedef std::map<uint64_t, std::vector<CkptLoc> > CkptIndex;
+
+
+// records of every node of `prefix` in `dir`, by index, latest first
+inline int ckpt_scan(const std::string &dir, const std::string &prefix,
+  CkptIndex *loc)
+{
+  loc->clear();
+  DIR *d = opendir(dir.c_str());
+  if (d == NULL) {
+    return CKPT_ERR_OPEN;
+  }
+  const std::string head = prefix + "--ckpt-";
+  std::vector<std::string> names;
+  for (dirent *e = readdir(d); e != NULL; e = readdir(d)) {
+    const std::string name(e->d_name);
+    if (name.size() > head.size() + 4 && name.compare(0, head.size(), head) == 0
+      && name.compare(name.size() - 4, 4, ".idx") == 0)
+    {
+      names.push_back(name.substr(0, name.size() - 4));
+    }
+  }
+  closedir(d);
+
+  for (const std::string &name : names) {
+    const std::string base = dir + "/" + name;
+    FILE *f = std::fopen((base + ".idx").c_str(), "rb");
+    if (f == NULL) {
+      continue;
+    }
+    char ent[CKPT_INDEX_ENTRY];
+    while (std::fread(ent, 1, CKPT_INDEX_ENTRY, f) == CKPT_INDEX_ENTRY) {
+      CkptLoc l;
+      uint64_t r;
+      std::memcpy(&r, ent, 8);
+      std::memcpy(&l.offset, ent + 8, 8);
+      std::memcpy(&l.stamp, ent + 16, 8);
+      l.seg = base + ".seg";
+      (*loc)[r].push_back(l);
+    }
+    std::fclose(f);
+  }
+  for (auto &kv : *loc) {
+    std::stable_sort(kv.second.begin(), kv.second.end(),
+      [](const CkptLoc &a, const CkptLoc &b) { return a.stamp > b.stamp; });
+  }
+  return CKPT_OK;
+}
+
+
+// P doubles of node r at `l`
+inline int ckpt_read(const CkptLoc &l, uint64_t r, uint64_t P, double *x)
+{
+  const int fd = open(l.seg.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return CKPT_ERR_OPEN;
+  }
+  char hdr[CKPT_HEADER];
+  uint64_t r0, P0, checksum;
+  bool isOK = pread(fd, hdr, CKPT_HEADER, off_t(l.offset))
+    == ssize_t(CKPT_HEADER);
+  if (isOK) {
+    std::memcpy(&r0, hdr + 8, 8);
+    std::memcpy(&P0, hdr + 16, 8);
+    std::memcpy(&checksum, hdr + 32, 8);
+    isOK = std::memcmp(hdr, CKPT_MAGIC, 8) == 0 && r0 == r && P0 == P;
+  }
+  size_t done = 0;
+  while (isOK && done < 8*P) {
+    const ssize_t k = pread(fd, (char *) x + done, size_t(8*P) - done,
+      off_t(l.offset + CKPT_HEADER + done));
+    if (k <= 0) {
+      isOK = false;
+    }
+    else {
+      done += size_t(k);
+    }
+  }
+  close(fd);
+  if (!isOK || ckpt_checksum(x, size_t(P)) != checksum) {
+    return CKPT_ERR_CORRUPT;
+  }
+  return CKPT_OK;
+}
+
+
+// P doubles of node r from the latest intact record of `locs` (latest first);
+// `numBad` gets the number of damaged records passed over
+inline int ckpt_read_latest(const std::vector<CkptLoc> &locs, uint64_t r,
+  uint64_t P, double *x, size_t *numBad)
+{
+  *numBad = 0;
+  for (const CkptLoc &l : locs) {
+    if (ckpt_read(l, r, P, x) == CKPT_OK) {
+      return CKPT_OK;
+    }
+    ++*numBad;
+  }
+  return CKPT_ERR_CORRUPT;
+}
+
+
+inline const char *ckpt_strerror(int status)
+{
+  switch (status) {
+    case CKPT_OK :          return "no error";
+    case CKPT_ERR_OPEN :    return "could not open the checkpoint files";
+    case CKPT_ERR_WRITE :   return "could not write the checkpoint files";
+    case CKPT_ERR_CORRUPT : return "corrupt checkpoint record";
+    default :               return "unknown error";
+  }
+}
+
+#endif // CKPT_HPP
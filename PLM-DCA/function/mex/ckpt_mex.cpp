@@ -0,0 +1,248 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ *                ckpt_mex('put', filePath, filePrefix, r, r_h_and_J)
+ * r_h_and_J    = ckpt_mex('get', filePath, filePrefix, r, P)
+ * [r_list, X]  = ckpt_mex('load', filePath, filePrefix, P)
+ *                ckpt_mex('flush')
+ *                ckpt_mex('close')
+ *
+ *  filePath    char     directory of the checkpoints
+ *  filePrefix  char     prefix of the segment files (see `ckpt.hpp`)
+ *  r           double   node (1-based)
+ *  r_h_and_J   double   parameters of node r, P-by-1, from its latest intact
+ *                       record (older records stand in for a damaged one);
+ *                       `get` returns [] if there is no intact record
+ *  P           double   q + q*q*(N-1)
+ *  r_list      double   1-by-K, nodes with a record, ascending
+ *  X           double   P-by-K, X(:,k) of node r_list(k)
+ *
+ * `put` hands a copy of `r_h_and_J` to the writer thread of this process and
+ * returns at once; it only blocks when 256 MB are queued and not yet written.
+ * Records go to segments of up to 1 GB. `flush` returns when everything put
+ * by this process is on disk (call it on every worker at the end of a stage,
+ * e.g. by `parfevalOnAll`); it also drops the index cached by `get`, which is
+ * read once per prefix otherwise. Errors of the writer thread are raised by
+ * the next `put` or `flush`.
+ *
+ * The MEX file stays locked while a writer is open, and `clear mex` or the
+ * exit of MATLAB flushes it. `close` flushes and stops all writers.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v1.1  fall back to older records of a node; `load` reads into its outputs
+ * - 2018-05-10  v1
+ */
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "mex.h"
+#include "ckpt.hpp"
+
+using namespace std;
+
+
+static const size_t QUEUE_BYTES   = size_t(256) << 20;
+static const size_t SEGMENT_BYTES = size_t(1) << 30;
+
+typedef map<string, unique_ptr<CkptWriter>> WriterMap;
+typedef map<string, CkptIndex> IndexMap;
+
+static WriterMap g_writer;   // by path and prefix
+static IndexMap  g_index;    // by path and prefix, for `get`
+static bool      g_isLocked = false;
+
+
+static void close_all()
+{
+  g_writer.clear();          // destructors flush
+  g_index.clear();
+  if (g_isLocked) {
+    mexUnlock();
+    g_isLocked = false;
+  }
+}
+
+
+static string get_string(const mxArray *pm, const char *name)
+{
+  if (!mxIsChar(pm)) {
+    mexErrMsgIdAndTxt("ckpt_mex:prhs:WrongType",
+      "`%s` should be provided as a string.", name);
+  }
+  char *pc = mxArrayToString(pm);
+  const string s(pc);
+  mxFree(pc);
+  return s;
+}
+
+
+static void warn_damaged(uint64_t r, size_t numBad, bool isFound)
+{
+  if (numBad > 0) {
+    mexWarnMsgIdAndTxt("ckpt_mex:corrupt",
+      "%llu damaged record(s) of node %llu ignored; %s.",
+      (unsigned long long) numBad, (unsigned long long) r,
+      isFound ? "an older record is used" : "no intact record is left");
+  }
+}
+
+
+static uint64_t get_count(const mxArray *pm, const char *name)
+{
+  const double v = mxIsDouble(pm) && !mxIsComplex(pm)
+    && mxGetNumberOfElements(pm) == 1 ? mxGetScalar(pm) : 0;
+  if (v < 1 || v != double(uint64_t(v))) {
+    mexErrMsgIdAndTxt("ckpt_mex:prhs:WrongType",
+      "`%s` should be a positive integer (double).", name);
+  }
+  return uint64_t(v);
+}
+
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nrhs < 1) {
+    mexErrMsgIdAndTxt("ckpt_mex:nrhs",
+      "Syntax: ckpt_mex(command, ...)");
+  }
+  const string cmd = get_string(prhs[0], "command");
+
+  if (cmd == "flush" || cmd == "close") {
+    int st = CKPT_OK;
+    for (auto &kv : g_writer) {
+      const int s = kv.second->flush();
+      st = (st == CKPT_OK) ? s : st;
+    }
+    g_index.clear();
+    if (cmd == "close") {
+      close_all();
+    }
+    if (st != CKPT_OK) {
+      mexErrMsgIdAndTxt("ckpt_mex:write",
+        "Checkpoints could not be saved (%s).", ckpt_strerror(st));
+    }
+    return;
+  }
+
+  if (nrhs != (cmd == "load" ? 4 : 5)) {
+    mexErrMsgIdAndTxt("ckpt_mex:nrhs",
+      "Wrong number of inputs for `%s`.", cmd.c_str());
+  }
+  const string filePath   = get_string(prhs[1], "filePath");
+  const string filePrefix = get_string(prhs[2], "filePrefix");
+  const string key = filePath + "\n" + filePrefix;
+
+  if (cmd == "put") {
+    const uint64_t r = get_count(prhs[3], "r");
+    const mxArray *pm_x = prhs[4];
+    if (!mxIsDouble(pm_x) || mxIsComplex(pm_x) || mxIsSparse(pm_x)
+      || mxGetNumberOfElements(pm_x) == 0)
+    {
+      mexErrMsgIdAndTxt("ckpt_mex:prhs:WrongType",
+        "`r_h_and_J` should be a real double vector.");
+    }
+    const uint64_t P = mxGetNumberOfElements(pm_x);
+
+    WriterMap::iterator it = g_writer.find(key);
+    if (it == g_writer.end()) {
+      it = g_writer.emplace(key, unique_ptr<CkptWriter>(new CkptWriter(
+        filePath, filePrefix, P, QUEUE_BYTES, SEGMENT_BYTES))).first;
+      if (!g_isLocked) {
+        mexLock();
+        mexAtExit(close_all);
+        g_isLocked = true;
+      }
+    }
+    if (it->second->P() != P) {
+      mexErrMsgIdAndTxt("ckpt_mex:prhs:WrongSize",
+        "`r_h_and_J` should have %llu elements as before.",
+        (unsigned long long) it->second->P());
+    }
+    const int st = it->second->put(r, mxGetPr(pm_x));
+    if (st != CKPT_OK) {
+      mexErrMsgIdAndTxt("ckpt_mex:write",
+        "Checkpoints could not be saved (%s).", ckpt_strerror(st));
+    }
+    return;
+  }
+
+  if (cmd == "get" || cmd == "load") {
+    const uint64_t P = get_count(prhs[cmd == "get" ? 4 : 3], "P");
+
+    IndexMap::iterator it = g_index.find(key);
+    if (it == g_index.end()) {
+      it = g_index.emplace(key, CkptIndex()).first;
+      if (ckpt_scan(filePath, filePrefix, &it->second) != CKPT_OK) {
+        g_index.erase(it);
+        mexErrMsgIdAndTxt("ckpt_mex:open",
+          "`%s` could not be read.", filePath.c_str());
+      }
+    }
+    const CkptIndex &index = it->second;
+
+    if (cmd == "get") {
+      const uint64_t r = get_count(prhs[3], "r");
+      const CkptIndex::const_iterator loc = index.find(r);
+      if (loc == index.end()) {
+        plhs[0] = mxCreateDoubleMatrix(0, 0, mxREAL);
+        return;
+      }
+      plhs[0] = mxCreateDoubleMatrix(P, 1, mxREAL);
+      size_t numBad;
+      const int st = ckpt_read_latest(loc->second, r, P, mxGetPr(plhs[0]),
+        &numBad);
+      warn_damaged(r, numBad, st == CKPT_OK);
+      if (st != CKPT_OK) {
+        mxDestroyArray(plhs[0]);
+        plhs[0] = mxCreateDoubleMatrix(0, 0, mxREAL);
+      }
+      return;
+    }
+
+    // records are read into their columns of the outputs, which are sized for
+    // every node of the index and shrunk (without a copy) by damaged ones
+    plhs[0] = mxCreateDoubleMatrix(1, index.size(), mxREAL);
+    double *r_list = mxGetPr(plhs[0]);
+    double *X = NULL;
+    vector<double> x;
+    if (nlhs > 1) {
+      plhs[1] = mxCreateDoubleMatrix(P, index.size(), mxREAL);
+      X = mxGetPr(plhs[1]);
+    }
+    else {
+      x.resize(P);
+    }
+    size_t K = 0;
+    for (const auto &kv : index) {
+      size_t numBad;
+      const int st = ckpt_read_latest(kv.second, kv.first, P,
+        X != NULL ? X + K*P : x.data(), &numBad);
+      warn_damaged(kv.first, numBad, st == CKPT_OK);
+      if (st == CKPT_OK) {
+        r_list[K++] = double(kv.first);
+      }
+    }
+    g_index.erase(key);      // `load` is for after the run
+    mxSetN(plhs[0], K);
+    if (nlhs > 1) {
+      mxSetN(plhs[1], K);
+    }
+    return;
+  }
+
+  mexErrMsgIdAndTxt("ckpt_mex:command",
+    "Unknown command `%s`.", cmd.c_str());
+}
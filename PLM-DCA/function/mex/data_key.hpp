@@ -0,0 +1,79 @@
+#ifndef DATA_KEY_HPP
+#define DATA_KEY_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Identity of the data (`S`, `w` and the sizes) a cached result belongs to,
+ * for gateways which keep results between calls (`g_r_mex_v2`, `Hv_g_r_mex`).
+ *
+ * Raw pointers do not identify data: MATLAB may free an array and allocate
+ * another one with different content at the same address. Thus `S` is
+ * identified by the name of its shared segment (read-only, see `shm_msa.hpp`),
+ * or else by a hash of its content, and `w` by a hash of its content. A hash
+ * reads every byte once, which costs little next to one evaluation of `g_r`
+ * (about q operations per byte of `S`).
+ *
+ * No MATLAB API is called.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v1
+ */
+
+#include <stdint.h> // uint8_t, uint64_t
+#include <string.h> // memcpy()
+#include <string>
+
+
+// 64-bit hash of `bytes` bytes, 8 at a time (not cryptographic)
+inline uint64_t data_hash(const void *data, const size_t bytes)
+{
+  const uint8_t *p = (const uint8_t *) data;
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ bytes;
+  size_t k = 0;
+  for (; k + 8 <= bytes; k += 8) {
+    uint64_t x;
+    memcpy(&x, p + k, 8);
+    h = (h ^ x) * 0xff51afd7ed558ccdULL;
+    h ^= h >> 29;
+  }
+  uint64_t x = 0;
+  memcpy(&x, p + k, bytes - k);
+  h = (h ^ x) * 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 32;
+  return h;
+}
+
+
+struct DataKey {
+  std::string name;   // handle of a shared `S`, or empty
+  uint64_t S_hash;    // hash of `S` if `name` is empty, otherwise 0
+  uint64_t w_hash;
+  size_t N, B, q;
+
+  DataKey() : S_hash(0), w_hash(0), N(0), B(0), q(0) {}
+
+  // `name` is the handle of `S` in shared memory, or empty
+  DataKey(const std::string &name, const uint8_t *S, const double *w,
+    const size_t N, const size_t B, const size_t q)
+    : name(name), S_hash(name.empty() ? data_hash(S, N*B) : 0),
+      w_hash(data_hash(w, B*sizeof(double))), N(N), B(B), q(q) {}
+
+  bool operator==(const DataKey &other) const {
+    return N == other.N && B == other.B && q == other.q
+      && S_hash == other.S_hash && w_hash == other.w_hash
+      && name == other.name;
+  }
+};
+
+
+#endif // DATA_KEY_HPP
@@ -0,0 +1,415 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * numDone = dist_coord_mex(address, specFile, outFile, N, P, rangeSize, ...
+ *   timeout[, maxTime])
+ *
+ *  address    char      `tcp://host:port` (host `*` for all interfaces) or
+ *                       `unix:///path/to/socket`
+ *  specFile   char      job specification sent to every worker (`.mat`
+ *                       readable by the workers, see `PLM_L2_Asym_dist`)
+ *  outFile    char      result file (see `dist_protocol.hpp`); an existing
+ *                       file of the same N and P is resumed
+ *  N          double    number of nodes
+ *  P          double    length of `r_h_and_J`
+ *  rangeSize  double    number of nodes handed out per request
+ *  timeout    double    seconds without any message after which a worker is
+ *                       considered lost and its unfinished nodes are re-queued;
+ *                       also, seconds without any worker connected after
+ *                       which the coordinator gives up
+ *  maxTime    double    seconds after which the coordinator gives up
+ *                       (default Inf)
+ *
+ *  numDone    number of nodes done: N, or fewer if the coordinator gave up
+ *             (the result file is consistent; a new call resumes it)
+ *
+ * The coordinator serves workers (`dist_worker_mex`) on the calling thread
+ * with `poll`, until every node is done: workers pull ranges of nodes and
+ * stream back one column per node, which is written to `outFile` at once.
+ * Nothing but the flags of the nodes is kept in memory. A worker sending a
+ * message longer than its type allows is dropped at once (see
+ * `dist_max_len`), as is a worker sending an unknown message. Replies are
+ * queued per worker and sent without blocking as its socket accepts them, so
+ * that a worker which stops reading can not stall the others; one holding
+ * more than 1 MiB of unsent replies is dropped. A worker kept waiting for a
+ * range gets a HEARTBEAT every `DIST_PING_INTERVAL` seconds.
+ *
+ * MATLAB does not see Ctrl-C while a MEX function runs; `maxTime` bounds the
+ * call instead, and with every worker gone it returns after `timeout`.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v1.1  lengths of messages are bounded by their type,
+ *                     replies never block, columns are synced before their
+ *                     nodes are marked done
+ * - 2018-05-10  v1.2  gives up without workers or after `maxTime`,
+ *                     pings waiting workers
+ * - 2018-05-07  v1
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include <poll.h>
+#include "mex.h"
+#include "dist_protocol.hpp"
+
+using namespace std;
+
+
+struct Client {
+  int fd;
+  vector<char> in;            // bytes received, not yet parsed
+  vector<char> out;           // bytes of replies, not sent yet
+  double last;                // time of the last message
+  double lastPing;            // time of the last HEARTBEAT sent
+  bool isWaiting;             // REQUEST not answered yet
+  vector<uint64_t> nodes;     // assigned, not returned yet
+};
+
+
+static double now_sec() {
+  return chrono::duration<double>(
+    chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// contiguous runs of at most `rangeSize` nodes
+static void push_ranges(deque<pair<uint64_t, uint64_t> > &pending,
+  const vector<uint64_t> &nodes, uint64_t rangeSize)
+{
+  size_t k = 0;
+  while (k < nodes.size()) {
+    const uint64_t r0 = nodes[k];
+    uint64_t r1 = r0 + 1;
+    k++;
+    while (k < nodes.size() && nodes[k] == r1 && r1 - r0 < rangeSize) {
+      r1++;
+      k++;
+    }
+    pending.push_back(make_pair(r0, r1));
+  }
+}
+
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nrhs != 7 && nrhs != 8) {
+    mexErrMsgIdAndTxt("dist_coord_mex:nrhs",
+      "This function accepts 7 or 8 arguments.");
+  }
+  if (nlhs > 1) {
+    mexErrMsgIdAndTxt("dist_coord_mex:nlhs",
+      "This function produces at most 1 output.");
+  }
+  for (int k = 0; k < 3; k++) {
+    if (!mxIsChar(prhs[k])) {
+      mexErrMsgIdAndTxt("dist_coord_mex:prhs:WrongType",
+        "{address, specFile, outFile} should be provided as strings.");
+    }
+  }
+  for (int k = 3; k < nrhs; k++) {
+    if (!mxIsDouble(prhs[k]) || mxGetNumberOfElements(prhs[k]) != 1) {
+      mexErrMsgIdAndTxt("dist_coord_mex:prhs:WrongType",
+        "{N, P, rangeSize, timeout, maxTime} should be double scalars.");
+    }
+  }
+
+  char *pc;
+  pc = mxArrayToString(prhs[0]);  const string address(pc);  mxFree(pc);
+  pc = mxArrayToString(prhs[1]);  const string specFile(pc); mxFree(pc);
+  pc = mxArrayToString(prhs[2]);  const string outFile(pc);  mxFree(pc);
+  const uint64_t N         = uint64_t(mxGetScalar(prhs[3]));
+  const uint64_t P         = uint64_t(mxGetScalar(prhs[4]));
+  const uint64_t rangeSize = uint64_t(max(1.0, mxGetScalar(prhs[5])));
+  const double   timeout   = mxGetScalar(prhs[6]);
+  const double   maxTime   = nrhs == 8 ? mxGetScalar(prhs[7]) : INFINITY;
+  if (N < 2 || P == 0 || !(timeout > 0.0) || !(maxTime > 0.0)) {
+    mexErrMsgIdAndTxt("dist_coord_mex:prhs",
+      "N >= 2, P > 0, timeout > 0 and maxTime > 0 are required.");
+  }
+  if (specFile.size() > DIST_MAX_PATH) {
+    mexErrMsgIdAndTxt("dist_coord_mex:prhs",
+      "The path of `specFile` is longer than %d characters.", DIST_MAX_PATH);
+  }
+
+  /* result file */
+  int fdOut = -1;
+  vector<uint8_t> done;
+  const int st = dist_result_open(outFile.c_str(), N, P, &fdOut, &done);
+  if (st != 0) {
+    if (fdOut >= 0) {
+      close(fdOut);
+    }
+    mexErrMsgIdAndTxt("dist_coord_mex:outFile",
+      st == 1 ? "Could not open or write `%s`."
+              : "`%s` holds the result of another problem.",
+      outFile.c_str());
+  }
+  uint64_t numDone = 0;
+  vector<uint64_t> todo;
+  for (uint64_t r = 0; r < N; r++) {
+    if (done[r]) {
+      numDone++;
+    }
+    else {
+      todo.push_back(r);
+    }
+  }
+  deque<pair<uint64_t, uint64_t> > pending;
+  push_ranges(pending, todo, rangeSize);
+  todo.clear();
+
+  const int fdListen = numDone < N ? dist_listen(address) : -1;
+  if (numDone < N && fdListen < 0) {
+    close(fdOut);
+    mexErrMsgIdAndTxt("dist_coord_mex:listen",
+      "Could not listen on `%s`.", address.c_str());
+  }
+  mexPrintf("Coordinator on %s: %lu of %lu nodes to do\n", address.c_str(),
+    (unsigned long) (N - numDone), (unsigned long) N);
+  mexEvalString("drawnow;");
+
+  vector<Client> clients;
+  bool isIOFailed = false;
+  const double t0 = now_sec();
+  double lastClient = t0;     // time a worker was last connected
+  uint64_t nextReport = numDone + max<uint64_t>(1, N/20);
+
+  // drop client k, re-queue its unfinished nodes
+  auto drop = [&](size_t k, const char *why) {
+    Client &c = clients[k];
+    vector<uint64_t> left;
+    for (uint64_t r : c.nodes) {
+      if (!done[r]) {
+        left.push_back(r);
+      }
+    }
+    sort(left.begin(), left.end());
+    push_ranges(pending, left, rangeSize);
+    mexPrintf("\tworker %d %s, %lu nodes re-queued\n", c.fd, why,
+      (unsigned long) left.size());
+    close(c.fd);
+    clients.erase(clients.begin() + k);
+  };
+
+  // queue a reply to client c and send what its socket takes; false to drop
+  auto reply = [&](Client &c, uint32_t type, const void *a, size_t na) {
+    dist_pack_msg(&c.out, type, a, na);
+    return dist_flush(c.fd, &c.out) && c.out.size() <= (1 << 20);
+  };
+
+  // answer a REQUEST of client k if possible; false to drop the client
+  auto serve = [&](Client &c) {
+    if (!pending.empty()) {
+      const pair<uint64_t, uint64_t> range = pending.front();
+      pending.pop_front();
+      for (uint64_t r = range.first; r < range.second; r++) {
+        c.nodes.push_back(r);
+      }
+      c.isWaiting = false;
+      const uint64_t buf[2] = {range.first, range.second};
+      return reply(c, DIST_RANGE, buf, sizeof(buf));
+    }
+    if (numDone == N) {
+      c.isWaiting = false;
+      return reply(c, DIST_DONE, NULL, 0);
+    }
+    c.isWaiting = true;
+    return true;
+  };
+
+  // handle one complete message of client c; false to drop the client
+  auto handle = [&](Client &c, uint32_t type, const char *payload,
+    uint64_t len)
+  {
+    switch (type) {
+      case DIST_HELLO :
+        return reply(c, DIST_SPEC, specFile.data(), specFile.size());
+      case DIST_HEARTBEAT :
+        return true;
+      case DIST_REQUEST :
+        return serve(c);
+      case DIST_RESULT : {
+        uint64_t r;
+        if (len != 8 + 8*P) {
+          return false;
+        }
+        memcpy(&r, payload, 8);
+        if (r >= N) {
+          return false;
+        }
+        if (!done[r]) {
+          // copy for alignment
+          vector<double> x(P);
+          memcpy(x.data(), payload + 8, size_t(8*P));
+          if (!dist_result_write(fdOut, N, P, r, x.data())) {
+            isIOFailed = true;
+            return true;
+          }
+          done[r] = 1;
+          numDone++;
+        }
+        c.nodes.erase(remove(c.nodes.begin(), c.nodes.end(), r),
+          c.nodes.end());
+        return true;
+      }
+      default :
+        return false;
+    }
+  };
+
+  /* event loop */
+  vector<char> buf(1 << 20);
+  while (numDone < N && !isIOFailed) {
+    const double tNow = now_sec();
+    if (!clients.empty()) {
+      lastClient = tNow;
+    }
+    else if (tNow - lastClient > timeout) {
+      mexPrintf("\tno worker for %g s, giving up\n", timeout);
+      break;
+    }
+    if (tNow - t0 > maxTime) {
+      mexPrintf("\t`maxTime` of %g s reached, giving up\n", maxTime);
+      break;
+    }
+
+    vector<pollfd> pfd(1 + clients.size());
+    pfd[0].fd = fdListen;
+    pfd[0].events = POLLIN;
+    for (size_t k = 0; k < clients.size(); k++) {
+      pfd[k+1].fd = clients[k].fd;
+      pfd[k+1].events = POLLIN | (clients[k].out.empty() ? 0 : POLLOUT);
+    }
+    poll(pfd.data(), pfd.size(), 1000);
+    const double t = now_sec();
+
+    // new workers
+    if (pfd[0].revents & POLLIN) {
+      const int fd = accept(fdListen, NULL, NULL);
+      if (fd >= 0) {
+        dist_no_sigpipe(fd);
+        Client c;
+        c.fd = fd;
+        c.last = t;
+        c.lastPing = t;
+        c.isWaiting = false;
+        clients.push_back(c);
+        mexPrintf("\tworker %d joined\n", fd);
+      }
+    }
+
+    // messages, from the last client so that `drop` keeps indices valid
+    for (size_t k = pfd.size() - 1; k >= 1; k--) {
+      Client &c = clients[k-1];
+      if ((pfd[k].revents & POLLOUT) && !dist_flush(c.fd, &c.out)) {
+        drop(k-1, "failed");
+        continue;
+      }
+      if (!(pfd[k].revents & (POLLIN | POLLHUP | POLLERR))) {
+        continue;
+      }
+      const ssize_t n = recv(c.fd, buf.data(), buf.size(), MSG_DONTWAIT);
+      if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        drop(k-1, "disconnected");
+        continue;
+      }
+      if (n < 0) {
+        continue;
+      }
+      c.in.insert(c.in.end(), buf.data(), buf.data() + n);
+      c.last = t;
+
+      // complete messages
+      bool isOK = true;
+      size_t pos = 0;
+      while (isOK && c.in.size() - pos >= sizeof(DistMsgHeader)) {
+        DistMsgHeader hdr;
+        memcpy(&hdr, c.in.data() + pos, sizeof(hdr));
+        if (hdr.len > dist_max_len(hdr.type, P)) {
+          isOK = false;
+          break;
+        }
+        if (c.in.size() - pos - sizeof(hdr) < hdr.len) {
+          break;
+        }
+        isOK = handle(c, hdr.type, c.in.data() + pos + sizeof(hdr), hdr.len);
+        pos += sizeof(hdr) + size_t(hdr.len);
+      }
+      c.in.erase(c.in.begin(), c.in.begin() + pos);
+      if (!isOK) {
+        drop(k-1, "failed");
+      }
+    }
+
+    // lost workers
+    for (size_t k = clients.size(); k-- > 0; ) {
+      if (t - clients[k].last > timeout) {
+        drop(k, "timed out");
+      }
+    }
+
+    // re-queued ranges for waiting workers, or a sign of life
+    for (size_t k = clients.size(); k-- > 0; ) {
+      Client &c = clients[k];
+      if (c.isWaiting && (!pending.empty() || numDone == N)) {
+        if (!serve(c)) {
+          drop(k, "failed");
+        }
+      }
+      else if (c.isWaiting && t - c.lastPing >= DIST_PING_INTERVAL) {
+        c.lastPing = t;
+        if (!reply(c, DIST_HEARTBEAT, NULL, 0)) {
+          drop(k, "failed");
+        }
+      }
+    }
+
+    if (numDone >= nextReport) {
+      mexPrintf("\t%lu of %lu nodes done, %lu workers\n",
+        (unsigned long) numDone, (unsigned long) N,
+        (unsigned long) clients.size());
+      mexEvalString("drawnow;");
+      nextReport = numDone + max<uint64_t>(1, N/20);
+    }
+  }
+
+  /* release workers (best effort: a worker which does not read is closed) */
+  for (Client &c : clients) {
+    dist_pack_msg(&c.out, DIST_DONE);
+    dist_flush(c.fd, &c.out);
+    close(c.fd);
+  }
+  if (fdListen >= 0) {
+    close(fdListen);
+    bool isUnix;
+    string host, port;
+    if (dist_parse_address(address, &isUnix, &host, &port) && isUnix) {
+      unlink(host.c_str());
+    }
+  }
+  fsync(fdOut);
+  close(fdOut);
+
+  if (isIOFailed) {
+    mexErrMsgIdAndTxt("dist_coord_mex:outFile",
+      "Writing `%s` failed.", outFile.c_str());
+  }
+
+  plhs[0] = mxCreateDoubleScalar(double(numDone));
+}
@@ -0,0 +1,495 @@
+#ifndef DIST_PROTOCOL_HPP
+#define DIST_PROTOCOL_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Wire protocol, sockets and result file shared by the coordinator
+ * (`dist_coord_mex`) and the workers (`dist_worker_mex`) of the distributed
+ * mode of PLM (see `PLM_L2_Asym_dist.m`).
+ *
+ * Addresses are `tcp://host:port` or `unix:///path/to/socket`. POSIX only.
+ *
+ *
+ * # Messages
+ *
+ * Every message is a 16-byte header {uint32 type, uint32 0, uint64 length}
+ * followed by `length` bytes of payload, in the byte order of the hosts (all
+ * hosts are assumed to share it).
+ *
+ *  HELLO      worker -> coord   (none)
+ *  SPEC       coord -> worker   path of the job specification (`.mat`)
+ *  REQUEST    worker -> coord   (none), ask for a range of nodes
+ *  RANGE      coord -> worker   uint64 r0, r1: nodes [r0, r1), 0-based
+ *  RESULT     worker -> coord   uint64 r, then P doubles (`r_h_and_J`)
+ *  HEARTBEAT  both ways          (none)
+ *  DONE       coord -> worker   (none), no more work
+ *
+ * A REQUEST is answered when a range is available (possibly much later, when
+ * the range of a lost worker is re-queued); a worker keeps sending HEARTBEAT
+ * meanwhile, and the coordinator sends one every `DIST_PING_INTERVAL` seconds
+ * to a worker it keeps waiting, so that either side can tell a silent peer
+ * from a lost one.
+ *
+ * A header announcing more payload than its type allows (`dist_max_len`) is
+ * not read further, and the peer is dropped: a corrupt or foreign peer can not
+ * make the other side buffer an arbitrary length.
+ *
+ *
+ * # Result file (see `dist_result_*`)
+ *
+ *  offset 0   char[8]   "CCPLMDST"
+ *  offset 8   uint32    version (1)
+ *  offset 12  uint32    0
+ *  offset 16  uint64    N, number of nodes
+ *  offset 24  uint64    P, length of `r_h_and_J`
+ *  offset 32  uint64[4] reserved, 0
+ *  offset 64  uint8[N]  1 if node r is done, padded to a multiple of 8 bytes
+ *  then       double    P-by-N, column r is `r_h_and_J` of node r
+ *
+ * A node is marked done after its column is written and synced to disk
+ * (`fdatasync`), so that a coordinator restarted on the same file, even after
+ * a crash of the host, resumes with the remaining nodes and never takes a lost
+ * column for done. A lost flag only costs the node again.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v1.1
+ *
+ * - lengths of messages are bounded by their type
+ * - a column is synced before its node is marked done
+ * - `dist_pack_msg` for senders that must not block
+ * - HEARTBEAT from the coordinator to waiting workers
+ * - `dist_set_timeout` for blocking receipt and sending
+ *
+ * ## 2018-05-07  v1
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+  #define DIST_SEND_FLAGS MSG_NOSIGNAL
+#else
+  #define DIST_SEND_FLAGS 0   // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+
+enum DistMsgType {
+  DIST_HELLO     = 1,
+  DIST_SPEC      = 2,
+  DIST_REQUEST   = 3,
+  DIST_RANGE     = 4,
+  DIST_RESULT    = 5,
+  DIST_HEARTBEAT = 6,
+  DIST_DONE      = 7
+};
+
+struct DistMsgHeader {
+  uint32_t type;
+  uint32_t pad;
+  uint64_t len;
+};
+
+// longest path of a job specification sent by SPEC
+#define DIST_MAX_PATH 4096
+
+// seconds between two HEARTBEAT of the coordinator to a waiting worker
+#define DIST_PING_INTERVAL 10
+
+
+// largest payload of a message of `type`, given P; 0 for unknown types
+inline uint64_t dist_max_len(uint32_t type, uint64_t P)
+{
+  switch (type) {
+    case DIST_SPEC :
+      return DIST_MAX_PATH;
+    case DIST_RANGE :
+      return 16;
+    case DIST_RESULT :
+      return 8 + 8*P;
+    default :   // HELLO, REQUEST, HEARTBEAT, DONE
+      return 0;
+  }
+}
+
+
+/*************************************************
+ *    sockets
+ *************************************************/
+
+inline void dist_no_sigpipe(int fd) {
+#ifdef SO_NOSIGPIPE
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#else
+  (void) fd;
+#endif
+}
+
+
+// split `address` into the scheme (tcp/unix) and the rest; false if malformed
+inline bool dist_parse_address(const std::string &address, bool *isUnix,
+  std::string *host, std::string *port)
+{
+  if (address.compare(0, 7, "unix://") == 0) {
+    *isUnix = true;
+    *host = address.substr(7);
+    return !host->empty() && host->size() < sizeof(sockaddr_un().sun_path);
+  }
+  if (address.compare(0, 6, "tcp://") == 0) {
+    *isUnix = false;
+    const std::string rest = address.substr(6);
+    const size_t colon = rest.rfind(':');
+    if (colon == std::string::npos || colon + 1 == rest.size()) {
+      return false;
+    }
+    *host = rest.substr(0, colon);
+    *port = rest.substr(colon + 1);
+    return true;
+  }
+  return false;
+}
+
+
+// listening socket on `address`, -1 on failure
+inline int dist_listen(const std::string &address)
+{
+  bool isUnix;
+  std::string host, port;
+  if (!dist_parse_address(address, &isUnix, &host, &port)) {
+    return -1;
+  }
+
+  if (isUnix) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      return -1;
+    }
+    sockaddr_un sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    std::strcpy(sa.sun_path, host.c_str());
+    unlink(host.c_str());   // stale socket of a previous run
+    if (bind(fd, (sockaddr *) &sa, sizeof(sa)) != 0 || listen(fd, 64) != 0) {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  addrinfo hints, *res = NULL;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  const char *node = (host.empty() || host == "*") ? NULL : host.c_str();
+  if (getaddrinfo(node, port.c_str(), &hints, &res) != 0) {
+    return -1;
+  }
+  int fd = -1;
+  for (addrinfo *ai = res; ai != NULL; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 64) == 0) {
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  return fd;
+}
+
+
+// connected socket to `address`, -1 on failure
+inline int dist_connect(const std::string &address)
+{
+  bool isUnix;
+  std::string host, port;
+  if (!dist_parse_address(address, &isUnix, &host, &port)) {
+    return -1;
+  }
+
+  int fd = -1;
+  if (isUnix) {
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      return -1;
+    }
+    sockaddr_un sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    std::strcpy(sa.sun_path, host.c_str());
+    if (connect(fd, (sockaddr *) &sa, sizeof(sa)) != 0) {
+      close(fd);
+      return -1;
+    }
+  }
+  else {
+    addrinfo hints, *res = NULL;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) {
+      return -1;
+    }
+    for (addrinfo *ai = res; ai != NULL; ai = ai->ai_next) {
+      fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+      if (fd < 0) {
+        continue;
+      }
+      if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+        break;
+      }
+      close(fd);
+      fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) {
+      return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+  dist_no_sigpipe(fd);
+  return fd;
+}
+
+
+// blocking `recv` and `send` of `fd` fail (EAGAIN) after `seconds`
+inline bool dist_set_timeout(int fd, double seconds)
+{
+  timeval tv;
+  tv.tv_sec = time_t(seconds);
+  tv.tv_usec = suseconds_t((seconds - double(tv.tv_sec))*1e6);
+  return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0
+    && setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) == 0;
+}
+
+
+inline bool dist_send_all(int fd, const void *buf, size_t n)
+{
+  const char *p = (const char *) buf;
+  while (n > 0) {
+    const ssize_t k = send(fd, p, n, DIST_SEND_FLAGS);
+    if (k < 0 && errno == EINTR) {
+      continue;
+    }
+    if (k <= 0) {
+      return false;
+    }
+    p += k;
+    n -= size_t(k);
+  }
+  return true;
+}
+
+
+inline bool dist_recv_all(int fd, void *buf, size_t n)
+{
+  char *p = (char *) buf;
+  while (n > 0) {
+    const ssize_t k = recv(fd, p, n, 0);
+    if (k < 0 && errno == EINTR) {
+      continue;
+    }
+    if (k <= 0) {
+      return false;
+    }
+    p += k;
+    n -= size_t(k);
+  }
+  return true;
+}
+
+
+// one message with a payload of two parts (either may be empty)
+inline bool dist_send_msg(int fd, uint32_t type,
+  const void *a = NULL, size_t na = 0, const void *b = NULL, size_t nb = 0)
+{
+  DistMsgHeader hdr = {type, 0, uint64_t(na + nb)};
+  return dist_send_all(fd, &hdr, sizeof(hdr))
+    && (na == 0 || dist_send_all(fd, a, na))
+    && (nb == 0 || dist_send_all(fd, b, nb));
+}
+
+
+// append one message to `out`, for a sender that must not block
+inline void dist_pack_msg(std::vector<char> *out, uint32_t type,
+  const void *a = NULL, size_t na = 0)
+{
+  const DistMsgHeader hdr = {type, 0, uint64_t(na)};
+  out->insert(out->end(), (const char *) &hdr, (const char *) &hdr + sizeof(hdr));
+  out->insert(out->end(), (const char *) a, (const char *) a + na);
+}
+
+
+// send what the socket takes now from the front of `out` (never blocks);
+// false if the socket failed
+inline bool dist_flush(int fd, std::vector<char> *out)
+{
+  size_t sent = 0;
+  while (sent < out->size()) {
+    const ssize_t k = send(fd, out->data() + sent, out->size() - sent,
+      DIST_SEND_FLAGS | MSG_DONTWAIT);
+    if (k < 0 && errno == EINTR) {
+      continue;
+    }
+    if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (k <= 0) {
+      return false;
+    }
+    sent += size_t(k);
+  }
+  out->erase(out->begin(), out->begin() + sent);
+  return true;
+}
+
+
+// blocking receipt of one message; false on failure or a length beyond
+// `dist_max_len` (P bounds RESULT)
+inline bool dist_recv_msg(int fd, uint32_t *type, std::vector<char> *payload,
+  uint64_t P = 0)
+{
+  DistMsgHeader hdr;
+  if (!dist_recv_all(fd, &hdr, sizeof(hdr))
+    || hdr.len > dist_max_len(hdr.type, P))
+  {
+    return false;
+  }
+  *type = hdr.type;
+  payload->resize(size_t(hdr.len));
+  return hdr.len == 0 || dist_recv_all(fd, payload->data(), size_t(hdr.len));
+}
+
+
+/*************************************************
+ *    result file
+ *************************************************/
+
+static const char DIST_MAGIC[8] = {'C', 'C', 'P', 'L', 'M', 'D', 'S', 'T'};
+
+inline uint64_t dist_result_offset_done() {
+  return 64;
+}
+
+inline uint64_t dist_result_offset_data(uint64_t N) {
+  return 64 + (N + 7) / 8 * 8;
+}
+
+
+// open (or create) the result file; `done` gets the flags of the nodes
+// 0 on success, 1 on I/O failure, 2 if the file holds another problem
+inline int dist_result_open(const char *filename, uint64_t N, uint64_t P,
+  int *fdOut, std::vector<uint8_t> *done)
+{
+  const int fd = open(filename, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    return 1;
+  }
+  *fdOut = fd;
+  done->assign(size_t(N), 0);
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    return 1;
+  }
+  if (st.st_size == 0) {
+    char hdr[64];
+    std::memset(hdr, 0, sizeof(hdr));
+    std::memcpy(hdr, DIST_MAGIC, 8);
+    const uint32_t version = 1;
+    std::memcpy(hdr + 8, &version, 4);
+    std::memcpy(hdr + 16, &N, 8);
+    std::memcpy(hdr + 24, &P, 8);
+    if (pwrite(fd, hdr, 64, 0) != 64) {
+      return 1;
+    }
+    const off_t size = off_t(dist_result_offset_data(N) + 8*P*N);
+    return ftruncate(fd, size) == 0 ? 0 : 1;   // sparse, zeros
+  }
+
+  char hdr[64];
+  if (pread(fd, hdr, 64, 0) != 64 || std::memcmp(hdr, DIST_MAGIC, 8) != 0) {
+    return 2;
+  }
+  uint64_t N0, P0;
+  std::memcpy(&N0, hdr + 16, 8);
+  std::memcpy(&P0, hdr + 24, 8);
+  if (N0 != N || P0 != P) {
+    return 2;
+  }
+  if (pread(fd, done->data(), size_t(N), off_t(dist_result_offset_done()))
+    != ssize_t(N))
+  {
+    return 1;
+  }
+  return 0;
+}
+
+
+// data of `fd` on disk
+inline bool dist_datasync(int fd)
+{
+#if defined(__linux__)
+  return fdatasync(fd) == 0;
+#else
+  return fsync(fd) == 0;    // no `fdatasync` on macOS
+#endif
+}
+
+
+// write column r and sync it, then mark it done
+inline bool dist_result_write(int fd, uint64_t N, uint64_t P, uint64_t r,
+  const double *x)
+{
+  const off_t off = off_t(dist_result_offset_data(N) + 8*P*r);
+  const size_t n = size_t(8*P);
+  size_t written = 0;
+  while (written < n) {
+    const ssize_t k = pwrite(fd, (const char *) x + written, n - written,
+      off + off_t(written));
+    if (k <= 0) {
+      return false;
+    }
+    written += size_t(k);
+  }
+  if (!dist_datasync(fd)) {
+    return false;
+  }
+  const uint8_t one = 1;
+  return pwrite(fd, &one, 1, off_t(dist_result_offset_done() + r)) == 1;
+}
+
+#endif // DIST_PROTOCOL_HPP
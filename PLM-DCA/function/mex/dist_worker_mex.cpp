@@ -0,0 +1,243 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * specFile = dist_worker_mex('connect', address, heartbeat[, wait[, timeout]])
+ * range    = dist_worker_mex('next')
+ * isSent   = dist_worker_mex('send', r, r_h_and_J)
+ *            dist_worker_mex('close')
+ *
+ *  address    char      address of the coordinator (see `dist_coord_mex`)
+ *  heartbeat  double    seconds between two heartbeats
+ *  wait       double    seconds during which a refused or failed connection
+ *                       is retried, once a second (default 0: no retry)
+ *  timeout    double    seconds without a message from the coordinator (or a
+ *                       send blocked) after which it is considered lost
+ *                       (default 600; more than `DIST_PING_INTERVAL`)
+ *  specFile   char      job specification given by the coordinator
+ *  range      double    [r0 r1], nodes r0:r1 (1-based) to do; [] when there
+ *                       is no more work
+ *  r          double    node (1-based)
+ *  r_h_and_J  double    result of node r
+ *  isSent     logical   false if the coordinator is gone (e.g. it finished
+ *                       while this node was re-assigned); `next` then
+ *                       returns []
+ *
+ * One connection per MATLAB process. After `connect`, a native thread sends a
+ * heartbeat every `heartbeat` seconds, so that the coordinator keeps the
+ * worker alive while MATLAB is busy in `minFunc` or waits in `next`. A
+ * coordinator which keeps `next` waiting sends heartbeats too; `next` raises
+ * an error if none arrives within `timeout`, e.g. when the host of the
+ * coordinator is gone. The MEX file stays locked until `close`.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v1.2  `wait`: connecting is retried; `timeout` of receipt
+ * - 2018-05-10  v1.1  messages longer than their type allows are rejected
+ * - 2018-05-07  v1
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mex.h"
+#include "dist_protocol.hpp"
+
+using namespace std;
+
+
+static int                 g_fd = -1;
+static thread              g_heartbeat;
+static mutex               g_sendMtx;    // the heartbeat thread sends too
+static mutex               g_stopMtx;
+static condition_variable  g_stopCv;
+static bool                g_stop = false;
+static bool                g_isDone = false;
+
+
+static void disconnect()
+{
+  if (g_heartbeat.joinable()) {
+    {
+      lock_guard<mutex> lock(g_stopMtx);
+      g_stop = true;
+    }
+    g_stopCv.notify_all();
+    g_heartbeat.join();
+  }
+  if (g_fd >= 0) {
+    close(g_fd);
+    g_fd = -1;
+  }
+  if (mexIsLocked()) {
+    mexUnlock();
+  }
+}
+
+
+static void heartbeat_loop(int fd, double interval)
+{
+  const chrono::duration<double> dt(interval);
+  unique_lock<mutex> lock(g_stopMtx);
+  while (!g_stopCv.wait_for(lock, dt, []{ return g_stop; })) {
+    lock_guard<mutex> sendLock(g_sendMtx);
+    if (!dist_send_msg(fd, DIST_HEARTBEAT)) {
+      return;
+    }
+  }
+}
+
+
+static string get_string(const mxArray *pm, const char *name)
+{
+  if (!mxIsChar(pm)) {
+    mexErrMsgIdAndTxt("dist_worker_mex:prhs:WrongType",
+      "`%s` should be provided as a string.", name);
+  }
+  char *pc = mxArrayToString(pm);
+  const string s(pc);
+  mxFree(pc);
+  return s;
+}
+
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nrhs < 1) {
+    mexErrMsgIdAndTxt("dist_worker_mex:nrhs", "A command is required.");
+  }
+  const string cmd = get_string(prhs[0], "command");
+
+  if (cmd == "connect") {
+    if (nrhs < 3 || nrhs > 5 || !mxIsDouble(prhs[2])
+      || (nrhs >= 4 && !mxIsDouble(prhs[3]))
+      || (nrhs == 5 && !mxIsDouble(prhs[4])))
+    {
+      mexErrMsgIdAndTxt("dist_worker_mex:nrhs",
+        "Syntax: dist_worker_mex('connect', address, heartbeat[, wait[, timeout]])");
+    }
+    if (g_fd >= 0) {
+      mexErrMsgIdAndTxt("dist_worker_mex:connect", "Already connected.");
+    }
+    const string address = get_string(prhs[1], "address");
+    const double interval = mxGetScalar(prhs[2]);
+    const double wait = nrhs >= 4 ? mxGetScalar(prhs[3]) : 0.0;
+    const double timeout = nrhs == 5 ? mxGetScalar(prhs[4]) : 600.0;
+    if (!(timeout > DIST_PING_INTERVAL)) {
+      mexErrMsgIdAndTxt("dist_worker_mex:connect",
+        "`timeout` should exceed %d s.", DIST_PING_INTERVAL);
+    }
+
+    // the coordinator may not listen yet
+    const chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    g_fd = dist_connect(address);
+    while (g_fd < 0 && chrono::duration<double>(
+      chrono::steady_clock::now() - t0).count() < wait)
+    {
+      this_thread::sleep_for(chrono::seconds(1));
+      g_fd = dist_connect(address);
+    }
+    if (g_fd < 0) {
+      mexErrMsgIdAndTxt("dist_worker_mex:connect",
+        "Could not connect to `%s`.", address.c_str());
+    }
+    uint32_t type;
+    vector<char> payload;
+    if (!dist_set_timeout(g_fd, timeout)
+      || !dist_send_msg(g_fd, DIST_HELLO)
+      || !dist_recv_msg(g_fd, &type, &payload) || type != DIST_SPEC)
+    {
+      disconnect();
+      mexErrMsgIdAndTxt("dist_worker_mex:connect",
+        "No job specification from `%s`.", address.c_str());
+    }
+    mexLock();
+    mexAtExit(disconnect);
+    g_stop = false;
+    g_isDone = false;
+    g_heartbeat = thread(heartbeat_loop, g_fd, interval > 0 ? interval : 1.0);
+
+    plhs[0] = mxCreateString(string(payload.begin(), payload.end()).c_str());
+    return;
+  }
+
+  if (cmd == "next") {
+    if (g_fd < 0 || g_isDone) {
+      plhs[0] = mxCreateDoubleMatrix(0, 0, mxREAL);
+      return;
+    }
+    bool isOK;
+    {
+      lock_guard<mutex> lock(g_sendMtx);
+      isOK = dist_send_msg(g_fd, DIST_REQUEST);
+    }
+    // the DONE of a finished coordinator may still be in the socket;
+    // heartbeats come while the coordinator keeps this worker waiting
+    uint32_t type;
+    vector<char> payload;
+    do {
+      if (!dist_recv_msg(g_fd, &type, &payload)) {
+        const bool isTimedOut = errno == EAGAIN || errno == EWOULDBLOCK;
+        disconnect();
+        mexErrMsgIdAndTxt("dist_worker_mex:next",
+          isTimedOut ? "The coordinator sent nothing within the timeout."
+          : isOK ? "The coordinator closed the connection."
+                 : "The coordinator is not reachable.");
+      }
+    } while (type == DIST_HEARTBEAT);
+    if (type == DIST_DONE) {
+      g_isDone = true;
+      plhs[0] = mxCreateDoubleMatrix(0, 0, mxREAL);
+      return;
+    }
+    if (type != DIST_RANGE || payload.size() != 16) {
+      disconnect();
+      mexErrMsgIdAndTxt("dist_worker_mex:next", "Unexpected message.");
+    }
+    uint64_t range[2];
+    memcpy(range, payload.data(), 16);
+    plhs[0] = mxCreateDoubleMatrix(1, 2, mxREAL);
+    mxGetPr(plhs[0])[0] = double(range[0] + 1);
+    mxGetPr(plhs[0])[1] = double(range[1]);
+    return;
+  }
+
+  if (cmd == "send") {
+    if (nrhs != 3 || !mxIsDouble(prhs[1]) || !mxIsDouble(prhs[2])) {
+      mexErrMsgIdAndTxt("dist_worker_mex:nrhs",
+        "Syntax: dist_worker_mex('send', r, r_h_and_J)");
+    }
+    bool isOK = false;
+    if (g_fd >= 0 && !g_isDone) {
+      const uint64_t r = uint64_t(mxGetScalar(prhs[1])) - 1;
+      lock_guard<mutex> lock(g_sendMtx);
+      isOK = dist_send_msg(g_fd, DIST_RESULT, &r, 8, mxGetPr(prhs[2]),
+        8*mxGetNumberOfElements(prhs[2]));
+    }
+    if (nlhs > 0) {
+      plhs[0] = mxCreateLogicalScalar(isOK);
+    }
+    return;
+  }
+
+  if (cmd == "close") {
+    disconnect();
+    return;
+  }
+
+  mexErrMsgIdAndTxt("dist_worker_mex:command",
+    "Unknown command `%s`.", cmd.c_str());
+}
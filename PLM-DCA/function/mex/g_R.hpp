@@ -0,0 +1,193 @@
+#ifndef G_R_TILE_HPP
+#define G_R_TILE_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Objective and gradient of `g_r` (see `g_r.v02.h`) for a tile of R nodes,
+ * r_1, ..., r_R, computed in one sweep over the MSA.
+ *
+ * Samples are processed in blocks of `G_R_BLOCK` sequences. For every block,
+ *
+ *  1. the block of `S` is transposed once into a site-major tile
+ *     (`T[i*nb + bb]` = $s_i^{b_0+bb}$), which is then reused by all R nodes;
+ *  2. for every node r of the tile, the sites are visited in the outer loop
+ *     and the samples of the block in the inner loop, so that each q*q block
+ *     $J_{ri}$ (and its gradient) is loaded once per block instead of once
+ *     per sample.
+ *
+ * Thus `S` is read once per tile rather than once per node, and the traffic on
+ * `J_r` and `grad_J_r` is divided by the block size.
+ *
+ *
+ * # Output (by pointer)
+ *
+ *  *Initialization* needed: obj[] and grad[] should be 0.
+ *
+ *  obj      : R elements, objective of each node
+ *  grad     : (q + q*q*(N-1))*R elements, [grad_h_r; grad_J_r] of each node
+ *
+ *
+ * # Input
+ *
+ *  B, N, q, S, w, B_eff, l_h, l_J : same as `g_r`
+ *  R        : number of nodes in the tile
+ *  r        : R node indices, 0-indexing, [0, N-1]
+ *  h_and_J  : (q + q*q*(N-1))*R elements, [h_r; J_r] of each node
+ *
+ *
+ * # Return
+ *
+ *  -1 on success; otherwise the index (0-based) of a node whose `Num[k]` is
+ *  too large and likely to overflow `exp(Num[k])`. No MATLAB API is called,
+ *  thus it is safe to call from native threads.
+ *
+ *
+ * # History
+ *
+ * ## 2018-03-28  v1
+ */
+
+#include <math.h>   // exp() and log()
+#include <stdint.h> // uint8_t
+#include <vector>
+
+#ifndef G_R_BLOCK
+#define G_R_BLOCK 32
+#endif
+
+
+inline long g_R(
+  double *obj, double *grad,
+  const size_t B, const size_t N, const size_t q,
+  const uint8_t *S,
+  const double *w, const double B_eff,
+  const size_t R, const size_t *r,
+  const double *h_and_J,
+  const double l_h, const double l_J)
+{
+  const size_t P = q + q*q*(N-1);   // number of parameters per node
+
+  std::vector<uint8_t> T(N*G_R_BLOCK);
+  std::vector<double>  Prob(q*G_R_BLOCK); // Num, then Prob, of each sample
+
+  for (size_t b0 = 0; b0 < B; b0 += G_R_BLOCK) {
+    const size_t nb = (b0 + G_R_BLOCK < B) ? G_R_BLOCK : B - b0;
+
+    /* site-major copy of the block, shared by all nodes of the tile */
+    for (size_t bb = 0; bb < nb; bb++) {
+      const uint8_t *s = S + N*(b0+bb);
+      for (size_t i = 0; i < N; i++) {
+        T[i*nb + bb] = s[i];
+      }
+    }
+
+    for (size_t t = 0; t < R; t++) {
+      const size_t   rt   = r[t];
+      const double  *h_r  = h_and_J + P*t;
+      const double  *J_r  = h_r + q;
+      double        *gh_r = grad + P*t;
+      double        *gJ_r = gh_r + q;
+      const uint8_t *s_r  = T.data() + rt*nb;   // s_r^b of the block
+
+      /* begin: calculate $h_r(k) + \sum_{i \neq r} J_{r i}(k, s_i^b)$ */
+      for (size_t bb = 0; bb < nb; bb++) {
+        for (size_t k = 0; k < q; k++) {
+          Prob[q*bb + k] = h_r[k];
+        }
+      }
+      for (size_t i = 0; i < N; i++) {
+        if (i == rt) {
+          continue;
+        }
+        const double  *J_ri = J_r + q*q*(i < rt ? i : i-1);
+        const uint8_t *s_i  = T.data() + i*nb;
+        for (size_t bb = 0; bb < nb; bb++) {
+          const double *J_ri_s = J_ri + q*s_i[bb];   // J_{ri}(:,s_i^b)
+          double *Num = Prob.data() + q*bb;
+          for (size_t k = 0; k < q; k++) {
+            Num[k] += J_ri_s[k];
+          }
+        }
+      }
+      /* end */
+
+      // Num -> Prob; objective and gradient of h_r
+      for (size_t bb = 0; bb < nb; bb++) {
+        double *Num = Prob.data() + q*bb;
+        double Z_r = 0;
+        for (size_t k = 0; k < q; k++) {
+          if (Num[k] > 709.0) {
+            return long(rt);
+          }
+          Num[k] = exp(Num[k]);
+          Z_r   += Num[k];
+        }
+        const double wb = w[b0+bb];
+        for (size_t k = 0; k < q; k++) {
+          Num[k] /= Z_r;            // now `Num` is `Prob`
+          gh_r[k] += wb * Num[k];
+        }
+        const size_t srb = s_r[bb];
+        obj[t]    -= wb * log(Num[srb]);
+        gh_r[srb] -= wb;
+      }
+
+      // gradient of J_{r i}(k, s_i^b)
+      for (size_t i = 0; i < N; i++) {
+        if (i == rt) {
+          continue;
+        }
+        double        *gJ_ri = gJ_r + q*q*(i < rt ? i : i-1);
+        const uint8_t *s_i   = T.data() + i*nb;
+        for (size_t bb = 0; bb < nb; bb++) {
+          const double  wb = w[b0+bb];
+          const double *Pb = Prob.data() + q*bb;
+          double *gJ_ri_s  = gJ_ri + q*s_i[bb];
+          for (size_t k = 0; k < q; k++) {
+            gJ_ri_s[k] += wb * Pb[k];
+          }
+          gJ_ri_s[s_r[bb]] -= wb;
+        }
+      }
+    }
+  }
+
+
+  /*************************************************
+   *    from sum to mean, and add L2 regulator
+   *************************************************/
+  for (size_t t = 0; t < R; t++) {
+    const double *h_r = h_and_J + P*t;
+    double *g = grad + P*t;
+
+    obj[t] /= B_eff;
+    for (size_t p = 0; p < P; p++) {
+      g[p] /= B_eff;
+    }
+
+    if (l_h > 0.0) {
+      for (size_t k = 0; k < q; k++) {
+        g[k]   += l_h*h_r[k]*2;
+        obj[t] += l_h*h_r[k]*h_r[k];
+      }
+    }
+    if (l_J > 0.0) {
+      for (size_t p = q; p < P; p++) {
+        g[p]   += l_J*h_r[p]*2;
+        obj[t] += l_J*h_r[p]*h_r[p];
+      }
+    }
+  }
+
+  return -1;
+}
+
+#endif // G_R_TILE_HPP
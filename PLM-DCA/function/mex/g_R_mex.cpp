@@ -0,0 +1,227 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * [obj, R_grad_h_and_J, obj_r] = g_R_mex(...
+ *   S, ...
+ *   N, B, q, ...
+ *   w, B_eff, ...
+ *   rlist, R_h_and_J, ...
+ *   lambda, ...
+ *   SkipCheckFlag)
+ *
+ *  S          uint8     [0, 255], N rows, B columns (column-major)
+ *  N          uint64    length of sequence (for check: to be robust)
+ *  B          uint64    number of sequences (for check: to be robust)
+ *  q          uint64    $q \le 256$ since S is uint8.
+ *  w          double    $\{ w_b \}$
+ *  B_eff      double    $B_{\text{eff}} = \sum_{b=1}^B w_b$
+ *  rlist      uint64    R node indices, [1,N]
+ *  R_h_and_J  double    $(q + q^2(N-1)) R$ elements; column t (after
+ *                       reshaping to R columns) is `r_h_and_J` of node rlist(t)
+ *  lambda     double    2 elements: first is $\lambda_h$, second is $\lambda_J$
+ *
+ *  obj             sum of the objectives of the R nodes
+ *  R_grad_h_and_J  $(q + q^2(N-1)) R$ rows, 1 column; gradient of `obj`
+ *  obj_r           1-by-R, objective of each node
+ *
+ * Since the objectives of different nodes share no parameter, minimizing `obj`
+ * over `R_h_and_J` minimizes every `g_r` of the tile (cf. `min_g_R`). This MEX
+ * file has the same semantics as calling `g_r_mex_v2` R times, but reads `S`
+ * only once (see `g_R.hpp`).
+ *
+ * `SkipCheckFlag` is a placeholder as in `g_r_mex_v2`.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v1.1  the node of an overflow is reported 1-based
+ * - 2018-03-28  v1
+ */
+
+
+#include <vector>
+#include "mex.h"
+#include "g_R.hpp"
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs > 3) {
+    mexErrMsgIdAndTxt(
+      "g_R_mex:nlhs",
+      "This function can only calculate objective and gradient.");
+  }
+  // default to check, 10-th arugment is a placeholder to skip check
+  if (nrhs != 9 && nrhs != 10) {
+    mexErrMsgIdAndTxt(
+      "g_R_mex:nrhs",
+      "Number of arguments supported: 9, 10\n"
+      "provided: %d", nrhs);
+  }
+
+  const mxArray *pm_S           = prhs[0];
+  const mxArray *pm_N           = prhs[1];
+  const mxArray *pm_B           = prhs[2];
+  const mxArray *pm_q           = prhs[3];
+  const mxArray *pm_w           = prhs[4];
+  const mxArray *pm_B_eff       = prhs[5];
+  const mxArray *pm_rlist       = prhs[6];
+  const mxArray *pm_R_h_and_J   = prhs[7];
+  const mxArray *pm_lambda      = prhs[8];
+
+  // check when only 9 arguments are provided
+  if (nrhs == 9) {
+    /* type check */
+    if (   !mxIsUint8(pm_S)
+        || !mxIsUint64(pm_N)
+        || !mxIsUint64(pm_B)
+        || !mxIsUint64(pm_q)
+        || !mxIsUint64(pm_rlist)
+        || !mxIsDouble(pm_w)
+        || !mxIsDouble(pm_B_eff)
+        || !mxIsDouble(pm_R_h_and_J)
+        || !mxIsDouble(pm_lambda) )
+    {
+      mexErrMsgIdAndTxt(
+        "g_R_mex:prhs:WrongType",
+        "Requirement:\n"
+        "   uint8:    S\n"
+        "  uint64:    N,  B,  q,  rlist\n"
+        "  double:    w,  B_eff,  R_h_and_J,  lambda");
+    }
+
+    for (int k = 0; k < 9; k++) {
+      if (mxIsComplex(prhs[k])) {
+        mexErrMsgIdAndTxt(
+          "g_R_mex:prhs:IsComplex",
+          "\tAll inputs should be real.");
+      }
+    }
+
+    if ( mxGetNumberOfElements(pm_N) != 1
+      || mxGetNumberOfElements(pm_B) != 1
+      || mxGetNumberOfElements(pm_q) != 1
+      || mxGetNumberOfElements(pm_B_eff) != 1 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_R_mex:prhs:ScalarWrong",
+        "\tAll of {N, B, q, B_eff} should be scalar.");
+    }
+
+    const size_t N0 = *((uint64_t *) mxGetData(pm_N));
+    const size_t B0 = *((uint64_t *) mxGetData(pm_B));
+    const size_t q0 = *((uint64_t *) mxGetData(pm_q));
+    const size_t R0 = mxGetNumberOfElements(pm_rlist);
+
+    if ( mxGetM(pm_S) != N0
+      || mxGetN(pm_S) != B0 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_R_mex:prhs:S",
+        "\tColumns of `S` are considered as sequences.\n"
+        "\tThus `S` should be a matrix consists of `N` rows and `B` columns");
+    }
+
+    if (q0 < 2 || q0 > 256) {
+        mexErrMsgIdAndTxt(
+          "g_R_mex:prhs:q",
+          "Requirement on q:\n"
+          "\tq >= 2 since 1-state Potts model is trivial.\n"
+          "\tq <= 256 since `S` can only stores 0~255.\n");
+    }
+
+    if (mxGetNumberOfElements(pm_w) != B0) {
+      mexErrMsgIdAndTxt(
+        "g_R_mex:prhs:w",
+        "\t`w`, which contains weights of sequences, mismatches `S`.\n");
+    }
+
+    if (R0 == 0) {
+      mexErrMsgIdAndTxt(
+        "g_R_mex:prhs:rlist",
+        "\t`rlist` should contain at least one node.");
+    }
+    const uint64_t *rlist0 = (uint64_t *) mxGetData(pm_rlist);
+    for (size_t t = 0; t < R0; t++) {
+      if (rlist0[t] > N0 || rlist0[t] == 0) {
+        mexErrMsgIdAndTxt(
+          "g_R_mex:prhs:rlist",
+          "\t`rlist` should contain integers in [1,N].");
+      }
+    }
+
+    if (mxGetNumberOfElements(pm_R_h_and_J) != (q0 + q0*q0*(N0-1))*R0) {
+      mexErrMsgIdAndTxt(
+        "g_R_mex:prhs:R_h_and_J",
+        "\t`R_h_and_J`, "
+        "which contains h_r and J_r of the R nodes in `rlist`, "
+        "should contain (q + q*q*(N-1))*R elements\n");
+    }
+
+    if (mxGetNumberOfElements(pm_lambda) != 2) {
+      mexErrMsgIdAndTxt(
+        "g_R_mex:prhs:lambda",
+        "\t`lambda`, which contains lambda_h and lambda_J, "
+        "should contains 2 real numbers.");
+    }
+    if (mxGetPr(pm_lambda)[0] < 0.0 || mxGetPr(pm_lambda)[1] < 0.0) {
+      mexErrMsgIdAndTxt("g_R_mex:prhs:lambda",
+        "\t`lambda` may not be negative.");
+    }
+  }
+
+  const size_t   N       = mxGetM(pm_S);
+  const size_t   B       = mxGetN(pm_S);
+  const size_t   q       = *((uint64_t *) mxGetData(pm_q));
+  const size_t   R       = mxGetNumberOfElements(pm_rlist);
+  const uint64_t *rlist  = (uint64_t *) mxGetData(pm_rlist);
+  const uint8_t *S       = (uint8_t *) mxGetData(pm_S);
+  const double  *w       = mxGetPr(pm_w);
+  const double   B_eff   = mxGetPr(pm_B_eff)[0];
+  const double  *h_and_J = mxGetPr(pm_R_h_and_J);
+  const double   l_h     = mxGetPr(pm_lambda)[0];
+  const double   l_J     = mxGetPr(pm_lambda)[1];
+  const size_t   P       = q + q*q*(N-1);
+
+  std::vector<size_t> r(R);
+  for (size_t t = 0; t < R; t++) {
+    r[t] = rlist[t] - 1;
+  }
+
+  // `mxCreateDoubleMatrix` initializes each element to 0, required by `g_R`
+  mxArray *pm_obj_r = mxCreateDoubleMatrix(1, R, mxREAL);
+  double *obj_r = mxGetPr(pm_obj_r);
+  plhs[1] = mxCreateDoubleMatrix(P*R, 1, mxREAL);
+  double *grad = mxGetPr(plhs[1]);
+
+  const long r_overflow = g_R(obj_r, grad,
+    B, N, q, S, w, B_eff, R, r.data(), h_and_J, l_h, l_J);
+  if (r_overflow >= 0) {
+    mexErrMsgIdAndTxt(
+      "g_R_mex:overflow:exp",
+      "r = %ld:  "
+      "`Num[k]` is too large and likely to overflow `exp(Num[k])`\n",
+      r_overflow + 1);   // 1-based, as `rlist` and `g_r_mex_v2`
+  }
+
+  double obj = 0.0;
+  for (size_t t = 0; t < R; t++) {
+    obj += obj_r[t];
+  }
+  plhs[0] = mxCreateDoubleScalar(obj);
+
+  if (nlhs > 2) {
+    plhs[2] = pm_obj_r;
+  }
+  else {
+    mxDestroyArray(pm_obj_r);
+  }
+}
@@ -44,6 +44,14 @@
  *  l_J    : lambda for L2 regularization on J_r
  *
  *
+ * # Return (`g_r` and `g_r_value`)
+ *
+ *  -1 on success; otherwise `r`, when `Num[k]` is too large and likely to
+ *  overflow `exp(Num[k])` (outputs are then incomplete). No MATLAB API is
+ *  called, thus it is safe to call from native threads; the gateway raises the
+ *  error.
+ *
+ *
  *  # Note for implementation
  *
  *  In this function, `q` is chosen to be `size_t` to avoid integer overflow
@@ -52,6 +60,19 @@
  *
  *  # History
  *
+ *  ## 2018-05-10  v2.3
+ *  - `g_r` and `g_r_value` return the node on overflow instead of calling
+ *    `mexErrMsgIdAndTxt`, which may not be called from native threads
+ *
+ *  ## 2018-04-12  v2.2
+ *  - `g_r` split into `g_r_value` (objective only, optionally keeping `Prob` of
+ *    every sample) and `g_r_grad_Prob` (gradient from the kept `Prob`), for
+ *    evaluations where the gradient is not needed or is needed later
+ *
+ *  ## 2018-03-12  v2.1
+ *  - `Num` and `Prob` live on the stack (q <= 256), so that `g_r` can be
+ *    called from native threads where `mxMalloc` is not allowed
+ *
  *  ## 2017-08-09  v2
  *  - (q*S_i^b + q*q*i) -> (q*(S_i^b + q*i))
  *  - change the order of `mxFree`
@@ -62,10 +83,9 @@
 
 #include <math.h>   // exp() and log()
 #include <stdint.h> // uint8_t
-#include "mex.h"    // mxMalloc & mxFree, mexErrMsgIdAndTxt
 
 extern inline
-void g_r(
+long g_r(
   double *obj, double *grad_h_r, double *grad_J_r,
   const size_t B, const size_t N, const size_t q,
   const uint8_t *S,
@@ -88,8 +108,8 @@ void g_r(
    *   used to calculate gradient of h and J.
    *
    */
-  double *Num  = (double*) mxMalloc(sizeof *Num * q);
-  double *Prob = (double*) mxMalloc(sizeof *Prob * q);
+  double Num[256];
+  double Prob[256];
 
   // loop over samples
   for (size_t b = 0; b < B; b++) {
@@ -120,11 +140,7 @@ void g_r(
     double Z_r = 0;
     for (size_t k = 0; k < q; k++) {
       if (Num[k] > 709.0) {
-        mexErrMsgIdAndTxt(
-          "g_rC:overflow:exp",
-          "r = %ld:  "
-          "`Num[k]` is too large and likely to overflow `exp(Num[k])`\n",
-          r);
+        return long(r);
       }
 
       // Now Num[k] is safe
@@ -164,9 +180,6 @@ void g_r(
 
   }
 
-  mxFree(Prob);
-  mxFree(Num);
-
 
   /*************************************************
    *    from sum to mean (easy to be vectorized)
@@ -196,4 +209,140 @@ void g_r(
       *obj        += l_J*J_r[i]*J_r[i];
     }
   }
+
+  return -1;
+}
+
+
+
+/**
+ * Objective of `g_r` only, i.e. without the scatter into `grad_J_r`.
+ *
+ * If `Prob_all` is not NULL, it receives (q*B elements)
+ * $P(s_r^b = k | \underline{s}_{\partial r}^b)$ at `Prob_all[k + q*b]`, from
+ * which `g_r_grad_Prob` gets the gradient at the same point.
+ *
+ * *Initialization* needed: obj[0] should be 0.
+ */
+extern inline
+long g_r_value(
+  double *obj,
+  const size_t B, const size_t N, const size_t q,
+  const uint8_t *S,
+  const double *w, const double B_eff,
+  const size_t r,
+  const double *h_r, const double *J_r,
+  const double l_h, const double l_J,
+  double *Prob_all)
+{
+  double Num[256];
+
+  for (size_t b = 0; b < B; b++) {
+    for (size_t k = 0; k < q; k++) {
+      Num[k] = h_r[k];
+    }
+    for (size_t i = 0; i < r; i++) {
+      for (size_t k = 0; k < q; k++) {
+        Num[k] += J_r[k + q*(S[N*b+i] + q*i)];        // J_{ri}(k,s_i^b), i < r
+      }
+    }
+    for (size_t i = r+1; i < N; i++) {
+      for (size_t k = 0; k < q; k++) {
+        Num[k] += J_r[k + q*(S[N*b+i] + q*(i-1))];    // J_{ri}(k,s_i^b), i > r
+      }
+    }
+
+    double Z_r = 0;
+    for (size_t k = 0; k < q; k++) {
+      if (Num[k] > 709.0) {
+        return long(r);
+      }
+      Num[k] = exp(Num[k]);
+      Z_r   += Num[k];
+    }
+
+    size_t srb = S[N*b+r];  // s_r^b
+    *obj -= w[b] * log(Num[srb] / Z_r);
+
+    if (Prob_all != NULL) {
+      for (size_t k = 0; k < q; k++) {
+        Prob_all[k + q*b] = Num[k] / Z_r;
+      }
+    }
+  }
+
+  *obj /= B_eff;
+
+  if (l_h > 0.0) {
+    for (size_t k = 0; k < q; k++) {
+      *obj += l_h*h_r[k]*h_r[k];
+    }
+  }
+  if (l_J > 0.0) {
+    for (size_t i = 0; i < (q*q*(N-1)); i++) {
+      *obj += l_J*J_r[i]*J_r[i];
+    }
+  }
+
+  return -1;
+}
+
+
+/**
+ * Gradient of `g_r` at (h_r, J_r), given `Prob_all` computed by `g_r_value`
+ * at the same point.
+ *
+ * *Initialization* needed: grad_h_r[] and grad_J_r[] should be 0.
+ */
+extern inline
+void g_r_grad_Prob(
+  double *grad_h_r, double *grad_J_r,
+  const size_t B, const size_t N, const size_t q,
+  const uint8_t *S,
+  const double *w, const double B_eff,
+  const size_t r,
+  const double *h_r, const double *J_r,
+  const double l_h, const double l_J,
+  const double *Prob_all)
+{
+  for (size_t b = 0; b < B; b++) {
+    const double *Prob = Prob_all + q*b;
+    size_t srb = S[N*b+r];  // s_r^b
+
+    for (size_t k = 0; k < q; k++) {
+      grad_h_r[k] += w[b] * Prob[k];
+    }
+    grad_h_r[srb] -= w[b];
+
+    for (size_t j = 0; j < r; j++) {    // j < r
+      for (size_t k = 0; k < q; k++) {
+        grad_J_r[k + q*(S[N*b+j] + q*j)] += w[b]*Prob[k];
+      }
+      grad_J_r[srb + q*(S[N*b+j] + q*j)] -= w[b];
+    }
+    for (size_t j = r+1; j < N; j++) {  // j > r
+      for (size_t k = 0; k < q; k++) {
+        grad_J_r[k + q*(S[N*b+j] + q*(j-1))] += w[b]*Prob[k];
+      }
+      grad_J_r[srb + q*(S[N*b+j] + q*(j-1))] -= w[b];
+    }
+  }
+
+  for (size_t k = 0; k < q; k++) {
+    grad_h_r[k] /= B_eff;
+  }
+  for (size_t i = 0; i < (q*q*(N-1)); i++) {
+    grad_J_r[i] /= B_eff;
+  }
+
+  if (l_h > 0.0) {
+    for (size_t k = 0; k < q; k++) {
+      grad_h_r[k] += l_h*h_r[k]*2;
+    }
+  }
+  if (l_J > 0.0) {
+    for (size_t i = 0; i < (q*q*(N-1)); i++) {
+      grad_J_r[i] += l_J*J_r[i]*2;
+    }
+  }
 }
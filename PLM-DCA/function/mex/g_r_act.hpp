@@ -0,0 +1,147 @@
+#ifndef G_R_ACT_HPP
+#define G_R_ACT_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * `g_r` (see `g_r.v02.h`) restricted to an active set of couplings: only the
+ * blocks $J_{ri}$ with i in `act` are variables, all other blocks are frozen
+ * at 0. The field accumulation and the gradient scatter then cost M blocks
+ * per sample instead of N-1.
+ *
+ * # Packed layout
+ *
+ * Parameters are stored in one vector of q + q*q*M elements: `h_r` followed by
+ * the blocks $J_{r, act[m]}$, m = 0..M-1, each a q-by-q matrix in the layout
+ * of `g_r`, i.e. $J_{r, act[m]}(k, s)$ is at `q + k + q*(s + q*m)`. With
+ * `act` = all i != r in increasing order, the layout is the same as `g_r`.
+ *
+ *
+ * # Output (by pointer)
+ *
+ *  *Initialization* needed: obj[0] and grad[] should be 0.
+ *
+ *  obj    : objective (1 element)
+ *  grad   : gradient, q + q*q*M elements
+ *
+ *
+ * # Input
+ *
+ *  B, N, q, S, w, B_eff, r, l_h, l_J : same as `g_r`
+ *  M        : number of active blocks
+ *  act      : M elements, 0-indexing sites (!= r) of the active blocks
+ *  h_and_J  : q + q*q*M elements, [h_r; J_r] in the packed layout
+ *
+ *
+ * # Return
+ *
+ *  true on success; false if `Num[k]` is too large and likely to overflow
+ *  `exp(Num[k])`. No MATLAB API is called.
+ *
+ *
+ * # History
+ *
+ * ## 2018-04-25  v1
+ */
+
+#include <math.h>   // exp() and log()
+#include <stdint.h> // uint8_t
+
+
+inline bool g_r_act(
+  double *obj, double *grad,
+  const size_t B, const size_t N, const size_t q,
+  const uint8_t *S,
+  const double *w, const double B_eff,
+  const size_t r,
+  const size_t M, const size_t *act,
+  const double *h_and_J,
+  const double l_h, const double l_J)
+{
+  const double *h_r      = h_and_J;
+  const double *J_r      = h_and_J + q;
+  double       *grad_h_r = grad;
+  double       *grad_J_r = grad + q;
+
+  double Num[256];
+
+  for (size_t b = 0; b < B; b++) {
+    if (w[b] == 0.0) {
+      continue;
+    }
+    const uint8_t *s = S + N*b;
+
+    /* begin: calculate $h_r(k) + \sum_{i \in act} J_{r i}(k, s_i^b)$ */
+    for (size_t k = 0; k < q; k++) {
+      Num[k] = h_r[k];
+    }
+    for (size_t m = 0; m < M; m++) {
+      const double *J_ri_s = J_r + q*(s[act[m]] + q*m);
+      for (size_t k = 0; k < q; k++) {
+        Num[k] += J_ri_s[k];
+      }
+    }
+    /* end */
+
+    double Z_r = 0;
+    for (size_t k = 0; k < q; k++) {
+      if (Num[k] > 709.0) {
+        return false;
+      }
+      Num[k] = exp(Num[k]);
+      Z_r   += Num[k];
+    }
+    for (size_t k = 0; k < q; k++) {
+      Num[k] /= Z_r;              // now `Num` is `Prob`
+    }
+
+    const size_t srb = s[r];
+    *obj -= w[b] * log(Num[srb]);
+
+    for (size_t k = 0; k < q; k++) {
+      grad_h_r[k] += w[b] * Num[k];
+    }
+    grad_h_r[srb] -= w[b];
+
+    for (size_t m = 0; m < M; m++) {
+      double *grad_J_ri_s = grad_J_r + q*(s[act[m]] + q*m);
+      for (size_t k = 0; k < q; k++) {
+        grad_J_ri_s[k] += w[b] * Num[k];
+      }
+      grad_J_ri_s[srb] -= w[b];
+    }
+  }
+
+
+  /*************************************************
+   *    from sum to mean, and add L2 regulator
+   *************************************************/
+  *obj /= B_eff;
+  for (size_t p = 0; p < q + q*q*M; p++) {
+    grad[p] /= B_eff;
+  }
+
+  if (l_h > 0.0) {
+    for (size_t k = 0; k < q; k++) {
+      grad_h_r[k] += l_h*h_r[k]*2;
+      *obj        += l_h*h_r[k]*h_r[k];
+    }
+  }
+  if (l_J > 0.0) {
+    for (size_t p = 0; p < q*q*M; p++) {
+      grad_J_r[p] += l_J*J_r[p]*2;
+      *obj        += l_J*J_r[p]*J_r[p];
+    }
+  }
+
+  return true;
+}
+
+#endif // G_R_ACT_HPP
@@ -0,0 +1,209 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * [obj, r_grad_h_and_J] = g_r_act_mex(...
+ *   S, ...
+ *   N, B, q, ...
+ *   w, B_eff, ...
+ *   r, act, r_h_and_J, ...
+ *   lambda, ...
+ *   SkipCheckFlag)
+ *
+ *  act        uint64    M elements, increasing sites i != r of the active
+ *                       blocks $J_{ri}$, [1,N]
+ *  r_h_and_J  double    $q + q^2 M$ rows, 1 column, in the packed layout of
+ *                       `g_r_act.hpp`
+ *  others     same as `g_r_mex_v2`
+ *
+ * Blocks not in `act` are frozen at 0 (see `min_g_r_act`).
+ *
+ * `SkipCheckFlag` is a placeholder as in `g_r_mex_v2`.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-04-25  v1
+ */
+
+
+#include <vector>
+#include "mex.h"
+#include "g_r_act.hpp"
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs > 2) {
+    mexErrMsgIdAndTxt(
+      "g_r_act_mex:nlhs",
+      "This function can only calculate objective and gradient.");
+  }
+  // default to check, 11-th arugment is a placeholder to skip check
+  if (nrhs != 10 && nrhs != 11) {
+    mexErrMsgIdAndTxt(
+      "g_r_act_mex:nrhs",
+      "Number of arguments supported: 10, 11\n"
+      "provided: %d", nrhs);
+  }
+
+  const mxArray *pm_S           = prhs[0];
+  const mxArray *pm_N           = prhs[1];
+  const mxArray *pm_B           = prhs[2];
+  const mxArray *pm_q           = prhs[3];
+  const mxArray *pm_w           = prhs[4];
+  const mxArray *pm_B_eff       = prhs[5];
+  const mxArray *pm_r           = prhs[6];
+  const mxArray *pm_act         = prhs[7];
+  const mxArray *pm_h_r_and_J_r = prhs[8];
+  const mxArray *pm_lambda      = prhs[9];
+
+  // check when only 10 arguments are provided
+  if (nrhs == 10) {
+    /* type check */
+    if (   !mxIsUint8(pm_S)
+        || !mxIsUint64(pm_N)
+        || !mxIsUint64(pm_B)
+        || !mxIsUint64(pm_q)
+        || !mxIsUint64(pm_r)
+        || !mxIsUint64(pm_act)
+        || !mxIsDouble(pm_w)
+        || !mxIsDouble(pm_B_eff)
+        || !mxIsDouble(pm_h_r_and_J_r)
+        || !mxIsDouble(pm_lambda) )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_act_mex:prhs:WrongType",
+        "Requirement:\n"
+        "   uint8:    S\n"
+        "  uint64:    N,  B,  q,  r,  act\n"
+        "  double:    w,  B_eff,  h_r_and_J_r,  lambda");
+    }
+
+    for (int k = 0; k < 10; k++) {
+      if (mxIsComplex(prhs[k])) {
+        mexErrMsgIdAndTxt(
+          "g_r_act_mex:prhs:IsComplex",
+          "\tAll inputs should be real.");
+      }
+    }
+
+    if ( mxGetNumberOfElements(pm_N) != 1
+      || mxGetNumberOfElements(pm_B) != 1
+      || mxGetNumberOfElements(pm_q) != 1
+      || mxGetNumberOfElements(pm_r) != 1
+      || mxGetNumberOfElements(pm_B_eff) != 1 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_act_mex:prhs:ScalarWrong",
+        "\tAll of {N, B, q, r, B_eff} should be scalar.");
+    }
+
+    const size_t N0 = *((uint64_t *) mxGetData(pm_N));
+    const size_t B0 = *((uint64_t *) mxGetData(pm_B));
+    const size_t q0 = *((uint64_t *) mxGetData(pm_q));
+    const size_t r0 = *((uint64_t *) mxGetData(pm_r));
+    const size_t M0 = mxGetNumberOfElements(pm_act);
+
+    if ( mxGetM(pm_S) != N0
+      || mxGetN(pm_S) != B0 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_act_mex:prhs:S",
+        "\tColumns of `S` are considered as sequences.\n"
+        "\tThus `S` should be a matrix consists of `N` rows and `B` columns");
+    }
+
+    if (q0 < 2 || q0 > 256) {
+        mexErrMsgIdAndTxt(
+          "g_r_act_mex:prhs:q",
+          "Requirement on q:\n"
+          "\tq >= 2 since 1-state Potts model is trivial.\n"
+          "\tq <= 256 since `S` can only stores 0~255.\n");
+    }
+
+    if (mxGetNumberOfElements(pm_w) != B0) {
+      mexErrMsgIdAndTxt(
+        "g_r_act_mex:prhs:w",
+        "\t`w`, which contains weights of sequences, mismatches `S`.\n");
+    }
+
+    if (r0 > N0 || r0 == 0) {
+      mexErrMsgIdAndTxt(
+        "g_r_act_mex:prhs:r",
+        "\t`r` should be integers in [1,N].");
+    }
+
+    const uint64_t *act0 = (uint64_t *) mxGetData(pm_act);
+    for (size_t m = 0; m < M0; m++) {
+      if ( act0[m] > N0 || act0[m] == 0 || act0[m] == r0
+        || (m > 0 && act0[m] <= act0[m-1]) )
+      {
+        mexErrMsgIdAndTxt(
+          "g_r_act_mex:prhs:act",
+          "\t`act` should contain increasing integers in [1,N] except r.");
+      }
+    }
+
+    if ( mxGetM(pm_h_r_and_J_r) != (q0 + q0*q0*M0)
+      || mxGetN(pm_h_r_and_J_r) != 1 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_act_mex:prhs:h_r_and_J_r",
+        "\t`h_r_and_J_r` should be a (q + q*q*M) * 1 matrix, "
+        "M = numel(act)\n");
+    }
+
+    if (mxGetNumberOfElements(pm_lambda) != 2) {
+      mexErrMsgIdAndTxt(
+        "g_r_act_mex:prhs:lambda",
+        "\t`lambda`, which contains lambda_h and lambda_J, "
+        "should contains 2 real numbers.");
+    }
+    if (mxGetPr(pm_lambda)[0] < 0.0 || mxGetPr(pm_lambda)[1] < 0.0) {
+      mexErrMsgIdAndTxt("g_r_act_mex:prhs:lambda",
+        "\t`lambda` may not be negative.");
+    }
+  }
+
+  const size_t    N       = mxGetM(pm_S);
+  const size_t    B       = mxGetN(pm_S);
+  const size_t    q       = *((uint64_t *) mxGetData(pm_q));
+  const size_t    r       = *((uint64_t *) mxGetData(pm_r)) - 1;
+  const size_t    M       = mxGetNumberOfElements(pm_act);
+  const uint64_t *act64   = (uint64_t *) mxGetData(pm_act);
+  const uint8_t  *S       = (uint8_t *) mxGetData(pm_S);
+  const double   *w       = mxGetPr(pm_w);
+  const double    B_eff   = mxGetPr(pm_B_eff)[0];
+  const double   *h_and_J = mxGetPr(pm_h_r_and_J_r);
+  const double    l_h     = mxGetPr(pm_lambda)[0];
+  const double    l_J     = mxGetPr(pm_lambda)[1];
+
+  std::vector<size_t> act(M);
+  for (size_t m = 0; m < M; m++) {
+    act[m] = act64[m] - 1;
+  }
+
+  // `mxCreateDoubleMatrix` initializes each element to 0, required by `g_r_act`
+  plhs[1] = mxCreateDoubleMatrix(q + q*q*M, 1, mxREAL);
+  double obj = 0.0;
+
+  if (!g_r_act(&obj, mxGetPr(plhs[1]),
+        B, N, q, S, w, B_eff, r, M, act.data(), h_and_J, l_h, l_J))
+  {
+    mexErrMsgIdAndTxt(
+      "g_r_act_mex:overflow:exp",
+      "r = %ld:  "
+      "`Num[k]` is too large and likely to overflow `exp(Num[k])`\n",
+      r+1);
+  }
+
+  plhs[0] = mxCreateDoubleScalar(obj);
+}
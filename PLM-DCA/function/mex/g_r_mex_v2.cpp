@@ -16,7 +16,8 @@
  *   lambda, ...
  *   SkipCheckFlag)
  *
- *  S    uint8     [0, 255], N rows, B columns (column-major)
+ *  S    uint8     [0, 255], N rows, B columns (column-major); or the handle
+ *                 of `S` in shared memory (char, see `shm_msa_mex`)
  *  N    uint64    length of sequence (for check: to be robust)
  *  B    uint64    number of sequences (for check: to be robust)
  *  q    uint64    $q \le 256$ since S is uint8.
@@ -31,11 +32,74 @@
  *  speed (thus the user should be responsible for the correctness of inputs).
  *  By measuring, skipping check reduces time by $0.4\%$.
  *
+ *
+ * Objective only
+ * ===
+ *
+ *     obj = g_r_mex_v2(...)
+ *
+ * With one output, the scatter into the gradient of `J_r`, roughly half of the
+ * cost, is skipped. The conditional probabilities of all samples are kept
+ * (q*B doubles) together with a copy of `r_h_and_J`; a following call asking
+ * for the gradient at the same point, with the same data, only performs the
+ * scatter. The data are identified by the handle of `S` (or a hash of `S`), a
+ * hash of `w` and the sizes, not by their addresses (see `data_key.hpp`). Thus a line search can evaluate trial points by objective only and
+ * get the gradient at the accepted point for little more than the scatter
+ * (cf. `options.LS_valueOnly` of minFunc).
+ *
+ *
+ * Shared MSA
+ * ===
+ *
+ * With `S` given as a handle of `shm_msa_mex`, the matrix is mapped from
+ * shared memory once per process and not copied: `parfor` then sends the
+ * handle to the workers instead of `S`. A handle `file:<path>` maps an MSA
+ * file of `write_MSA_bin` the same way (see `PLM_worker`).
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  handles `file:<path>` of MSA files
+ * - 2018-05-10  the cache is keyed on the data, not on their addresses
+ * - 2018-05-08  `S` as a handle of a shared MSA
+ * - 2018-04-12  objective-only call and the cache of probabilities
  */
 
 
+#include <string.h> // memcmp()
+#include <vector>
 #include "mex.h"
 #include "g_r.v02.h"
+#include "data_key.hpp"
+#include "../../../common/mex/shm_msa.hpp"
+
+
+// shared MSAs mapped by this process
+static ShmMsaCache shmCache;
+
+
+// probabilities of the last objective-only call, and the point they belong to
+static struct {
+  bool valid;
+  DataKey data;
+  size_t r;
+  double B_eff, l_h, l_J;
+  double obj;
+  std::vector<double> h_r_and_J_r;
+  std::vector<double> Prob;
+} cache = {};
+
+
+// raised here rather than in `g_r`, which may also run on native threads
+static void overflow(size_t r)
+{
+  mexErrMsgIdAndTxt(
+    "g_rC:overflow:exp",
+    "r = %lu:  "
+    "`Num[k]` is too large and likely to overflow `exp(Num[k])`\n",
+    (unsigned long) r);
+}
+
 
 void mexFunction(
   int nlhs, mxArray *plhs[],
@@ -46,6 +110,9 @@ void mexFunction(
       "g_r_mex:nlhs",
       "This function can only calculate objective and gradient.");
   }
+  // any failure below leaves the cache invalid
+  const bool cache_was_valid = cache.valid;
+  cache.valid = false;
   // default to check, 10-th arugment is a placeholder to skip check
 	if (nrhs != 9 && nrhs != 10) {
     mexErrMsgIdAndTxt(
@@ -64,12 +131,36 @@ void mexFunction(
   const mxArray *pm_h_r_and_J_r = prhs[7];
   const mxArray *pm_lambda      = prhs[8];
 
+  // S, possibly from shared memory
+  const uint8_t *S;
+  size_t S_M, S_N;
+  char name[SHM_MSA_MAX_HANDLE] = "";
+  if (mxIsChar(pm_S)) {
+    if (mxGetString(pm_S, name, sizeof(name)) != 0) {
+      mexErrMsgIdAndTxt("g_r_mex:prhs:S", "\tInvalid handle of `S`.");
+    }
+    int st;
+    const ShmMsa *msa = shmCache.get(name, &st);
+    if (msa == NULL) {
+      mexErrMsgIdAndTxt("g_r_mex:prhs:S",
+        "\t`%s`: %s.", name, shm_msa_strerror(st));
+    }
+    S   = msa->data;
+    S_M = size_t(msa->M);
+    S_N = size_t(msa->K);
+  }
+  else {
+    S   = (uint8_t *) mxGetData(pm_S);
+    S_M = mxGetM(pm_S);
+    S_N = mxGetN(pm_S);
+  }
+
   // check when only 9 arguments are provided
   if (nrhs == 9) {
     /* type check */
 
     // class of mxArray
-    if (   !mxIsUint8(pm_S)
+    if (   !(mxIsUint8(pm_S) || mxIsChar(pm_S))
         || !mxIsUint64(pm_N)
         || !mxIsUint64(pm_B)
         || !mxIsUint64(pm_q)
@@ -82,7 +173,7 @@ void mexFunction(
       mexErrMsgIdAndTxt(
         "g_r_mex:prhs:WrongType",
         "Requirement:\n"
-        "   uint8:    S\n"
+        "   uint8:    S (or its handle)\n"
         "  uint64:    N,  B,  q,  r\n"
         "  double:    w,  B_eff,  h_r_and_J_r,  lambda");
     }
@@ -125,8 +216,8 @@ void mexFunction(
     const size_t r0 = *((uint64_t *) mxGetData(pm_r));
 
     // S, dimension
-    if ( mxGetM(pm_S) != N0
-      || mxGetN(pm_S) != B0 )
+    if ( S_M != N0
+      || S_N != B0 )
     {
       mexErrMsgIdAndTxt(
         "g_r_mex:prhs:S",
@@ -183,11 +274,10 @@ void mexFunction(
     }
   }
 
-  const size_t   N     = mxGetM(pm_S);
-  const size_t   B     = mxGetN(pm_S);
+  const size_t   N     = S_M;
+  const size_t   B     = S_N;
   const size_t   q     = *((uint64_t *) mxGetData(pm_q));
   const size_t   r     = *((uint64_t *) mxGetData(pm_r));
-  const uint8_t *S     = (uint8_t *) mxGetData(pm_S);
   const double  *w     = mxGetPr(pm_w);
   const double   B_eff = mxGetPr(pm_B_eff)[0];
   const double  *h_r   = mxGetPr(pm_h_r_and_J_r);
@@ -195,17 +285,60 @@ void mexFunction(
   const double   l_h   = mxGetPr(pm_lambda)[0];
   const double   l_J   = mxGetPr(pm_lambda)[1];
 
+  const size_t P = q + q*q*(N-1);
+
+  /* objective only: keep `Prob` of all samples for the gradient */
+  if (nlhs < 2) {
+    cache.Prob.resize(q*B);
+    double obj = 0.0;
+    if (g_r_value(&obj, B, N, q, S, w, B_eff, r-1, h_r, J_r, l_h, l_J,
+      cache.Prob.data()) >= 0)
+    {
+      overflow(r);
+    }
+
+    cache.h_r_and_J_r.assign(h_r, h_r + P);
+    cache.data = DataKey(name, S, w, N, B, q);
+    cache.r = r;
+    cache.B_eff = B_eff;
+    cache.l_h = l_h;
+    cache.l_J = l_J;
+    cache.obj = obj;
+    cache.valid = true;
+
+    plhs[0] = mxCreateDoubleScalar(obj);
+    return;
+  }
+
   /**
    * `mxCreateDoubleMatrix` initializes each element to 0, which is required by
    * `g_r`
    */
-  plhs[0] = mxCreateDoubleMatrix(1, 1, mxREAL);
-  double *obj = mxGetPr(plhs[0]);
-  plhs[1] = mxCreateDoubleMatrix(q + q*q*(N-1), 1, mxREAL);
+  plhs[1] = mxCreateDoubleMatrix(P, 1, mxREAL);
   double *grad_h_r = mxGetPr(plhs[1]);
   double *grad_J_r = grad_h_r + q;
 
-  g_r(obj, grad_h_r, grad_J_r,
-      B, N, q, S, w, B_eff, r-1, h_r, J_r, l_h, l_J);
+  /* objective and gradient at the point of the last objective-only call */
+  if (cache_was_valid
+    && cache.data.N == N && cache.data.B == B && cache.data.q == q
+    && cache.r == r
+    && cache.B_eff == B_eff && cache.l_h == l_h && cache.l_J == l_J
+    && memcmp(cache.h_r_and_J_r.data(), h_r, P*sizeof(double)) == 0
+    && cache.data == DataKey(name, S, w, N, B, q))
+  {
+    g_r_grad_Prob(grad_h_r, grad_J_r,
+      B, N, q, S, w, B_eff, r-1, h_r, J_r, l_h, l_J, cache.Prob.data());
+    plhs[0] = mxCreateDoubleScalar(cache.obj);
+    return;
+  }
+
+  plhs[0] = mxCreateDoubleMatrix(1, 1, mxREAL);
+  double *obj = mxGetPr(plhs[0]);
+
+  if (g_r(obj, grad_h_r, grad_J_r,
+      B, N, q, S, w, B_eff, r-1, h_r, J_r, l_h, l_J) >= 0)
+  {
+    overflow(r);
+  }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,167 @@
+#ifndef G_R_REP_HPP
+#define G_R_REP_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Objective and gradient of `g_r` (see `g_r.v02.h`) of one node r for R
+ * replicates which share the MSA but not the weights of samples, e.g.
+ * bootstrap replicates (resampling = multiplicities as weights).
+ *
+ * The parameters of the R replicates are interleaved: element p of `r_h_and_J`
+ * of replicate t is at `h_and_J[t + R*p]`. For sample b, the offsets
+ * $q(s_i^b + q i')$ are computed once, and every gather/scatter of `g_r` reads
+ * or writes q*R contiguous numbers serving all replicates, instead of R
+ * separate blocks of q numbers scattered over R parameter vectors. A sample
+ * whose weight is 0 in every replicate is skipped.
+ *
+ *
+ * # Output (by pointer)
+ *
+ *  *Initialization* needed: obj[] and grad[] should be 0.
+ *
+ *  obj      : R elements, objective of each replicate
+ *  grad     : (q + q*q*(N-1))*R elements, interleaved as `h_and_J`
+ *
+ *
+ * # Input
+ *
+ *  B, N, q, S, r, l_h, l_J : same as `g_r`
+ *  R        : number of replicates
+ *  W        : B*R elements, W[b + B*t] is the weight of sample b in replicate t
+ *  B_eff    : R elements, B_eff[t] = \sum_b W[b + B*t]
+ *  h_and_J  : (q + q*q*(N-1))*R elements, [h_r; J_r] of each replicate,
+ *             interleaved
+ *
+ *
+ * # Return
+ *
+ *  -1 on success; otherwise the replicate (0-indexing) whose `Num[k]` is too
+ *  large and likely to overflow `exp(Num[k])`. No MATLAB API is called.
+ *
+ *
+ * # History
+ *
+ * ## 2018-04-23  v1
+ */
+
+#include <math.h>   // exp() and log()
+#include <stdint.h> // uint8_t
+#include <vector>
+
+
+inline long g_r_rep(
+  double *obj, double *grad,
+  const size_t B, const size_t N, const size_t q,
+  const uint8_t *S,
+  const size_t R, const double *W, const double *B_eff,
+  const size_t r,
+  const double *h_and_J,
+  const double l_h, const double l_J)
+{
+  const size_t qR = q*R;            // h_r(k) of replicate t at [t + R*k]
+  const size_t P  = q + q*q*(N-1);  // number of parameters per replicate
+
+  const double *h_r      = h_and_J;
+  const double *J_r      = h_and_J + qR;
+  double       *grad_h_r = grad;
+  double       *grad_J_r = grad + qR;
+
+  std::vector<size_t> off(N-1);     // J_{ri}(k, s_i^b) at J_r[off[i'] + R*k]
+  std::vector<double> Num(qR);      // Num[t + R*k]
+  std::vector<double> wb(R);        // weights of sample b
+
+  for (size_t b = 0; b < B; b++) {
+    bool isUsed = false;
+    for (size_t t = 0; t < R; t++) {
+      wb[t] = W[b + B*t];
+      isUsed = isUsed || wb[t] != 0.0;
+    }
+    if (!isUsed) {
+      continue;
+    }
+
+    const uint8_t *s = S + N*b;
+    for (size_t i = 0; i < r; i++) {
+      off[i]   = qR*(s[i] + q*i);
+    }
+    for (size_t i = r+1; i < N; i++) {
+      off[i-1] = qR*(s[i] + q*(i-1));
+    }
+    const size_t srb = s[r];  // s_r^b
+
+    /* begin: calculate $h_r(k) + \sum_{i \neq r} J_{r i}(k, s_i^b)$ */
+    for (size_t p = 0; p < qR; p++) {
+      Num[p] = h_r[p];
+    }
+    for (size_t i = 0; i < N-1; i++) {
+      const double *J_ri_s = J_r + off[i];
+      for (size_t p = 0; p < qR; p++) {
+        Num[p] += J_ri_s[p];
+      }
+    }
+    /* end */
+
+    /* Num[t + R*k] <- w_b^t (Prob(k) - [k == s_r^b]), the term of gradient */
+    for (size_t t = 0; t < R; t++) {
+      double Z_r = 0;
+      for (size_t k = 0; k < q; k++) {
+        double &x = Num[t + R*k];
+        if (x > 709.0) {
+          return long(t);
+        }
+        x    = exp(x);
+        Z_r += x;
+      }
+      if (wb[t] != 0.0) {
+        obj[t] -= wb[t] * log(Num[t + R*srb] / Z_r);
+      }
+      const double c = wb[t] / Z_r;
+      for (size_t k = 0; k < q; k++) {
+        Num[t + R*k] *= c;
+      }
+      Num[t + R*srb] -= wb[t];
+    }
+
+    for (size_t p = 0; p < qR; p++) {
+      grad_h_r[p] += Num[p];
+    }
+    for (size_t i = 0; i < N-1; i++) {
+      double *grad_J_ri_s = grad_J_r + off[i];
+      for (size_t p = 0; p < qR; p++) {
+        grad_J_ri_s[p] += Num[p];
+      }
+    }
+  }
+
+
+  /*************************************************
+   *    from sum to mean, and add L2 regulator
+   *************************************************/
+  for (size_t t = 0; t < R; t++) {
+    obj[t] /= B_eff[t];
+  }
+  for (size_t p = 0; p < P; p++) {
+    const double l = p < q ? l_h : l_J;
+    for (size_t t = 0; t < R; t++) {
+      const double x = h_and_J[t + R*p];
+      double &g = grad[t + R*p];
+      g /= B_eff[t];
+      if (l > 0.0) {
+        g      += l*x*2;
+        obj[t] += l*x*x;
+      }
+    }
+  }
+
+  return -1;
+}
+
+#endif // G_R_REP_HPP
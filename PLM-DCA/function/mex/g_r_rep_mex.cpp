@@ -0,0 +1,230 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * [obj, R_grad_h_and_J, obj_t] = g_r_rep_mex(...
+ *   S, ...
+ *   N, B, q, ...
+ *   W, B_eff, ...
+ *   r, R_h_and_J, ...
+ *   lambda, ...
+ *   SkipCheckFlag)
+ *
+ *  S          uint8     [0, 255], N rows, B columns (column-major)
+ *  N          uint64    length of sequence (for check: to be robust)
+ *  B          uint64    number of sequences (for check: to be robust)
+ *  q          uint64    $q \le 256$ since S is uint8.
+ *  W          double    B rows, R columns; column t holds the weights of the
+ *                       sequences in replicate t
+ *  B_eff      double    R elements, B_eff(t) = sum(W(:,t))
+ *  r          uint64    node index, [1,N]
+ *  R_h_and_J  double    $(q + q^2(N-1)) R$ elements; row t (after
+ *                       reshaping to R rows) is `r_h_and_J` of replicate t
+ *  lambda     double    2 elements: first is $\lambda_h$, second is $\lambda_J$
+ *
+ *  obj             sum of the objectives of the R replicates
+ *  R_grad_h_and_J  $(q + q^2(N-1)) R$ rows, 1 column; gradient of `obj`, in
+ *                  the layout of `R_h_and_J`
+ *  obj_t           1-by-R, objective of each replicate
+ *
+ * Since the replicates share no parameter, minimizing `obj` over `R_h_and_J`
+ * minimizes `g_r` of every replicate (cf. `min_g_r_rep`). This MEX file has
+ * the same semantics as calling `g_r_mex_v2` with each column of `W`, but
+ * reads `S` only once, and the replicates are interleaved so that the
+ * parameters touched by one sample are contiguous (see `g_r_rep.hpp`).
+ *
+ * `SkipCheckFlag` is a placeholder as in `g_r_mex_v2`.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-04-23  v1
+ */
+
+
+#include "mex.h"
+#include "g_r_rep.hpp"
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs > 3) {
+    mexErrMsgIdAndTxt(
+      "g_r_rep_mex:nlhs",
+      "This function can only calculate objective and gradient.");
+  }
+  // default to check, 10-th arugment is a placeholder to skip check
+  if (nrhs != 9 && nrhs != 10) {
+    mexErrMsgIdAndTxt(
+      "g_r_rep_mex:nrhs",
+      "Number of arguments supported: 9, 10\n"
+      "provided: %d", nrhs);
+  }
+
+  const mxArray *pm_S           = prhs[0];
+  const mxArray *pm_N           = prhs[1];
+  const mxArray *pm_B           = prhs[2];
+  const mxArray *pm_q           = prhs[3];
+  const mxArray *pm_W           = prhs[4];
+  const mxArray *pm_B_eff       = prhs[5];
+  const mxArray *pm_r           = prhs[6];
+  const mxArray *pm_R_h_and_J   = prhs[7];
+  const mxArray *pm_lambda      = prhs[8];
+
+  // check when only 9 arguments are provided
+  if (nrhs == 9) {
+    /* type check */
+    if (   !mxIsUint8(pm_S)
+        || !mxIsUint64(pm_N)
+        || !mxIsUint64(pm_B)
+        || !mxIsUint64(pm_q)
+        || !mxIsUint64(pm_r)
+        || !mxIsDouble(pm_W)
+        || !mxIsDouble(pm_B_eff)
+        || !mxIsDouble(pm_R_h_and_J)
+        || !mxIsDouble(pm_lambda) )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_rep_mex:prhs:WrongType",
+        "Requirement:\n"
+        "   uint8:    S\n"
+        "  uint64:    N,  B,  q,  r\n"
+        "  double:    W,  B_eff,  R_h_and_J,  lambda");
+    }
+
+    for (int k = 0; k < 9; k++) {
+      if (mxIsComplex(prhs[k])) {
+        mexErrMsgIdAndTxt(
+          "g_r_rep_mex:prhs:IsComplex",
+          "\tAll inputs should be real.");
+      }
+    }
+
+    if ( mxGetNumberOfElements(pm_N) != 1
+      || mxGetNumberOfElements(pm_B) != 1
+      || mxGetNumberOfElements(pm_q) != 1
+      || mxGetNumberOfElements(pm_r) != 1 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_rep_mex:prhs:ScalarWrong",
+        "\tAll of {N, B, q, r} should be scalar.");
+    }
+
+    const size_t N0 = *((uint64_t *) mxGetData(pm_N));
+    const size_t B0 = *((uint64_t *) mxGetData(pm_B));
+    const size_t q0 = *((uint64_t *) mxGetData(pm_q));
+    const size_t r0 = *((uint64_t *) mxGetData(pm_r));
+    const size_t R0 = mxGetN(pm_W);
+
+    if ( mxGetM(pm_S) != N0
+      || mxGetN(pm_S) != B0 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_rep_mex:prhs:S",
+        "\tColumns of `S` are considered as sequences.\n"
+        "\tThus `S` should be a matrix consists of `N` rows and `B` columns");
+    }
+
+    if (q0 < 2 || q0 > 256) {
+        mexErrMsgIdAndTxt(
+          "g_r_rep_mex:prhs:q",
+          "Requirement on q:\n"
+          "\tq >= 2 since 1-state Potts model is trivial.\n"
+          "\tq <= 256 since `S` can only stores 0~255.\n");
+    }
+
+    if (mxGetM(pm_W) != B0 || R0 == 0) {
+      mexErrMsgIdAndTxt(
+        "g_r_rep_mex:prhs:W",
+        "\t`W`, whose columns contain weights of sequences, "
+        "should have B rows and at least one column.\n");
+    }
+
+    if (mxGetNumberOfElements(pm_B_eff) != R0) {
+      mexErrMsgIdAndTxt(
+        "g_r_rep_mex:prhs:B_eff",
+        "\t`B_eff` should contain one number per column of `W`.\n");
+    }
+    for (size_t t = 0; t < R0; t++) {
+      if (!(mxGetPr(pm_B_eff)[t] > 0.0)) {
+        mexErrMsgIdAndTxt(
+          "g_r_rep_mex:prhs:B_eff",
+          "\t`B_eff` should be positive.\n");
+      }
+    }
+
+    if (r0 > N0 || r0 == 0) {
+      mexErrMsgIdAndTxt(
+        "g_r_rep_mex:prhs:r",
+        "\t`r` should be integers in [1,N].");
+    }
+
+    if (mxGetNumberOfElements(pm_R_h_and_J) != (q0 + q0*q0*(N0-1))*R0) {
+      mexErrMsgIdAndTxt(
+        "g_r_rep_mex:prhs:R_h_and_J",
+        "\t`R_h_and_J`, "
+        "which contains h_r and J_r of the R replicates, "
+        "should contain (q + q*q*(N-1))*R elements\n");
+    }
+
+    if (mxGetNumberOfElements(pm_lambda) != 2) {
+      mexErrMsgIdAndTxt(
+        "g_r_rep_mex:prhs:lambda",
+        "\t`lambda`, which contains lambda_h and lambda_J, "
+        "should contains 2 real numbers.");
+    }
+    if (mxGetPr(pm_lambda)[0] < 0.0 || mxGetPr(pm_lambda)[1] < 0.0) {
+      mexErrMsgIdAndTxt("g_r_rep_mex:prhs:lambda",
+        "\t`lambda` may not be negative.");
+    }
+  }
+
+  const size_t   N       = mxGetM(pm_S);
+  const size_t   B       = mxGetN(pm_S);
+  const size_t   q       = *((uint64_t *) mxGetData(pm_q));
+  const size_t   r       = *((uint64_t *) mxGetData(pm_r));
+  const size_t   R       = mxGetN(pm_W);
+  const uint8_t *S       = (uint8_t *) mxGetData(pm_S);
+  const double  *W       = mxGetPr(pm_W);
+  const double  *B_eff   = mxGetPr(pm_B_eff);
+  const double  *h_and_J = mxGetPr(pm_R_h_and_J);
+  const double   l_h     = mxGetPr(pm_lambda)[0];
+  const double   l_J     = mxGetPr(pm_lambda)[1];
+  const size_t   P       = q + q*q*(N-1);
+
+  // `mxCreateDoubleMatrix` initializes each element to 0, required by `g_r_rep`
+  mxArray *pm_obj_t = mxCreateDoubleMatrix(1, R, mxREAL);
+  double *obj_t = mxGetPr(pm_obj_t);
+  plhs[1] = mxCreateDoubleMatrix(P*R, 1, mxREAL);
+  double *grad = mxGetPr(plhs[1]);
+
+  const long t_overflow = g_r_rep(obj_t, grad,
+    B, N, q, S, R, W, B_eff, r-1, h_and_J, l_h, l_J);
+  if (t_overflow >= 0) {
+    mexErrMsgIdAndTxt(
+      "g_r_rep_mex:overflow:exp",
+      "r = %ld, replicate %ld:  "
+      "`Num[k]` is too large and likely to overflow `exp(Num[k])`\n",
+      (long) r, t_overflow+1);
+  }
+
+  double obj = 0.0;
+  for (size_t t = 0; t < R; t++) {
+    obj += obj_t[t];
+  }
+  plhs[0] = mxCreateDoubleScalar(obj);
+
+  if (nlhs > 2) {
+    plhs[2] = pm_obj_t;
+  }
+  else {
+    mxDestroyArray(pm_obj_t);
+  }
+}
@@ -0,0 +1,247 @@
+#ifndef G_R_STATS_HPP
+#define G_R_STATS_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * `g_r` (see `g_r.v02.h`) evaluated on sufficient statistics of node r.
+ *
+ * `g_r` depends on a sample only through its neighbourhood pattern
+ * $\underline{s}_{\partial r}^b$ (the sequence without site r) and its state
+ * $s_r^b$. Samples sharing a neighbourhood pattern u share `Num`, `Z_r` and
+ * `Prob`, thus they are aggregated into
+ *
+ *  - `pat`   : (N-1) uint8 states of pattern u, `pat[i'] = s_i^u`, where i'
+ *              is the index of i in `J_r` (i' = i for i < r, i-1 for i > r),
+ *              i.e. $J_{ri}(k, s_i^u)$ = `J_r[q*q*i' + q*pat[i'] + k]`;
+ *  - `count` : q weights, `count[k]` = $\sum_{b \in u} w_b \delta(s_r^b, k)$.
+ *
+ * With $W_u = \sum_k c_u(k)$,
+ *
+ * $$
+ * g_r = -\frac{1}{B_eff} \sum_u \sum_k c_u(k) \log P_u(k) + \text{L2}
+ * $$
+ * $$
+ * \partial g_r / \partial J_{ri}(k, s_i^u) \ni
+ *   \frac{1}{B_eff} \left( W_u P_u(k) - c_u(k) \right)
+ * $$
+ *
+ * The statistics depend only on the data, so they are built once per node
+ * (`g_r_patterns` and `fill_g_r_stats`) and reused in every iteration of the
+ * minimization (`g_r_stats`), which then needs no pass over redundant samples.
+ * The patterns keep one byte per site, as `S` does, so that they take at most
+ * the memory of `S` (U <= B) and an evaluation reads no more than `g_r`;
+ * the base `q*q*i'` of every site is added while gathering.
+ *
+ * None of the functions calls the MATLAB API.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v2
+ * - uint8 states of every pattern instead of int32 offsets, which took 4
+ *   times the memory of `S` when few samples share a pattern
+ *
+ * ## 2018-04-05  v1
+ */
+
+#include <math.h>   // exp() and log()
+#include <stdint.h> // uint8_t, uint64_t
+#include <string.h> // memcmp(), memcpy()
+#include <algorithm>
+#include <vector>
+
+
+/**
+ * Group the B samples by neighbourhood pattern of node r.
+ *
+ *  rep     : (output) the first sample of each pattern, U elements
+ *  pattern : (output) pattern index of each sample, B elements
+ *
+ * Return U, the number of distinct patterns.
+ */
+inline size_t g_r_patterns(
+  std::vector<size_t> &rep, std::vector<size_t> &pattern,
+  const size_t B, const size_t N, const uint8_t *S, const size_t r)
+{
+  // FNV-1a hash of the pattern, to make most comparisons O(1)
+  std::vector<uint64_t> hash(B);
+  for (size_t b = 0; b < B; b++) {
+    const uint8_t *s = S + N*b;
+    uint64_t x = 14695981039346656037ULL;
+    for (size_t i = 0; i < N; i++) {
+      if (i != r) {
+        x = (x ^ s[i]) * 1099511628211ULL;
+      }
+    }
+    hash[b] = x;
+  }
+
+  // compare the pattern of samples a and b: hash, then sites before and after r
+  auto compare = [&](size_t a, size_t b) -> int {
+    if (hash[a] != hash[b]) {
+      return hash[a] < hash[b] ? -1 : 1;
+    }
+    const uint8_t *sa = S + N*a;
+    const uint8_t *sb = S + N*b;
+    int c = memcmp(sa, sb, r);
+    if (c == 0) {
+      c = memcmp(sa + r+1, sb + r+1, N-r-1);
+    }
+    return c;
+  };
+
+  std::vector<size_t> order(B);
+  for (size_t b = 0; b < B; b++) {
+    order[b] = b;
+  }
+  std::stable_sort(order.begin(), order.end(),
+    [&](size_t a, size_t b) { return compare(a, b) < 0; });
+
+  rep.clear();
+  pattern.assign(B, 0);
+  for (size_t t = 0; t < B; t++) {
+    const size_t b = order[t];
+    if (t == 0 || compare(order[t-1], b) != 0) {
+      rep.push_back(b);   // first sample of the pattern, by stable sorting
+    }
+    pattern[b] = rep.size() - 1;
+  }
+  return rep.size();
+}
+
+
+/**
+ * Fill the statistics of the U patterns found by `g_r_patterns`.
+ *
+ *  pat   : (output) (N-1)*U elements
+ *  count : (output) q*U elements, *initialization* to 0 needed
+ */
+inline void fill_g_r_stats(
+  uint8_t *pat, double *count,
+  const size_t B, const size_t N, const size_t q,
+  const uint8_t *S, const double *w, const size_t r,
+  const std::vector<size_t> &rep, const std::vector<size_t> &pattern)
+{
+  const size_t U = rep.size();
+  for (size_t u = 0; u < U; u++) {
+    const uint8_t *s = S + N*rep[u];
+    uint8_t *p = pat + (N-1)*u;
+    memcpy(p, s, r);
+    memcpy(p + r, s + r+1, N-r-1);
+  }
+  for (size_t b = 0; b < B; b++) {
+    count[q*pattern[b] + S[N*b+r]] += w[b];
+  }
+}
+
+
+/**
+ * Objective and gradient of `g_r` from the statistics.
+ *
+ * # Output (by pointer)
+ *
+ *  *Initialization* needed: obj[0], grad_h_r[] and grad_J_r[] should be 0.
+ *
+ * # Input
+ *
+ *  U, N, q    : number of patterns, number of nodes, number of states
+ *  pat, count : statistics, see above
+ *  B_eff, h_r, J_r, l_h, l_J : same as `g_r`
+ *
+ * # Return
+ *
+ *  true on success; false if `Num[k]` is too large and likely to overflow
+ *  `exp(Num[k])`.
+ */
+inline bool g_r_stats(
+  double *obj, double *grad_h_r, double *grad_J_r,
+  const size_t U, const size_t N, const size_t q,
+  const uint8_t *pat, const double *count,
+  const double B_eff,
+  const double *h_r, const double *J_r,
+  const double l_h, const double l_J)
+{
+  double Num[256];
+  double D[256];    // $W_u P_u(k) - c_u(k)$
+
+  for (size_t u = 0; u < U; u++) {
+    const uint8_t *p = pat + (N-1)*u;
+    const double  *c = count + q*u;
+
+    /* begin: calculate $h_r(k) + \sum_{i \neq r} J_{r i}(k, s_i^u)$ */
+    for (size_t k = 0; k < q; k++) {
+      Num[k] = h_r[k];
+    }
+    for (size_t i = 0; i < N-1; i++) {
+      const double *J_ri_s = J_r + q*(p[i] + q*i);
+      for (size_t k = 0; k < q; k++) {
+        Num[k] += J_ri_s[k];
+      }
+    }
+    /* end */
+
+    double Z_r = 0;
+    double W_u = 0;
+    for (size_t k = 0; k < q; k++) {
+      if (Num[k] > 709.0) {
+        return false;
+      }
+      Num[k] = exp(Num[k]);
+      Z_r   += Num[k];
+      W_u   += c[k];
+    }
+
+    for (size_t k = 0; k < q; k++) {
+      const double Prob = Num[k] / Z_r;
+      if (c[k] > 0.0) {
+        *obj -= c[k] * log(Prob);
+      }
+      D[k] = W_u*Prob - c[k];
+      grad_h_r[k] += D[k];
+    }
+
+    for (size_t i = 0; i < N-1; i++) {
+      double *grad_J_ri_s = grad_J_r + q*(p[i] + q*i);
+      for (size_t k = 0; k < q; k++) {
+        grad_J_ri_s[k] += D[k];
+      }
+    }
+  }
+
+
+  /*************************************************
+   *    from sum to mean, and add L2 regulator
+   *************************************************/
+  *obj /= B_eff;
+  for (size_t k = 0; k < q; k++) {
+    grad_h_r[k] /= B_eff;
+  }
+  for (size_t p = 0; p < q*q*(N-1); p++) {
+    grad_J_r[p] /= B_eff;
+  }
+
+  if (l_h > 0.0) {
+    for (size_t k = 0; k < q; k++) {
+      grad_h_r[k] += l_h*h_r[k]*2;
+      *obj        += l_h*h_r[k]*h_r[k];
+    }
+  }
+  if (l_J > 0.0) {
+    for (size_t p = 0; p < q*q*(N-1); p++) {
+      grad_J_r[p] += l_J*J_r[p]*2;
+      *obj        += l_J*J_r[p]*J_r[p];
+    }
+  }
+
+  return true;
+}
+
+#endif // G_R_STATS_HPP
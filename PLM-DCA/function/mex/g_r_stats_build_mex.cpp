@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * [pat, count] = g_r_stats_build_mex(S, q, w, r)
+ *
+ *  S      uint8     [0, q-1], N rows, B columns (column-major)
+ *  q      uint64    number of states, $q \le 256$
+ *  w      double    B weights of sequences
+ *  r      uint64    node index, [1,N]
+ *
+ *  pat    uint8     (N-1)-by-U, each neighbourhood pattern of r (S without
+ *                   row r)
+ *  count  double    q-by-U, weights of each pattern, split by the state of r
+ *
+ * Samples with the same neighbourhood pattern (the sequence without site r)
+ * are aggregated into one column of `pat` and `count`; see `g_r_stats.hpp`.
+ * The result is passed to `g_r_stats_mex` in every iteration of the
+ * minimization of `g_r`.
+ *
+ * Memory of `pat` is (N-1)*U bytes, i.e. at most that of `S`.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v2
+ *   - uint8 patterns instead of int32 offsets
+ * - 2018-04-05  v1
+ */
+
+
+#include <vector>
+#include "mex.h"
+#include "g_r_stats.hpp"
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs != 2) {
+    mexErrMsgIdAndTxt(
+      "g_r_stats_build_mex:nlhs",
+      "Two outputs are required: [pat, count].");
+  }
+  if (nrhs != 4) {
+    mexErrMsgIdAndTxt(
+      "g_r_stats_build_mex:nrhs",
+      "Number of arguments supported: 4\n"
+      "provided: %d", nrhs);
+  }
+
+  const mxArray *pm_S = prhs[0];
+  const mxArray *pm_q = prhs[1];
+  const mxArray *pm_w = prhs[2];
+  const mxArray *pm_r = prhs[3];
+
+  /* type check */
+  if (   !mxIsUint8(pm_S)
+      || !mxIsUint64(pm_q)
+      || !mxIsDouble(pm_w)
+      || !mxIsUint64(pm_r) )
+  {
+    mexErrMsgIdAndTxt(
+      "g_r_stats_build_mex:prhs:WrongType",
+      "Requirement:\n"
+      "   uint8:    S\n"
+      "  uint64:    q,  r\n"
+      "  double:    w");
+  }
+  if (   mxIsComplex(pm_w)
+      || mxGetNumberOfElements(pm_q) != 1
+      || mxGetNumberOfElements(pm_r) != 1 )
+  {
+    mexErrMsgIdAndTxt(
+      "g_r_stats_build_mex:prhs",
+      "\t`q` and `r` should be scalar, `w` should be real.");
+  }
+
+  const size_t   N = mxGetM(pm_S);
+  const size_t   B = mxGetN(pm_S);
+  const size_t   q = *((uint64_t *) mxGetData(pm_q));
+  const size_t   r = *((uint64_t *) mxGetData(pm_r));
+  const uint8_t *S = (uint8_t *) mxGetData(pm_S);
+  const double  *w = mxGetPr(pm_w);
+
+  if (q < 2 || q > 256) {
+    mexErrMsgIdAndTxt(
+      "g_r_stats_build_mex:prhs:q",
+      "Requirement on q:\n"
+      "\tq >= 2 since 1-state Potts model is trivial.\n"
+      "\tq <= 256 since `S` can only stores 0~255.\n");
+  }
+  if (N < 2 || r > N || r == 0) {
+    mexErrMsgIdAndTxt(
+      "g_r_stats_build_mex:prhs:r",
+      "\t`r` should be integers in [1,N], N >= 2.");
+  }
+  if (mxGetNumberOfElements(pm_w) != B) {
+    mexErrMsgIdAndTxt(
+      "g_r_stats_build_mex:prhs:w",
+      "\t`w`, which contains weights of sequences, mismatches `S`.\n");
+  }
+  for (size_t p = 0; p < N*B; p++) {
+    if (S[p] >= q) {
+      mexErrMsgIdAndTxt(
+        "g_r_stats_build_mex:prhs:S",
+        "\tq possible states should be mapped to integers in [0,q-1].");
+    }
+  }
+
+  std::vector<size_t> rep, pattern;
+  const size_t U = g_r_patterns(rep, pattern, B, N, S, r-1);
+
+  plhs[0] = mxCreateNumericMatrix(N-1, U, mxUINT8_CLASS, mxREAL);
+  plhs[1] = mxCreateDoubleMatrix(q, U, mxREAL);   // initialized to 0
+  fill_g_r_stats(
+    (uint8_t *) mxGetData(plhs[0]), mxGetPr(plhs[1]),
+    B, N, q, S, w, r-1, rep, pattern);
+}
@@ -0,0 +1,166 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * [obj, r_grad_h_and_J] = g_r_stats_mex(...
+ *   pat, count, ...
+ *   B_eff, ...
+ *   r_h_and_J, ...
+ *   lambda, ...
+ *   SkipCheckFlag)
+ *
+ *  pat        uint8     (N-1)-by-U, from `g_r_stats_build_mex`
+ *  count      double    q-by-U, from `g_r_stats_build_mex`
+ *  B_eff      double    $B_{\text{eff}} = \sum_{b=1}^B w_b$
+ *  r_h_and_J  double    $q + q^2(N-1)$ rows, $1$ columns
+ *  lambda     double    2 elements: first is $\lambda_h$, second is $\lambda_J$
+ *
+ * Same objective and gradient as `g_r_mex_v2` (up to round-off), computed from
+ * the statistics of node r (see `g_r_stats.hpp`).
+ *
+ * `SkipCheckFlag` is a placeholder as in `g_r_mex_v2`. Without it, every
+ * state of `pat` is checked to be in [0, q-1].
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v2
+ *   - uint8 patterns instead of int32 offsets
+ * - 2018-04-05  v1
+ */
+
+
+#include "mex.h"
+#include "g_r_stats.hpp"
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs > 2) {
+    mexErrMsgIdAndTxt(
+      "g_r_stats_mex:nlhs",
+      "This function can only calculate objective and gradient.");
+  }
+  // default to check, 6-th arugment is a placeholder to skip check
+  if (nrhs != 5 && nrhs != 6) {
+    mexErrMsgIdAndTxt(
+      "g_r_stats_mex:nrhs",
+      "Number of arguments supported: 5, 6\n"
+      "provided: %d", nrhs);
+  }
+
+  const mxArray *pm_pat         = prhs[0];
+  const mxArray *pm_count       = prhs[1];
+  const mxArray *pm_B_eff       = prhs[2];
+  const mxArray *pm_h_r_and_J_r = prhs[3];
+  const mxArray *pm_lambda      = prhs[4];
+
+  // check when only 5 arguments are provided
+  if (nrhs == 5) {
+    /* type check */
+    if (   !mxIsUint8(pm_pat)
+        || !mxIsDouble(pm_count)
+        || !mxIsDouble(pm_B_eff)
+        || !mxIsDouble(pm_h_r_and_J_r)
+        || !mxIsDouble(pm_lambda) )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_stats_mex:prhs:WrongType",
+        "Requirement:\n"
+        "   uint8:    pat\n"
+        "  double:    count,  B_eff,  h_r_and_J_r,  lambda");
+    }
+
+    for (int k = 0; k < 5; k++) {
+      if (mxIsComplex(prhs[k])) {
+        mexErrMsgIdAndTxt(
+          "g_r_stats_mex:prhs:IsComplex",
+          "\tAll inputs should be real.");
+      }
+    }
+
+    if (mxGetNumberOfElements(pm_B_eff) != 1) {
+      mexErrMsgIdAndTxt(
+        "g_r_stats_mex:prhs:ScalarWrong",
+        "\t`B_eff` should be scalar.");
+    }
+
+    const size_t N0 = mxGetM(pm_pat) + 1;
+    const size_t U0 = mxGetN(pm_pat);
+    const size_t q0 = mxGetM(pm_count);
+
+    if (q0 < 2 || q0 > 256 || mxGetN(pm_count) != U0) {
+      mexErrMsgIdAndTxt(
+        "g_r_stats_mex:prhs:count",
+        "\t`count` should be a q-by-U matrix, 2 <= q <= 256.");
+    }
+
+    // h_r_and_J_r, dimension
+    if ( mxGetM(pm_h_r_and_J_r) != (q0 + q0*q0*(N0-1))
+      || mxGetN(pm_h_r_and_J_r) != 1 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_stats_mex:prhs:h_r_and_J_r",
+        "\t`h_r_and_J_r`, "
+        "which contains h_r and J_r in pseudo-likelihood of node r, "
+        "should be a (q + q*q*(N-1)) * 1 matrix\n");
+    }
+
+    // pat, range: J_{ri}(:, s_i^u) is inside J_r
+    const uint8_t *pat0 = (uint8_t *) mxGetData(pm_pat);
+    for (size_t p = 0; p < (N0-1)*U0; p++) {
+      if (pat0[p] >= q0) {
+        mexErrMsgIdAndTxt(
+          "g_r_stats_mex:prhs:pat",
+          "\t`pat` is not built by `g_r_stats_build_mex` for this q.");
+      }
+    }
+
+    // lambda, dimension and range
+    if (mxGetNumberOfElements(pm_lambda) != 2) {
+      mexErrMsgIdAndTxt(
+        "g_r_stats_mex:prhs:lambda",
+        "\t`lambda`, which contains lambda_h and lambda_J, "
+        "should contains 2 real numbers.");
+    }
+    if (mxGetPr(pm_lambda)[0] < 0.0 || mxGetPr(pm_lambda)[1] < 0.0) {
+      mexErrMsgIdAndTxt("g_r_stats_mex:prhs:lambda",
+        "\t`lambda` may not be negative.");
+    }
+  }
+
+  const size_t   N     = mxGetM(pm_pat) + 1;
+  const size_t   U     = mxGetN(pm_pat);
+  const size_t   q     = mxGetM(pm_count);
+  const uint8_t *pat   = (uint8_t *) mxGetData(pm_pat);
+  const double  *count = mxGetPr(pm_count);
+  const double   B_eff = mxGetPr(pm_B_eff)[0];
+  const double  *h_r   = mxGetPr(pm_h_r_and_J_r);
+  const double  *J_r   = h_r + q;
+  const double   l_h   = mxGetPr(pm_lambda)[0];
+  const double   l_J   = mxGetPr(pm_lambda)[1];
+
+  // `mxCreateDoubleMatrix` initializes each element to 0, required by
+  // `g_r_stats`
+  plhs[1] = mxCreateDoubleMatrix(q + q*q*(N-1), 1, mxREAL);
+  double *grad_h_r = mxGetPr(plhs[1]);
+  double *grad_J_r = grad_h_r + q;
+  double obj = 0.0;
+
+  if (!g_r_stats(&obj, grad_h_r, grad_J_r,
+        U, N, q, pat, count, B_eff, h_r, J_r, l_h, l_J))
+  {
+    mexErrMsgIdAndTxt(
+      "g_r_stats_mex:overflow:exp",
+      "`Num[k]` is too large and likely to overflow `exp(Num[k])`\n");
+  }
+
+  plhs[0] = mxCreateDoubleScalar(obj);
+}
@@ -0,0 +1,178 @@
+#ifndef G_R_VAR_HPP
+#define G_R_VAR_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * `g_r` (see `g_r.v02.h`) for a Potts model whose alphabet size depends on the
+ * site: site i takes q_i states, encoded as [0, q_i-1].
+ *
+ * # Packed layout
+ *
+ * Parameters of node r are stored in one vector of
+ *
+ * $$ P_r = q_r + q_r \sum_{i \neq r} q_i $$
+ *
+ * elements: `h_r` (q_r elements) followed by the blocks $J_{ri}$, i != r, in
+ * increasing order of i. The block $J_{ri}$ is a q_r-by-q_i matrix stored in
+ * column-major, i.e. $J_{ri}(k, s)$ is at
+ *
+ *   q_r + off_i + k + q_r*s,   off_i = q_r \sum_{i' < i, i' \neq r} q_{i'}
+ *
+ * With q_i = q for every site, the layout is the same as that of `g_r`.
+ *
+ *
+ * # Output (by pointer)
+ *
+ *  *Initialization* needed: obj[0] and grad[] should be 0.
+ *
+ *  obj    : objective (1 element)
+ *  grad   : gradient, P_r elements
+ *
+ *
+ * # Input
+ *
+ *  B, N, S, w, B_eff, l_h, l_J : same as `g_r`; S[N*b+i] in [0, q_i-1]
+ *  qlist    : N elements, q_i <= 256
+ *  r        : node index, 0-indexing, [0, N-1]
+ *  h_and_J  : P_r elements, [h_r; J_r] in the packed layout
+ *
+ *
+ * # Return
+ *
+ *  true on success; false if `Num[k]` is too large and likely to overflow
+ *  `exp(Num[k])`. No MATLAB API is called.
+ *
+ *
+ * # History
+ *
+ * ## 2018-04-09  v1
+ */
+
+#include <math.h>   // exp() and log()
+#include <stdint.h> // uint8_t
+#include <vector>
+
+
+// offsets of $J_{ri}$ in `J_r` (off[r] is unused), return the size of `J_r`
+inline size_t g_r_var_offsets(
+  std::vector<size_t> &off,
+  const size_t N, const size_t *qlist, const size_t r)
+{
+  const size_t q_r = qlist[r];
+  off.assign(N, 0);
+  size_t o = 0;
+  for (size_t i = 0; i < N; i++) {
+    off[i] = o;
+    if (i != r) {
+      o += q_r*qlist[i];
+    }
+  }
+  return o;
+}
+
+
+inline bool g_r_var(
+  double *obj, double *grad,
+  const size_t B, const size_t N, const size_t *qlist,
+  const uint8_t *S,
+  const double *w, const double B_eff,
+  const size_t r,
+  const double *h_and_J,
+  const double l_h, const double l_J)
+{
+  const size_t q_r = qlist[r];
+
+  std::vector<size_t> off;
+  const size_t size_J = g_r_var_offsets(off, N, qlist, r);
+
+  const double *h_r      = h_and_J;
+  const double *J_r      = h_and_J + q_r;
+  double       *grad_h_r = grad;
+  double       *grad_J_r = grad + q_r;
+
+  double Num[256];
+
+  for (size_t b = 0; b < B; b++) {
+    const uint8_t *s = S + N*b;
+
+    /* begin: calculate $h_r(k) + \sum_{i \neq r} J_{r i}(k, s_i^b)$ */
+    for (size_t k = 0; k < q_r; k++) {
+      Num[k] = h_r[k];
+    }
+    for (size_t i = 0; i < N; i++) {
+      if (i == r) {
+        continue;
+      }
+      const double *J_ri_s = J_r + off[i] + q_r*s[i];
+      for (size_t k = 0; k < q_r; k++) {
+        Num[k] += J_ri_s[k];
+      }
+    }
+    /* end */
+
+    double Z_r = 0;
+    for (size_t k = 0; k < q_r; k++) {
+      if (Num[k] > 709.0) {
+        return false;
+      }
+      Num[k] = exp(Num[k]);
+      Z_r   += Num[k];
+    }
+    for (size_t k = 0; k < q_r; k++) {
+      Num[k] /= Z_r;              // now `Num` is `Prob`
+    }
+
+    const size_t srb = s[r];
+    *obj -= w[b] * log(Num[srb]);
+
+    for (size_t k = 0; k < q_r; k++) {
+      grad_h_r[k] += w[b] * Num[k];
+    }
+    grad_h_r[srb] -= w[b];
+
+    for (size_t i = 0; i < N; i++) {
+      if (i == r) {
+        continue;
+      }
+      double *grad_J_ri_s = grad_J_r + off[i] + q_r*s[i];
+      for (size_t k = 0; k < q_r; k++) {
+        grad_J_ri_s[k] += w[b] * Num[k];
+      }
+      grad_J_ri_s[srb] -= w[b];
+    }
+  }
+
+
+  /*************************************************
+   *    from sum to mean, and add L2 regulator
+   *************************************************/
+  *obj /= B_eff;
+  for (size_t p = 0; p < q_r + size_J; p++) {
+    grad[p] /= B_eff;
+  }
+
+  if (l_h > 0.0) {
+    for (size_t k = 0; k < q_r; k++) {
+      grad_h_r[k] += l_h*h_r[k]*2;
+      *obj        += l_h*h_r[k]*h_r[k];
+    }
+  }
+  if (l_J > 0.0) {
+    for (size_t p = 0; p < size_J; p++) {
+      grad_J_r[p] += l_J*J_r[p]*2;
+      *obj        += l_J*J_r[p]*J_r[p];
+    }
+  }
+
+  return true;
+}
+
+#endif // G_R_VAR_HPP
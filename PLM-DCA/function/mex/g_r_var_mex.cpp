@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * [obj, r_grad_h_and_J] = g_r_var_mex(...
+ *   S, qlist, ...
+ *   w, B_eff, ...
+ *   r, r_h_and_J, ...
+ *   lambda, ...
+ *   SkipCheckFlag)
+ *
+ *  S          uint8     N rows, B columns (column-major); S(i,b) in [0,q_i-1]
+ *  qlist      uint64    N elements, number of states of each site, <= 256
+ *  w          double    $\{ w_b \}$
+ *  B_eff      double    $B_{\text{eff}} = \sum_{b=1}^B w_b$
+ *  r          uint64    node index, [1,N]
+ *  r_h_and_J  double    $q_r + q_r \sum_{i \neq r} q_i$ rows, 1 column, in
+ *                       the packed layout of `g_r_var.hpp`
+ *  lambda     double    2 elements: first is $\lambda_h$, second is $\lambda_J$
+ *
+ * `SkipCheckFlag` is a placeholder as in `g_r_mex_v2`. The range of `S` is not
+ * checked here (see `PLM_L2_Asym_var`).
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-04-09  v1
+ */
+
+
+#include <vector>
+#include "mex.h"
+#include "g_r_var.hpp"
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs > 2) {
+    mexErrMsgIdAndTxt(
+      "g_r_var_mex:nlhs",
+      "This function can only calculate objective and gradient.");
+  }
+  // default to check, 8-th arugment is a placeholder to skip check
+  if (nrhs != 7 && nrhs != 8) {
+    mexErrMsgIdAndTxt(
+      "g_r_var_mex:nrhs",
+      "Number of arguments supported: 7, 8\n"
+      "provided: %d", nrhs);
+  }
+
+  const mxArray *pm_S         = prhs[0];
+  const mxArray *pm_qlist     = prhs[1];
+  const mxArray *pm_w         = prhs[2];
+  const mxArray *pm_B_eff     = prhs[3];
+  const mxArray *pm_r         = prhs[4];
+  const mxArray *pm_h_and_J   = prhs[5];
+  const mxArray *pm_lambda    = prhs[6];
+
+  const size_t N = mxGetM(pm_S);
+  const size_t B = mxGetN(pm_S);
+
+  // check when only 7 arguments are provided
+  if (nrhs == 7) {
+    /* type check */
+    if (   !mxIsUint8(pm_S)
+        || !mxIsUint64(pm_qlist)
+        || !mxIsUint64(pm_r)
+        || !mxIsDouble(pm_w)
+        || !mxIsDouble(pm_B_eff)
+        || !mxIsDouble(pm_h_and_J)
+        || !mxIsDouble(pm_lambda) )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_var_mex:prhs:WrongType",
+        "Requirement:\n"
+        "   uint8:    S\n"
+        "  uint64:    qlist,  r\n"
+        "  double:    w,  B_eff,  r_h_and_J,  lambda");
+    }
+
+    for (int k = 0; k < 7; k++) {
+      if (mxIsComplex(prhs[k])) {
+        mexErrMsgIdAndTxt(
+          "g_r_var_mex:prhs:IsComplex",
+          "\tAll inputs should be real.");
+      }
+    }
+
+    if ( mxGetNumberOfElements(pm_r) != 1
+      || mxGetNumberOfElements(pm_B_eff) != 1 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_var_mex:prhs:ScalarWrong",
+        "\tAll of {r, B_eff} should be scalar.");
+    }
+
+    if (mxGetNumberOfElements(pm_qlist) != N) {
+      mexErrMsgIdAndTxt(
+        "g_r_var_mex:prhs:qlist",
+        "\t`qlist` should contain N elements, one per row of `S`.");
+    }
+    const uint64_t *qlist0 = (uint64_t *) mxGetData(pm_qlist);
+    for (size_t i = 0; i < N; i++) {
+      if (qlist0[i] < 1 || qlist0[i] > 256) {
+        mexErrMsgIdAndTxt(
+          "g_r_var_mex:prhs:qlist",
+          "\tElements of `qlist` should be in [1,256].");
+      }
+    }
+
+    if (mxGetNumberOfElements(pm_w) != B) {
+      mexErrMsgIdAndTxt(
+        "g_r_var_mex:prhs:w",
+        "\t`w`, which contains weights of sequences, mismatches `S`.\n");
+    }
+
+    const size_t r0 = *((uint64_t *) mxGetData(pm_r));
+    if (r0 > N || r0 == 0) {
+      mexErrMsgIdAndTxt(
+        "g_r_var_mex:prhs:r",
+        "\t`r` should be integers in [1,N].");
+    }
+
+    size_t Q = 0;
+    for (size_t i = 0; i < N; i++) {
+      Q += qlist0[i];
+    }
+    const size_t q_r = qlist0[r0-1];
+    if ( mxGetM(pm_h_and_J) != q_r + q_r*(Q - q_r)
+      || mxGetN(pm_h_and_J) != 1 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_r_var_mex:prhs:r_h_and_J",
+        "\t`r_h_and_J` should be a (q_r + q_r*sum_{i~=r} q_i) * 1 matrix\n");
+    }
+
+    if (mxGetNumberOfElements(pm_lambda) != 2) {
+      mexErrMsgIdAndTxt(
+        "g_r_var_mex:prhs:lambda",
+        "\t`lambda`, which contains lambda_h and lambda_J, "
+        "should contains 2 real numbers.");
+    }
+    if (mxGetPr(pm_lambda)[0] < 0.0 || mxGetPr(pm_lambda)[1] < 0.0) {
+      mexErrMsgIdAndTxt("g_r_var_mex:prhs:lambda",
+        "\t`lambda` may not be negative.");
+    }
+  }
+
+  const uint64_t *qlist64 = (uint64_t *) mxGetData(pm_qlist);
+  const size_t   r       = *((uint64_t *) mxGetData(pm_r)) - 1;
+  const uint8_t *S       = (uint8_t *) mxGetData(pm_S);
+  const double  *w       = mxGetPr(pm_w);
+  const double   B_eff   = mxGetPr(pm_B_eff)[0];
+  const double  *h_and_J = mxGetPr(pm_h_and_J);
+  const double   l_h     = mxGetPr(pm_lambda)[0];
+  const double   l_J     = mxGetPr(pm_lambda)[1];
+
+  std::vector<size_t> qlist(qlist64, qlist64 + N);
+
+  // `mxCreateDoubleMatrix` initializes each element to 0, required by `g_r_var`
+  plhs[1] = mxCreateDoubleMatrix(mxGetM(pm_h_and_J), 1, mxREAL);
+  double obj = 0.0;
+
+  if (!g_r_var(&obj, mxGetPr(plhs[1]),
+        B, N, qlist.data(), S, w, B_eff, r, h_and_J, l_h, l_J))
+  {
+    mexErrMsgIdAndTxt(
+      "g_r_var_mex:overflow:exp",
+      "r = %ld:  "
+      "`Num[k]` is too large and likely to overflow `exp(Num[k])`\n",
+      r+1);
+  }
+
+  plhs[0] = mxCreateDoubleScalar(obj);
+}
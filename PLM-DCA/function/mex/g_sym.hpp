@@ -0,0 +1,226 @@
+#ifndef G_SYM_HPP
+#define G_SYM_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Objective and gradient of the symmetric pseudo-likelihood of q-state Potts
+ * model, i.e. the sum of `g_r` (see `g_r.v02.h`) over all nodes r with one
+ * shared coupling matrix J_ij = J_ji^T per pair:
+ *
+ *   F = - 1/B_eff \sum_b w_b \sum_r log P(s_r^b | s_{\r}^b)
+ *       + l_h \sum_r |h_r|^2 + l_J \sum_{i<j} |J_ij|^2
+ *
+ * Parameters (P = q*N + q*q*N*(N-1)/2 elements):
+ *
+ *   h_r(k)     at [k + q*r]
+ *   J_ij(k,l)  at [q*N + q*q*p + k + q*l], k the state of i, l that of j,
+ *              where p is the index of pair (i,j), i < j, in the order (0,1),
+ *              (0,2), ..., (0,N-1), (1,2), ... (the order of `CC_MSA`)
+ *
+ * For every sample, the fields of all nodes are accumulated in one pass over
+ * the pair blocks (column s_j of J_ij for node i, row s_i for node j), and the
+ * gradient is scattered in a second pass in the same order.
+ *
+ * The sample loop is split among the threads of `pool`; every thread other
+ * than the first accumulates into a private gradient of P doubles, and the
+ * private gradients are then summed in parallel over slices of parameters.
+ * Memory is thus (numThread - 1)*P doubles on top of the output. Private
+ * gradients are allocated by their threads; when the pool spans several NUMA
+ * nodes (pinned), the parameters read by every sample are copied once per node
+ * (`NodeReplicas`), which adds P doubles per node.
+ *
+ *
+ * # Output (by pointer)
+ *
+ *  obj      : 1 element
+ *  grad     : P elements, need not be initialized
+ *
+ *
+ * # Input
+ *
+ *  B, N, q, S, w, B_eff : same as `g_r`
+ *  h_and_J  : P elements, layout above
+ *  l_h, l_J : lambdas for L2 regularization on h and J
+ *
+ *
+ * # Return
+ *
+ *  -1 on success; otherwise the node (0-indexing) whose `Num[k]` is too large
+ *  and likely to overflow `exp(Num[k])`. No MATLAB API is called.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-09  v1.1
+ *
+ * - parameters replicated per NUMA node
+ *
+ * ## 2018-05-06  v1
+ */
+
+#include <math.h>   // exp() and log()
+#include <stdint.h> // uint8_t
+#include <algorithm>
+#include <vector>
+#include "../../../common/mex/thread_pool.hpp"
+
+
+// number of parameters of the symmetric model
+inline size_t g_sym_numel(const size_t N, const size_t q) {
+  return q*N + q*q*(N*(N-1)/2);
+}
+
+
+// unregularized sum over samples [b0, b1), added to *obj and grad[]
+inline long g_sym_samples(
+  double *obj, double *grad,
+  const size_t b0, const size_t b1, const size_t N, const size_t q,
+  const uint8_t *S, const double *w,
+  const double *h_and_J)
+{
+  const double *h  = h_and_J;
+  const double *J  = h_and_J + q*N;
+  double *grad_h   = grad;
+  double *grad_J   = grad + q*N;
+  const size_t qq  = q*q;
+
+  std::vector<double> Num(q*N);     // fields, then w_b (Prob - delta)
+
+  for (size_t b = b0; b < b1; b++) {
+    const double wb = w[b];
+    if (wb == 0.0) {
+      continue;
+    }
+    const uint8_t *s = S + N*b;
+
+    /* begin: Num[k + q*r] = $h_r(k) + \sum_{i \neq r} J_{r i}(k, s_i^b)$ */
+    std::copy(h, h + q*N, Num.begin());
+    const double *blk = J;
+    for (size_t i = 0; i+1 < N; i++) {
+      const size_t si = s[i];
+      double *Num_i = Num.data() + q*i;
+      for (size_t j = i+1; j < N; j++, blk += qq) {
+        const double *col = blk + q*s[j];       // J_ij(:, s_j)
+        double *Num_j = Num.data() + q*j;
+        for (size_t k = 0; k < q; k++) {
+          Num_i[k] += col[k];
+          Num_j[k] += blk[si + q*k];            // J_ij(s_i, :)
+        }
+      }
+    }
+    /* end */
+
+    /* Num[k + q*r] <- w_b (Prob_r(k) - [k == s_r^b]) */
+    for (size_t r = 0; r < N; r++) {
+      double *Num_r = Num.data() + q*r;
+      double Z_r = 0;
+      for (size_t k = 0; k < q; k++) {
+        if (Num_r[k] > 709.0) {
+          return long(r);
+        }
+        Num_r[k] = exp(Num_r[k]);
+        Z_r += Num_r[k];
+      }
+      *obj -= wb * log(Num_r[s[r]] / Z_r);
+      const double c = wb / Z_r;
+      for (size_t k = 0; k < q; k++) {
+        Num_r[k] *= c;
+      }
+      Num_r[s[r]] -= wb;
+    }
+
+    for (size_t p = 0; p < q*N; p++) {
+      grad_h[p] += Num[p];
+    }
+    double *gblk = grad_J;
+    for (size_t i = 0; i+1 < N; i++) {
+      const size_t si = s[i];
+      const double *Num_i = Num.data() + q*i;
+      for (size_t j = i+1; j < N; j++, gblk += qq) {
+        double *gcol = gblk + q*s[j];
+        const double *Num_j = Num.data() + q*j;
+        for (size_t k = 0; k < q; k++) {
+          gcol[k]         += Num_i[k];
+          gblk[si + q*k]  += Num_j[k];
+        }
+      }
+    }
+  }
+  return -1;
+}
+
+
+inline long g_sym(
+  double *obj, double *grad,
+  const size_t B, const size_t N, const size_t q,
+  const uint8_t *S, const double *w, const double B_eff,
+  const double *h_and_J,
+  const double l_h, const double l_J,
+  ThreadPool &pool)
+{
+  const size_t P = g_sym_numel(N, q);
+  const size_t T = pool.size();
+
+  std::vector<std::vector<double> > grad_t(T > 1 ? T-1 : 0);
+  std::vector<double> obj_t(T, 0.0);
+  std::vector<long> err_t(T, -1);
+  const NodeReplicas<double> x_node(pool, h_and_J, P);
+
+  /* samples split evenly, one range per thread */
+  pool.run([&](size_t tid) {
+    const size_t b0 = B*tid/T;
+    const size_t b1 = B*(tid+1)/T;
+    double *g = grad;
+    if (tid > 0) {
+      grad_t[tid-1].assign(P, 0.0);
+      g = grad_t[tid-1].data();
+    }
+    else {
+      std::fill(grad, grad + P, 0.0);
+    }
+    err_t[tid] = g_sym_samples(&obj_t[tid], g, b0, b1, N, q, S, w,
+      x_node.get(tid));
+  });
+  for (size_t t = 0; t < T; t++) {
+    if (err_t[t] >= 0) {
+      return err_t[t];
+    }
+  }
+
+  /* reduction, then from sum to mean, and add L2 regulator */
+  std::vector<double> reg_t(T, 0.0);
+  pool.parallel_for(P, 1 << 16, [&](size_t begin, size_t end, size_t tid) {
+    double reg = 0.0;
+    for (size_t p = begin; p < end; p++) {
+      double g = grad[p];
+      for (size_t t = 0; t+1 < T; t++) {
+        g += grad_t[t][p];
+      }
+      const double l = p < q*N ? l_h : l_J;
+      const double x = h_and_J[p];
+      grad[p] = g / B_eff + l*x*2;
+      reg    += l*x*x;
+    }
+    reg_t[tid] += reg;
+  });
+
+  double sum = 0.0;
+  for (size_t t = 0; t < T; t++) {
+    sum += obj_t[t];
+  }
+  *obj = sum / B_eff;
+  for (size_t t = 0; t < T; t++) {
+    *obj += reg_t[t];
+  }
+  return -1;
+}
+
+#endif // G_SYM_HPP
@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * [obj, grad_h_and_J] = g_sym_mex(...
+ *   S, ...
+ *   N, B, q, ...
+ *   w, B_eff, ...
+ *   h_and_J, ...
+ *   lambda, ...
+ *   numThread, ...
+ *   SkipCheckFlag)
+ *
+ *  S          uint8     [0, 255], N rows, B columns (column-major)
+ *  N          uint64    length of sequence (for check: to be robust)
+ *  B          uint64    number of sequences (for check: to be robust)
+ *  q          uint64    $q \le 256$ since S is uint8.
+ *  w          double    $\{ w_b \}$
+ *  B_eff      double    $B_{\text{eff}} = \sum_{b=1}^B w_b$
+ *  h_and_J    double    $qN + q^2 N(N-1)/2$ elements, [h(:); J(:)] where h is
+ *                       q-by-N and J(:,p) is J_ij(:) of the p-th pair (i<j) in
+ *                       the order of `CC_MSA` (see `g_sym.hpp`)
+ *  lambda     double    2 elements: first is $\lambda_h$, second is $\lambda_J$
+ *                       (every J_ij is penalized once)
+ *  numThread  double    number of native threads splitting the samples
+ *
+ *  obj             symmetric objective, $\sum_r g_r$ with shared couplings
+ *  grad_h_and_J    gradient of `obj`, in the layout of `h_and_J`
+ *
+ * `SkipCheckFlag` is a placeholder as in `g_r_mex_v2`.
+ *
+ * When `numThread` exceeds the CPUs of one NUMA node, threads are pinned and
+ * spread over the nodes, and the parameters are copied once per node.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-09  v1.1  NUMA placement
+ * - 2018-05-06  v1
+ */
+
+
+#include "mex.h"
+#include "g_sym.hpp"
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs > 2) {
+    mexErrMsgIdAndTxt(
+      "g_sym_mex:nlhs",
+      "This function can only calculate objective and gradient.");
+  }
+  // default to check, 10-th arugment is a placeholder to skip check
+  if (nrhs != 9 && nrhs != 10) {
+    mexErrMsgIdAndTxt(
+      "g_sym_mex:nrhs",
+      "Number of arguments supported: 9, 10\n"
+      "provided: %d", nrhs);
+  }
+
+  const mxArray *pm_S           = prhs[0];
+  const mxArray *pm_N           = prhs[1];
+  const mxArray *pm_B           = prhs[2];
+  const mxArray *pm_q           = prhs[3];
+  const mxArray *pm_w           = prhs[4];
+  const mxArray *pm_B_eff       = prhs[5];
+  const mxArray *pm_h_and_J     = prhs[6];
+  const mxArray *pm_lambda      = prhs[7];
+  const mxArray *pm_numThread   = prhs[8];
+
+  // check when only 9 arguments are provided
+  if (nrhs == 9) {
+    /* type check */
+    if (   !mxIsUint8(pm_S)
+        || !mxIsUint64(pm_N)
+        || !mxIsUint64(pm_B)
+        || !mxIsUint64(pm_q)
+        || !mxIsDouble(pm_w)
+        || !mxIsDouble(pm_B_eff)
+        || !mxIsDouble(pm_h_and_J)
+        || !mxIsDouble(pm_lambda)
+        || !mxIsDouble(pm_numThread) )
+    {
+      mexErrMsgIdAndTxt(
+        "g_sym_mex:prhs:WrongType",
+        "Requirement:\n"
+        "   uint8:    S\n"
+        "  uint64:    N,  B,  q\n"
+        "  double:    w,  B_eff,  h_and_J,  lambda,  numThread");
+    }
+
+    for (int k = 0; k < 9; k++) {
+      if (mxIsComplex(prhs[k])) {
+        mexErrMsgIdAndTxt(
+          "g_sym_mex:prhs:IsComplex",
+          "\tAll inputs should be real.");
+      }
+    }
+
+    if ( mxGetNumberOfElements(pm_N) != 1
+      || mxGetNumberOfElements(pm_B) != 1
+      || mxGetNumberOfElements(pm_q) != 1
+      || mxGetNumberOfElements(pm_B_eff) != 1
+      || mxGetNumberOfElements(pm_numThread) != 1 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_sym_mex:prhs:ScalarWrong",
+        "\tAll of {N, B, q, B_eff, numThread} should be scalar.");
+    }
+
+    const size_t N0 = *((uint64_t *) mxGetData(pm_N));
+    const size_t B0 = *((uint64_t *) mxGetData(pm_B));
+    const size_t q0 = *((uint64_t *) mxGetData(pm_q));
+
+    if ( mxGetM(pm_S) != N0
+      || mxGetN(pm_S) != B0 )
+    {
+      mexErrMsgIdAndTxt(
+        "g_sym_mex:prhs:S",
+        "\tColumns of `S` are considered as sequences.\n"
+        "\tThus `S` should be a matrix consists of `N` rows and `B` columns");
+    }
+
+    if (q0 < 2 || q0 > 256) {
+        mexErrMsgIdAndTxt(
+          "g_sym_mex:prhs:q",
+          "Requirement on q:\n"
+          "\tq >= 2 since 1-state Potts model is trivial.\n"
+          "\tq <= 256 since `S` can only stores 0~255.\n");
+    }
+
+    if (mxGetNumberOfElements(pm_w) != B0) {
+      mexErrMsgIdAndTxt(
+        "g_sym_mex:prhs:w",
+        "\t`w`, which contains weights of sequences, "
+        "should contain B elements.\n");
+    }
+
+    if (!(mxGetScalar(pm_B_eff) > 0.0)) {
+      mexErrMsgIdAndTxt(
+        "g_sym_mex:prhs:B_eff",
+        "\t`B_eff` should be positive.\n");
+    }
+
+    if (mxGetNumberOfElements(pm_h_and_J) != g_sym_numel(N0, q0)) {
+      mexErrMsgIdAndTxt(
+        "g_sym_mex:prhs:h_and_J",
+        "\t`h_and_J`, which contains h and the shared J, "
+        "should contain q*N + q*q*N*(N-1)/2 elements\n");
+    }
+
+    if (mxGetNumberOfElements(pm_lambda) != 2) {
+      mexErrMsgIdAndTxt(
+        "g_sym_mex:prhs:lambda",
+        "\t`lambda`, which contains lambda_h and lambda_J, "
+        "should contains 2 real numbers.");
+    }
+    if (mxGetPr(pm_lambda)[0] < 0.0 || mxGetPr(pm_lambda)[1] < 0.0) {
+      mexErrMsgIdAndTxt("g_sym_mex:prhs:lambda",
+        "\t`lambda` may not be negative.");
+    }
+  }
+
+  const size_t   N       = mxGetM(pm_S);
+  const size_t   B       = mxGetN(pm_S);
+  const size_t   q       = *((uint64_t *) mxGetData(pm_q));
+  const uint8_t *S       = (uint8_t *) mxGetData(pm_S);
+  const double  *w       = mxGetPr(pm_w);
+  const double   B_eff   = mxGetScalar(pm_B_eff);
+  const double  *h_and_J = mxGetPr(pm_h_and_J);
+  const double   l_h     = mxGetPr(pm_lambda)[0];
+  const double   l_J     = mxGetPr(pm_lambda)[1];
+  const double   nt      = mxGetScalar(pm_numThread);
+
+  // no more threads than samples
+  size_t numThread = nt >= 1.0 ? size_t(nt) : 1;
+  if (numThread > B && B > 0) {
+    numThread = B;
+  }
+
+  plhs[1] = mxCreateDoubleMatrix(g_sym_numel(N, q), 1, mxREAL);
+  double obj = 0.0;
+
+  ThreadPool pool(numThread, numa_spans_nodes(numThread));
+  const long r_overflow = g_sym(&obj, mxGetPr(plhs[1]),
+    B, N, q, S, w, B_eff, h_and_J, l_h, l_J, pool);
+  if (r_overflow >= 0) {
+    mexErrMsgIdAndTxt(
+      "g_sym_mex:overflow:exp",
+      "r = %ld:  "
+      "`Num[k]` is too large and likely to overflow `exp(Num[k])`\n",
+      r_overflow+1);
+  }
+
+  plhs[0] = mxCreateDoubleScalar(obj);
+}
@@ -1,3 +1,71 @@
 fprintf('Compiling `g_r_mex_v2.cpp` ...\n')
+if isunix && ~ismac  % `shm_open` is in librt before glibc 2.34
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+    -outdir ../compiled g_r_mex_v2.cpp -lrt
+else
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+    -outdir ../compiled g_r_mex_v2.cpp
+end
+fprintf('Compiling `shm_msa_mex.cpp` ...\n')
+if isunix && ~ismac
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+    -outdir ../compiled ../../../common/mex/shm_msa_mex.cpp -lrt
+else
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+    -outdir ../compiled ../../../common/mex/shm_msa_mex.cpp
+end
+fprintf('Compiling `g_R_mex.cpp` ...\n')
 mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
-  -outdir ../compiled g_r_mex_v2.cpp
+  -outdir ../compiled g_R_mex.cpp
+fprintf('Compiling `g_r_stats_build_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+  -outdir ../compiled g_r_stats_build_mex.cpp
+fprintf('Compiling `g_r_stats_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+  -outdir ../compiled g_r_stats_mex.cpp
+fprintf('Compiling `g_r_var_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+  -outdir ../compiled g_r_var_mex.cpp
+fprintf('Compiling `Hv_g_r_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+  -outdir ../compiled Hv_g_r_mex.cpp
+fprintf('Compiling `g_r_rep_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+  -outdir ../compiled g_r_rep_mex.cpp
+fprintf('Compiling `g_r_act_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11' ...
+  -outdir ../compiled g_r_act_mex.cpp
+fprintf('Compiling `g_sym_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+  LDFLAGS='$LDFLAGS -pthread' ...
+  -outdir ../compiled g_sym_mex.cpp
+if isunix  % POSIX sockets and directories
+  fprintf('Compiling `dist_coord_mex.cpp` ...\n')
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+    LDFLAGS='$LDFLAGS -pthread' ...
+    -outdir ../compiled dist_coord_mex.cpp
+  fprintf('Compiling `dist_worker_mex.cpp` ...\n')
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+    LDFLAGS='$LDFLAGS -pthread' ...
+    -outdir ../compiled dist_worker_mex.cpp
+  fprintf('Compiling `ckpt_mex.cpp` ...\n')
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+    LDFLAGS='$LDFLAGS -pthread' ...
+    -outdir ../compiled ckpt_mex.cpp
+else
+  fprintf('Skipping `dist_coord_mex.cpp`, `dist_worker_mex.cpp` and `ckpt_mex.cpp` (POSIX only) ...\n')
+end
+fprintf('Compiling `telemetry_mex.cpp` ...\n')
+if isunix && ~ismac
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+    LDFLAGS='$LDFLAGS -pthread' ...
+    -outdir ../compiled telemetry_mex.cpp -lrt
+else
+  mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+    LDFLAGS='$LDFLAGS -pthread' ...
+    -outdir ../compiled telemetry_mex.cpp
+end
+fprintf('Compiling `sample_Potts_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+  LDFLAGS='$LDFLAGS -pthread' ...
+  -outdir ../compiled sample_Potts_mex.cpp
@@ -0,0 +1,198 @@
+#ifndef SAMPLE_POTTS_HPP
+#define SAMPLE_POTTS_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Gibbs (heat-bath) sampler of a q-state Potts model with sparse couplings
+ *
+ * $$
+ * P(\underline{s}) \propto
+ *   \exp\left( \sum_i h_i(s_i) + \sum_{i<j} J_{ij}(s_i,s_j) \right)
+ * $$
+ *
+ * The conditional distribution of node r is exactly the one modelled by `g_r`:
+ *
+ * $$
+ * P(s_r = k | \underline{s}_{\partial r}) \propto
+ *   \exp\left( h_r(k) + \sum_{i \neq r} J_{r i}(k, s_i) \right)
+ * $$
+ *
+ * and the couplings of node r are kept in the layout of `J_r` in `g_r`: the
+ * block $J_{r i}$ is a q-by-q matrix stored in column-major, whose row index
+ * is the state of r. Only non-zero blocks are stored (CSR-like adjacency).
+ *
+ *
+ * # Chains
+ *
+ * Samples are produced by independent chains of `chainLen` samples. Chain c
+ * starts from a uniform random configuration, performs `burnIn` sweeps, and
+ * then records a sample every `thin` sweeps. Its random number generator is
+ * seeded by (seed, c), thus the output does not depend on the number of
+ * threads.
+ *
+ *
+ * # History
+ *
+ * ## 2018-03-20  v1
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+
+struct PottsSparse {
+  size_t N;
+  size_t q;
+  const double *h;            // q*N, h[k + q*r] = h_r(k)
+  std::vector<size_t>   ptr;  // N+1 offsets into `nbr`
+  std::vector<uint32_t> nbr;  // neighbours i of node r (0-based)
+  std::vector<double>   J;    // q*q per neighbour, J_{ri}(k,l) at k + q*l
+};
+
+
+/**
+ * Build the adjacency from an edge list.
+ *
+ *  edges : 2*E, 1-based (i_e, j_e) with i_e != j_e
+ *  J_e   : q*q*E, J_e[k + q*l + q*q*e] = J_{i_e j_e}(k,l)
+ */
+inline void build_Potts_sparse(
+  PottsSparse &model,
+  const size_t N, const size_t q, const double *h,
+  const size_t E, const uint32_t *edges, const double *J_e)
+{
+  model.N = N;
+  model.q = q;
+  model.h = h;
+
+  // degree
+  model.ptr.assign(N+1, 0);
+  for (size_t e = 0; e < E; e++) {
+    model.ptr[edges[2*e]]++;
+    model.ptr[edges[2*e+1]]++;
+  }
+  for (size_t r = 0; r < N; r++) {
+    model.ptr[r+1] += model.ptr[r];
+  }
+
+  // fill
+  model.nbr.resize(model.ptr[N]);
+  model.J.resize(model.ptr[N]*q*q);
+  std::vector<size_t> pos(model.ptr.begin(), model.ptr.end()-1);
+  for (size_t e = 0; e < E; e++) {
+    const size_t i = edges[2*e]   - 1;
+    const size_t j = edges[2*e+1] - 1;
+    const double *Jij = J_e + q*q*e;
+
+    // J_{ij}(k,l) as it is
+    size_t p = pos[i]++;
+    model.nbr[p] = uint32_t(j);
+    for (size_t l = 0; l < q; l++) {
+      for (size_t k = 0; k < q; k++) {
+        model.J[q*q*p + k + q*l] = Jij[k + q*l];
+      }
+    }
+
+    // J_{ji}(k,l) = J_{ij}(l,k)
+    p = pos[j]++;
+    model.nbr[p] = uint32_t(i);
+    for (size_t l = 0; l < q; l++) {
+      for (size_t k = 0; k < q; k++) {
+        model.J[q*q*p + k + q*l] = Jij[l + q*k];
+      }
+    }
+  }
+}
+
+
+// one Gibbs sweep over all nodes, s[i] in [0,q-1]
+template <class RNG>
+inline void gibbs_sweep(
+  const PottsSparse &model, uint8_t *s, RNG &rng, double *Num)
+{
+  const size_t q = model.q;
+  std::uniform_real_distribution<double> unif(0.0, 1.0);
+
+  for (size_t r = 0; r < model.N; r++) {
+    for (size_t k = 0; k < q; k++) {
+      Num[k] = model.h[k + q*r];
+    }
+    for (size_t p = model.ptr[r]; p < model.ptr[r+1]; p++) {
+      const double *J_ri = model.J.data() + q*(s[model.nbr[p]] + q*p);
+      for (size_t k = 0; k < q; k++) {
+        Num[k] += J_ri[k];
+      }
+    }
+
+    // heat-bath: P(k) = exp(Num[k] - max) / Z
+    double Num_max = Num[0];
+    for (size_t k = 1; k < q; k++) {
+      if (Num[k] > Num_max) {
+        Num_max = Num[k];
+      }
+    }
+    double Z = 0.0;
+    for (size_t k = 0; k < q; k++) {
+      Num[k] = std::exp(Num[k] - Num_max);
+      Z += Num[k];
+    }
+
+    double u = unif(rng) * Z;
+    size_t k = 0;
+    while (k < q-1 && u >= Num[k]) {
+      u -= Num[k];
+      k++;
+    }
+    s[r] = uint8_t(k);
+  }
+}
+
+
+/**
+ * Run chain c and write its samples into S (N rows, columns as samples).
+ *
+ *  S          : pointer to the first column of this chain
+ *  numSample  : number of samples recorded by this chain
+ */
+inline void sample_chain(
+  const PottsSparse &model, uint8_t *S, const size_t numSample,
+  const size_t burnIn, const size_t thin,
+  const uint64_t seed, const uint64_t c)
+{
+  const size_t N = model.N;
+  const size_t q = model.q;
+
+  std::seed_seq seq{uint32_t(seed), uint32_t(seed >> 32),
+                    uint32_t(c),    uint32_t(c >> 32)};
+  std::mt19937_64 rng(seq);
+  std::uniform_int_distribution<int> state(0, int(q) - 1);
+
+  std::vector<uint8_t> s(N);
+  for (auto &si : s) {
+    si = uint8_t(state(rng));
+  }
+
+  double Num[256];
+  for (size_t t = 0; t < burnIn; t++) {
+    gibbs_sweep(model, s.data(), rng, Num);
+  }
+  for (size_t b = 0; b < numSample; b++) {
+    for (size_t t = 0; t < thin; t++) {
+      gibbs_sweep(model, s.data(), rng, Num);
+    }
+    std::copy(s.begin(), s.end(), S + N*b);
+  }
+}
+
+#endif // SAMPLE_POTTS_HPP
@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * S = sample_Potts_mex(h, edges, J, B, burnIn, thin, chainLen, seed, numThread)
+ *
+ *  h          double    q rows, N columns; h(k,r) = $h_r(k)$
+ *  edges      uint32    2 rows, E columns; (i,j) of non-zero couplings, 1-based
+ *  J          double    q*q*E elements; J(:,:,e) = $J_{ij}$ of edges(:,e)
+ *  B          double    number of samples
+ *  burnIn     double    sweeps discarded at the beginning of each chain
+ *  thin       double    sweeps between two recorded samples
+ *  chainLen   double    number of samples recorded by one chain
+ *  seed       double    seed of random number generators
+ *  numThread  double    number of native threads
+ *
+ *  S          uint8     [0,q-1], N rows, B columns (column-major), the same
+ *                       layout as `S` in `g_r_mex_v2`
+ *
+ * See `sample_Potts.hpp` for the model and the chains. The output depends on
+ * `seed` and `chainLen` only, not on `numThread`.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-03-20  v1
+ */
+
+#include <cstdint>
+#include "mex.h"
+#include "sample_Potts.hpp"
+#include "../../../common/mex/thread_pool.hpp"
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nlhs > 1) {
+    mexErrMsgIdAndTxt(
+      "sample_Potts_mex:nlhs",
+      "This function produces 1 output.");
+  }
+  if (nrhs != 9) {
+    mexErrMsgIdAndTxt(
+      "sample_Potts_mex:nrhs",
+      "Number of arguments needed: 9\n"
+      "provided: %d", nrhs);
+  }
+
+  const mxArray *pm_h     = prhs[0];
+  const mxArray *pm_edges = prhs[1];
+  const mxArray *pm_J     = prhs[2];
+
+  /* type check */
+  if (   !mxIsDouble(pm_h)
+      || !mxIsUint32(pm_edges)
+      || !mxIsDouble(pm_J) )
+  {
+    mexErrMsgIdAndTxt(
+      "sample_Potts_mex:prhs:WrongType",
+      "Requirement:\n"
+      "  double:    h,  J\n"
+      "  uint32:    edges");
+  }
+  for (int k = 3; k < 9; k++) {
+    if (!mxIsDouble(prhs[k]) || mxGetNumberOfElements(prhs[k]) != 1) {
+      mexErrMsgIdAndTxt(
+        "sample_Potts_mex:prhs:ScalarWrong",
+        "All of {B, burnIn, thin, chainLen, seed, numThread} "
+        "should be double scalars.");
+    }
+  }
+
+  const size_t q = mxGetM(pm_h);
+  const size_t N = mxGetN(pm_h);
+  const size_t E = mxGetN(pm_edges);
+
+  /* dimension and range */
+  if (q < 2 || q > 256) {
+    mexErrMsgIdAndTxt(
+      "sample_Potts_mex:prhs:q",
+      "Requirement on q (number of rows of `h`):\n"
+      "\tq >= 2 since 1-state Potts model is trivial.\n"
+      "\tq <= 256 since `S` can only stores 0~255.\n");
+  }
+  if (E > 0 && mxGetM(pm_edges) != 2) {
+    mexErrMsgIdAndTxt(
+      "sample_Potts_mex:prhs:edges",
+      "`edges` should be a 2-by-E matrix.");
+  }
+  if (mxGetNumberOfElements(pm_J) != q*q*E) {
+    mexErrMsgIdAndTxt(
+      "sample_Potts_mex:prhs:J",
+      "`J` should contain q*q*E elements.");
+  }
+  const uint32_t *edges = (uint32_t *) mxGetData(pm_edges);
+  for (size_t e = 0; e < E; e++) {
+    const uint32_t i = edges[2*e];
+    const uint32_t j = edges[2*e+1];
+    if (i < 1 || j < 1 || i > N || j > N || i == j) {
+      mexErrMsgIdAndTxt(
+        "sample_Potts_mex:prhs:edges",
+        "Edge %zu: (%u,%u) should be two different nodes in [1,N].",
+        e+1, i, j);
+    }
+  }
+
+  const size_t B         = size_t(mxGetScalar(prhs[3]));
+  const size_t burnIn    = size_t(mxGetScalar(prhs[4]));
+  const size_t thin      = size_t(mxGetScalar(prhs[5]));
+  const size_t chainLen  = size_t(mxGetScalar(prhs[6]));
+  const uint64_t seed    = uint64_t(mxGetScalar(prhs[7]));
+  const size_t numThread = size_t(mxGetScalar(prhs[8]));
+  if (thin < 1 || chainLen < 1 || numThread < 1) {
+    mexErrMsgIdAndTxt(
+      "sample_Potts_mex:prhs:range",
+      "`thin`, `chainLen` and `numThread` should be positive.");
+  }
+
+  PottsSparse model;
+  build_Potts_sparse(model, N, q, mxGetPr(pm_h), E, edges, mxGetPr(pm_J));
+
+  plhs[0] = mxCreateNumericMatrix(N, B, mxUINT8_CLASS, mxREAL);
+  uint8_t *S = (uint8_t *) mxGetData(plhs[0]);
+
+  const size_t numChain = (B + chainLen - 1) / chainLen;
+  ThreadPool pool(numThread < numChain ? numThread : (numChain > 0 ? numChain : 1));
+  pool.parallel_for(numChain, 1, [&](size_t begin, size_t end, size_t) {
+    for (size_t c = begin; c < end; c++) {
+      const size_t b0 = c*chainLen;
+      const size_t numSample = (b0 + chainLen < B) ? chainLen : B - b0;
+      sample_chain(model, S + N*b0, numSample, burnIn, thin, seed, c);
+    }
+  });
+}
@@ -0,0 +1,797 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * Live state of the minimization of nodes, shared by all MATLAB processes of
+ * one host through a POSIX shared-memory segment (see `telemetry_mex`).
+ *
+ *  offset 0    char[8]   "CCPLMTEL"
+ *  offset 8    uint32    version (1)
+ *  offset 12   uint32    number of slots
+ *  offset 16   uint64    number of nodes
+ *  offset 24   uint64[5] reserved, 0
+ *  offset 64   slots     128 bytes each, one per process
+ *  ...         nodes     48 bytes each, one per node
+ *
+ * Every worker process claims one slot (by its pid) and is the only writer of
+ * it: the node in progress, its iteration, evaluations, objective, gradient
+ * norm (max |g|, the `optTol` criterion of `minFunc`) and time stamps, plus
+ * the evaluations and nodes done by the process so far. An update is a few
+ * relaxed stores between two increments of a sequence number (seqlock) and no
+ * system call, so the optimization does not wait for the monitor. A finished
+ * node writes its entry of the node table and releases it by `state`.
+ *
+ * `TelemetryMonitor` is the only reader: a thread of the client which copies
+ * all slots every `period` seconds, aggregates them (nodes done and in
+ * flight, evaluations per second, rolling ETA over the last 10 minutes,
+ * iterations of finished nodes) and rewrites a plain-text status file by
+ * `rename`, so that `cat` or `tail` never see a partial file. Nodes are
+ * flagged as
+ *
+ *   stuck      no iteration within `stall` seconds
+ *   divergent  objective or gradient norm not finite (finished nodes too)
+ *   lost       the process holding the node is gone
+ *   slow       running 5 times longer than the median node, and more than a
+ *              minute (after 10 nodes)
+ *
+ *
+ * # Note for implementation
+ *
+ * Plain C++ and POSIX; functions return a `TelemetryStatus` and the caller maps
+ * it to MATLAB errors. Times are seconds of `steady_clock`, which is common to
+ * all processes of a host. Link with `-lrt` on Linux (glibc < 2.34). On
+ * Windows every function fails with `TEL_ERR_UNSUPPORTED`.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v1.1
+ *
+ * - the monitor thread uses `localtime_r` (`localtime_s` on Windows)
+ *
+ * ## 2018-05-10  v1
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <signal.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+
+enum TelemetryStatus {
+  TEL_OK              = 0,
+  TEL_ERR_OPEN        = 1,  // no such segment, or not permitted
+  TEL_ERR_SPACE       = 2,  // shared memory exhausted
+  TEL_ERR_MAP         = 3,
+  TEL_ERR_FORMAT      = 4,  // not created by `tel_create`
+  TEL_ERR_FULL        = 5,  // all slots are taken
+  TEL_ERR_FILE        = 6,  // status file could not be written
+  TEL_ERR_UNSUPPORTED = 7   // Windows
+};
+
+// words of a slot
+enum {
+  TS_SEQ = 0,      // odd while the owner writes
+  TS_PID,          // owner, 0 if free
+  TS_NODE,         // node in progress (1-based), 0 if none
+  TS_ITER,
+  TS_EVALS,        // evaluations of the node in progress
+  TS_F,            // bits of a double
+  TS_GNORM,        // bits of a double
+  TS_T_NODE,       // bits of a double, start of the node
+  TS_T_UPDATE,     // bits of a double, last update
+  TS_EVALS_TOTAL,  // evaluations of the process, finished nodes included
+  TS_NODES_DONE,
+  TS_NUM_WORD = 16
+};
+
+// words of an entry of the node table
+enum {
+  TN_STATE = 0,    // 1 once finished, written last
+  TN_ITER,
+  TN_EVALS,
+  TN_F,            // bits of a double
+  TN_GNORM,        // bits of a double
+  TN_SECONDS,      // bits of a double
+  TN_NUM_WORD
+};
+
+struct TelSlot { std::atomic<uint64_t> w[TS_NUM_WORD]; };
+struct TelNode { std::atomic<uint64_t> w[TN_NUM_WORD]; };
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+  "64-bit atomics in shared memory need to be lock-free");
+static_assert(sizeof(TelSlot) == 8*TS_NUM_WORD && sizeof(TelNode) == 8*TN_NUM_WORD,
+  "atomics should have no padding");
+
+static const char TEL_MAGIC[8] = {'C', 'C', 'P', 'L', 'M', 'T', 'E', 'L'};
+static const size_t TEL_HEADER = 64;
+static const uint32_t TEL_NUM_SLOT = 1024;
+
+struct TelMap {
+  void *base;      // the mapping, header included
+  size_t size;
+  uint32_t numSlot;
+  uint64_t numNode;
+  TelSlot *slots;
+  TelNode *nodes;
+};
+
+
+inline double tel_now()
+{
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t tel_bits(double x)
+{
+  uint64_t u;
+  std::memcpy(&u, &x, 8);
+  return u;
+}
+
+inline double tel_double(uint64_t u)
+{
+  double x;
+  std::memcpy(&x, &u, 8);
+  return x;
+}
+
+
+#ifndef _WIN32
+
+
+inline std::string tel_new_name()
+{
+  static unsigned counter = 0;
+  const unsigned long t = (unsigned long) std::chrono::steady_clock::now()
+    .time_since_epoch().count();
+  char buf[40];
+  std::snprintf(buf, sizeof(buf), "/ccplm-tel-%ld-%x", (long) getpid(),
+    (unsigned) ((t ^ (t >> 32)) + counter++) & 0xffffffffu);
+  return std::string(buf);
+}
+
+
+inline size_t tel_size(uint32_t numSlot, uint64_t numNode)
+{
+  return TEL_HEADER + numSlot*sizeof(TelSlot) + size_t(numNode)*sizeof(TelNode);
+}
+
+
+// new segment `name` with all slots free and no node finished
+inline int tel_create(const std::string &name, uint64_t numNode)
+{
+  const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    return TEL_ERR_OPEN;
+  }
+  const size_t size = tel_size(TEL_NUM_SLOT, numNode);
+#ifdef __linux__
+  const bool isReserved = posix_fallocate(fd, 0, off_t(size)) == 0;
+#else
+  const bool isReserved = ftruncate(fd, off_t(size)) == 0;
+#endif
+  if (!isReserved) {
+    close(fd);
+    shm_unlink(name.c_str());
+    return TEL_ERR_SPACE;
+  }
+
+  // the pages are zero-filled: free slots and unfinished nodes
+  char header[TEL_HEADER];
+  std::memset(header, 0, TEL_HEADER);
+  std::memcpy(header, TEL_MAGIC, 8);
+  const uint32_t version = 1;
+  std::memcpy(header + 8, &version, 4);
+  std::memcpy(header + 12, &TEL_NUM_SLOT, 4);
+  std::memcpy(header + 16, &numNode, 8);
+  const bool isWritten = pwrite(fd, header, TEL_HEADER, 0) == ssize_t(TEL_HEADER);
+  close(fd);
+  if (!isWritten) {
+    shm_unlink(name.c_str());
+    return TEL_ERR_MAP;
+  }
+  return TEL_OK;
+}
+
+
+// map segment `name` read-write
+inline int tel_attach(const std::string &name, TelMap *m)
+{
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return TEL_ERR_OPEN;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < TEL_HEADER) {
+    close(fd);
+    return TEL_ERR_FORMAT;
+  }
+  const size_t size = size_t(st.st_size);
+  void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return TEL_ERR_MAP;
+  }
+
+  char *p = (char *) base;
+  uint32_t numSlot;
+  uint64_t numNode;
+  std::memcpy(&numSlot, p + 12, 4);
+  std::memcpy(&numNode, p + 16, 8);
+  if (std::memcmp(p, TEL_MAGIC, 8) != 0
+    || numNode > (size - TEL_HEADER) / sizeof(TelNode)
+    || tel_size(numSlot, numNode) != size)
+  {
+    munmap(base, size);
+    return TEL_ERR_FORMAT;
+  }
+  m->base = base;
+  m->size = size;
+  m->numSlot = numSlot;
+  m->numNode = numNode;
+  m->slots = (TelSlot *) (p + TEL_HEADER);
+  m->nodes = (TelNode *) (p + TEL_HEADER + numSlot*sizeof(TelSlot));
+  return TEL_OK;
+}
+
+
+inline void tel_detach(TelMap *m)
+{
+  if (m->base != NULL) {
+    munmap(m->base, m->size);
+    m->base = NULL;
+  }
+}
+
+
+inline int tel_unlink(const std::string &name)
+{
+  return shm_unlink(name.c_str()) == 0 ? TEL_OK : TEL_ERR_OPEN;
+}
+
+
+inline bool tel_exists(const std::string &name)
+{
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+  close(fd);
+  return true;
+}
+
+
+inline bool tel_is_alive(uint64_t pid)
+{
+  return kill(pid_t(pid), 0) == 0 || errno != ESRCH;
+}
+
+
+inline uint64_t tel_pid() { return uint64_t(getpid()); }
+
+
+// local time of `t`, thread-safe (`std::localtime` shares its result)
+inline void tel_localtime(std::time_t t, std::tm *out) { localtime_r(&t, out); }
+
+
+#else
+
+inline std::string tel_new_name() { return std::string(); }
+inline int tel_create(const std::string &, uint64_t) {
+  return TEL_ERR_UNSUPPORTED;
+}
+inline int tel_attach(const std::string &, TelMap *) {
+  return TEL_ERR_UNSUPPORTED;
+}
+inline void tel_detach(TelMap *) {}
+inline int tel_unlink(const std::string &) { return TEL_ERR_UNSUPPORTED; }
+inline bool tel_exists(const std::string &) { return false; }
+inline bool tel_is_alive(uint64_t) { return true; }
+inline uint64_t tel_pid() { return 0; }
+inline void tel_localtime(std::time_t t, std::tm *out) { localtime_s(out, &t); }
+
+#endif
+
+
+/**
+ * The slot of this process in one segment. `begin`, `iter` and `end` are
+ * called by the thread running `minFunc`; all of them only store to memory.
+ */
+class TelemetryWriter {
+public:
+  TelemetryWriter() : slot_(NULL), node_(0), iter_(0), evals_(0),
+    evalsBase_(0), nodesDone_(0), f_(0.0), gnorm_(0.0), tNode_(0.0)
+  {
+    map_.base = NULL;
+  }
+
+  ~TelemetryWriter() {
+    if (slot_ != NULL && node_ > 0) {
+      publish(0, 0, 0, 0.0, 0.0, 0.0);  // leave no node in flight behind
+    }
+    tel_detach(&map_);
+  }
+
+  TelemetryWriter(const TelemetryWriter&) = delete;
+  TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+  // attach and take the slot of this process, or a free one, or the one of a
+  // process which is gone (whose counts are carried on)
+  int open(const std::string &name) {
+    int st = tel_attach(name, &map_);
+    if (st != TEL_OK) {
+      return st;
+    }
+    const uint64_t pid = tel_pid();
+    for (int pass = 0; pass < 3 && slot_ == NULL; pass++) {
+      for (uint32_t k = 0; k < map_.numSlot && slot_ == NULL; k++) {
+        std::atomic<uint64_t> &owner = map_.slots[k].w[TS_PID];
+        uint64_t expected = owner.load(std::memory_order_relaxed);
+        const bool isCandidate = pass == 0 ? expected == pid
+          : pass == 1 ? expected == 0 : !tel_is_alive(expected);
+        if (isCandidate && (expected == pid
+          || owner.compare_exchange_strong(expected, pid)))
+        {
+          slot_ = &map_.slots[k];
+        }
+      }
+    }
+    if (slot_ == NULL) {
+      tel_detach(&map_);
+      return TEL_ERR_FULL;
+    }
+    evalsBase_ = slot_->w[TS_EVALS_TOTAL].load(std::memory_order_relaxed);
+    nodesDone_ = slot_->w[TS_NODES_DONE].load(std::memory_order_relaxed);
+    return TEL_OK;
+  }
+
+  uint64_t numNode() const { return map_.numNode; }
+
+  void begin(uint64_t r) {
+    if (node_ > 0) {
+      evalsBase_ += evals_;  // the previous node did not end
+    }
+    node_ = r;
+    iter_ = 0;
+    evals_ = 0;
+    f_ = 0.0;
+    gnorm_ = 0.0;
+    tNode_ = tel_now();
+    publish(node_, 0, 0, 0.0, 0.0, tNode_);
+  }
+
+  void iter(uint64_t i, uint64_t funEvals, double f, double gnorm) {
+    if (node_ == 0) {
+      return;
+    }
+    iter_ = i;
+    evals_ = funEvals;
+    f_ = f;
+    gnorm_ = gnorm;
+    publish(node_, iter_, evals_, f, gnorm_, tel_now());
+  }
+
+  void end() {
+    if (node_ == 0) {
+      return;
+    }
+    const double t = tel_now();
+    if (node_ <= map_.numNode) {
+      std::atomic<uint64_t> *w = map_.nodes[node_ - 1].w;
+      w[TN_ITER].store(iter_, std::memory_order_relaxed);
+      w[TN_EVALS].store(evals_, std::memory_order_relaxed);
+      w[TN_F].store(tel_bits(f_), std::memory_order_relaxed);
+      w[TN_GNORM].store(tel_bits(gnorm_), std::memory_order_relaxed);
+      w[TN_SECONDS].store(tel_bits(t - tNode_), std::memory_order_relaxed);
+      w[TN_STATE].store(1, std::memory_order_release);
+    }
+    evalsBase_ += evals_;
+    nodesDone_++;
+    node_ = 0;
+    publish(0, 0, 0, 0.0, 0.0, t);
+  }
+
+private:
+  void publish(uint64_t node, uint64_t i, uint64_t funEvals, double f,
+    double gnorm, double t)
+  {
+    std::atomic<uint64_t> *w = slot_->w;
+    const uint64_t seq = w[TS_SEQ].load(std::memory_order_relaxed);
+    w[TS_SEQ].store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    w[TS_NODE].store(node, std::memory_order_relaxed);
+    w[TS_ITER].store(i, std::memory_order_relaxed);
+    w[TS_EVALS].store(funEvals, std::memory_order_relaxed);
+    w[TS_F].store(tel_bits(f), std::memory_order_relaxed);
+    w[TS_GNORM].store(tel_bits(gnorm), std::memory_order_relaxed);
+    w[TS_T_NODE].store(tel_bits(tNode_), std::memory_order_relaxed);
+    w[TS_T_UPDATE].store(tel_bits(t), std::memory_order_relaxed);
+    w[TS_EVALS_TOTAL].store(evalsBase_ + funEvals, std::memory_order_relaxed);
+    w[TS_NODES_DONE].store(nodesDone_, std::memory_order_relaxed);
+    w[TS_SEQ].store(seq + 2, std::memory_order_release);
+  }
+
+  TelMap map_;
+  TelSlot *slot_;
+  uint64_t node_;
+  uint64_t iter_;
+  uint64_t evals_;
+  uint64_t evalsBase_;
+  uint64_t nodesDone_;
+  double f_;
+  double gnorm_;
+  double tNode_;
+};
+
+
+/**
+ * Aggregates a segment every `period` seconds in a thread of its own and
+ * rewrites `statusFile`; `report` gives the latest text.
+ */
+class TelemetryMonitor {
+public:
+  TelemetryMonitor(const std::string &name, const std::string &statusFile,
+    double period, double stall)
+    : name_(name), statusFile_(statusFile), period_(period), stall_(stall),
+      t0_(tel_now()), tLast_(0.0), evalsLast_(0), status_(TEL_OK), stop_(false)
+  {
+    map_.base = NULL;
+  }
+
+  ~TelemetryMonitor() { stop(); }
+
+  TelemetryMonitor(const TelemetryMonitor&) = delete;
+  TelemetryMonitor& operator=(const TelemetryMonitor&) = delete;
+
+  int start() {
+    const int st = tel_attach(name_, &map_);
+    if (st != TEL_OK) {
+      return st;
+    }
+    update();
+    if (status_ != TEL_OK) {
+      tel_detach(&map_);
+      return status_;
+    }
+    thread_ = std::thread(&TelemetryMonitor::loop, this);
+    return TEL_OK;
+  }
+
+  // the final state is written once more
+  void stop() {
+    if (!thread_.joinable()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    update();
+    tel_detach(&map_);
+  }
+
+  std::string report() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return text_;
+  }
+
+  // status of the last write of `statusFile`
+  int status() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return status_;
+  }
+
+private:
+  struct InFlight {
+    uint64_t node, pid, iter, evals;
+    double f, gnorm, seconds, idle;
+    const char *flag;
+  };
+
+  void loop() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!stop_) {
+      cv_.wait_for(lock, std::chrono::duration<double>(period_));
+      if (stop_) {
+        break;
+      }
+      lock.unlock();
+      update();
+      lock.lock();
+    }
+  }
+
+  // consistent copy of slot k; false if the owner kept writing
+  bool read_slot(uint32_t k, uint64_t *w) const {
+    const std::atomic<uint64_t> *s = map_.slots[k].w;
+    for (int attempt = 0; attempt < 1000; attempt++) {
+      const uint64_t seq = s[TS_SEQ].load(std::memory_order_acquire);
+      if (seq & 1) {
+        std::this_thread::yield();
+        continue;
+      }
+      for (int j = 0; j < TS_NUM_WORD; j++) {
+        w[j] = s[j].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (s[TS_SEQ].load(std::memory_order_relaxed) == seq) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static double median(std::vector<double> &x) {
+    if (x.empty()) {
+      return 0.0;
+    }
+    const size_t k = x.size()/2;
+    std::nth_element(x.begin(), x.begin() + k, x.end());
+    return x[k];
+  }
+
+  static std::string format_seconds(double s) {
+    char buf[32];
+    if (!std::isfinite(s)) {
+      return "unknown";
+    }
+    if (s < 120) {
+      std::snprintf(buf, sizeof(buf), "%.0f s", s);
+    }
+    else if (s < 7200) {
+      std::snprintf(buf, sizeof(buf), "%.1f min", s/60);
+    }
+    else {
+      std::snprintf(buf, sizeof(buf), "%.1f h", s/3600);
+    }
+    return std::string(buf);
+  }
+
+  void update() {
+    const double t = tel_now();
+    char buf[256];
+
+    // finished nodes
+    uint64_t numDone = 0;
+    double gnormMax = 0.0;
+    std::vector<double> iters, seconds;
+    std::vector<uint64_t> divergent;
+    for (uint64_t r = 0; r < map_.numNode; r++) {
+      const std::atomic<uint64_t> *w = map_.nodes[r].w;
+      if (w[TN_STATE].load(std::memory_order_acquire) != 1) {
+        continue;
+      }
+      numDone++;
+      const double f = tel_double(w[TN_F].load(std::memory_order_relaxed));
+      const double gnorm = tel_double(w[TN_GNORM].load(std::memory_order_relaxed));
+      if (!std::isfinite(f) || !std::isfinite(gnorm)) {
+        divergent.push_back(r + 1);
+        continue;
+      }
+      gnormMax = std::max(gnormMax, gnorm);
+      iters.push_back(double(w[TN_ITER].load(std::memory_order_relaxed)));
+      seconds.push_back(tel_double(w[TN_SECONDS].load(std::memory_order_relaxed)));
+    }
+    const double iterMax = iters.empty() ? 0.0
+      : *std::max_element(iters.begin(), iters.end());
+    const double iterMedian = median(iters);
+    const double secondsMedian = median(seconds);
+
+    // nodes in flight
+    uint64_t evals = 0;
+    std::vector<InFlight> busy;
+    int numStuck = 0, numLost = 0, numSlow = 0;
+    size_t numDivergent = divergent.size();
+    uint64_t w[TS_NUM_WORD];
+    for (uint32_t k = 0; k < map_.numSlot; k++) {
+      if (map_.slots[k].w[TS_PID].load(std::memory_order_relaxed) == 0) {
+        continue;
+      }
+      if (!read_slot(k, w)) {
+        continue;
+      }
+      evals += w[TS_EVALS_TOTAL];
+      if (w[TS_NODE] == 0) {
+        continue;
+      }
+      InFlight b;
+      b.node = w[TS_NODE];
+      b.pid = w[TS_PID];
+      b.iter = w[TS_ITER];
+      b.evals = w[TS_EVALS];
+      b.f = tel_double(w[TS_F]);
+      b.gnorm = tel_double(w[TS_GNORM]);
+      b.seconds = t - tel_double(w[TS_T_NODE]);
+      b.idle = t - tel_double(w[TS_T_UPDATE]);
+      b.flag = "";
+      if (!std::isfinite(b.f) || !std::isfinite(b.gnorm)) {
+        b.flag = "divergent";
+        numDivergent++;
+      }
+      else if (!tel_is_alive(b.pid)) {
+        b.flag = "lost";
+        numLost++;
+      }
+      else if (b.idle > stall_) {
+        b.flag = "stuck";
+        numStuck++;
+      }
+      else if (iters.size() >= 10 && b.seconds > 60.0
+        && b.seconds > 5*secondsMedian)
+      {
+        b.flag = "slow";
+        numSlow++;
+      }
+      busy.push_back(b);
+    }
+    std::sort(busy.begin(), busy.end(), [](const InFlight &a, const InFlight &b) {
+      return a.seconds > b.seconds; });
+
+    // rates: evaluations over the last period, nodes over the last 10 minutes
+    const double evalRate = tLast_ > 0.0 && t > tLast_
+      ? double(evals - std::min(evals, evalsLast_))/(t - tLast_) : 0.0;
+    tLast_ = t;
+    evalsLast_ = evals;
+    history_.push_back(std::make_pair(t, numDone));
+    while (history_.size() > 2 && t - history_[1].first >= 600.0) {
+      history_.pop_front();
+    }
+    const double dt = t - history_.front().first;
+    const double nodeRate = dt > 0.0
+      ? double(numDone - std::min(numDone, history_.front().second))/dt : 0.0;
+    const uint64_t numLeft = map_.numNode - std::min(map_.numNode, numDone);
+    const double eta = numLeft == 0 ? 0.0
+      : nodeRate > 0.0 ? double(numLeft)/nodeRate : INFINITY;
+
+    // text
+    std::string s;
+    std::tm now;
+    tel_localtime(std::time(NULL), &now);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &now);
+    std::snprintf(buf, sizeof(buf),
+      "# PLM telemetry, rewritten every %g s\n"
+      "updated      %s\n"
+      "elapsed      %s\n", period_, stamp, format_seconds(t - t0_).c_str());
+    s += buf;
+    std::snprintf(buf, sizeof(buf),
+      "nodes        %llu / %llu done, %llu in flight\n",
+      (unsigned long long) numDone, (unsigned long long) map_.numNode,
+      (unsigned long long) busy.size());
+    s += buf;
+    std::snprintf(buf, sizeof(buf),
+      "evaluations  %.1f /s, %llu in total\n", evalRate,
+      (unsigned long long) evals);
+    s += buf;
+    std::snprintf(buf, sizeof(buf),
+      "ETA          %s (%.3g nodes/s over the last %s)\n",
+      format_seconds(eta).c_str(), nodeRate, format_seconds(dt).c_str());
+    s += buf;
+    std::snprintf(buf, sizeof(buf),
+      "finished     iterations median %.0f, max %.0f; max |g| up to %.3g; "
+      "median %s per node\n", iterMedian, iterMax, gnormMax,
+      format_seconds(secondsMedian).c_str());
+    s += buf;
+    std::snprintf(buf, sizeof(buf),
+      "alerts       %d stuck, %llu divergent, %d lost, %d slow\n",
+      numStuck, (unsigned long long) numDivergent, numLost, numSlow);
+    s += buf;
+    if (!divergent.empty()) {
+      s += "divergent    finished nodes";
+      for (size_t k = 0; k < divergent.size() && k < 20; k++) {
+        std::snprintf(buf, sizeof(buf), " %llu", (unsigned long long) divergent[k]);
+        s += buf;
+      }
+      s += divergent.size() > 20 ? " ...\n" : "\n";
+    }
+
+    s += "\n# in flight, longest first\n";
+    std::snprintf(buf, sizeof(buf), "%9s %9s %7s %7s %13s %10s %10s %8s  %s\n",
+      "node", "pid", "iter", "evals", "f", "max|g|", "seconds", "idle", "flag");
+    s += buf;
+    for (const InFlight &b : busy) {
+      std::snprintf(buf, sizeof(buf),
+        "%9llu %9llu %7llu %7llu %13.6g %10.3g %10.1f %8.1f  %s\n",
+        (unsigned long long) b.node, (unsigned long long) b.pid,
+        (unsigned long long) b.iter, (unsigned long long) b.evals,
+        b.f, b.gnorm, b.seconds, b.idle, b.flag);
+      s += buf;
+    }
+
+    const int st = write_file(s);
+    std::lock_guard<std::mutex> lock(mtx_);
+    text_.swap(s);
+    status_ = st;
+  }
+
+  // write a temporary file next to `statusFile` and rename it
+  int write_file(const std::string &s) const {
+    if (statusFile_.empty()) {
+      return TEL_OK;
+    }
+    const std::string tmp = statusFile_ + ".tmp";
+    FILE *fp = std::fopen(tmp.c_str(), "w");
+    if (fp == NULL) {
+      return TEL_ERR_FILE;
+    }
+    const bool isWritten = std::fwrite(s.data(), 1, s.size(), fp) == s.size();
+    if (std::fclose(fp) != 0 || !isWritten
+      || std::rename(tmp.c_str(), statusFile_.c_str()) != 0)
+    {
+      std::remove(tmp.c_str());
+      return TEL_ERR_FILE;
+    }
+    return TEL_OK;
+  }
+
+  const std::string name_;
+  const std::string statusFile_;
+  const double period_;
+  const double stall_;
+  const double t0_;
+  TelMap map_;
+
+  // used by `update` only
+  double tLast_;
+  uint64_t evalsLast_;
+  std::deque<std::pair<double, uint64_t>> history_;
+
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  std::string text_;
+  int status_;
+  bool stop_;
+  std::thread thread_;
+};
+
+
+inline const char *tel_strerror(int status)
+{
+  switch (status) {
+    case TEL_OK :              return "no error";
+    case TEL_ERR_OPEN :        return "no such telemetry segment";
+    case TEL_ERR_SPACE :       return "shared memory exhausted";
+    case TEL_ERR_MAP :         return "mapping failed";
+    case TEL_ERR_FORMAT :      return "not a telemetry segment";
+    case TEL_ERR_FULL :        return "no free slot";
+    case TEL_ERR_FILE :        return "status file could not be written";
+    case TEL_ERR_UNSUPPORTED : return "not supported on this platform";
+    default :                  return "unknown error";
+  }
+}
+
+#endif // TELEMETRY_HPP
@@ -0,0 +1,256 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * handle = telemetry_mex('start', statusFile, numNode[, period[, stall]])
+ *          telemetry_mex('begin', handle, r)
+ * stop   = telemetry_mex('iter', handle, i, funEvals, f, optCond)
+ *          telemetry_mex('end', handle)
+ * text   = telemetry_mex('status', handle)
+ *          telemetry_mex('stop', handle)
+ *
+ *  statusFile  char     rewritten every `period` seconds ('' for none)
+ *  numNode     double   number of nodes (N)
+ *  period      double   seconds between updates (default 10)
+ *  stall       double   seconds without an iteration after which a node is
+ *                       flagged as stuck (default 600)
+ *  handle      char     name of the shared segment (see `telemetry.hpp`)
+ *  r           double   node (1-based)
+ *  i, funEvals, f, optCond
+ *                       as passed to `options.outputFcn` by `minFunc`
+ *  stop        logical  always false
+ *  text        char     the latest status
+ *
+ * `start` (on the client) creates the segment and a monitor thread which
+ * aggregates it and writes `statusFile`; `stop` writes it a last time and
+ * removes the segment. The MEX file stays locked while a monitor runs, and
+ * `clear mex` or the exit of MATLAB stops it.
+ *
+ * `begin`, `iter` and `end` (on the workers) report node r, see
+ * `telemetry_options`. They never raise an error, so that telemetry cannot
+ * stop a minimization: a process which finds no free slot reports nothing,
+ * with one warning.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v1.1  check `nlhs`
+ * - 2018-05-10  v1
+ */
+
+#include <map>
+#include <memory>
+#include <string>
+#include "mex.h"
+#include "telemetry.hpp"
+
+using namespace std;
+
+
+typedef map<string, unique_ptr<TelemetryMonitor>> MonitorMap;
+typedef map<string, unique_ptr<TelemetryWriter>> WriterMap;
+
+static MonitorMap g_monitor;        // by handle, on the client
+static WriterMap  g_writer;         // by handle, on the workers
+static TelemetryWriter *g_last = NULL;
+static string     g_lastName;
+static bool       g_isLocked = false;
+
+
+static void stop_all()
+{
+  for (auto &kv : g_monitor) {
+    tel_unlink(kv.first);
+  }
+  g_monitor.clear();                // destructors stop the threads
+  g_writer.clear();
+  g_last = NULL;
+  g_lastName.clear();
+  if (g_isLocked) {
+    mexUnlock();
+    g_isLocked = false;
+  }
+}
+
+
+static string get_string(const mxArray *pm, const char *name)
+{
+  if (!mxIsChar(pm)) {
+    mexErrMsgIdAndTxt("telemetry_mex:prhs:WrongType",
+      "`%s` should be provided as a string.", name);
+  }
+  char *pc = mxArrayToString(pm);
+  const string s(pc);
+  mxFree(pc);
+  return s;
+}
+
+
+static double get_scalar(const mxArray *pm, double value)
+{
+  return mxIsNumeric(pm) && !mxIsComplex(pm)
+    && mxGetNumberOfElements(pm) == 1 ? mxGetScalar(pm) : value;
+}
+
+
+// writer of this process for `handle`, opened on first use; NULL if none
+static TelemetryWriter *get_writer(const mxArray *pm_handle)
+{
+  char name[64];
+  if (!mxIsChar(pm_handle) || mxGetString(pm_handle, name, sizeof(name)) != 0) {
+    return NULL;
+  }
+  if (g_last != NULL && g_lastName == name) {
+    return g_last;
+  }
+
+  WriterMap::iterator it = g_writer.find(name);
+  if (it == g_writer.end()) {
+    // drop writers of segments removed meanwhile
+    for (WriterMap::iterator jt = g_writer.begin(); jt != g_writer.end(); ) {
+      if (!tel_exists(jt->first)) {
+        jt = g_writer.erase(jt);
+      }
+      else {
+        ++jt;
+      }
+    }
+    unique_ptr<TelemetryWriter> writer(new TelemetryWriter());
+    const int st = writer->open(name);
+    if (st != TEL_OK) {
+      mexWarnMsgIdAndTxt("telemetry_mex:open",
+        "No telemetry from this process (%s).", tel_strerror(st));
+      writer.reset();               // remembered, so that it warns once
+    }
+    it = g_writer.emplace(name, std::move(writer)).first;
+  }
+  g_last = it->second.get();
+  g_lastName = g_last != NULL ? name : "";
+  return g_last;
+}
+
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nrhs < 2) {
+    mexErrMsgIdAndTxt("telemetry_mex:nrhs",
+      "Syntax: telemetry_mex(command, ...)");
+  }
+  const string cmd = get_string(prhs[0], "command");
+
+  // workers: no errors, nothing allocated but the output
+  if (cmd == "iter") {
+    if (nrhs == 6) {
+      TelemetryWriter *writer = get_writer(prhs[1]);
+      if (writer != NULL) {
+        writer->iter(uint64_t(get_scalar(prhs[2], 0)),
+          uint64_t(get_scalar(prhs[3], 0)), get_scalar(prhs[4], NAN),
+          get_scalar(prhs[5], NAN));
+      }
+    }
+    plhs[0] = mxCreateLogicalScalar(false);
+    return;
+  }
+  if (cmd == "begin") {
+    TelemetryWriter *writer = get_writer(prhs[1]);
+    const double r = nrhs == 3 ? get_scalar(prhs[2], 0) : 0;
+    if (writer != NULL && r >= 1 && r <= double(writer->numNode())) {
+      writer->begin(uint64_t(r));
+    }
+    return;
+  }
+  if (cmd == "end") {
+    TelemetryWriter *writer = get_writer(prhs[1]);
+    if (writer != NULL) {
+      writer->end();
+    }
+    return;
+  }
+
+  // client
+  if (nlhs > 1) {
+    mexErrMsgIdAndTxt("telemetry_mex:nlhs",
+      "This function produces at most 1 output.");
+  }
+  if (cmd == "start") {
+    if (nrhs < 3 || nrhs > 5) {
+      mexErrMsgIdAndTxt("telemetry_mex:nrhs",
+        "Syntax: telemetry_mex('start', statusFile, numNode[, period[, stall]])");
+    }
+    const string statusFile = get_string(prhs[1], "statusFile");
+    const double numNode = get_scalar(prhs[2], 0);
+    const double period  = nrhs > 3 ? get_scalar(prhs[3], 0) : 10.0;
+    const double stall   = nrhs > 4 ? get_scalar(prhs[4], 0) : 600.0;
+    if (numNode < 1 || numNode != double(uint64_t(numNode))
+      || !(period > 0.0) || !(stall > 0.0))
+    {
+      mexErrMsgIdAndTxt("telemetry_mex:prhs:WrongType",
+        "`numNode` should be a positive integer, `period` and `stall` positive.");
+    }
+
+    const string name = tel_new_name();
+    int st = tel_create(name, uint64_t(numNode));
+    unique_ptr<TelemetryMonitor> monitor;
+    if (st == TEL_OK) {
+      monitor.reset(new TelemetryMonitor(name, statusFile, period, stall));
+      st = monitor->start();
+      if (st != TEL_OK) {
+        tel_unlink(name);
+      }
+    }
+    if (st != TEL_OK) {
+      mexErrMsgIdAndTxt("telemetry_mex:start",
+        "Could not start telemetry (%s).", tel_strerror(st));
+    }
+    g_monitor.emplace(name, std::move(monitor));
+    if (!g_isLocked) {
+      mexLock();
+      mexAtExit(stop_all);
+      g_isLocked = true;
+    }
+    plhs[0] = mxCreateString(name.c_str());
+    return;
+  }
+
+  const string name = get_string(prhs[1], "handle");
+  MonitorMap::iterator it = g_monitor.find(name);
+  if (it == g_monitor.end()) {
+    mexErrMsgIdAndTxt("telemetry_mex:handle",
+      "No telemetry `%s` was started by this process.", name.c_str());
+  }
+
+  if (cmd == "status") {
+    plhs[0] = mxCreateString(it->second->report().c_str());
+    return;
+  }
+
+  if (cmd == "stop") {
+    it->second->stop();
+    const int st = it->second->status();
+    g_monitor.erase(it);
+    tel_unlink(name);
+    g_writer.erase(name);           // this process may have been a worker
+    g_last = NULL;
+    g_lastName.clear();
+    if (g_monitor.empty() && g_isLocked) {
+      mexUnlock();
+      g_isLocked = false;
+    }
+    if (st != TEL_OK) {
+      mexWarnMsgIdAndTxt("telemetry_mex:write",
+        "The status file was not written (%s).", tel_strerror(st));
+    }
+    return;
+  }
+
+  mexErrMsgIdAndTxt("telemetry_mex:command",
+    "Unknown command `%s`.", cmd.c_str());
+}
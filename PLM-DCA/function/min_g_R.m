@@ -0,0 +1,56 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Minimization of g_r for a tile of nodes at once. The objective passed to
+% `minFunc` is the sum of g_r over the nodes in `rlist`, evaluated by
+% `g_R_mex` in one sweep over `S`. Since different nodes share no parameter,
+% the minimizer is the same as that of every node minimized separately; the
+% stopping criterion `optTol` applies to the largest gradient component over
+% all nodes of the tile.
+%
+% Note that L-BFGS stores `Corr` copies of R*(q+q*q*(N-1)) numbers.
+%
+% INPUT
+% ===
+% |     name      | description                                          |
+% | ------------- | ---------------------------------------------------- |
+% | S (uint8)     | [0,q-1], columns as sequences/samples/configurations |
+% | N (uint64)    | length of sequences (number of nodes/spins)          |
+% | B (uint64)    | number of sequences/samples/configurations           |
+% | q (uint64)    | number of possible states                            |
+% | weights       | sequences can be weigted                             |
+% | B_eff         | B_eff = sum(weights)                                 |
+% | rlist (uint64)| node indices of the tile (1-based)                   |
+% | lambdas       | [lambda_h lambda_J]                                  |
+% | skip          | non-zero to skip built-in check of `g_R_mex`         |
+% | options       | passed to `minFunc`                                  |
+%
+% OUTPUT
+% ===
+% R_h_and_J(:,t) = [h_r(:); J_r(:)] of node r = rlist(t).
+%
+% HISTORY
+% ===
+% - 2018-03-28  v1
+%   - adapted from `min_g_r.m`
+
+function R_h_and_J = min_g_R(S,N,B,q,weights,B_eff,rlist,lambdas,skip,options)
+
+if skip
+  funObj = @(x) g_R_mex(S,N,B,q,weights,B_eff,rlist,x,lambdas,'SkipCheckFlag');
+else
+  funObj = @(x) g_R_mex(S,N,B,q,weights,B_eff,rlist,x,lambdas);
+end
+
+P = double(q + q*q*(N-1));
+R = numel(rlist);
+x0 = zeros(P*R, 1);
+x = minFunc(funObj,x0,options);
+R_h_and_J = reshape(x, [P R]);
+
+end
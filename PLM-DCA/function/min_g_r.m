@@ -13,6 +13,7 @@
 % |    name    | description                                               |
 % | ---------- | --------------------------------------------------------- |
 % | S (uint8)  | [0,q-1], columns as sequences/samples/configurations      |
+% |            | (or its handle of `shm_msa_mex`)                          |
 % | N (uint64) | length of sequences (number of nodes/spins)               |
 % | B (uint64) | number of sequences/samples/configurations                |
 % | q (uint64) | number of possible states                                 |
@@ -22,6 +23,7 @@
 % | lambdas    | [lambda_h lambda_J]                                       |
 % | skip       | non-zero to skip built-in check of `g_r_mex_v2`           |
 % | options    | passed to `minFunc`                                       |
+% | wr0        | (optional) initial point, default zeros (warm start)      |
 %
 % OUTPUT
 % ===
@@ -29,13 +31,19 @@
 %
 % HISTORY
 % ===
+% - 2018-05-10  v3.2
+%   - `options.LS_valueOnly` on unless given
+%
+% - 2018-04-19  v3.1
+%   - optional initial point `wr0`
+%
 % - 2017-10-18  v3.0
 %   - name changed from `PLM_L2_node` to `min_g_r`
 %
 % - 2017-10-09  v2
 %   - `g_r_mex` -> `g_r_mex_v2`
 
-function r_h_and_J = min_g_r(S,N,B,q,weights,B_eff,r,lambdas,skip,options)
+function r_h_and_J = min_g_r(S,N,B,q,weights,B_eff,r,lambdas,skip,options,wr0)
 
 if skip
   funObj = @(wr) g_r_mex_v2(S,N,B,q,weights,B_eff,r,wr,lambdas,'SkipCheckFlag');
@@ -43,7 +51,13 @@ else
   funObj = @(wr) g_r_mex_v2(S,N,B,q,weights,B_eff,r,wr,lambdas);
 end
 
-wr0 = zeros(q + q*q*(N-1), 1);
+if nargin < 11
+  wr0 = zeros(q + q*q*(N-1), 1);
+end
+% trial steps of the line search by objective only (one output)
+if ~isfield(options, 'LS_valueOnly')
+  options.LS_valueOnly = 1;
+end
 r_h_and_J = minFunc(funObj,wr0,options);
 
 end
@@ -0,0 +1,84 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Minimization of g_r with active-set screening of the couplings.
+%
+% Only the blocks J_ri with `options.active(i,r)` true are optimized
+% (`g_r_act_mex`); the others are frozen at 0, so that every iteration costs
+% the active blocks only. At convergence, the gradient of the full g_r is
+% evaluated once (`g_r_mex_v2`) and every frozen block whose gradient exceeds
+% `options.optTol` (the stopping criterion of `minFunc`) is activated, and the
+% minimization is resumed from the current point. When no block is added, the
+% result satisfies the same optimality condition as `min_g_r`.
+%
+% A good active set (e.g. from the MI table of CC, see `active_set_MI`) needs
+% no or few restarts; a poor one only costs restarts.
+%
+% INPUT
+% ===
+% Same as `min_g_r`; `options.active` is an N-by-N logical matrix, or only its
+% column r (as `PLM_L2_Asym` passes it).
+%
+% OUTPUT
+% ===
+% r_h_and_J = [h_r(:); J_r(:)] in the layout of `g_r_mex_v2`.
+% act       = sites of the blocks finally active (1-based)
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1.1
+%   - `options.active` may be the column of node r only
+%
+% - 2018-04-25  v1
+
+function [r_h_and_J, act] = min_g_r_act(S,N,B,q,weights,B_eff,r,lambdas,skip,options)
+
+N0 = double(N);
+q0 = double(q);
+r0 = double(r);
+
+if isfield(options, 'optTol')
+  optTol = options.optTol;
+else
+  optTol = 1e-5;  % default of `minFunc`
+end
+
+% sites in the order of the blocks J_ri of `g_r`
+site = [1:r0-1, r0+1:N0];
+active_r = options.active;
+if size(active_r, 2) > 1
+  active_r = active_r(:, r0);
+end
+isActive = reshape(active_r(site), 1, N0-1);
+
+r_h_and_J = zeros(q0 + q0*q0*(N0-1), 1);
+idx_J = reshape(q0+1 : q0+q0*q0*(N0-1), [q0*q0 N0-1]);
+
+while true
+  act = uint64(site(isActive));
+  idx = [1:q0, reshape(idx_J(:, isActive), 1, [])];
+
+  if skip
+    funObj = @(x) g_r_act_mex(S,N,B,q,weights,B_eff,r,act,x,lambdas,'SkipCheckFlag');
+  else
+    funObj = @(x) g_r_act_mex(S,N,B,q,weights,B_eff,r,act,x,lambdas);
+  end
+  r_h_and_J(idx) = minFunc(funObj,r_h_and_J(idx),options);
+
+  % KKT check of the frozen blocks
+  [~, grad] = g_r_mex_v2(S,N,B,q,weights,B_eff,r,r_h_and_J,lambdas,'SkipCheckFlag');
+  isViolated = max(abs(grad(idx_J)), [], 1) > optTol & ~isActive;
+  if ~any(isViolated)
+    break
+  end
+  isActive = isActive | isViolated;
+end
+
+act = double(act);
+
+end
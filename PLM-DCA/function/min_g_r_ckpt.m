@@ -0,0 +1,101 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `min_g_r_file` with checkpoints written in the background (`ckpt_mex`)
+% instead of one MAT-file per node: the result is handed to the writer thread
+% of this process and the next node starts at once. Results saved by this
+% process are durable only after `ckpt_mex('flush')`, which `PLM_L2_Asym_file`
+% calls on every worker at the end of each stage (`flush_ckpt`). With LoadIP,
+% a node without a checkpoint starts from its MAT-file of `min_g_r_file` if
+% one exists, so that runs of earlier versions resume.
+%
+% INPUT
+% ===
+% |    name    | description                                               |
+% | ---------- | --------------------------------------------------------- |
+% | S (uint8)  | [0,q-1], columns as sequences/samples/configurations      |
+% |            | (or its handle of `shm_msa_mex`)                          |
+% | N (uint64) | length of sequences (number of nodes/spins)               |
+% | B (uint64) | number of sequences/samples/configurations                |
+% | q (uint64) | number of possible states                                 |
+% | weights    | sequences can be weigted                                  |
+% | B_eff      | B_eff = sum(weights)                                      |
+% | r (uint64) | node index (1-based)                                      |
+% | lambdas    | [lambda_h lambda_J]                                       |
+% | skip       | non-zero to skip built-in check of `g_r_mex_v2`           |
+% | options    | passed to `minFunc`                                       |
+% | LoadIP     | true to load initial point                                |
+% | SaveFP     | true to save final point                                  |
+% | filePath   | directory of the checkpoints                              |
+% | filePrefix | prefix of the segment files (see `ckpt_mex`)              |
+%
+% OUTPUT
+% ===
+% r_h_and_J = [h_r(:); J_r(:)], where h_r and J_r are in Ising gauge.
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1.1
+%   - initial point from a MAT-file of `min_g_r_file` if not checkpointed
+%
+% - 2018-05-10  v1
+%   - adapted from `min_g_r_file.m`
+
+function r_h_and_J = min_g_r_ckpt(S,N,B,q,weights,B_eff,r,lambdas,skip,options, ...
+  LoadIP,SaveFP,filePath,filePrefixLoad,filePrefixSave)
+
+% simple check
+if ~ischar(filePath) || ~ischar(filePrefixLoad) || ~ischar(filePrefixSave)
+  error('path and filename should be provided as char vectors.')
+end
+
+if exist(filePath,'dir') ~= 7
+  error('`%s` does not exist.', filePath);
+end
+
+
+% Load the result if it exists, otherwise start from zeros
+P = q + q*q*(N-1);
+r_h_and_J = [];
+if LoadIP
+  r_h_and_J = ckpt_mex('get', filePath, filePrefixLoad, double(r), double(P));
+  filenameLoadFull = fullfile(filePath, ...
+    sprintf('%s--r-%d.mat', filePrefixLoad, r));
+  if isempty(r_h_and_J) && exist(filenameLoadFull, 'file') == 2
+    load(filenameLoadFull, 'r_h_and_J');      % saved by `min_g_r_file`
+    if numel(r_h_and_J) ~= P
+      error('Dimension of `r_h_and_J` should be [q+q*q*(N-1), 1].')
+    end
+    r_h_and_J = r_h_and_J(:);
+  end
+end
+if isempty(r_h_and_J)
+  r_h_and_J = zeros(P, 1);
+end
+
+
+% minimization of g_r
+if skip
+  funObj = @(wr) g_r_mex_v2(S,N,B,q,weights,B_eff,r,wr,lambdas,'SkipCheckFlag');
+else
+  funObj = @(wr) g_r_mex_v2(S,N,B,q,weights,B_eff,r,wr,lambdas);
+end
+% trial steps of the line search by objective only (one output)
+if ~isfield(options, 'LS_valueOnly')
+  options.LS_valueOnly = 1;
+end
+r_h_and_J = minFunc(funObj,r_h_and_J,options);
+
+
+% hand the result to the writer thread
+if SaveFP
+  ckpt_mex('put', filePath, filePrefixSave, double(r), r_h_and_J);
+end
+
+
+end
@@ -15,6 +15,7 @@
 % |    name    | description                                               |
 % | ---------- | --------------------------------------------------------- |
 % | S (uint8)  | [0,q-1], columns as sequences/samples/configurations      |
+% |            | (or its handle of `shm_msa_mex`)                          |
 % | N (uint64) | length of sequences (number of nodes/spins)               |
 % | B (uint64) | number of sequences/samples/configurations                |
 % | q (uint64) | number of possible states                                 |
@@ -35,6 +36,12 @@
 %
 % HISTORY
 % ===
+% - 2018-05-10  v1.2
+%   - `options.LS_valueOnly` on unless given
+%
+% - 2018-05-10  v1.1
+%   - `options.outputFcn` (telemetry) is not saved
+%
 % - 2017-11-16  v1
 %   - adapted from `min_g_r.m`
 
@@ -72,6 +79,10 @@ if skip
 else
   funObj = @(wr) g_r_mex_v2(S,N,B,q,weights,B_eff,r,wr,lambdas);
 end
+% trial steps of the line search by objective only (one output)
+if ~isfield(options, 'LS_valueOnly')
+  options.LS_valueOnly = 1;
+end
 r_h_and_J = minFunc(funObj,r_h_and_J,options);
 
 
@@ -82,6 +93,9 @@ if SaveFP
   if numel(r_h_and_J)*8 > 2^31
     error('Extra work needed; see the embedded comment.')
   end
+  if isfield(options, 'outputFcn')
+    options = rmfield(options, 'outputFcn');  % a handle bound to this run
+  end
   save(filenameSaveFull,'r_h_and_J','options','-v6');
   % '-v6' limits the maximum size of any variable to 2^31 bytes. For larger
   % variables, use HDF5 without compression (by `h5write` and friends).
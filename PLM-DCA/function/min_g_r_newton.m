@@ -0,0 +1,57 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% minimization of g_r by truncated Newton (Newton-CG), i.e. the method
+% 'newton0' of `minFunc` with exact Hessian-vector products (`Hv_g_r_mex`).
+%
+% g_r is smooth and, with L2 regularization, strictly convex, so that Newton
+% steps converge in far fewer outer iterations than L-BFGS. The memory is a
+% few vectors of q + q*q*(N-1) elements (no L-BFGS history of `Corr` vectors),
+% thus there is no limitation on `Corr*(q + q*q*(N-1))`.
+%
+% Every CG iteration costs one Hessian-vector product, about one evaluation of
+% g_r, and is counted in `MaxFunEvals` by `minFunc`; `MaxFunEvals` defaults to
+% Inf here, and `MaxIter` bounds the number of Newton steps.
+%
+% INPUT
+% ===
+% Same as `min_g_r` (including the optional initial point `wr0`).
+% `options.Method` is set to 'newton0'.
+%
+% OUTPUT
+% ===
+% r_h_and_J = [h_r(:); J_r(:)]
+%
+% HISTORY
+% ===
+% - 2018-04-16  v1
+%   - adapted from `min_g_r.m`
+
+function r_h_and_J = min_g_r_newton(S,N,B,q,weights,B_eff,r,lambdas,skip, ...
+  options,wr0)
+
+if skip
+  funObj = @(wr) g_r_mex_v2(S,N,B,q,weights,B_eff,r,wr,lambdas,'SkipCheckFlag');
+  options.HvFunc = @(v,wr) Hv_g_r_mex(v,wr,S,N,B,q,weights,B_eff,r,lambdas, ...
+    'SkipCheckFlag');
+else
+  funObj = @(wr) g_r_mex_v2(S,N,B,q,weights,B_eff,r,wr,lambdas);
+  options.HvFunc = @(v,wr) Hv_g_r_mex(v,wr,S,N,B,q,weights,B_eff,r,lambdas);
+end
+
+options.Method = 'newton0';
+if ~isfield(options, 'MaxFunEvals') || isempty(options.MaxFunEvals)
+  options.MaxFunEvals = Inf;
+end
+
+if nargin < 11
+  wr0 = zeros(q + q*q*(N-1), 1);
+end
+r_h_and_J = minFunc(funObj,wr0,options);
+
+end
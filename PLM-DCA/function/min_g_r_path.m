@@ -0,0 +1,50 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% minimization of g_r along a regularization path: `lambda_list` is visited
+% from the strongest to the weakest regularization, and every minimization is
+% warm-started from the solution of the previous (stronger) lambda. Nearby
+% solutions are close, so each point of the path needs only a few iterations.
+%
+% As in `PLM_DCA`, lambda_h = lambda and lambda_J = lambda/2 for every lambda.
+%
+% INPUT
+% ===
+% Same as `min_g_r`, except that `lambda_list` (L elements, any order)
+% replaces `lambdas`. With `options.Method = 'newton0'`, every point is solved
+% by `min_g_r_newton`.
+%
+% OUTPUT
+% ===
+% r_h_and_J(:,l) = [h_r(:); J_r(:)] for lambda_list(l)
+%
+% HISTORY
+% ===
+% - 2018-04-19  v1
+
+function r_h_and_J = min_g_r_path(S,N,B,q,weights,B_eff,r,lambda_list,skip, ...
+  options)
+
+if strcmp(options.Method, 'newton0')
+  min_node = @min_g_r_newton;
+else
+  min_node = @min_g_r;
+end
+
+[~, order] = sort(lambda_list, 'descend');
+
+P = double(q + q*q*(N-1));
+r_h_and_J = zeros(P, numel(lambda_list));
+wr = zeros(P, 1);
+for l = order(:).'
+  lambdas = [lambda_list(l) lambda_list(l)/2];
+  wr = min_node(S,N,B,q,weights,B_eff,r,lambdas,skip,options,wr);
+  r_h_and_J(:,l) = wr;
+end
+
+end
@@ -0,0 +1,58 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Minimization of g_r of one node for R replicates at once, e.g. bootstrap
+% replicates whose weights differ but whose MSA is the same. The objective
+% passed to `minFunc` is the sum of g_r over the replicates, evaluated by
+% `g_r_rep_mex` in one sweep over `S`. Since different replicates share no
+% parameter, the minimizer is the same as that of every replicate minimized
+% separately; the stopping criterion `optTol` applies to the largest gradient
+% component over all replicates.
+%
+% Note that L-BFGS stores `Corr` copies of R*(q+q*q*(N-1)) numbers.
+%
+% INPUT
+% ===
+% |     name      | description                                          |
+% | ------------- | ---------------------------------------------------- |
+% | S (uint8)     | [0,q-1], columns as sequences/samples/configurations |
+% | N (uint64)    | length of sequences (number of nodes/spins)          |
+% | B (uint64)    | number of sequences/samples/configurations           |
+% | q (uint64)    | number of possible states                            |
+% | W             | B-by-R, W(:,t) are the weights of replicate t        |
+% | B_eff         | 1-by-R, B_eff(t) = sum(W(:,t))                       |
+% | r (uint64)    | node index (1-based)                                 |
+% | lambdas       | [lambda_h lambda_J]                                  |
+% | skip          | non-zero to skip built-in check of `g_r_rep_mex`     |
+% | options       | passed to `minFunc`                                  |
+%
+% OUTPUT
+% ===
+% R_h_and_J(:,t) = [h_r(:); J_r(:)] of replicate t.
+%
+% HISTORY
+% ===
+% - 2018-04-23  v1
+%   - adapted from `min_g_R.m`
+
+function R_h_and_J = min_g_r_rep(S,N,B,q,W,B_eff,r,lambdas,skip,options)
+
+if skip
+  funObj = @(x) g_r_rep_mex(S,N,B,q,W,B_eff,r,x,lambdas,'SkipCheckFlag');
+else
+  funObj = @(x) g_r_rep_mex(S,N,B,q,W,B_eff,r,x,lambdas);
+end
+
+P = double(q + q*q*(N-1));
+R = size(W, 2);
+x0 = zeros(R*P, 1);
+x = minFunc(funObj,x0,options);
+% `g_r_rep_mex` interleaves the replicates: x(t + R*(p-1)) is element p of t
+R_h_and_J = reshape(x, [R P]).';
+
+end
@@ -0,0 +1,48 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Minimization of g_r on sufficient statistics of node r. Samples are
+% aggregated by neighbourhood pattern once (`g_r_stats_build_mex`), and every
+% evaluation in `minFunc` uses the statistics (`g_r_stats_mex`) instead of `S`.
+% The minimizer is the same as that of `min_g_r` up to round-off.
+%
+% It pays off when samples share neighbourhood patterns (e.g. sequences
+% differing only at r). The patterns keep one byte per site, so that without
+% sharing (e.g. after `unique(MSA,'rows')`) an evaluation costs as much as one
+% of `g_r_mex_v2`, plus building them once per node.
+%
+% INPUT
+% ===
+% Same as `min_g_r`.
+%
+% OUTPUT
+% ===
+% r_h_and_J = [h_r(:); J_r(:)]
+%
+% HISTORY
+% ===
+% - 2018-05-10  v2
+%   - uint8 patterns instead of int32 offsets
+%
+% - 2018-04-05  v1
+%   - adapted from `min_g_r.m`
+
+function r_h_and_J = min_g_r_stats(S,N,B,q,weights,B_eff,r,lambdas,skip,options)
+
+[pat, count] = g_r_stats_build_mex(S,q,weights,r);
+
+if skip
+  funObj = @(wr) g_r_stats_mex(pat,count,B_eff,wr,lambdas,'SkipCheckFlag');
+else
+  funObj = @(wr) g_r_stats_mex(pat,count,B_eff,wr,lambdas);
+end
+
+wr0 = zeros(q + q*q*(N-1), 1);
+r_h_and_J = minFunc(funObj,wr0,options);
+
+end
@@ -0,0 +1,45 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% minimization of g_r with per-site alphabet sizes (`g_r_var_mex`)
+%
+% INPUT
+% ===
+% |      name      | description                                          |
+% | -------------- | ---------------------------------------------------- |
+% | S (uint8)      | S(i,b) in [0,qlist(i)-1], columns as sequences       |
+% | qlist (uint64) | number of states of each site                        |
+% | weights        | sequences can be weigted                             |
+% | B_eff          | B_eff = sum(weights)                                 |
+% | r (uint64)     | node index (1-based)                                 |
+% | lambdas        | [lambda_h lambda_J]                                  |
+% | skip           | non-zero to skip built-in check of `g_r_var_mex`     |
+% | options        | passed to `minFunc`                                  |
+%
+% OUTPUT
+% ===
+% r_h_and_J = [h_r; J_r] in the packed layout (see `g_r_var.hpp`)
+%
+% HISTORY
+% ===
+% - 2018-04-09  v1
+%   - adapted from `min_g_r.m`
+
+function r_h_and_J = min_g_r_var(S,qlist,weights,B_eff,r,lambdas,skip,options)
+
+if skip
+  funObj = @(wr) g_r_var_mex(S,qlist,weights,B_eff,r,wr,lambdas,'SkipCheckFlag');
+else
+  funObj = @(wr) g_r_var_mex(S,qlist,weights,B_eff,r,wr,lambdas);
+end
+
+q_r = double(qlist(r));
+wr0 = zeros(q_r + q_r*(sum(double(qlist)) - q_r), 1);
+r_h_and_J = minFunc(funObj,wr0,options);
+
+end
@@ -0,0 +1,48 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Read a MSA in the native binary format (see `write_MSA_bin`).
+%
+% OUTPUT
+% ===
+% S  (uint8)  [0,q-1], N rows, columns as sequences
+% q, N, B     as stored in the header (double)
+%
+% HISTORY
+% ===
+% - 2018-03-20  v1
+
+function [S, q, N, B] = read_MSA_bin(filename)
+
+fid = fopen(filename, 'r', 'l');
+if fid < 0
+  error('Could not open `%s` for reading.', filename)
+end
+
+magic = fread(fid, [1 8], 'char*1=>char');
+if ~strcmp(magic, 'CCPLMMSA')
+  fclose(fid);
+  error('`%s` is not a MSA in the native binary format.', filename)
+end
+version = fread(fid, 1, 'uint32');
+if version ~= 1
+  fclose(fid);
+  error('Unsupported version of the binary format: %d.', version)
+end
+q = fread(fid, 1, 'uint32');
+N = fread(fid, 1, 'uint64');
+B = fread(fid, 1, 'uint64');
+
+S = fread(fid, [N B], 'uint8=>uint8');
+fclose(fid);
+
+if numel(S) ~= N*B
+  error('`%s` is truncated.', filename)
+end
+
+end
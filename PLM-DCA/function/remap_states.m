@@ -0,0 +1,47 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Per-site alphabets: the states observed on site i are relabeled to
+% [0, q_i-1], keeping their order, where q_i is the number of observed states.
+% Since the order is kept, the gap state (global state 0) is mapped to local
+% state 0 whenever it is observed on the site.
+%
+% INPUT
+% ===
+% S  (uint8)  [0,q-1], N-by-B, columns as sequences/samples
+% q           number of possible states (global alphabet)
+%
+% OUTPUT
+% ===
+% S_loc (uint8)  N-by-B, S_loc(i,b) in [0, qlist(i)-1]
+% qlist          N-by-1, number of observed states of each site
+% present        q-by-N logical, present(k+1,i) is true if global state k is
+%                observed on site i; `present(1,:)` flags sites with gap
+%
+% HISTORY
+% ===
+% - 2018-04-09  v1
+
+function [S_loc, qlist, present] = remap_states(S, q)
+
+[N,B] = size(S);
+
+present = false(q, N);
+for i = 1:N
+  present(double(unique(S(i,:))) + 1, i) = true;
+end
+qlist = sum(present, 1).';
+
+% global state -> local state, per site
+map = uint8(max(cumsum(present, 1) - 1, 0));
+S_loc = zeros(N, B, 'uint8');
+for i = 1:N
+  S_loc(i,:) = map(double(S(i,:)) + 1, i);
+end
+
+end
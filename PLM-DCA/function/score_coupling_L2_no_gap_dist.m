@@ -0,0 +1,57 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `score_coupling_L2_no_gap` on the result file of `PLM_L2_Asym_dist`, which
+% is mapped by `memmapfile`: only one column of `h_and_J` and the blocks J_ji
+% it is paired with are read at a time.
+%
+% OUTPUT
+% ===
+% `table_i_j_score` --- Every column, formatted as `[i; j; S_ij]`, contains the
+% pair $(i,j)$ and score $S_{ij}$, in the order of `score_coupling_L2_no_gap`
+%
+% HISTORY
+% ===
+% - 2018-05-07  v1
+
+function table_i_j_score = score_coupling_L2_no_gap_dist(outFile,q,N)
+
+if ~isa(q, 'double')
+  q = double(q);
+end
+if ~isa(N, 'double')
+  N = double(N);
+end
+
+P = q + q*q*(N-1);
+offset = 64 + ceil(N/8)*8;
+m = memmapfile(outFile, 'Offset', offset, 'Format', 'double', 'Repeat', P*N);
+
+%% Extract J_ij and calculate the score
+table_i_j_score = zeros(3, N*(N-1)/2);
+
+idx_no_gap = reshape(1:q*q, [q q]);
+idx_no_gap = idx_no_gap(2:q,2:q);
+idx_no_gap = idx_no_gap(:);
+
+l = 1;
+for i = 1:N-1
+  J_i = reshape( m.Data(P*(i-1)+q+1:P*i), [q q N-1] );
+  for j = i+1:N
+    J_ij = J_i(:,:,j-1);  % since j > i
+    J_ji = reshape( m.Data(P*(j-1)+q+q*q*(i-1)+1:P*(j-1)+q+q*q*i), [q q]);
+
+    J_ij_sym = (J_ij + J_ji.') / 2;   % J_ji(s_j, s_i) -> J_ji(s_i, s_j)
+    score_excluding_gap = norm(J_ij_sym(idx_no_gap));
+
+    table_i_j_score(:,l) = [i; j; score_excluding_gap];
+    l = l+1;
+  end
+end
+
+end
@@ -0,0 +1,42 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `score_coupling_L2_no_gap` for the shared couplings of `PLM_L2_Sym`: J_ij is
+% stored once, so no average of J_ij and J_ji is needed.
+%
+% INPUT
+% ===
+% J (q*q-by-N(N-1)/2): J(:,p) is J_ij(:) of the p-th pair (i<j) in the order
+% (1,2), (1,3), ..., (1,N), (2,3), ...
+%
+% OUTPUT
+% ===
+% `table_i_j_score` --- Every column, formatted as `[i; j; S_ij]`, contains the
+% pair $(i,j)$ and score $S_{ij}$, in the order of `score_coupling_L2_no_gap`
+%
+% HISTORY
+% ===
+% - 2018-05-06  v1
+
+function table_i_j_score = score_coupling_L2_no_gap_sym(J,q,N)
+
+if ~isa(q, 'double')
+  q = double(q);
+end
+if ~isa(N, 'double')
+  N = double(N);
+end
+
+J = reshape(J, [q q N*(N-1)/2]);
+score = sqrt(sum(sum(J(2:q,2:q,:).^2, 1), 2));
+
+% pairs with i outer, j inner
+[j, i] = find(tril(true(N), -1));
+table_i_j_score = [i.'; j.'; score(:).'];
+
+end
@@ -0,0 +1,55 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `score_coupling_L2_no_gap` for per-site alphabet sizes `qlist` and the
+% packed layout of `g_r_var_mex`. $J_{ij}$ is a q_i-by-q_j matrix and
+% the score is the $l_2$-norm of its symmetrized version excluding the gap
+% state, which is local state 0 (first row/column) on sites with
+% `hasGap(i) = true` (cf. `remap_states`). On sites without gap, all states
+% are scored.
+%
+% INPUT
+% ===
+% h_and_J   1-by-N cell, h_and_J{r} = [h_r; J_r] in the packed layout
+% qlist     N elements, number of states of each site
+% hasGap    N elements, logical
+%
+% OUTPUT
+% ===
+% `table_i_j_score` --- Every column, formatted as `[i; j; S_ij]`, contains the
+% pair $(i,j)$ and score $S_{ij}$
+
+function table_i_j_score = score_coupling_L2_no_gap_var(h_and_J,qlist,hasGap)
+
+qlist = double(qlist(:));
+N = numel(qlist);
+cumQ = [0; cumsum(qlist)];    % cumQ(i) = sum of q_{i'} over i' < i
+
+%% Extract J_ij and calculate the score
+table_i_j_score = zeros(3, N*(N-1)/2);
+
+l = 1;
+for i = 1:N-1
+  q_i = qlist(i);
+  for j = i+1:N
+    q_j = qlist(j);
+    s_ij = q_i + q_i*(cumQ(j) - q_i);   % since j > i
+    J_ij = reshape(h_and_J{i}(s_ij+1 : s_ij+q_i*q_j), [q_i q_j]);
+    s_ji = q_j + q_j*cumQ(i);           % since i < j
+    J_ji = reshape(h_and_J{j}(s_ji+1 : s_ji+q_j*q_i), [q_j q_i]);
+
+    J_ij_sym = (J_ij + J_ji.') / 2;   % J_ji(s_j, s_i) -> J_ji(s_i, s_j)
+    J_ij_sym = J_ij_sym(1+hasGap(i):end, 1+hasGap(j):end);
+    score_excluding_gap = norm(J_ij_sym(:));
+
+    table_i_j_score(:,l) = [i; j; score_excluding_gap];
+    l = l+1;
+  end
+end
+
+end
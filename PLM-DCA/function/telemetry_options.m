@@ -0,0 +1,41 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Reports node r to the telemetry `handle` (see `telemetry_mex`) and returns
+% `options` of `minFunc` whose `outputFcn` reports every iteration. After the
+% minimization, call `telemetry_mex('end', handle)`. The node is marked begun
+% here rather than by the 'init' call of `minFunc`, which is skipped when the
+% initial point is already optimal (e.g. a node loaded by `LoadIP`).
+%
+% With an empty `handle`, `options` is returned unchanged.
+%
+% INPUT
+% ===
+% options   passed to `minFunc`
+% handle    char, returned by `telemetry_mex('start', ...)`, or ''
+% r         node index (1-based)
+%
+% OUTPUT
+% ===
+% options   with `outputFcn` set
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1
+
+function options = telemetry_options(options, handle, r)
+
+if isempty(handle)
+  return
+end
+
+telemetry_mex('begin', handle, double(r));
+options.outputFcn = @(x,type,i,funEvals,f,t,gtd,g,d,optCond,varargin) ...
+  telemetry_mex('iter', handle, i, funEvals, f, optCond);
+
+end
@@ -0,0 +1,55 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Write `S` (uint8, [0,q-1], N rows, columns as sequences) to the native binary
+% MSA format. All numbers are little-endian.
+%
+% | offset | type       | content                                    |
+% | ------ | ---------- | ------------------------------------------ |
+% | 0      | char[8]    | magic `CCPLMMSA`                           |
+% | 8      | uint32     | version (1)                                |
+% | 12     | uint32     | q                                          |
+% | 16     | uint64     | N                                          |
+% | 24     | uint64     | B                                          |
+% | 32     | uint8[N*B] | S, sequence-by-sequence (same as `g_r`)    |
+%
+% The payload starts at a fixed offset, so that the file can be memory-mapped
+% and used as `S` directly. See `read_MSA_bin`.
+%
+% HISTORY
+% ===
+% - 2018-03-20  v1
+
+function write_MSA_bin(filename, S, q)
+
+if ~isa(S, 'uint8')
+  error('S should be provided as uint8.')
+end
+if double(max(S(:))) > q-1
+  error('q possible states should be mapped to integers in [0,q-1].')
+end
+
+fid = fopen(filename, 'w', 'l');
+if fid < 0
+  error('Could not open `%s` for writing.', filename)
+end
+
+[N,B] = size(S);
+fwrite(fid, 'CCPLMMSA', 'char*1');
+fwrite(fid, 1, 'uint32');
+fwrite(fid, q, 'uint32');
+fwrite(fid, N, 'uint64');
+fwrite(fid, B, 'uint64');
+count = fwrite(fid, S, 'uint8');
+fclose(fid);
+
+if count ~= N*B
+  error('Writing `%s` failed.', filename)
+end
+
+end
@@ -0,0 +1,38 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Write `S` (uint8, [0,q-1], columns as sequences) to a FASTA file readable by
+% `fasta2matrix_mex`. States 0,1,2,3,4 are written as NACGT, thus q <= 5.
+% Every sequence is written as one data line preceded by `>seq<b>`.
+%
+% HISTORY
+% ===
+% - 2018-03-20  v1
+
+function write_MSA_fasta(filename, S)
+
+if ~isa(S, 'uint8')
+  error('S should be provided as uint8.')
+end
+if max(S(:)) > 4
+  error('Only q <= 5 states can be written as NACGT.')
+end
+
+fid = fopen(filename, 'w');
+if fid < 0
+  error('Could not open `%s` for writing.', filename)
+end
+
+letters = 'NACGT';
+for b = 1:size(S,2)
+  fprintf(fid, '>seq%d\n%s\n', b, letters(double(S(:,b)) + 1));
+end
+
+fclose(fid);
+
+end
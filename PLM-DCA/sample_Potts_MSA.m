@@ -0,0 +1,101 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Generate a synthetic MSA from a Potts model with planted couplings by native
+% multithreaded Gibbs sampling. The output `S` has the layout consumed by
+% `PLM_L2_Asym` and `g_r_mex_v2`; `model` is the ground truth (see
+% `gen_Potts_sparse`).
+%
+% If `filename` is given, `S` is also written to a file: a name ending with
+% `.fasta` (or `.fa`) gives a FASTA file (q <= 5, states 0..4 as NACGT),
+% otherwise the native binary format is used (see `write_MSA_bin`).
+%
+% INPUT
+% ===
+% | name      | description                                                |
+% | --------- | ---------------------------------------------------------- |
+% | N, B, q   | size of the MSA: B sequences of N nodes with q states      |
+% | numEdge   | number of planted couplings (sparsity)                     |
+% | sigma_J   | strength of planted couplings                              |
+% | sigma_h   | strength of local fields                                   |
+% | numThread | number of native threads                                   |
+% | seed      | seed for both the model and the sampler                    |
+% | filename  | (optional) output file                                     |
+% | sampling  | (optional) struct with fields burnIn, thin and chainLen    |
+% |           | (default: 200, 10 and 100)                                 |
+%
+% OUTPUT
+% ===
+% S      (uint8)  [0,q-1], N rows, columns as sequences
+% model  planted Potts model
+%
+% EXAMPLE
+% ===
+%     [S, model] = sample_Potts_MSA(1e4, 1e5, 3, 2e4, 1, 0.5, 56, 1, 'stress.bin');
+%
+% HISTORY
+% ===
+% - 2018-03-20  v1
+
+function [S, model] = sample_Potts_MSA(N, B, q, numEdge, sigma_J, sigma_h, ...
+  numThread, seed, filename, sampling)
+
+if nargin < 9
+  filename = '';
+end
+if nargin < 10
+  sampling = struct();
+end
+if ~isfield(sampling, 'burnIn')
+  sampling.burnIn = 200;
+end
+if ~isfield(sampling, 'thin')
+  sampling.thin = 10;
+end
+if ~isfield(sampling, 'chainLen')
+  sampling.chainLen = 100;
+end
+
+% search path
+if exist('sample_Potts_mex', 'file') ~= 3
+  addpath(genpath(pwd))
+end
+
+
+%% model
+model = gen_Potts_sparse(N, q, numEdge, sigma_J, sigma_h, seed);
+
+
+%% sampling
+fprintf('Sampling %d sequences from the Potts model ...\n', B)
+timer = tic;
+
+S = sample_Potts_mex(model.h, model.edges, model.J, B, ...
+  sampling.burnIn, sampling.thin, sampling.chainLen, seed, numThread);
+
+time = toc(timer);
+fprintf('\tFinished in %.2f s.\n', time);
+
+
+%% output
+if ~isempty(filename)
+  fprintf('Saving to file ...\n')
+  timer = tic;
+
+  [~,~,ext] = fileparts(filename);
+  if any(strcmpi(ext, {'.fasta','.fa'}))
+    write_MSA_fasta(filename, S);
+  else
+    write_MSA_bin(filename, S, q);
+  end
+
+  time = toc(timer);
+  fprintf('\tFinished in %.2f s.\n', time);
+end
+
+end
@@ -1,7 +1,7 @@
 function [t,x_new,f_new,g_new,funEvals,H] = ArmijoBacktrack(...
-    x,t,d,f,fr,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,saveHessianComp,funObj,varargin)
+    x,t,d,f,fr,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,saveHessianComp,valueOnly,funObj,varargin)
 % [t,x_new,f_new,g_new,funEvals,H] = ArmijoBacktrack(...
-%    x,t,d,f,fr,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,saveHessianComp,funObj,varargin)
+%    x,t,d,f,fr,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,saveHessianComp,valueOnly,funObj,varargin)
 %
 % Backtracking linesearch to satisfy Armijo condition
 %
@@ -17,6 +17,10 @@ function [t,x_new,f_new,g_new,funEvals,H] = ArmijoBacktrack(...
 %   LS_interp: type of interpolation
 %   progTol: minimum allowable step length
 %   doPlot: do a graphical display of interpolation
+%   valueOnly: evaluate trial points by function value only (f = funObj(x)),
+%       and the gradient only at the accepted point; used when the
+%       interpolation does not need derivatives (LS_interp < 2) and no
+%       Hessian is requested
 %   funObj: objective function
 %   varargin: parameters of objective function
 %
@@ -29,9 +33,14 @@ function [t,x_new,f_new,g_new,funEvals,H] = ArmijoBacktrack(...
 %
 % recet change: LS changed to LS_interp and LS_multi
 
+valueOnly = valueOnly && LS_interp < 2 && nargout < 6;
+
 % Evaluate the Objective and Gradient at the Initial Step
 if nargout == 6
     [f_new,g_new,H] = funObj(x + t*d,varargin{:});
+elseif valueOnly
+    f_new = funObj(x+t*d,varargin{:});
+    g_new = [];
 else
     [f_new,g_new] = funObj(x+t*d,varargin{:});
 end
@@ -111,6 +120,8 @@ while f_new > fr + c1*t*gtd || ~isLegal(f_new)
     
     if ~saveHessianComp && nargout == 6
         [f_new,g_new,H] = funObj(x + t*d,varargin{:});
+    elseif valueOnly
+        f_new = funObj(x + t*d,varargin{:});
     else
         [f_new,g_new] = funObj(x + t*d,varargin{:});
     end
@@ -128,6 +139,12 @@ while f_new > fr + c1*t*gtd || ~isLegal(f_new)
     end
 end
 
+% Evaluate gradient at the accepted point (not counted: it completes the last
+% evaluation, and objectives may reuse its intermediate results)
+if valueOnly && t ~= 0
+    [f_new,g_new] = funObj(x + t*d,varargin{:});
+end
+
 % Evaluate Hessian at new point
 if nargout == 6 && funEvals > 1 && saveHessianComp
     [f_new,g_new,H] = funObj(x + t*d,varargin{:});
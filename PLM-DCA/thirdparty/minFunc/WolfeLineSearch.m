@@ -1,5 +1,5 @@
 function [t,f_new,g_new,funEvals,H] = WolfeLineSearch(...
-    x,t,d,f,g,gtd,c1,c2,LS_interp,LS_multi,maxLS,progTol,debug,doPlot,saveHessianComp,funObj,varargin)
+    x,t,d,f,g,gtd,c1,c2,LS_interp,LS_multi,maxLS,progTol,debug,doPlot,saveHessianComp,valueOnly,funObj,varargin)
 %
 % Bracketing Line Search to Satisfy Wolfe Conditions
 %
@@ -17,6 +17,10 @@ function [t,f_new,g_new,funEvals,H] = WolfeLineSearch(...
 %   maxLS: maximum number of iterations
 %   progTol: minimum allowable step length
 %   doPlot: do a graphical display of interpolation
+%   valueOnly: evaluate trial points by function value only (f = funObj(x))
+%       and the gradient only at points passing the sufficient decrease
+%       test (with LS_interp = 2); the interpolation through a rejected
+%       point is then quadratic
 %   funObj: objective function
 %   varargin: parameters of objective function
 %
@@ -27,9 +31,15 @@ function [t,f_new,g_new,funEvals,H] = WolfeLineSearch(...
 %   funEvals: number function evaluations performed by line search
 %   H: Hessian at initial guess (only computed if requested
 
+valueOnly = valueOnly && LS_interp == 2 && nargout < 5;
+
 % Evaluate the Objective and Gradient at the Initial Step
 if nargout == 5
     [f_new,g_new,H] = funObj(x + t*d,varargin{:});
+elseif valueOnly
+    f_new = funObj(x + t*d,varargin{:});
+    g_new = nan(size(g)); % not known yet
+    pending = 1;
 else
     [f_new,g_new] = funObj(x+t*d,varargin{:});
 end
@@ -50,7 +60,15 @@ done = 0;
 while LSiter < maxLS
 
     %% Bracketing Phase
-    if ~isLegal(f_new) || ~isLegal(g_new)
+    if valueOnly && pending && isLegal(f_new) && ...
+            ~(f_new > f + c1*t*gtd || (LSiter > 1 && f_new >= f_prev))
+        % The point is not rejected by its value: get its gradient
+        [f_new,g_new] = funObj(x + t*d,varargin{:});
+        gtd_new = g_new'*d;
+        pending = 0;
+    end
+
+    if ~isLegal(f_new) || (~(valueOnly && pending) && ~isLegal(g_new))
         if debug
             fprintf('Extrapolated into illegal region, switching to Armijo line-search\n');
         end
@@ -58,11 +76,11 @@ while LSiter < maxLS
         % Do Armijo
         if nargout == 5
             [t,x_new,f_new,g_new,armijoFunEvals,H] = ArmijoBacktrack(...
-                x,t,d,f,f,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,saveHessianComp,...
+                x,t,d,f,f,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,saveHessianComp,0,...
                 funObj,varargin{:});
         else
             [t,x_new,f_new,g_new,armijoFunEvals] = ArmijoBacktrack(...
-                x,t,d,f,f,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,saveHessianComp,...
+                x,t,d,f,f,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,saveHessianComp,0,...
                 funObj,varargin{:});
         end
         funEvals = funEvals + armijoFunEvals;
@@ -110,6 +128,10 @@ while LSiter < maxLS
     gtd_prev = gtd_new;
     if ~saveHessianComp && nargout == 5
         [f_new,g_new,H] = funObj(x + t*d,varargin{:});
+    elseif valueOnly
+        f_new = funObj(x + t*d,varargin{:});
+        g_new = nan(size(g));
+        pending = 1;
     else
         [f_new,g_new] = funObj(x + t*d,varargin{:});
     end
@@ -139,7 +161,15 @@ while ~done && LSiter < maxLS
     HIpos = -LOpos + 3;
 
     % Compute new trial value
-    if LS_interp <= 1 || ~isLegal(bracketFval) || ~isLegal(bracketGval)
+    bracketGtd = bracketGval'*d;
+    if valueOnly
+        % gradients not evaluated are unknown to polyinterp
+        known = ~isnan(bracketGtd);
+        bracketGtd(~known) = sqrt(-1);
+    else
+        known = true(size(bracket));
+    end
+    if LS_interp <= 1 || ~isLegal(bracketFval) || ~any(known) || ~isLegal(bracketGval(:,known))
         if debug
             fprintf('Bisecting\n');
         end
@@ -148,8 +178,8 @@ while ~done && LSiter < maxLS
         if debug
             fprintf('Grad-Cubic Interpolation\n');
         end
-        t = polyinterp([bracket(1) bracketFval(1) bracketGval(:,1)'*d
-            bracket(2) bracketFval(2) bracketGval(:,2)'*d],doPlot);
+        t = polyinterp([bracket(1) bracketFval(1) bracketGtd(1)
+            bracket(2) bracketFval(2) bracketGtd(2)],doPlot);
     else
         % Mixed Case %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
         nonTpos = -Tpos+3;
@@ -190,6 +220,13 @@ while ~done && LSiter < maxLS
     % Evaluate new point
     if ~saveHessianComp && nargout == 5
         [f_new,g_new,H] = funObj(x + t*d,varargin{:});
+    elseif valueOnly
+        f_new = funObj(x + t*d,varargin{:});
+        if f_new < f + c1*t*gtd && f_new < f_LO
+            [f_new,g_new] = funObj(x + t*d,varargin{:});
+        else
+            g_new = nan(size(g)); % rejected, only interpolated through
+        end
     else
         [f_new,g_new] = funObj(x + t*d,varargin{:});
     end
@@ -251,6 +288,10 @@ end
 t = bracket(LOpos);
 f_new = bracketFval(LOpos);
 g_new = bracketGval(:,LOpos);
+if valueOnly && any(isnan(g_new))
+    % the lowest point was rejected by sufficient decrease
+    [f_new,g_new] = funObj(x + t*d,varargin{:});
+end
 
 
 
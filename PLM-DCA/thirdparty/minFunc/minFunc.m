@@ -114,6 +114,12 @@ function [x,f,exitflag,output] = minFunc(funObj,x0,options,varargin)
 %       should have the following interface:
 %       outputFcn(x,iterationType,i,funEvals,f,t,gtd,g,d,optCond,varargin{:});
 %   useMex - where applicable, use mex files to speed things up (default: 1)
+%   LS_valueOnly - if 1, the line search evaluates trial points by function
+%       value only (f = funObj(x)): the Armijo line search (LS_type = 0) with
+%       LS_interp < 2 gets the gradient only at the accepted point, the
+%       Wolfe line search (LS_type = 1) with LS_interp = 2 only at points
+%       passing the sufficient decrease test; useful when funObj skips the
+%       gradient for one output (default: 0)
 %
 % Method-specific input options:
 %   newton:
@@ -239,7 +245,7 @@ end
   HessianModify,Fref,useComplex,numDiff,LS_saveHessianComp,...
   Damped,HvFunc,bbType,cycle,...
   HessianIter,outputFcn,useMex,useNegCurv,precFunc,...
-  LS_type,LS_interp,LS_multi,checkGrad] = ...
+  LS_type,LS_interp,LS_multi,checkGrad,LS_valueOnly] = ...
   minFunc_processInputOptions(options);
 
 % Constants
@@ -1051,18 +1057,18 @@ for i = 1:maxIter
   if LS_type == 0 % Use Armijo Bactracking
     % Perform Backtracking line search
     if computeHessian
-      [t,x,f,g,LSfunEvals,H] = ArmijoBacktrack(x,t,d,f,fr,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,LS_saveHessianComp,funObj,varargin{:});
+      [t,x,f,g,LSfunEvals,H] = ArmijoBacktrack(x,t,d,f,fr,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,LS_saveHessianComp,LS_valueOnly,funObj,varargin{:});
     else
-      [t,x,f,g,LSfunEvals] = ArmijoBacktrack(x,t,d,f,fr,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,1,funObj,varargin{:});
+      [t,x,f,g,LSfunEvals] = ArmijoBacktrack(x,t,d,f,fr,g,gtd,c1,LS_interp,LS_multi,progTol,debug,doPlot,1,LS_valueOnly,funObj,varargin{:});
     end
     funEvals = funEvals + LSfunEvals;
     
   elseif LS_type == 1 % Find Point satisfying Wolfe conditions
     
     if computeHessian
-      [t,f,g,LSfunEvals,H] = WolfeLineSearch(x,t,d,f,g,gtd,c1,c2,LS_interp,LS_multi,25,progTol,debug,doPlot,LS_saveHessianComp,funObj,varargin{:});
+      [t,f,g,LSfunEvals,H] = WolfeLineSearch(x,t,d,f,g,gtd,c1,c2,LS_interp,LS_multi,25,progTol,debug,doPlot,LS_saveHessianComp,LS_valueOnly,funObj,varargin{:});
     else
-      [t,f,g,LSfunEvals] = WolfeLineSearch(x,t,d,f,g,gtd,c1,c2,LS_interp,LS_multi,25,progTol,debug,doPlot,1,funObj,varargin{:});
+      [t,f,g,LSfunEvals] = WolfeLineSearch(x,t,d,f,g,gtd,c1,c2,LS_interp,LS_multi,25,progTol,debug,doPlot,1,LS_valueOnly,funObj,varargin{:});
     end
     funEvals = funEvals + LSfunEvals;
     x = x + t*d;
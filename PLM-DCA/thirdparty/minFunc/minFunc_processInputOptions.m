@@ -4,7 +4,7 @@ function [verbose,verboseI,debug,doPlot,maxFunEvals,maxIter,optTol,progTol,metho
     HessianModify,Fref,useComplex,numDiff,LS_saveHessianComp,...
     Damped,HvFunc,bbType,cycle,...
     HessianIter,outputFcn,useMex,useNegCurv,precFunc,...
-    LS_type,LS_interp,LS_multi,DerivativeCheck] = ...
+    LS_type,LS_interp,LS_multi,DerivativeCheck,LS_valueOnly] = ...
     minFunc_processInputOptions(o)
 
 % Constants
@@ -144,6 +144,7 @@ precFunc = getOpt(o,'PRECFUNC',[]);
 LS_type = getOpt(o,'LS_type',LS_type);
 LS_interp = getOpt(o,'LS_interp',LS_interp);
 LS_multi = getOpt(o,'LS_multi',LS_multi);
+LS_valueOnly = getOpt(o,'LS_valueOnly',0);
 end
 
 function [v] = getOpt(options,opt,default)
@@ -0,0 +1,477 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% `paper_CC_PLM_DCA` for many datasets on one machine, sharing one pool of
+% `numWorker` workers. Every dataset goes through the same stages and writes
+% the same files as `paper_CC_PLM_DCA` (filtering, CC, PLM and scoring with
+% `Compress` as given and `Stream = false`), but the stages are tasks
+% (`parfeval`) on the shared pool:
+%
+% 1. filtering: one task per FASTA file, which is read once for all datasets
+%    taken from it (`rows`), then filtered and deduplicated per dataset;
+% 2. CC: one task per dataset (`CC_MSA` with one worker);
+% 3. PLM: one task per range of nodes, as `PLM_L2_Asym` (`min_g_r` and
+%    `gauge_shift_Ising`); workers read the MSA of the dataset from shared
+%    memory (`shm_msa_mex`, Linux and macOS) and keep MEX files loaded.
+%
+% Ranges of nodes are fed to the pool from the client, about two per worker
+% at a time, from the dataset with the most PLM work left: large datasets
+% start first and small ones fill the workers left idle as large ones run
+% out of nodes. Filtering and CC tasks are submitted as soon as possible, since
+% they make nodes available. Scoring is done by the client once all nodes of a
+% dataset are done. A dataset which fails is reported and does not stop the
+% others.
+%
+% INPUT
+% ===
+% | name       | note                                                       |
+% | ---------- | ---------------------------------------------------------- |
+% | manifest   | struct array, one element per dataset, or the name of a    |
+% |            | tab-separated text file with columns fastafile, dataID,    |
+% |            | num_MI and lambda (lines starting with # are skipped)      |
+% | outputPath | as `paper_CC_PLM_DCA`                                      |
+% | numWorker  | number of workers of the shared pool                       |
+% | NoLoad     | as `paper_CC_PLM_DCA`                                      |
+%
+% Fields of the manifest:
+%
+% | field     | note                                                        |
+% | --------- | ----------------------------------------------------------- |
+% | fastafile | as `paper_CC_PLM_DCA`                                       |
+% | dataID    | as `paper_CC_PLM_DCA`, unique                               |
+% | num_MI    | as `paper_CC_PLM_DCA`                                       |
+% | lambda    | as `paper_CC_PLM_DCA`, a scalar                             |
+% | rows      | (optional) sequences of the FASTA file (1-based), [] as all |
+% | Compress  | (optional) as `paper_CC_PLM_DCA`, default false             |
+%
+% OUTPUT
+% ===
+% `results(k)` for dataset k: `dataID`, `status` ('done' or 'failed'),
+% `message`, `filename` (full path of the scores), `N_f`, `B_f`, `N_cc` and
+% `seconds` (worker time of filtering, CC and PLM; client time of scoring).
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1.1
+%   - PLM of the last dataset through CC is dispatched (e.g. one dataset)
+%
+% - 2018-05-10  v1
+
+function results = batch_CC_PLM(manifest, outputPath, numWorker, NoLoad)
+
+if nargin < 4
+  NoLoad = false;
+end
+
+%% check with little overhead
+if ~ischar(outputPath) || exist(outputPath,'dir') ~= 7
+  error('The folder `%s` does not exist.', outputPath)
+end
+if ~islogical(NoLoad)
+  error('`NoLoad` should be provided as logical.')
+end
+data = read_manifest(manifest);
+numData = numel(data);
+
+
+%% some preparation
+
+% If no pool exists, a new one is created.
+poolobj = gcp('nocreate');
+if isempty(poolobj)
+  poolobj = parpool(numWorker);
+end
+numWorker = poolobj.NumWorkers;
+
+% search path
+addpath(genpath(pwd))
+
+letter_N_max = 500;
+MAF_min = 0.01;
+
+% see `PLM_DCA.m`
+options.Display = 'off';
+options.progTol = -0;
+options.optTol  = 1e-5;
+options.useMEX  = true;
+options.Method  = 'lbfgs';
+options.Corr    = 100;
+skip = false;
+
+results = struct('dataID', {data.dataID}, 'status', 'pending', ...
+  'message', '', 'filename', '', 'N_f', 0, 'B_f', 0, 'N_cc', 0, ...
+  'seconds', zeros(1,4));
+
+% state of the PLM stage of every dataset
+state = struct('S', [], 'S_ref', [], 'min_node', '', 'N', 0, 'B', 0, ...
+  'q', 0, 'weights', [], 'idx_f', [], 'idx_cc', [], 'MSA_id', '', ...
+  'h_and_J', [], 'next', 1, 'numDone', 0, 'rangeSize', 1);
+state = repmat(state, 1, numData);
+
+% futures and what they are
+F = parallel.FevalFuture.empty(1, 0);
+meta = cell(1, 0);
+maxQueued = 2*numWorker;
+
+
+%% filtering, one task per FASTA file
+fprintf('Batch of %d datasets on %d workers ...\n', numData, numWorker);
+timer = tic;
+
+[files, ~, group] = unique({data.fastafile}, 'stable');
+for g = 1:numel(files)
+  k = find(group == g);
+  F(end+1) = parfeval(poolobj, @task_filter, 1, files{g}, data(k), ...
+    outputPath, NoLoad, letter_N_max, MAF_min); %#ok<AGROW>
+  meta{end+1} = struct('type', 'filter', 'k', k, 'nodes', []); %#ok<AGROW>
+end
+
+
+%% event loop
+try
+  while true
+    % ranges of nodes, from the dataset with the most PLM work left
+    numQueued = sum(cellfun(@(m) strcmp(m.type, 'PLM'), meta));
+    while numQueued < maxQueued
+      left = zeros(1, numData);
+      for k = 1:numData
+        if ~isempty(state(k).h_and_J) && strcmp(results(k).status, 'pending')
+          left(k) = (state(k).N - state(k).next + 1)*state(k).N*state(k).B;
+        end
+      end
+      [w, k] = max(left);
+      if w <= 0
+        break
+      end
+      nodes = state(k).next : min(state(k).N, ...
+        state(k).next + state(k).rangeSize - 1);
+      state(k).next = nodes(end) + 1;
+      lambdas = [data(k).lambda data(k).lambda/2];
+      F(end+1) = parfeval(poolobj, @task_PLM, 1, state(k).min_node, ...
+        state(k).S_ref, state(k).N, state(k).B, state(k).q, ...
+        state(k).weights, nodes, lambdas, skip, options); %#ok<AGROW>
+      meta{end+1} = struct('type', 'PLM', 'k', k, 'nodes', nodes); %#ok<AGROW>
+      numQueued = numQueued + 1;
+    end
+    % after the last CC task, its nodes are dispatched above before leaving
+    if isempty(F)
+      break
+    end
+
+    [i, out] = fetchNext(F);
+    m = meta{i};
+    F(i) = [];
+    meta(i) = [];
+
+    switch m.type
+      case 'filter'
+        for j = 1:numel(m.k)
+          k = m.k(j);
+          if ~isempty(out.err)
+            results(k) = fail(results(k), out.err);
+            continue
+          end
+          d = out.data(j);
+          results(k).N_f = size(d.MSA_u, 2);
+          results(k).B_f = size(d.MSA_u, 1);
+          results(k).seconds(1) = out.seconds/numel(m.k);
+          state(k).idx_f = d.idx_f;
+          fprintf('\t[%s] filtered: N = %d, B = %d (%.1f s)\n', ...
+            data(k).dataID, results(k).N_f, results(k).B_f, toc(timer));
+
+          F(end+1) = parfeval(poolobj, @task_CC, 1, d.MSA_u, d.idx_row, ...
+            data(k).dataID, data(k).num_MI, data(k).Compress, outputPath, ...
+            NoLoad); %#ok<AGROW>
+          meta{end+1} = struct('type', 'CC', 'k', k, 'nodes', []); %#ok<AGROW>
+        end
+
+      case 'CC'
+        k = m.k;
+        if ~isempty(out.err)
+          results(k) = fail(results(k), out.err);
+          continue
+        end
+        results(k).seconds(2) = out.seconds;
+        results(k).N_cc = out.N;
+        fprintf('\t[%s] CC: N = %d (%.1f s)\n', data(k).dataID, out.N, ...
+          toc(timer));
+        if out.N < 2
+          results(k) = fail(results(k), 'Less than 2 loci are left by CC.');
+          continue
+        end
+
+        s = state(k);
+        s.S = out.S;
+        s.N = out.N;
+        s.B = out.B;
+        s.q = out.q;
+        s.weights = out.weights;
+        s.idx_cc = out.idx_cc;
+        s.MSA_id = out.MSA_id;
+        s.h_and_J = zeros(s.q + s.q*s.q*(s.N-1), s.N);
+        s.rangeSize = max(1, min(16, floor(s.N/(2*numWorker))));
+        % L-BFGS of `min_g_r` on shared memory, or truncated Newton beyond the
+        % limitation of `minFunc` (see `PLM_L2_Asym`)
+        if options.Corr*size(s.h_and_J, 1) < 2^31
+          s.min_node = 'min_g_r';
+          s.S_ref = s.S;
+          if numWorker > 1 && isunix
+            s.S_ref = shm_msa_mex('create', s.S);
+          end
+        else
+          s.min_node = 'min_g_r_newton';
+          s.S_ref = s.S;
+        end
+        state(k) = s;
+
+      case 'PLM'
+        k = m.k;
+        if ~strcmp(results(k).status, 'pending')
+          continue
+        end
+        if ~isempty(out.err)
+          results(k) = fail(results(k), out.err);
+          state(k) = free_shared(state(k));
+          continue
+        end
+        state(k).h_and_J(:,m.nodes) = out.h_and_J;
+        state(k).numDone = state(k).numDone + numel(m.nodes);
+        results(k).seconds(3) = results(k).seconds(3) + out.seconds;
+        if state(k).numDone == state(k).N
+          [results(k), state(k)] = finish(results(k), state(k), data(k), ...
+            outputPath);
+          fprintf('\t[%s] done (%.1f s)\n', data(k).dataID, toc(timer));
+        end
+    end
+  end
+catch e
+  % copies in shared memory outlive the session otherwise
+  cancel(F);
+  free_shared(state);
+  rethrow(e)
+end
+
+% nothing is left pending unreported
+for k = find(strcmp({results.status}, 'pending'))
+  results(k) = fail(results(k), 'The event loop ended before PLM was done.');
+  state(k) = free_shared(state(k));
+end
+
+time = toc(timer);
+isDone = strcmp({results.status}, 'done');
+fprintf('\tFinished %d of %d datasets in %.2f s (%.3g nodes/s).\n', ...
+  sum(isDone), numData, time, sum([results(isDone).N_cc])/time);
+for k = find(strcmp({results.status}, 'failed'))
+  fprintf('\t[%s] failed: %s\n', results(k).dataID, results(k).message);
+end
+
+end
+
+
+
+
+
+
+
+
+
+
+% manifest as a struct array with defaults filled
+function data = read_manifest(manifest)
+
+if ischar(manifest)
+  fid = fopen(manifest, 'r');
+  if fid < 0
+    error('Could not open `%s` for reading.', manifest)
+  end
+  C = textscan(fid, '%s %s %f %f', 'Delimiter', '\t', ...
+    'CommentStyle', '#', 'MultipleDelimsAsOne', true);
+  fclose(fid);
+  manifest = struct('fastafile', C{1}, 'dataID', C{2}, ...
+    'num_MI', num2cell(C{3}), 'lambda', num2cell(C{4}));
+end
+if ~isstruct(manifest) || isempty(manifest) ...
+    || ~all(isfield(manifest, {'fastafile', 'dataID', 'num_MI', 'lambda'}))
+  error('`manifest` should contain fastafile, dataID, num_MI and lambda.')
+end
+
+data = manifest(:).';
+for k = 1:numel(data)
+  if ~isfield(data, 'rows') || isempty(data(k).rows)
+    data(k).rows = [];
+  end
+  if ~isfield(data, 'Compress') || isempty(data(k).Compress)
+    data(k).Compress = false;
+  end
+  if ~ischar(data(k).fastafile) || ~ischar(data(k).dataID)
+    error('fastafile and dataID of dataset %d should be char vectors.', k)
+  end
+  if ~isscalar(data(k).lambda) || data(k).lambda < 0
+    error('lambda of `%s` should be a non-negative scalar.', data(k).dataID)
+  end
+  if ~islogical(data(k).Compress)
+    error('`Compress` of `%s` should be provided as logical.', data(k).dataID)
+  end
+end
+if numel(unique({data.dataID})) ~= numel(data)
+  error('dataID should be unique in the manifest.')
+end
+
+end
+
+
+
+function r = fail(r, message)
+
+r.status = 'failed';
+r.message = message;
+
+end
+
+
+
+% free the copy of S in shared memory, if any
+function state = free_shared(state)
+
+for k = 1:numel(state)
+  if ischar(state(k).S_ref)
+    shm_msa_mex('free', state(k).S_ref);
+  end
+  state(k).S_ref = [];
+end
+
+end
+
+
+
+% scores of a dataset whose nodes are all done, saved as `paper_CC_PLM_DCA`
+function [r, s] = finish(r, s, d, outputPath)
+
+s = free_shared(s);
+timer = tic;
+table_i_j_score = score_coupling_L2_no_gap(s.h_and_J, s.q, s.N);
+table_i_j_score(1:2,:) = s.idx_f(s.idx_cc(table_i_j_score(1:2,:)));
+
+CC_id = sprintf('CC-MI_%g-N_%g', d.num_MI, s.N);
+DCA_id = sprintf('%s--PLM-l_%g', CC_id, d.lambda);
+r.filename = fullfile(outputPath, sprintf('%s--%s.mat', s.MSA_id, DCA_id));
+save(r.filename, 'table_i_j_score', '-v7.3');
+r.seconds(4) = toc(timer);
+r.status = 'done';
+
+s.S = [];
+s.h_and_J = [];
+
+end
+
+
+
+%% tasks, run by workers; errors are returned in `out.err`
+
+% read a FASTA file once, filter and deduplicate every dataset taken from it
+function out = task_filter(fastafile, data, outputPath, NoLoad, ...
+  letter_N_max, MAF_min)
+
+out.err = '';
+out.data = struct('MSA_u', {}, 'idx_f', {}, 'idx_row', {});
+timer = tic;
+try
+  MSA = [];
+  for k = 1:numel(data)
+    filename_filter_full = fullfile(outputPath, sprintf(...
+      '%s--gapMax_%g-MAFmin_%g-N_1-major_2-minor_3.mat', data(k).dataID, ...
+      letter_N_max, MAF_min));
+    if NoLoad || exist(filename_filter_full, 'file') ~= 2
+      if isempty(MSA)
+        [MSA, len_seq, num_seq, ~] = fasta2matrix_mex(fastafile, 1);
+        MSA = MSA.';
+        q = double(max(MSA(:)));
+        N = double(len_seq);
+      end
+      rows = data(k).rows;
+      if isempty(rows)
+        rows = 1:double(num_seq);
+      end
+      [MSA_f, idx_f] = filter_MSA(MSA(rows,:), numel(rows), N, q, ...
+        letter_N_max, MAF_min);
+      save(filename_filter_full, 'MSA_f', 'idx_f', '-v7.3');
+    else
+      load(filename_filter_full, 'MSA_f', 'idx_f');
+    end
+    [MSA_u, ~, idx_row] = unique(MSA_f, 'rows');
+    out.data(k) = struct('MSA_u', MSA_u, 'idx_f', idx_f, 'idx_row', idx_row);
+  end
+catch e
+  out.err = getReport(e, 'basic');
+end
+out.seconds = toc(timer);
+
+end
+
+
+
+% CC of one dataset, as `paper_CC_PLM_DCA`
+function out = task_CC(MSA_u, idx_row, dataID, num_MI, Compress, ...
+  outputPath, NoLoad)
+
+out.err = '';
+timer = tic;
+try
+  [B_f, N_f] = size(MSA_u);
+  q = double(max(MSA_u(:)));
+  if Compress
+    mult = accumarray(idx_row(:), 1);
+    weights = mult/max(mult);
+    MSA_id = sprintf('%s-N_%g-B_%g-mult', dataID, N_f, B_f);
+  else
+    weights = ones(B_f,1);
+    MSA_id = sprintf('%s-N_%g-B_%g-x_1', dataID, N_f, B_f);
+  end
+  [MSA_cc, idx_cc] = CC_MSA(MSA_u, MSA_id, N_f, B_f, q, weights, num_MI, ...
+    1, outputPath, NoLoad, Compress);
+  N_cc = numel(idx_cc);
+  CC_id = sprintf('CC-MI_%g-N_%g', num_MI, N_cc);
+  save(fullfile(outputPath, sprintf('%s--%s-MSA.mat', MSA_id, CC_id)), ...
+    'MSA_cc', 'idx_cc')
+
+  out.S = uint8(MSA_cc.'-1);
+  out.N = N_cc;
+  out.B = B_f;
+  out.q = q;
+  out.weights = weights;
+  out.idx_cc = idx_cc;
+  out.MSA_id = MSA_id;
+catch e
+  out.err = getReport(e, 'basic');
+end
+out.seconds = toc(timer);
+
+end
+
+
+
+% a range of nodes, as `PLM_L2_Asym`
+function out = task_PLM(min_node, S, N, B, q, weights, nodes, lambdas, ...
+  skip, options)
+
+out.err = '';
+timer = tic;
+try
+  B_eff = sum(weights);
+  out.h_and_J = zeros(q + q*q*(N-1), numel(nodes));
+  for j = 1:numel(nodes)
+    r_h_and_J = feval(min_node, S, uint64(N), uint64(B), uint64(q), ...
+      weights, B_eff, uint64(nodes(j)), lambdas, skip, options);
+    out.h_and_J(:,j) = gauge_shift_Ising(r_h_and_J, q, N);
+  end
+catch e
+  out.err = getReport(e, 'basic');
+end
+out.seconds = toc(timer);
+
+end
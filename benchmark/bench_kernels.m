@@ -0,0 +1,203 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Benchmark of the kernels as they are called in the pipeline (one MATLAB
+% process, no parfor), on synthetic MSAs of every combination of `Ns`, `Bs`
+% and `qs`. Synthetic data are i.i.d. uniform states with a fixed seed.
+%
+% | kernel                   | one call                        | unit of rate      |
+% | ------------------------ | ------------------------------- | ----------------- |
+% | g_r_mex_v2               | objective and gradient of g_r   | samples*sites/s   |
+% | g_r_mex_v2 (value)       | objective of g_r only           | samples*sites/s   |
+% | min_g_r (LS_valueOnly=v) | 20 L-BFGS iterations of a node  | nodes/s           |
+% | calc_f2_w_mex_uint8      | f_ij of one pair                | pairs/s           |
+% | calc_MI                  | MI of one pair given f_i, f_j   | pairs/s           |
+% | fasta2matrix_mex         | parse a B-by-N FASTA file       | MB/s              |
+% | gauge_shift_Ising        | shift one node to Ising gauge   | nodes/s           |
+% | score_coupling_L2_no_gap | score all N(N-1)/2 pairs        | pairs/s           |
+%
+% `min_g_r` is timed with `options.LS_valueOnly` off (v = 0) and on (v = 1),
+% where trial steps rejected by the line search are evaluated by objective
+% only.
+%
+% FASTA files use the letters NACGT, so the FASTA benchmark is run only for
+% q <= 5.
+%
+% INPUT
+% ===
+% Ns, Bs, qs   vectors of sizes to sweep
+% tmpPath      (optional) folder for temporary FASTA files, default `tempdir`
+%
+% OUTPUT
+% ===
+% `results` is a struct array with fields: kernel, N, B, q, time (seconds per
+% call), rate and unit.
+%
+% EXAMPLE
+% ===
+%     results = bench_kernels([1e3 4e3], [1e3 3e3], [3 5]);
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1.1
+%   - `g_r_mex_v2` by objective only, `min_g_r` with and without
+%     `options.LS_valueOnly`
+%
+% - 2018-03-12  v1
+
+function results = bench_kernels(Ns, Bs, qs, tmpPath)
+
+if nargin < 4
+  tmpPath = tempdir;
+end
+if exist(tmpPath,'dir') ~= 7
+  error('The folder `%s` does not exist.', tmpPath)
+end
+
+% search path
+here = fileparts(mfilename('fullpath'));
+if exist('g_r_mex_v2','file') ~= 3 || exist('calc_f2_w_mex_uint8','file') ~= 3 ...
+    || exist('fasta2matrix_mex','file') ~= 3
+  addpath(genpath(fullfile(here, '..')))
+end
+
+results = struct('kernel',{},'N',{},'B',{},'q',{},'time',{},'rate',{},'unit',{});
+
+fprintf('%-26s %8s %8s %4s %12s %12s %s\n', ...
+  'kernel','N','B','q','time (s)','rate','unit')
+
+rng(20180312);
+for N = Ns(:).'
+  for B = Bs(:).'
+    for q = qs(:).'
+      MSA = uint8(randi(q, B, N));          % [1,q], rows as sequences
+      S = MSA.' - 1;                        % [0,q-1], columns as sequences
+      weights = ones(B,1);
+      B_eff = B;
+
+
+      %% g_r (one node)
+      r = uint64(ceil(N/2));
+      wr = zeros(q + q*q*(N-1), 1);
+      lambdas = [0.01 0.005];
+      t = timeit(@() g_r_mex_v2(S,uint64(N),uint64(B),uint64(q), ...
+        weights,B_eff,r,wr,lambdas,'SkipCheckFlag'), 2);
+      results = report(results, 'g_r_mex_v2', N,B,q, t, B*(N-1)/t, ...
+        'samples*sites/s');
+      t = timeit(@() g_r_mex_v2(S,uint64(N),uint64(B),uint64(q), ...
+        weights,B_eff,r,wr,lambdas,'SkipCheckFlag'), 1);
+      results = report(results, 'g_r_mex_v2 (value)', N,B,q, t, B*(N-1)/t, ...
+        'samples*sites/s');
+
+
+      %% minimization of g_r (one node, with and without value-only trials)
+      options.Display = 'off';
+      options.progTol = -0;
+      options.optTol  = 0;        % run exactly `MaxIter` iterations
+      options.MaxIter = 20;
+      options.useMEX  = true;
+      options.Method  = 'lbfgs';
+      options.Corr    = 100;
+      for valueOnly = [0 1]
+        options.LS_valueOnly = valueOnly;
+        tic
+        min_g_r(S,uint64(N),uint64(B),uint64(q),weights,B_eff,r,lambdas, ...
+          true,options);
+        t = toc;
+        results = report(results, sprintf('min_g_r (LS_valueOnly=%d)', ...
+          valueOnly), N,B,q, t, 1/t, 'nodes/s');
+      end
+
+
+      %% f_ij (a batch of pairs)
+      numPair = min(1000, N*(N-1)/2);
+      list_i = randi(N-1, numPair, 1);
+      list_j = list_i + arrayfun(@(i) randi(N-i), list_i);
+      t = timeit(@() f2_batch(MSA, list_i, list_j, B, q, weights, B_eff));
+      results = report(results, 'calc_f2_w_mex_uint8', N,B,q, t/numPair, ...
+        numPair/t, 'pairs/s');
+
+
+      %% MI (a batch of pairs)
+      f1 = zeros(q,2);
+      f1(:,1) = calc_f1_w(MSA(:,1), B, q, weights, B_eff);
+      f1(:,2) = calc_f1_w(MSA(:,2), B, q, weights, B_eff);
+      fij = calc_f2_w_mex_uint8(MSA(:,1), MSA(:,2), ...
+        uint64(B), uint64(q), weights, B_eff);
+      t = timeit(@() MI_batch(f1, fij, q, numPair));
+      results = report(results, 'calc_MI', N,B,q, t/numPair, ...
+        numPair/t, 'pairs/s');
+
+
+      %% FASTA parsing
+      if q <= 5
+        filename = fullfile(tmpPath, sprintf('bench-N_%d-B_%d-q_%d.fasta',N,B,q));
+        letters = 'NACGT';
+        fid = fopen(filename, 'w');
+        for b = 1:B
+          fprintf(fid, '>seq%d\n%s\n', b, letters(MSA(b,:)));
+        end
+        fclose(fid);
+        info = dir(filename);
+        t = timeit(@() fasta2matrix_mex(filename));
+        delete(filename);
+        results = report(results, 'fasta2matrix_mex', N,B,q, t, ...
+          info.bytes/t/1e6, 'MB/s');
+      end
+
+
+      %% gauge shift (one node) and scoring (all pairs)
+      h_and_J = 0.1*randn(q + q*q*(N-1), min(N, 8));
+      t = timeit(@() gauge_shift_Ising(h_and_J(:,1), q, N));
+      results = report(results, 'gauge_shift_Ising', N,B,q, t, 1/t, ...
+        'nodes/s');
+
+      if (q + q*q*(N-1))*N*8 <= 2^30    % at most 1 GB for `h_and_J`
+        h_and_J = 0.1*randn(q + q*q*(N-1), N);
+        t = timeit(@() score_coupling_L2_no_gap(h_and_J, q, N), 1);
+        results = report(results, 'score_coupling_L2_no_gap', N,B,q, t, ...
+          N*(N-1)/2/t, 'pairs/s');
+      end
+    end
+  end
+end
+
+end
+
+
+
+
+
+
+
+
+
+
+function fij = f2_batch(MSA, list_i, list_j, B, q, weights, B_eff)
+B0 = uint64(B);
+q0 = uint64(q);
+for l = 1:numel(list_i)
+  fij = calc_f2_w_mex_uint8(MSA(:,list_i(l)), MSA(:,list_j(l)), ...
+    B0, q0, weights, B_eff);
+end
+end
+
+
+function I = MI_batch(f1, fij, q, numPair)
+for l = 1:numPair
+  I = calc_MI(f1(:,1), f1(:,2), fij, q);
+end
+end
+
+
+function results = report(results, kernel, N, B, q, time, rate, unit)
+results(end+1) = struct('kernel',kernel, 'N',N, 'B',B, 'q',q, ...
+  'time',time, 'rate',rate, 'unit',unit);
+fprintf('%-26s %8d %8d %4d %12.4g %12.4g %s\n', ...
+  kernel, N, B, q, time, rate, unit)
+end
@@ -0,0 +1,170 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Strong and weak scaling of the kernels across number of threads/workers.
+%
+% - strong scaling: the problem (N, B, q) is fixed; efficiency is
+%   T(1) / (p T(p)).
+% - weak scaling: the work per thread is fixed by using p*B sequences with p
+%   threads; efficiency is T(1) / T(p).
+%
+% Supported `kernel`:
+%
+% | kernel | parallelism                     | what is timed                        |
+% | ------ | ------------------------------- | ------------------------------------ |
+% | 'g_r'  | native threads (`bench_kernels_mex`) | one g_r sweep over all N nodes  |
+% | 'g_R'  | native threads (`bench_kernels_mex`) | the same sweep, tiles of 8 nodes |
+% | 'f2'   | native threads (`bench_kernels_mex`) | f_ij of all N(N-1)/2 pairs      |
+% | 'PLM'  | parfor workers (`PLM_L2_Asym`)  | PLM with `MaxIter` L-BFGS iterations |
+%
+% The native kernels exclude MATLAB overhead and show the limit of the memory
+% system; 'PLM' shows what the production code gets from a parallel pool of
+% `p` workers (the pool is restarted for every `p`).
+%
+% INPUT
+% ===
+% kernel        'g_r', 'g_R', 'f2' or 'PLM'
+% N, B, q       size of the problem (B per thread for weak scaling)
+% numThreads    vector of thread/worker counts, e.g. [1 2 4 8 14 28 56]
+% mode          'strong' or 'weak'
+% minTime       (optional) minimal measuring time of native kernels, default 1
+% MaxIter       (optional) L-BFGS iterations per node for 'PLM', default 20
+% Pin           (optional) true to pin native threads and spread them over the
+%               NUMA nodes, with one copy of the MSA per node; default false
+%
+% OUTPUT
+% ===
+% `results` is a struct array with fields: kernel, mode, p, N, B, q, time,
+% speedup, efficiency, numNode and topology (placement of native threads, see
+% `bench_kernels_mex`; '' for 'PLM').
+%
+% EXAMPLE
+% ===
+%     bench_scaling('g_r', 2000, 3000, 3, [1 2 4 8 14 28 56], 'strong');
+%     bench_scaling('f2',  4000, 1000, 3, [1 2 4 8 14 28 56], 'weak');
+%     bench_scaling('f2',  4000, 1000, 3, [28 56], 'strong', 1, 20, true);
+%
+% HISTORY
+% ===
+% - 2018-05-09  v1.1
+%   - optional `Pin`, NUMA topology in the results
+%
+% - 2018-03-12  v1
+
+function results = bench_scaling(kernel, N, B, q, numThreads, mode, ...
+  minTime, MaxIter, Pin)
+
+if nargin < 7
+  minTime = 1;
+end
+if nargin < 8
+  MaxIter = 20;
+end
+if nargin < 9
+  Pin = false;
+end
+if ~any(strcmp(mode, {'strong','weak'}))
+  error('`mode` should be ''strong'' or ''weak''.')
+end
+
+% search path
+here = fileparts(mfilename('fullpath'));
+if exist('bench_kernels_mex','file') ~= 3 || exist('PLM_L2_Asym','file') ~= 2
+  addpath(genpath(fullfile(here, '..')))
+end
+
+results = struct('kernel',{},'mode',{},'p',{},'N',{},'B',{},'q',{}, ...
+  'time',{},'speedup',{},'efficiency',{},'numNode',{},'topology',{});
+
+fprintf('%-6s %-6s %6s %8s %8s %4s %12s %10s %10s %5s\n', ...
+  'kernel','mode','p','N','B','q','time (s)','speedup','efficiency','nodes')
+
+time_1 = [];
+for p = numThreads(:).'
+  if strcmp(mode, 'weak')
+    B_p = B*p;
+  else
+    B_p = B;
+  end
+
+  switch kernel
+    case {'g_r','g_R','f2'}
+      result = bench_kernels_mex(kernel, N, B_p, q, p, minTime, Pin);
+      time = result.time;
+      numNode = result.numNode;
+      topology = result.topology;
+    case 'PLM'
+      time = time_PLM(N, B_p, q, p, MaxIter);
+      numNode = 1;
+      topology = '';
+    otherwise
+      error('Unsupported kernel: ''%s''.', kernel)
+  end
+
+  if isempty(time_1)
+    time_1 = time * numThreads(1);    % time with a single thread (estimated)
+    if strcmp(mode, 'weak')
+      time_1 = time;
+    end
+  end
+  if strcmp(mode, 'strong')
+    speedup = time_1 / time;
+    efficiency = speedup / p;
+  else
+    speedup = time_1 / time * p;
+    efficiency = time_1 / time;
+  end
+
+  results(end+1) = struct('kernel',kernel, 'mode',mode, 'p',p, ...
+    'N',N, 'B',B_p, 'q',q, 'time',time, ...
+    'speedup',speedup, 'efficiency',efficiency, ...
+    'numNode',numNode, 'topology',topology); %#ok<AGROW>
+  fprintf('%-6s %-6s %6d %8d %8d %4d %12.4g %10.3f %10.3f %5d\n', ...
+    kernel, mode, p, N, B_p, q, time, speedup, efficiency, numNode)
+end
+
+end
+
+
+
+
+
+
+
+
+
+
+% wall-clock time of `PLM_L2_Asym` with a pool of `numWorker` workers
+function time = time_PLM(N, B, q, numWorker, MaxIter)
+
+rng(20180312);
+S = uint8(randi(q, N, B) - 1);
+weights = ones(B,1);
+
+options.Display = 'off';
+options.progTol = -0;
+options.optTol  = 0;        % run exactly `MaxIter` iterations
+options.MaxIter = MaxIter;
+options.useMEX  = true;
+options.Method  = 'lbfgs';
+options.Corr    = 100;
+
+% restart the pool with `numWorker` workers
+poolobj = gcp('nocreate');
+if ~isempty(poolobj) && poolobj.NumWorkers ~= numWorker
+  delete(poolobj);
+end
+if numWorker > 1 && isempty(gcp('nocreate'))
+  parpool(numWorker);
+end
+
+timer = tic;
+PLM_L2_Asym(S,N,B,q,weights,[0.01 0.005],true,options,numWorker);
+time = toc(timer);
+
+end
@@ -0,0 +1,314 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * result = bench_kernels_mex(kernel, N, B, q, numThread, minTime[, pin])
+ *
+ *  kernel     char      'g_r', 'g_r_value', 'g_R' or 'f2'
+ *  N          double    number of nodes/loci
+ *  B          double    number of sequences
+ *  q          double    number of states, [2, 256]
+ *  numThread  double    number of native threads
+ *  minTime    double    minimal measuring time in seconds
+ *  pin        logical   (optional) pin threads and spread them over the NUMA
+ *                       nodes, with one copy of the MSA per node (default
+ *                       false: placement left to the scheduler, one copy)
+ *
+ *
+ * DESCRIPTION
+ * ===
+ * Micro-benchmark of native kernels on a synthetic MSA (i.i.d. uniform states,
+ * fixed seed). The kernel is repeated until `minTime` seconds have passed
+ * (at least once, after one warm-up run). One iteration is
+ *
+ *  - 'g_r': `g_r` evaluated once for every node r = 1..N at zero parameters,
+ *           i.e. one objective/gradient sweep of the asymmetric PLM. Nodes are
+ *           distributed over threads. Work is counted in sample-sites
+ *           (B*(N-1) per node) and the traffic on `S` is N*B bytes per node.
+ *  - 'g_r_value': same as 'g_r', but objective only (`g_r_value`, keeping the
+ *           conditional probabilities), i.e. the cost of a trial step of the
+ *           line search with `LS_valueOnly`.
+ *  - 'g_R': same as 'g_r', but nodes are evaluated in tiles of 8 by `g_R`
+ *           (one read of `S` per tile).
+ *  - 'f2':  `calc_f2_w_col` for every pair (i,j), i < j, i.e. the all-pairs
+ *           scan in `CC_MSA`. Pairs are distributed over threads. Work is
+ *           counted in pairs and the traffic is 2*B bytes per pair.
+ *
+ * `result` is a struct with fields
+ *
+ *  | name       | meaning                                   |
+ *  | ---------- | ----------------------------------------- |
+ *  | kernel     | name of the kernel                        |
+ *  | N, B, q    | size of the problem                       |
+ *  | numThread  | number of threads                         |
+ *  | iterations | number of measured iterations             |
+ *  | time       | seconds per iteration (wall clock)        |
+ *  | items      | work items per iteration                  |
+ *  | rate       | items per second                          |
+ *  | bandwidth  | bytes of MSA read per second              |
+ *  | numNode    | NUMA nodes holding threads                |
+ *  | topology   | placement of threads (see `ThreadPool`)   |
+ *
+ * and one summary line is printed in the style of Google Benchmark, followed
+ * by the placement of threads.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v3  kernel 'g_r_value'
+ * - 2018-05-09  v2  optional `pin`, topology
+ * - 2018-03-12  v1
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "mex.h"
+#include "../../PLM-DCA/function/mex/g_r.v02.h"
+#include "../../PLM-DCA/function/mex/g_R.hpp"
+#include "../../Correlation-Compression/function/mex/calc_f2_w_col.hpp"
+#include "../../common/mex/thread_pool.hpp"
+
+using namespace std;
+
+
+// i.i.d. uniform states in [offset, offset+q-1]
+inline void fill_uniform(vector<uint8_t> &data, size_t q, uint8_t offset) {
+  mt19937_64 rng(20180312);
+  uniform_int_distribution<int> state(0, int(q) - 1);
+  for (auto &s : data) {
+    s = uint8_t(state(rng) + offset);
+  }
+}
+
+
+// pair index l (0-based) -> (i,j), i < j; same order as `l2ij_off_lt`
+inline void l2ij(size_t l, size_t N, size_t &i, size_t &j) {
+  i = 0;
+  size_t len = N - 1;   // number of pairs (i, *)
+  while (l >= len) {
+    l -= len;
+    i++;
+    len--;
+  }
+  j = i + 1 + l;
+}
+
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nrhs != 6 && nrhs != 7) {
+    mexErrMsgIdAndTxt(
+      "bench_kernels_mex:nrhs",
+      "Number of arguments needed: 6 or 7\n"
+      "provided: %d", nrhs);
+  }
+  if (nlhs > 1) {
+    mexErrMsgIdAndTxt(
+      "bench_kernels_mex:nlhs",
+      "This function produces 1 output.");
+  }
+  if (!mxIsChar(prhs[0])) {
+    mexErrMsgIdAndTxt(
+      "bench_kernels_mex:kernel",
+      "`kernel` should be provided as a char vector.");
+  }
+  for (int k = 1; k < 6; k++) {
+    if (!mxIsDouble(prhs[k]) || mxGetNumberOfElements(prhs[k]) != 1) {
+      mexErrMsgIdAndTxt(
+        "bench_kernels_mex:prhs:ScalarWrong",
+        "All of {N, B, q, numThread, minTime} should be double scalars.");
+    }
+  }
+
+  char *pc = mxArrayToString(prhs[0]);
+  const string kernel(pc);
+  mxFree(pc);
+
+  const size_t N         = size_t(mxGetScalar(prhs[1]));
+  const size_t B         = size_t(mxGetScalar(prhs[2]));
+  const size_t q         = size_t(mxGetScalar(prhs[3]));
+  const size_t numThread = size_t(mxGetScalar(prhs[4]));
+  const double minTime   = mxGetScalar(prhs[5]);
+  const bool   pin       = nrhs > 6 && mxGetScalar(prhs[6]) != 0.0;
+
+  if (N < 2 || B < 1 || q < 2 || q > 256 || numThread < 1) {
+    mexErrMsgIdAndTxt(
+      "bench_kernels_mex:prhs:range",
+      "Requirement: N >= 2, B >= 1, 2 <= q <= 256, numThread >= 1.");
+  }
+
+  vector<double> w(B, 1.0);
+  const double B_eff = double(B);
+  ThreadPool pool(numThread, pin);
+
+  // one iteration of the selected kernel
+  function<void()> iteration;
+  double items = 0.0;
+  double bytes = 0.0;
+
+  // S: N rows (nodes), B columns (sequences), states in [0,q-1]
+  vector<uint8_t> S;
+  vector<double> h_r_and_J_r;
+  // MSA: B rows (sequences), N columns (loci), states in [1,q]
+  vector<uint8_t> MSA;
+  // one copy of S or MSA per NUMA node of the pool
+  unique_ptr<NodeReplicas<uint8_t> > S_node;
+
+  if (kernel == "g_r") {
+    S.resize(N*B);
+    fill_uniform(S, q, 0);
+    h_r_and_J_r.assign(q + q*q*(N-1), 0.0);
+    items = double(N) * double(B) * double(N-1);
+    bytes = double(N) * double(N) * double(B);
+
+    S_node.reset(new NodeReplicas<uint8_t>(pool, S.data(), S.size()));
+
+    iteration = [&]() {
+      pool.parallel_for(N, 1, [&](size_t begin, size_t end, size_t tid) {
+        vector<double> grad(q + q*q*(N-1));
+        for (size_t r = begin; r < end; r++) {
+          double obj = 0.0;
+          std::fill(grad.begin(), grad.end(), 0.0);
+          g_r(&obj, grad.data(), grad.data() + q,
+              B, N, q, S_node->get(tid), w.data(), B_eff, r,
+              h_r_and_J_r.data(), h_r_and_J_r.data() + q, 0.01, 0.005);
+        }
+      });
+    };
+  }
+  else if (kernel == "g_r_value") {
+    S.resize(N*B);
+    fill_uniform(S, q, 0);
+    h_r_and_J_r.assign(q + q*q*(N-1), 0.0);
+    items = double(N) * double(B) * double(N-1);
+    bytes = double(N) * double(N) * double(B);
+
+    S_node.reset(new NodeReplicas<uint8_t>(pool, S.data(), S.size()));
+
+    iteration = [&]() {
+      pool.parallel_for(N, 1, [&](size_t begin, size_t end, size_t tid) {
+        vector<double> Prob(q*B);
+        for (size_t r = begin; r < end; r++) {
+          double obj = 0.0;
+          g_r_value(&obj, B, N, q, S_node->get(tid), w.data(), B_eff, r,
+              h_r_and_J_r.data(), h_r_and_J_r.data() + q, 0.01, 0.005,
+              Prob.data());
+        }
+      });
+    };
+  }
+  else if (kernel == "g_R") {
+    const size_t tileSize = 8;
+    S.resize(N*B);
+    fill_uniform(S, q, 0);
+    h_r_and_J_r.assign((q + q*q*(N-1))*tileSize, 0.0);
+    items = double(N) * double(B) * double(N-1);
+    bytes = double(N) * double(N) * double(B) / double(tileSize);
+
+    S_node.reset(new NodeReplicas<uint8_t>(pool, S.data(), S.size()));
+
+    iteration = [&]() {
+      const size_t numTile = (N + tileSize - 1) / tileSize;
+      pool.parallel_for(numTile, 1, [&](size_t begin, size_t end, size_t tid) {
+        vector<double> obj(tileSize);
+        vector<double> grad((q + q*q*(N-1))*tileSize);
+        vector<size_t> r(tileSize);
+        for (size_t t = begin; t < end; t++) {
+          const size_t R = (t*tileSize + tileSize < N) ? tileSize : N - t*tileSize;
+          for (size_t k = 0; k < R; k++) {
+            r[k] = t*tileSize + k;
+          }
+          std::fill(obj.begin(), obj.end(), 0.0);
+          std::fill(grad.begin(), grad.end(), 0.0);
+          g_R(obj.data(), grad.data(), B, N, q, S_node->get(tid), w.data(), B_eff,
+              R, r.data(), h_r_and_J_r.data(), 0.01, 0.005);
+        }
+      });
+    };
+  }
+  else if (kernel == "f2") {
+    MSA.resize(N*B);
+    fill_uniform(MSA, q, 1);
+    const size_t numPair = N*(N-1)/2;
+    items = double(numPair);
+    bytes = double(numPair) * 2.0 * double(B);
+
+    S_node.reset(new NodeReplicas<uint8_t>(pool, MSA.data(), MSA.size()));
+
+    iteration = [&]() {
+      pool.parallel_for(numPair, 256, [&](size_t begin, size_t end, size_t tid) {
+        const uint8_t *MSA_t = S_node->get(tid);
+        vector<double> fij(q*q);
+        size_t i, j;
+        for (size_t l = begin; l < end; l++) {
+          l2ij(l, N, i, j);
+          std::fill(fij.begin(), fij.end(), 0.0);
+          calc_f2_w_col<uint8_t, size_t>(
+            MSA_t + B*i, MSA_t + B*j, q, B, w.data(), B_eff,
+            fij.data());
+        }
+      });
+    };
+  }
+  else {
+    mexErrMsgIdAndTxt(
+      "bench_kernels_mex:kernel",
+      "Unsupported kernel: '%s'. Supported: 'g_r', 'g_r_value', 'g_R', 'f2'.",
+      kernel.c_str());
+  }
+
+  /* warm-up, then measure */
+  iteration();
+
+  typedef chrono::steady_clock clock_type;
+  size_t iterations = 0;
+  double time_total = 0.0;
+  const auto t0 = clock_type::now();
+  do {
+    iteration();
+    iterations++;
+    time_total = chrono::duration<double>(clock_type::now() - t0).count();
+  } while (time_total < minTime);
+
+  const double time = time_total / double(iterations);
+
+  mexPrintf("%-28s %12.4g s %10zu it   %10.4g items/s %10.4g MB/s\n",
+    (kernel + "/N:" + to_string(N) + "/B:" + to_string(B) + "/q:"
+      + to_string(q) + "/threads:" + to_string(numThread)).c_str(),
+    time, iterations, items/time, bytes/time/1e6);
+  const string topology = pool.topology();
+  mexPrintf("  %s\n", topology.c_str());
+
+  /* output */
+  const char *fields[] = {
+    "kernel", "N", "B", "q", "numThread",
+    "iterations", "time", "items", "rate", "bandwidth", "numNode", "topology"};
+  plhs[0] = mxCreateStructMatrix(1, 1, 12, fields);
+  mxSetField(plhs[0], 0, "kernel",     mxCreateString(kernel.c_str()));
+  mxSetField(plhs[0], 0, "N",          mxCreateDoubleScalar(double(N)));
+  mxSetField(plhs[0], 0, "B",          mxCreateDoubleScalar(double(B)));
+  mxSetField(plhs[0], 0, "q",          mxCreateDoubleScalar(double(q)));
+  mxSetField(plhs[0], 0, "numThread",  mxCreateDoubleScalar(double(numThread)));
+  mxSetField(plhs[0], 0, "iterations", mxCreateDoubleScalar(double(iterations)));
+  mxSetField(plhs[0], 0, "time",       mxCreateDoubleScalar(time));
+  mxSetField(plhs[0], 0, "items",      mxCreateDoubleScalar(items));
+  mxSetField(plhs[0], 0, "rate",       mxCreateDoubleScalar(items/time));
+  mxSetField(plhs[0], 0, "bandwidth",  mxCreateDoubleScalar(bytes/time));
+  mxSetField(plhs[0], 0, "numNode",
+    mxCreateDoubleScalar(double(pool.num_nodes())));
+  mxSetField(plhs[0], 0, "topology",   mxCreateString(topology.c_str()));
+}
@@ -0,0 +1,12 @@
+fprintf(['\n' ...
+  'Benchmark\n' ...
+  '=========\n'])
+
+if exist('compiled', 'dir') ~= 7
+  mkdir('compiled')
+end
+
+fprintf('Compiling `bench_kernels_mex.cpp` ...\n')
+mex -silent -largeArrayDims CXXFLAGS='$CXXFLAGS -std=c++11 -pthread' ...
+  LDFLAGS='$LDFLAGS -pthread' ...
+  -outdir compiled mex/bench_kernels_mex.cpp
@@ -0,0 +1,208 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * NUMA topology of the calling process and pinning of threads, without
+ * libnuma: on Linux the CPUs of every node are read from
+ * `/sys/devices/system/node/node<k>/cpulist` and restricted to the affinity
+ * mask of the process (`taskset`, cgroups, ...). Elsewhere, or when the
+ * topology is unknown, all CPUs form one node and pinning is a no-op.
+ *
+ * Memory is placed by first touch: a page is allocated on the node of the
+ * thread writing it first, so a buffer allocated and filled by a pinned thread
+ * is local to that thread (see `NodeReplicas` in `thread_pool.hpp`).
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-09  v1
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+  #include <dirent.h>
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+
+struct NumaNode {
+  int id;                 // as in /sys/devices/system/node
+  std::vector<int> cpus;  // usable by this process
+};
+
+
+// "0-13,28-41" -> {0, ..., 13, 28, ..., 41}
+inline std::vector<int> numa_parse_cpulist(const std::string &s)
+{
+  std::vector<int> cpus;
+  size_t pos = 0;
+  while (pos < s.size()) {
+    char *end;
+    const long a = std::strtol(s.c_str() + pos, &end, 10);
+    if (end == s.c_str() + pos) {
+      break;
+    }
+    long b = a;
+    pos = size_t(end - s.c_str());
+    if (pos < s.size() && s[pos] == '-') {
+      b = std::strtol(s.c_str() + pos + 1, &end, 10);
+      pos = size_t(end - s.c_str());
+    }
+    for (long c = a; c <= b; c++) {
+      cpus.push_back(int(c));
+    }
+    while (pos < s.size() && (s[pos] == ',' || s[pos] == '\n')) {
+      pos++;
+    }
+  }
+  return cpus;
+}
+
+
+// nodes with at least one usable CPU, in the order of their id
+inline std::vector<NumaNode> numa_nodes()
+{
+  std::vector<NumaNode> nodes;
+
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  const bool hasMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+  DIR *dir = opendir("/sys/devices/system/node");
+  if (dir != NULL) {
+    std::vector<int> ids;
+    for (dirent *e = readdir(dir); e != NULL; e = readdir(dir)) {
+      int id;
+      char tail;
+      if (std::sscanf(e->d_name, "node%d%c", &id, &tail) == 1) {
+        ids.push_back(id);
+      }
+    }
+    closedir(dir);
+    std::sort(ids.begin(), ids.end());
+
+    for (int id : ids) {
+      char path[64];
+      std::snprintf(path, sizeof(path),
+        "/sys/devices/system/node/node%d/cpulist", id);
+      FILE *f = std::fopen(path, "r");
+      if (f == NULL) {
+        continue;
+      }
+      char buf[4096];
+      const size_t n = std::fread(buf, 1, sizeof(buf) - 1, f);
+      std::fclose(f);
+      buf[n] = '\0';
+
+      NumaNode node;
+      node.id = id;
+      for (int c : numa_parse_cpulist(buf)) {
+        if (!hasMask || (c < CPU_SETSIZE && CPU_ISSET(c, &allowed))) {
+          node.cpus.push_back(c);
+        }
+      }
+      if (!node.cpus.empty()) {
+        nodes.push_back(node);
+      }
+    }
+  }
+
+  // no sysfs: one node of the allowed CPUs
+  if (nodes.empty() && hasMask) {
+    NumaNode node;
+    node.id = 0;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+      if (CPU_ISSET(c, &allowed)) {
+        node.cpus.push_back(c);
+      }
+    }
+    if (!node.cpus.empty()) {
+      nodes.push_back(node);
+    }
+  }
+#endif
+
+  if (nodes.empty()) {
+    NumaNode node;
+    node.id = 0;
+    const unsigned n = std::thread::hardware_concurrency();
+    for (unsigned c = 0; c < (n > 0 ? n : 1); c++) {
+      node.cpus.push_back(int(c));
+    }
+    nodes.push_back(node);
+  }
+  return nodes;
+}
+
+
+// true if `numThread` threads cannot fit in the CPUs of one node, i.e. when
+// pinning and per-node copies pay off; smaller pools are left to the scheduler
+inline bool numa_spans_nodes(size_t numThread)
+{
+  const std::vector<NumaNode> nodes = numa_nodes();
+  size_t largest = 0;
+  for (const NumaNode &node : nodes) {
+    largest = std::max(largest, node.cpus.size());
+  }
+  return nodes.size() > 1 && numThread > largest;
+}
+
+
+// pin the calling thread to `cpu`; false if not supported or refused
+inline bool numa_pin_self(int cpu)
+{
+#ifdef __linux__
+  if (cpu < 0 || cpu >= CPU_SETSIZE) {
+    return false;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void) cpu;
+  return false;
+#endif
+}
+
+
+// {0,1,2,5,6} -> "0-2,5-6"
+inline std::string numa_format_list(const std::vector<int> &v)
+{
+  std::string s;
+  size_t k = 0;
+  while (k < v.size()) {
+    size_t e = k;
+    while (e + 1 < v.size() && v[e+1] == v[e] + 1) {
+      e++;
+    }
+    if (!s.empty()) {
+      s += ",";
+    }
+    s += std::to_string(v[k]);
+    if (e > k) {
+      s += "-" + std::to_string(v[e]);
+    }
+    k = e + 1;
+  }
+  return s;
+}
+
+#endif // NUMA_HPP
@@ -0,0 +1,365 @@
+#ifndef SHM_MSA_HPP
+#define SHM_MSA_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * A uint8 matrix (MSA) in POSIX shared memory, shared by all MATLAB processes
+ * of one host (e.g. the workers of a `parpool`). It is registered once by
+ * `shm_msa_mex('create', ...)`; the name of the segment is the handle passed
+ * to kernels instead of the matrix (`g_r_mex_v2`, `calc_f2_w_mex_uint8`).
+ * Every process maps the segment read-only on first use, so the pages are
+ * shared and the memory of a worker does not grow with the matrix.
+ *
+ *  offset 0   char[8]   "CCPLMSHM"
+ *  offset 8   uint32    version (1)
+ *  offset 12  uint32    0
+ *  offset 16  uint64    M, number of rows
+ *  offset 24  uint64    K, number of columns
+ *  offset 32  uint64[4] reserved, 0
+ *  offset 64  uint8     M-by-K, column-major (as in MATLAB)
+ *
+ * A segment lives until `shm_msa_mex('free', ...)` (or reboot) and counts
+ * against the size of `/dev/shm` on Linux. Processes which still map a freed
+ * segment keep reading it; `ShmMsaCache` unmaps it at the next new handle.
+ *
+ * A handle `file:<path>` names an MSA file in the native binary format
+ * (`write_MSA_bin`: 32-byte header "CCPLMMSA", uint32 version, uint32 q,
+ * uint64 N, uint64 B, then N-by-B uint8), which is mapped read-only in place:
+ * the processes of a host share its pages in the page cache, and nothing is
+ * created or freed. The file must not change while it is mapped.
+ *
+ *
+ * # Note for implementation
+ *
+ * Plain C++ and POSIX; functions return a `ShmMsaStatus` and the caller maps it
+ * to MATLAB errors. Link with `-lrt` on Linux (glibc < 2.34). On Windows every
+ * function fails with `SHM_MSA_ERR_UNSUPPORTED`, so that kernels accepting a
+ * handle still compile there.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v1.1
+ *
+ * - handles `file:<path>` of MSA files in the native binary format
+ *
+ * ## 2018-05-08  v1
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+
+enum ShmMsaStatus {
+  SHM_MSA_OK              = 0,
+  SHM_MSA_ERR_OPEN        = 1,  // no such segment, or not permitted
+  SHM_MSA_ERR_SPACE       = 2,  // shared memory exhausted
+  SHM_MSA_ERR_MAP         = 3,
+  SHM_MSA_ERR_FORMAT      = 4,  // not created by `shm_msa_create`
+  SHM_MSA_ERR_UNSUPPORTED = 5   // Windows
+};
+
+struct ShmMsa {
+  const uint8_t *data;  // M-by-K
+  uint64_t M;
+  uint64_t K;
+  void *base;           // the mapping, header included
+  size_t size;
+};
+
+static const char SHM_MSA_MAGIC[8] = {'C', 'C', 'P', 'L', 'M', 'S', 'H', 'M'};
+static const size_t SHM_MSA_HEADER = 64;
+
+// MSA files (`write_MSA_bin`), named by handles `file:<path>`
+static const char SHM_MSA_FILE_MAGIC[8] = {'C','C','P','L','M','M','S','A'};
+static const size_t SHM_MSA_FILE_HEADER = 32;
+static const char SHM_MSA_FILE_PREFIX[] = "file:";
+
+// longest handle accepted by kernels (a path, for files)
+#define SHM_MSA_MAX_HANDLE 4096
+
+
+inline bool shm_msa_is_file(const std::string &handle)
+{
+  return handle.compare(0, 5, SHM_MSA_FILE_PREFIX) == 0;
+}
+
+
+#ifndef _WIN32
+
+
+// a name unused by this process, short enough for every POSIX system
+inline std::string shm_msa_new_name()
+{
+  static unsigned counter = 0;
+  const unsigned long t = (unsigned long) std::chrono::steady_clock::now()
+    .time_since_epoch().count();
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "/ccplm-%ld-%x", (long) getpid(),
+    (unsigned) ((t ^ (t >> 32)) + counter++) & 0xffffffffu);
+  return std::string(buf);
+}
+
+
+// new segment `name` holding a copy of the M-by-K matrix `data`
+inline int shm_msa_create(const std::string &name, const uint8_t *data,
+  uint64_t M, uint64_t K)
+{
+  const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    return SHM_MSA_ERR_OPEN;
+  }
+  const size_t size = SHM_MSA_HEADER + size_t(M*K);
+
+  // reserve the pages now: a full tmpfs would otherwise raise SIGBUS in memcpy
+#ifdef __linux__
+  const bool isReserved = posix_fallocate(fd, 0, off_t(size)) == 0;
+#else
+  const bool isReserved = ftruncate(fd, off_t(size)) == 0;
+#endif
+  if (!isReserved) {
+    close(fd);
+    shm_unlink(name.c_str());
+    return SHM_MSA_ERR_SPACE;
+  }
+
+  void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return SHM_MSA_ERR_MAP;
+  }
+
+  char *p = (char *) base;
+  std::memset(p, 0, SHM_MSA_HEADER);
+  std::memcpy(p, SHM_MSA_MAGIC, 8);
+  const uint32_t version = 1;
+  std::memcpy(p + 8, &version, 4);
+  std::memcpy(p + 16, &M, 8);
+  std::memcpy(p + 24, &K, 8);
+  std::memcpy(p + SHM_MSA_HEADER, data, size_t(M*K));
+  munmap(base, size);
+  return SHM_MSA_OK;
+}
+
+
+// map segment `name` read-only
+inline int shm_msa_attach(const std::string &name, ShmMsa *msa)
+{
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return SHM_MSA_ERR_OPEN;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < SHM_MSA_HEADER) {
+    close(fd);
+    return SHM_MSA_ERR_FORMAT;
+  }
+  const size_t size = size_t(st.st_size);
+  void *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return SHM_MSA_ERR_MAP;
+  }
+
+  const char *p = (const char *) base;
+  uint64_t M, K;
+  std::memcpy(&M, p + 16, 8);
+  std::memcpy(&K, p + 24, 8);
+  if (std::memcmp(p, SHM_MSA_MAGIC, 8) != 0
+    || (K > 0 && M > (size - SHM_MSA_HEADER) / K)
+    || SHM_MSA_HEADER + M*K != size)
+  {
+    munmap(base, size);
+    return SHM_MSA_ERR_FORMAT;
+  }
+  msa->data = (const uint8_t *) (p + SHM_MSA_HEADER);
+  msa->M = M;
+  msa->K = K;
+  msa->base = base;
+  msa->size = size;
+  return SHM_MSA_OK;
+}
+
+
+// map the MSA file `path` (native binary format) read-only
+inline int shm_msa_attach_file(const std::string &path, ShmMsa *msa)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return SHM_MSA_ERR_OPEN;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < SHM_MSA_FILE_HEADER) {
+    close(fd);
+    return SHM_MSA_ERR_FORMAT;
+  }
+  const size_t size = size_t(st.st_size);
+  void *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return SHM_MSA_ERR_MAP;
+  }
+
+  const char *p = (const char *) base;
+  uint64_t N, B;
+  std::memcpy(&N, p + 16, 8);
+  std::memcpy(&B, p + 24, 8);
+  if (std::memcmp(p, SHM_MSA_FILE_MAGIC, 8) != 0
+    || (B > 0 && N > (size - SHM_MSA_FILE_HEADER) / B)
+    || SHM_MSA_FILE_HEADER + N*B > size)
+  {
+    munmap(base, size);
+    return SHM_MSA_ERR_FORMAT;
+  }
+  msa->data = (const uint8_t *) (p + SHM_MSA_FILE_HEADER);
+  msa->M = N;
+  msa->K = B;
+  msa->base = base;
+  msa->size = size;
+  return SHM_MSA_OK;
+}
+
+
+inline void shm_msa_detach(ShmMsa *msa)
+{
+  if (msa->base != NULL) {
+    munmap(msa->base, msa->size);
+    msa->base = NULL;
+    msa->data = NULL;
+  }
+}
+
+
+inline int shm_msa_unlink(const std::string &name)
+{
+  return shm_unlink(name.c_str()) == 0 ? SHM_MSA_OK : SHM_MSA_ERR_OPEN;
+}
+
+#else
+
+inline std::string shm_msa_new_name() { return std::string(); }
+
+inline int shm_msa_create(const std::string &, const uint8_t *, uint64_t,
+  uint64_t) { return SHM_MSA_ERR_UNSUPPORTED; }
+
+inline int shm_msa_attach(const std::string &, ShmMsa *) {
+  return SHM_MSA_ERR_UNSUPPORTED;
+}
+
+inline int shm_msa_attach_file(const std::string &, ShmMsa *) {
+  return SHM_MSA_ERR_UNSUPPORTED;
+}
+
+inline void shm_msa_detach(ShmMsa *) {}
+
+inline int shm_msa_unlink(const std::string &) {
+  return SHM_MSA_ERR_UNSUPPORTED;
+}
+
+#endif
+
+
+// map the segment or file of `handle` read-only
+inline int shm_msa_attach_handle(const std::string &handle, ShmMsa *msa)
+{
+  return shm_msa_is_file(handle)
+    ? shm_msa_attach_file(handle.substr(5), msa)
+    : shm_msa_attach(handle, msa);
+}
+
+
+/**
+ * Segments mapped by one MEX file, looked up by handle. A handle seen for the
+ * first time is attached, and segments freed meanwhile are unmapped then, so
+ * that a long-lived worker does not accumulate mappings.
+ */
+class ShmMsaCache {
+public:
+  ShmMsaCache() {}
+  ~ShmMsaCache() { clear(); }
+
+  ShmMsaCache(const ShmMsaCache&) = delete;
+  ShmMsaCache& operator=(const ShmMsaCache&) = delete;
+
+  // NULL on failure, with `*status` set
+  const ShmMsa *get(const std::string &name, int *status) {
+    std::map<std::string, ShmMsa>::iterator it = map_.find(name);
+    if (it != map_.end()) {
+      *status = SHM_MSA_OK;
+      return &it->second;
+    }
+    sweep();
+    ShmMsa msa;
+    *status = shm_msa_attach_handle(name, &msa);
+    if (*status != SHM_MSA_OK) {
+      return NULL;
+    }
+    return &(map_[name] = msa);
+  }
+
+  void clear() {
+    for (auto &kv : map_) {
+      shm_msa_detach(&kv.second);
+    }
+    map_.clear();
+  }
+
+private:
+  // unmap segments (and files) whose name is gone
+  void sweep() {
+#ifndef _WIN32
+    for (auto it = map_.begin(); it != map_.end(); ) {
+      const int fd = shm_msa_is_file(it->first)
+        ? open(it->first.c_str() + 5, O_RDONLY)
+        : shm_open(it->first.c_str(), O_RDONLY, 0);
+      if (fd >= 0) {
+        close(fd);
+        ++it;
+      }
+      else {
+        shm_msa_detach(&it->second);
+        it = map_.erase(it);
+      }
+    }
+#endif
+  }
+
+  std::map<std::string, ShmMsa> map_;
+};
+
+
+inline const char *shm_msa_strerror(int status)
+{
+  switch (status) {
+    case SHM_MSA_OK :              return "no error";
+    case SHM_MSA_ERR_OPEN :        return "no such shared MSA";
+    case SHM_MSA_ERR_SPACE :       return "shared memory exhausted";
+    case SHM_MSA_ERR_MAP :         return "mapping failed";
+    case SHM_MSA_ERR_FORMAT :      return "not a shared MSA";
+    case SHM_MSA_ERR_UNSUPPORTED : return "not supported on this platform";
+    default :                      return "unknown error";
+  }
+}
+
+#endif // SHM_MSA_HPP
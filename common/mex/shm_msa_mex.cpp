@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * LICENSE
+ * ===
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * MATLAB syntax:
+ * ===
+ * handle = shm_msa_mex('create', S)
+ *          shm_msa_mex('free', handle)
+ * sz     = shm_msa_mex('size', handle)
+ *
+ *  S       uint8    matrix to share (copied once into shared memory)
+ *  handle  char     name of the shared segment, passed to kernels in place
+ *                   of `S` (see `shm_msa.hpp`); or `file:<path>` of an MSA
+ *                   file (`write_MSA_bin`), which `free` leaves alone
+ *  sz      double   [rows columns] of the shared matrix
+ *
+ * Typical use before a `parfor`:
+ *
+ *   handle = shm_msa_mex('create', S);
+ *   cleanupObj = onCleanup(@() shm_msa_mex('free', handle));
+ *
+ * `parfor` then sends the short `handle` to the workers instead of `S`.
+ *
+ *
+ * HISTORY
+ * ===
+ * - 2018-05-10  v1.2  handles of MSA files
+ * - 2018-05-10  v1.1  number of outputs checked
+ * - 2018-05-08  v1
+ */
+
+#include <string>
+#include "mex.h"
+#include "shm_msa.hpp"
+
+using namespace std;
+
+
+static string get_string(const mxArray *pm, const char *name)
+{
+  if (!mxIsChar(pm)) {
+    mexErrMsgIdAndTxt("shm_msa_mex:prhs:WrongType",
+      "`%s` should be provided as a string.", name);
+  }
+  char *pc = mxArrayToString(pm);
+  const string s(pc);
+  mxFree(pc);
+  return s;
+}
+
+
+void mexFunction(
+  int nlhs, mxArray *plhs[],
+  int nrhs, const mxArray *prhs[])
+{
+  if (nrhs != 2) {
+    mexErrMsgIdAndTxt("shm_msa_mex:nrhs",
+      "Syntax: shm_msa_mex(command, S or handle)");
+  }
+  if (nlhs > 1) {
+    mexErrMsgIdAndTxt("shm_msa_mex:nlhs",
+      "This function produces at most 1 output.");
+  }
+  const string cmd = get_string(prhs[0], "command");
+
+  if (cmd == "create") {
+    const mxArray *pm_S = prhs[1];
+    if (!mxIsUint8(pm_S) || mxIsComplex(pm_S)
+      || mxGetNumberOfDimensions(pm_S) != 2)
+    {
+      mexErrMsgIdAndTxt("shm_msa_mex:prhs:WrongType",
+        "`S` should be a real uint8 matrix.");
+    }
+    const string name = shm_msa_new_name();
+    const int st = shm_msa_create(name, (const uint8_t *) mxGetData(pm_S),
+      mxGetM(pm_S), mxGetN(pm_S));
+    if (st != SHM_MSA_OK) {
+      mexErrMsgIdAndTxt("shm_msa_mex:create",
+        "Could not create the shared MSA (%s).", shm_msa_strerror(st));
+    }
+    plhs[0] = mxCreateString(name.c_str());
+    return;
+  }
+
+  const string name = get_string(prhs[1], "handle");
+
+  if (cmd == "free") {
+    if (shm_msa_is_file(name)) {
+      return;
+    }
+    if (shm_msa_unlink(name) != SHM_MSA_OK) {
+      mexWarnMsgIdAndTxt("shm_msa_mex:free",
+        "No shared MSA `%s`.", name.c_str());
+    }
+    return;
+  }
+
+  if (cmd == "size") {
+    ShmMsa msa;
+    const int st = shm_msa_attach_handle(name, &msa);
+    if (st != SHM_MSA_OK) {
+      mexErrMsgIdAndTxt("shm_msa_mex:handle",
+        "`%s`: %s.", name.c_str(), shm_msa_strerror(st));
+    }
+    plhs[0] = mxCreateDoubleMatrix(1, 2, mxREAL);
+    mxGetPr(plhs[0])[0] = double(msa.M);
+    mxGetPr(plhs[0])[1] = double(msa.K);
+    shm_msa_detach(&msa);
+    return;
+  }
+
+  mexErrMsgIdAndTxt("shm_msa_mex:command",
+    "Unknown command `%s`.", cmd.c_str());
+}
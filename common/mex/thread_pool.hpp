@@ -0,0 +1,374 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+/**
+ * Copyright (c) 2017 Chen-Yi Gao
+ *
+ * # License
+ *
+ * See 'LICENSE.txt' in the outermost folder
+ *
+ *
+ * # Description
+ *
+ * A minimal fixed-size thread pool shared by the MEX files that run native
+ * threads (benchmark, sampler, ...). Workers are created once and reused; a
+ * job is broadcast to all workers and the caller blocks until every worker
+ * returns.
+ *
+ *  - `run(fn)` calls `fn(tid)` once on every worker, tid in [0, size()-1].
+ *  - `parallel_for(n, grain, fn)` splits [0, n) into chunks of `grain` items
+ *    handed out dynamically; `fn(begin, end, tid)` is called for each chunk.
+ *  - `TaskQueue` runs tasks which may push further tasks, e.g. a task whose
+ *    inputs have just been produced by the finishing one, until none is left.
+ *
+ * With `pin = true`, workers are pinned to CPUs and spread over the NUMA nodes
+ * of the process (`numa.hpp`) in proportion to their CPUs, in contiguous
+ * blocks of tid. `node_of(tid)` tells the node of a worker, and
+ * `NodeReplicas` keeps one copy of read-only data per node, first touched by
+ * the workers of that node. `topology()` describes the placement.
+ *
+ *
+ * # Note for implementation
+ *
+ * MATLAB API functions (`mxMalloc`, `mexErrMsgIdAndTxt`, `mexPrintf`, ...) are
+ * NOT thread-safe. Code running inside a job must only use plain C++ and
+ * report errors back to the calling thread (e.g. by a flag), which then calls
+ * `mexErrMsgIdAndTxt` after the job has finished.
+ *
+ *
+ * # History
+ *
+ * ## 2018-05-10  v2.1
+ *
+ * - `TaskQueue`, with `push_front` for tasks ahead of the queue
+ *
+ * ## 2018-05-09  v2
+ *
+ * - pinning of workers, `node_of`, `NodeReplicas`
+ *
+ * ## 2018-03-12  v1
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "numa.hpp"
+
+
+// number of hardware threads, at least 1
+inline size_t hardware_threads() {
+  const size_t n = std::thread::hardware_concurrency();
+  return n > 0 ? n : 1;
+}
+
+
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t numThread, bool pin = false)
+    : numThread_(numThread > 0 ? numThread : 1),
+      node_(numThread_, 0), cpu_(numThread_, -1),
+      isPinned_(numThread_, 0),
+      generation_(0), numBusy_(0), stop_(false)
+  {
+    if (pin) {
+      plan(numa_nodes());
+    }
+    else {
+      nodeFirst_.assign(1, 0);
+      nodeSize_.assign(1, numThread_);
+      nodeId_.assign(1, -1);
+    }
+    workers_.reserve(numThread_);
+    for (size_t tid = 0; tid < numThread_; tid++) {
+      workers_.emplace_back(&ThreadPool::loop, this, tid);
+    }
+    if (pin) {
+      run([](size_t) {});   // every worker has pinned itself
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      stop_ = true;
+    }
+    cvJob_.notify_all();
+    for (auto &t : workers_) {
+      t.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t size() const { return numThread_; }
+
+  // nodes holding at least one worker, numbered from 0
+  size_t num_nodes() const { return nodeFirst_.size(); }
+  size_t node_of(size_t tid) const { return node_[tid]; }
+  size_t node_first(size_t node) const { return nodeFirst_[node]; }
+  size_t node_size(size_t node) const { return nodeSize_[node]; }
+
+  // e.g. "node 0 (cpus 0-13): threads 0-6; node 1 (cpus 14-27): threads 7-13;
+  // pinned"
+  std::string topology() const {
+    std::string s;
+    size_t numPinned = 0;
+    for (size_t tid = 0; tid < numThread_; tid++) {
+      numPinned += isPinned_[tid] ? 1 : 0;
+    }
+    for (size_t k = 0; k < num_nodes(); k++) {
+      if (nodeId_[k] >= 0) {
+        s += "node " + std::to_string(nodeId_[k]) + " (cpus "
+          + numa_format_list(nodeCpus_[k]) + "): ";
+      }
+      std::vector<int> tids;
+      for (size_t j = 0; j < nodeSize_[k]; j++) {
+        tids.push_back(int(nodeFirst_[k] + j));
+      }
+      s += "threads " + numa_format_list(tids) + "; ";
+    }
+    if (numPinned == numThread_) {
+      s += "pinned";
+    }
+    else if (numPinned > 0) {
+      s += std::to_string(numPinned) + " of " + std::to_string(numThread_)
+        + " pinned";
+    }
+    else {
+      s += "not pinned";
+    }
+    return s;
+  }
+
+  // call fn(tid) on every worker and wait for all of them
+  void run(const std::function<void(size_t)> &fn) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    job_ = fn;
+    numBusy_ = numThread_;
+    generation_++;
+    cvJob_.notify_all();
+    cvDone_.wait(lock, [this]{ return numBusy_ == 0; });
+    job_ = nullptr;
+  }
+
+  // dynamic scheduling of [0, n) in chunks of `grain` items
+  void parallel_for(
+    size_t n, size_t grain,
+    const std::function<void(size_t, size_t, size_t)> &fn)
+  {
+    if (grain == 0) {
+      grain = 1;
+    }
+    std::atomic<size_t> next(0);
+    run([&](size_t tid) {
+      for (;;) {
+        const size_t begin = next.fetch_add(grain);
+        if (begin >= n) {
+          break;
+        }
+        const size_t end = (begin + grain < n) ? begin + grain : n;
+        fn(begin, end, tid);
+      }
+    });
+  }
+
+private:
+  // blocks of workers per node, in proportion to the CPUs of the node
+  void plan(const std::vector<NumaNode> &nodes) {
+    size_t numCpu = 0;
+    for (const NumaNode &node : nodes) {
+      numCpu += node.cpus.size();
+    }
+    std::vector<size_t> count(nodes.size());
+    size_t assigned = 0;
+    for (size_t k = 0; k < nodes.size(); k++) {
+      count[k] = numThread_ * nodes[k].cpus.size() / numCpu;
+      assigned += count[k];
+    }
+    for (size_t k = 0; assigned < numThread_; k = (k + 1) % nodes.size()) {
+      count[k]++;
+      assigned++;
+    }
+
+    size_t tid = 0;
+    for (size_t k = 0; k < nodes.size(); k++) {
+      if (count[k] == 0) {
+        continue;
+      }
+      nodeFirst_.push_back(tid);
+      nodeSize_.push_back(count[k]);
+      nodeId_.push_back(nodes[k].id);
+      nodeCpus_.push_back(nodes[k].cpus);
+      for (size_t j = 0; j < count[k]; j++, tid++) {
+        node_[tid] = nodeFirst_.size() - 1;
+        cpu_[tid] = nodes[k].cpus[j % nodes[k].cpus.size()];
+      }
+    }
+  }
+
+  void loop(size_t tid) {
+    if (cpu_[tid] >= 0) {
+      isPinned_[tid] = numa_pin_self(cpu_[tid]) ? 1 : 0;
+    }
+    size_t seen = 0;
+    for (;;) {
+      std::function<void(size_t)> job;
+      {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cvJob_.wait(lock, [&]{ return stop_ || generation_ != seen; });
+        if (stop_) {
+          return;
+        }
+        seen = generation_;
+        job = job_;
+      }
+
+      job(tid);
+
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        numBusy_--;
+        if (numBusy_ == 0) {
+          cvDone_.notify_one();
+        }
+      }
+    }
+  }
+
+  const size_t numThread_;
+  std::vector<size_t> node_;          // node of every worker
+  std::vector<int> cpu_;              // CPU of every worker, -1 if not pinned
+  std::vector<char> isPinned_;
+  std::vector<size_t> nodeFirst_;     // first worker of every node
+  std::vector<size_t> nodeSize_;      // number of workers of every node
+  std::vector<int> nodeId_;           // id of every node, -1 if unknown
+  std::vector<std::vector<int> > nodeCpus_;
+  std::vector<std::thread> workers_;
+  std::function<void(size_t)> job_;
+  size_t generation_;
+  size_t numBusy_;
+  bool stop_;
+  std::mutex mtx_;
+  std::condition_variable cvJob_;
+  std::condition_variable cvDone_;
+};
+
+
+
+/**
+ * One copy of n read-only elements per node of `pool`. Every copy is written,
+ * hence placed, by the workers of its node; `get(tid)` returns the copy local
+ * to worker tid. With one node, `data` itself is used and nothing is copied.
+ */
+template<class T>
+class NodeReplicas {
+public:
+  NodeReplicas(ThreadPool &pool, const T *data, size_t n)
+    : pool_(pool), data_(data)
+  {
+    if (pool.num_nodes() < 2) {
+      return;
+    }
+    copies_.resize(pool.num_nodes());
+    for (auto &c : copies_) {
+      c.reset(new T[n]);    // not touched yet
+    }
+    pool.run([&](size_t tid) {
+      const size_t k = pool.node_of(tid);
+      const size_t m = pool.node_size(k);
+      const size_t j = tid - pool.node_first(k);
+      std::copy(data + n*j/m, data + n*(j+1)/m, copies_[k].get() + n*j/m);
+    });
+  }
+
+  NodeReplicas(const NodeReplicas&) = delete;
+  NodeReplicas& operator=(const NodeReplicas&) = delete;
+
+  const T *get(size_t tid) const {
+    return copies_.empty() ? data_ : copies_[pool_.node_of(tid)].get();
+  }
+
+private:
+  const ThreadPool &pool_;
+  const T *data_;
+  std::vector<std::unique_ptr<T[]> > copies_;
+};
+
+
+
+/**
+ * Tasks `fn(tid)` run by all workers of a pool, first in first out. A task may
+ * `push` further tasks, or `push_front` those which should run before all
+ * queued ones; `run` returns when the queue is empty and no task is running.
+ * `push` and `push_front` are thread-safe.
+ */
+class TaskQueue {
+public:
+  typedef std::function<void(size_t)> Task;
+
+  TaskQueue() : numRunning_(0) {}
+
+  TaskQueue(const TaskQueue&) = delete;
+  TaskQueue& operator=(const TaskQueue&) = delete;
+
+  void push(Task task) {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+  void push_front(Task task) {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      tasks_.push_front(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+  void run(ThreadPool &pool) {
+    pool.run([this](size_t tid) {
+      for (;;) {
+        Task task;
+        {
+          std::unique_lock<std::mutex> lock(mtx_);
+          cv_.wait(lock, [this]{ return !tasks_.empty() || numRunning_ == 0; });
+          if (tasks_.empty()) {
+            cv_.notify_all();   // all done
+            return;
+          }
+          task = std::move(tasks_.front());
+          tasks_.pop_front();
+          numRunning_++;
+        }
+
+        task(tid);
+
+        {
+          std::lock_guard<std::mutex> lock(mtx_);
+          numRunning_--;
+        }
+        cv_.notify_all();
+      }
+    });
+  }
+
+private:
+  std::deque<Task> tasks_;
+  size_t numRunning_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+};
+
+#endif // THREAD_POOL_HPP
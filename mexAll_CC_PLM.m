@@ -14,4 +14,8 @@ cd PLM-DCA
 mexAll_PLM
 cd(here)
 
+cd benchmark
+mexAll_bench
+cd(here)
+
 end
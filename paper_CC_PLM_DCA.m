@@ -1,5 +1,25 @@
 % HISTORY
 % ===
+% - 2018-05-10  v5.1
+%   - with `Stream`, the MI stage is not planned; warn when the plan would
+%     have selected the top pairs
+%
+% - 2018-05-10  v5
+%   - add optional `memBudget`: the variants of MI and PLM are selected by
+%     `plan_CC_PLM` before CC
+%
+% - 2018-05-10  v4
+%   - add optional `Stream`: filtering, removal of duplicates and MI in one
+%     native pipeline (see `filter_FASTA_MI`)
+%
+% - 2018-04-19  v3
+%   - `lambda` may be a list: PLM along the regularization path, sharing
+%     filtering, CC and the workers (see `PLM_DCA_path`)
+%
+% - 2018-04-02  v2
+%   - add optional `Compress`: keep multiplicities of duplicate samples as
+%     weights, and compress site patterns in CC (see `compress_MSA`)
+%
 % - 2017-10-24  v1
 
 % MEMO
@@ -9,10 +29,23 @@
 % `lambda`      checked here
 % `outputPath`  checked here
 % `NoLoad`      checked here
+% `Compress`    checked by `CC_MSA`
+% `Stream`      checked here
+% `memBudget`   checked here
 
 % function paper_CC_PLM_DCA(fastafile,dataID, num_MI,lambda, numWorker, outputPath, NoLoad)
 function paper_CC_PLM_DCA(fastafile,dataID, outputPath,NoLoad, numWorker, ...
-  num_MI,lambda)
+  num_MI,lambda, Compress, Stream, memBudget)
+
+if nargin < 8
+  Compress = false;
+end
+if nargin < 9
+  Stream = false;
+end
+if nargin < 10
+  memBudget = [];   % available memory of the host
+end
 
 
 %% check with little overhead
@@ -23,7 +56,7 @@ if ~ischar(dataID)
 end
 
 % lambda
-if lambda < 0.0
+if isempty(lambda) || any(lambda < 0.0)
   error('lambda should be non-negative.')
 end
 
@@ -40,6 +73,17 @@ if ~islogical(NoLoad)
   error('`NoLoad` should be provided as logical.')
 end
 
+% Stream
+if ~islogical(Stream)
+  error('`Stream` should be provided as logical.')
+end
+
+% memBudget
+if ~isempty(memBudget) && (~isnumeric(memBudget) || ~isscalar(memBudget) ...
+    || memBudget <= 0)
+  error('`memBudget` should be a positive number of bytes.')
+end
+
 
 %% some preparation
 
@@ -64,26 +108,79 @@ filename_filter_full = fullfile(outputPath, filename_filter);
 
 % 1. Loading results of previous run is not allowed.
 % 2. Results of previous do not exist.
-if NoLoad || exist(filename_filter_full, 'file') ~= 2
-  [MSA_f, idx_f] = filter_FASTA(fastafile, letter_N_max, MAF_min);
+isStreamed = false;
+if Stream && (NoLoad || exist(filename_filter_full, 'file') ~= 2)
+  % filtering, removal of duplicate samples and MI in one pipeline
+  [MSA_f_unique, idx_f, idx_row, list_MI, list_sub, time_MI] = ...
+    filter_FASTA_MI(fastafile, letter_N_max, MAF_min, numWorker, Compress);
+  MSA_f = MSA_f_unique(idx_row,:);
   save(filename_filter_full, 'MSA_f', 'idx_f', '-v7.3');
+  clear MSA_f
+  isStreamed = true;
 else
-  load(filename_filter_full, 'MSA_f', 'idx_f');
+  if NoLoad || exist(filename_filter_full, 'file') ~= 2
+    [MSA_f, idx_f] = filter_FASTA(fastafile, letter_N_max, MAF_min);
+    save(filename_filter_full, 'MSA_f', 'idx_f', '-v7.3');
+  else
+    load(filename_filter_full, 'MSA_f', 'idx_f');
+  end
+
+  % remove duplicate samples
+  [MSA_f_unique,~,idx_row] = unique(MSA_f,'rows');
+  clear MSA_f
 end
 
-% remove duplicate samples
-MSA_f_unique = unique(MSA_f,'rows');
-
 % MSA info
 [B_f,N_f] = size(MSA_f_unique);
 q = double(max(MSA_f_unique(:)));
-weights = ones(B_f,1);  % re-weighting filtered MSA with threshold x = 1
-MSA_id = sprintf('%s-N_%g-B_%g-x_1', dataID,N_f,B_f);
+if Compress
+  % multiplicities as weights, scaled into [0,1] as required by PLM (the
+  % normalization by B_eff makes the result independent of the scale)
+  mult = accumarray(idx_row(:), 1);
+  weights = mult/max(mult);
+  MSA_id = sprintf('%s-N_%g-B_%g-mult', dataID,N_f,B_f);
+else
+  weights = ones(B_f,1);  % re-weighting filtered MSA with threshold x = 1
+  MSA_id = sprintf('%s-N_%g-B_%g-x_1', dataID,N_f,B_f);
+end
+
+
+%% Memory plan
+% variants of MI and PLM fitting in `memBudget`, logged before heavy work
+plan = plan_CC_PLM(N_f, B_f, q, num_MI, numWorker, memBudget, numel(lambda));
+Sampled = plan.MI.Sampled;
+if isStreamed
+  % N and B are known only after the pipeline, which has computed all pairs
+  fprintf('\tMI    not planned: all pairs were computed by `Stream`\n');
+  if strcmp(plan.MI.variant, 'top')
+    warning('paper_CC_PLM_DCA:Stream', ...
+      ['The MI table of all pairs (`Stream`) exceeds the budget, where the ' ...
+      'plan selects the top pairs in blocks. Rerun without `Stream`.'])
+  end
+end
 
 
 %% Correlation Compression
+NoLoad_CC = NoLoad;
+if isStreamed
+  % MI table in the format of `CC_MSA`, which then only selects loci
+  fprintf('Rearranging MI table in descending order ...\n')
+  tic
+  [list_MI_sort, sidx_MI] = sort(list_MI, 'descend');
+  list_sub_sort = list_sub(:,sidx_MI);
+  time_sort = toc;
+  fprintf('\tFinished in %.2f s\n', time_sort);
+  clear list_MI list_sub sidx_MI
+
+  filename_MI_full = fullfile(outputPath, sprintf('%s--MI.mat', MSA_id));
+  save(filename_MI_full, 'list_MI_sort', 'list_sub_sort', ...
+    'time_MI', 'time_sort', '-v7.3')
+  clear list_MI_sort list_sub_sort
+  NoLoad_CC = false;
+  Sampled = [];   % all pairs are already there
+end
 [MSA_cc, idx_cc] = CC_MSA(MSA_f_unique, MSA_id, N_f, B_f, q, weights, num_MI, ...
-  numWorker, outputPath, NoLoad);
+  numWorker, outputPath, NoLoad_CC, Compress, Sampled);
 N_cc = numel(idx_cc);
 B_cc = B_f;
 CC_id = sprintf('CC-MI_%g-N_%g',num_MI,N_cc);
@@ -92,11 +189,42 @@ save(filename_CC_full, 'MSA_cc', 'idx_cc')
 
 
 %% PLM
-DCA_id = sprintf('%s--PLM-l_%g',CC_id,lambda);
-
 S = uint8(MSA_cc.'-1);
 
-table_i_j_score = PLM_DCA(S,N_cc,B_cc,q,weights,lambda,numWorker);
+if isscalar(lambda)
+  DCA_id = sprintf('%s--PLM-l_%g',CC_id,lambda);
+  switch plan.PLM.variant
+    case 'lbfgs'
+      table_i_j_score = PLM_DCA(S,N_cc,B_cc,q,weights,lambda,numWorker);
+    case 'active'
+      % couplings of the top `num_MI` pairs of the MI table of CC
+      if isempty(Sampled)
+        filename_MI = sprintf('%s--MI.mat', MSA_id);
+      else
+        filename_MI = sprintf('%s--MI-top.mat', MSA_id);
+      end
+      MatFileObj = matfile(fullfile(outputPath, filename_MI));
+      n = min(num_MI, size(MatFileObj, 'list_sub_sort', 2));
+      extra.active = active_set_MI(MatFileObj.list_MI_sort(1,1:n), ...
+        MatFileObj.list_sub_sort(:,1:n), idx_cc, n);
+      table_i_j_score = PLM_DCA(S,N_cc,B_cc,q,weights,lambda,numWorker, ...
+        false,extra);
+    case 'newton0'
+      extra.Method = 'newton0';
+      table_i_j_score = PLM_DCA(S,N_cc,B_cc,q,weights,lambda,numWorker, ...
+        false,extra);
+    case 'dist'
+      % worker processes of `PLM_DCA_dist` take the place of the pool
+      delete(gcp('nocreate'));
+      filePrefix = fullfile(outputPath, sprintf('%s--%s', MSA_id, DCA_id));
+      table_i_j_score = PLM_DCA_dist(S,N_cc,B_cc,q,weights,lambda, ...
+        numWorker,filePrefix,plan.PLM.method);
+  end
+else
+  % rows of scores follow the order of `lambda`
+  DCA_id = sprintf('%s--PLM-l%s',CC_id,sprintf('_%g',lambda));
+  table_i_j_score = PLM_DCA_path(S,N_cc,B_cc,q,weights,lambda,numWorker);
+end
 
 % position in MSA_cc -> pos in MSA_f -> pos in original MSA (1-based)
 table_i_j_score(1:2,:) = idx_f(idx_cc(table_i_j_score(1:2,:)));
@@ -0,0 +1,355 @@
+% Copyright (c) 2017 Chen-Yi Gao
+%
+% LICENSE
+% ===
+% See 'LICENSE.txt' in the outermost folder
+%
+% DESCRIPTION
+% ===
+% Memory plan of CC-PLM (`paper_CC_PLM_DCA`) for a filtered MSA, made before
+% any heavy work. The peak memory and the runtime of every stage are
+% predicted from the sizes alone, and the first variant of every stage which
+% fits in `memBudget` is selected:
+%
+% | stage | variants, in order of preference                             |
+% | ----- | ------------------------------------------------------------ |
+% | MI    | `all`:     table of all N(N-1)/2 pairs (`CC_MSA`)            |
+% |       | `top`:     exact top `num_MI` pairs in blocks (`Sampled`)    |
+% | PLM   | `lbfgs`:   `PLM_DCA`                                         |
+% |       | `active`:  L-BFGS on the couplings of the top `num_MI` pairs |
+% |       |            (`options.active`, `active_set_MI`)               |
+% |       | `newton0`: truncated Newton, no L-BFGS history               |
+% |       | `dist`:    out of core, `PLM_DCA_dist`: nodes are written to |
+% |       |            a file as they are done and scored from it        |
+% |       |            (POSIX only)                                      |
+%
+% The PLM stage includes scoring: `dist` scores from the file, the others
+% from `h_and_J` in memory. Loci after CC are unknown before CC; at most
+% min(N, 2*num_MI) are assumed. For a list of lambdas (`numLambda > 1`) only
+% `lbfgs` (`PLM_DCA_path`) is available. When no variant fits, the one with
+% the smallest peak is selected and a warning is issued.
+%
+% Memory counts the large arrays only (MSA, MI table, L-BFGS history,
+% `h_and_J`, scoring table, copies made by `parfor` and `sort`), not MATLAB
+% itself. Runtime is a rough figure from throughputs of one worker, which
+% should be measured by `bench_kernels` (in `benchmark`) on the target host.
+%
+% INPUT
+% ===
+% | name      | note                                                     |
+% | --------- | -------------------------------------------------------- |
+% | N         | number of loci of the filtered MSA                       |
+% | B         | number of (distinct) sequences                           |
+% | q         | number of possible states                                |
+% | num_MI    | as `CC_MSA`                                              |
+% | numWorker | number of workers                                        |
+% | memBudget | (optional) bytes; default [], the available memory of    |
+% |           | the host (`/proc/meminfo` on Linux, `memory` on Windows, |
+% |           | Inf otherwise)                                           |
+% | numLambda | (optional) number of values of lambda, default 1         |
+% | rates     | (optional) struct, throughputs of one worker:            |
+% |           | `f2`: samples*pairs/s of `calc_f2_w_mex_uint8`           |
+% |           | `MI`: pairs/s of `calc_MI`                               |
+% |           | `g_r`: samples*sites/s of `g_r_mex_v2`                   |
+% |           | `score`: pairs/s of `score_coupling_L2_no_gap`           |
+% |           | `numEval`: evaluations of g_r per node                   |
+%
+% OUTPUT
+% ===
+% `plan.MI`, `plan.PLM`: the selected variant of every stage, with fields
+% `variant`, `bytes` (peak), `seconds`, `parts` (large arrays, name and bytes)
+% and `fits`; `plan.MI.Sampled` is the argument `Sampled` of `CC_MSA` ([] for
+% `all`), `plan.PLM.method` is `options.Method` and `plan.PLM.disk` the bytes
+% written by `dist`. `plan.fits` is true if every stage fits.
+%
+% HISTORY
+% ===
+% - 2018-05-10  v1.1
+%   - `dist` only on POSIX systems
+%   - `options.active` is held by the client only
+%
+% - 2018-05-10  v1
+
+function plan = plan_CC_PLM(N, B, q, num_MI, numWorker, memBudget, ...
+  numLambda, rates)
+
+if nargin < 6 || isempty(memBudget)
+  memBudget = available_memory();
+end
+if nargin < 7
+  numLambda = 1;
+end
+if nargin < 8
+  rates = struct();
+end
+
+% rough figures of one core of a Xeon E5 (2017), for q = 3
+defaults = struct('f2', 1e9, 'MI', 2e5, 'g_r', 5e8, 'score', 1e6, ...
+  'numEval', 100);
+names = fieldnames(defaults);
+for k = 1:numel(names)
+  if ~isfield(rates, names{k})
+    rates.(names{k}) = defaults.(names{k});
+  end
+end
+
+d = 8;        % bytes of a double
+Corr = 100;   % L-BFGS corrections, as `PLM_DCA`
+isShared = numWorker > 1 && isunix;   % `shm_msa_mex`
+numPair = N*(N-1)/2;
+base = B*N;   % the filtered MSA, kept by the caller
+
+
+%% MI
+% all pairs: list_MI, list_sub (uint32), then list_MI_sort, sidx_MI and
+% list_sub_sort during the sort
+c = new_variant('all');
+c.parts = {'MSA', base; 'MSA in shared memory', isShared*B*N; ...
+  sprintf('MI table (%.3g pairs)', numPair), 5*d*numPair};
+c.seconds = numPair*(B/rates.f2 + 1/rates.MI)/numWorker;
+c.Sampled = [];
+cand = c;
+
+% top pairs: blocks of 2^22 pairs (subscripts, MI, sd and their merge) and
+% the top num_MI; the exact top needs every pair in the worst case
+K = min(num_MI, numPair);
+numSub = min(B, 1000);
+c = new_variant('top');
+c.parts = {'MSA', base; 'subsample', numSub*N; ...
+  'block of pairs', 2*3*d*2^22; sprintf('top %d pairs', K), 3*2*d*K};
+c.seconds = numPair*B/rates.f2/numWorker;
+c.Sampled = struct('numSub', numSub, 'alpha', 0, 'seed', 1, ...
+  'numThread', numWorker);
+cand(2) = c;
+
+plan.MI = select_variant(cand, memBudget);
+
+
+%% PLM and scoring
+N_cc = min(N, 2*num_MI);
+P = q + q*q*(N_cc-1);
+numPair_cc = N_cc*(N_cc-1)/2;
+S = B*N_cc;
+L = numLambda;
+
+% h_and_J is also assembled by `parfor`; the table gains a copy of the
+% endpoints when they are mapped back to loci of the FASTA file
+H = d*P*N_cc*L;
+part_H = {'parameter matrix h_and_J (and parfor copy)', 2*H};
+part_table = {'scoring table', d*(2+L+2)*numPair_cc + (L > 1)*3*d*numPair_cc};
+part_base = {'MSA', base};
+prob = d*q*B;   % conditional probabilities of g_r, per worker
+t_node = rates.numEval*B*N_cc/rates.g_r;
+
+% L-BFGS, workers read S from shared memory
+c = new_variant('lbfgs');
+numCopy = isShared + (numWorker > 1 && ~isShared)*numWorker;
+c.parts = [part_base; {'S (and its copies)', S*(1 + numCopy)}; part_H; ...
+  {sprintf('L-BFGS history (%d workers)', numWorker), ...
+  numWorker*(d*(2*Corr+10)*P + prob)}];
+c.score = [part_base; {'parameter matrix h_and_J', H}; part_table];
+c.seconds = L*N_cc*t_node/numWorker + L*numPair_cc/rates.score;
+c.method = 'lbfgs';
+c.isPossible = Corr*P < 2^31;
+cand = c;
+
+if L == 1
+  % L-BFGS on active couplings, the full gradient checked once; every worker
+  % gets S, and every node its own column of `options.active`
+  k = min(N_cc-1, ceil(2*num_MI/N_cc));
+  P_act = q + q*q*k;
+  c = new_variant('active');
+  c.parts = [part_base; {'S (one per worker)', S*(1 + numWorker); ...
+    'options.active', N_cc*N_cc}; part_H; ...
+    {sprintf('L-BFGS history (%d workers)', numWorker), ...
+    numWorker*(d*(2*Corr+10)*P_act + 3*d*P + prob)}];
+  c.score = cand(1).score;
+  c.seconds = N_cc*(rates.numEval*B*(k+1) + B*N_cc)/rates.g_r/numWorker ...
+    + numPair_cc/rates.score;
+  c.method = 'lbfgs';
+  c.isPossible = Corr*P_act < 2^31;
+  cand(end+1) = c;
+
+  % truncated Newton: a few vectors of P per worker
+  c = new_variant('newton0');
+  c.parts = [part_base; {'S (one per worker)', S*(1 + numWorker)}; part_H; ...
+    {sprintf('Newton vectors (%d workers)', numWorker), ...
+    numWorker*(10*d*P + prob)}];
+  c.score = cand(1).score;
+  c.seconds = N_cc*t_node/numWorker + numPair_cc/rates.score;
+  c.method = 'newton0';
+  cand(end+1) = c;
+
+  % out of core: worker processes map S from a file and nothing holds
+  % h_and_J; L-BFGS if its history fits, truncated Newton otherwise
+  for method = {'lbfgs', 'newton0'}
+    c = new_variant('dist');
+    c.method = method{1};
+    if strcmp(c.method, 'lbfgs')
+      worker = d*(2*Corr+10)*P + prob;
+      c.isPossible = isunix && Corr*P < 2^31;
+    else
+      worker = 10*d*P + prob;
+      c.isPossible = isunix;  % `dist_coord_mex` and `dist_worker_mex`
+    end
+    c.parts = [part_base; {'S (mapped file)', S; ...
+      sprintf('%s (%d processes)', c.method, numWorker), numWorker*worker; ...
+      'node buffer of the coordinator', 2*d*P}];
+    c.score = [part_base; part_table; {'two nodes of h_and_J', 2*d*P}];
+    c.seconds = N_cc*t_node/numWorker + numPair_cc/rates.score;
+    c.disk = S + d*P*N_cc;
+    cand(end+1) = c; %#ok<AGROW>
+  end
+end
+
+plan.PLM = select_variant(cand, memBudget);
+
+plan.budget = memBudget;
+plan.N_cc = N_cc;
+plan.fits = plan.MI.fits && plan.PLM.fits;
+
+
+%% log
+fprintf('Memory plan (budget %s) ...\n', format_bytes(memBudget));
+fprintf(['\tN = %d, B = %d, q = %d, num_MI = %d: at most %d loci after ' ...
+  'CC; %d workers\n'], N, B, q, num_MI, N_cc, numWorker);
+print_stage('MI', plan.MI);
+print_stage('PLM', plan.PLM);
+if plan.PLM.disk > 0
+  fprintf('\t    disk: %s\n', format_bytes(plan.PLM.disk));
+end
+if ~plan.fits
+  warning('plan_CC_PLM:budget', ...
+    'No variant of some stage fits in %s; the smallest one is used.', ...
+    format_bytes(memBudget));
+end
+
+end
+
+
+
+
+
+
+
+
+
+
+% a candidate of a stage, `parts` and `score` as {name, bytes} rows
+function c = new_variant(variant)
+
+c.variant = variant;
+c.parts = cell(0, 2);
+c.score = cell(0, 2);
+c.seconds = 0;
+c.Sampled = [];
+c.method = '';
+c.disk = 0;
+c.isPossible = true;
+c.bytes = 0;
+c.fits = false;
+
+end
+
+
+
+% the first possible candidate fitting in the budget, otherwise the smallest
+function s = select_variant(cand, memBudget)
+
+peak = inf(1, numel(cand));
+for k = 1:numel(cand)
+  if cand(k).isPossible
+    peak(k) = max(sum([cand(k).parts{:,2}]), sum([cand(k).score{:,2}]));
+  end
+end
+
+k = find(peak <= memBudget, 1);
+if isempty(k)
+  [~, k] = min(peak);
+end
+s = cand(k);
+s.bytes = peak(k);
+s.fits = peak(k) <= memBudget;
+if ~isempty(s.score)
+  % the larger part is reported
+  if sum([s.score{:,2}]) > sum([s.parts{:,2}])
+    s.parts = s.score;
+  end
+end
+s = rmfield(s, {'score', 'isPossible'});
+
+end
+
+
+
+function print_stage(name, s)
+
+note = '';
+if ~s.fits
+  note = '  (exceeds the budget)';
+end
+if ~isempty(s.method) && ~strcmp(s.method, s.variant)
+  name = sprintf('%s (%s)', name, s.method);
+end
+fprintf('\t%-5s %-16s peak %10s, ~%s%s\n', name, s.variant, ...
+  format_bytes(s.bytes), format_seconds(s.seconds), note);
+for k = 1:size(s.parts, 1)
+  if s.parts{k,2} > 0
+    fprintf('\t      %-44s %10s\n', s.parts{k,1}, format_bytes(s.parts{k,2}));
+  end
+end
+
+end
+
+
+
+% bytes of memory available to this process
+function bytes = available_memory()
+
+bytes = Inf;
+if ispc
+  [~, sys] = memory;
+  bytes = sys.PhysicalMemory.Available;
+elseif exist('/proc/meminfo', 'file') == 2
+  text = fileread('/proc/meminfo');
+  tok = regexp(text, 'MemAvailable:\s*(\d+) kB', 'tokens', 'once');
+  if ~isempty(tok)
+    bytes = str2double(tok{1})*1024;
+  end
+end
+
+end
+
+
+
+function str = format_bytes(bytes)
+
+if isinf(bytes)
+  str = 'unlimited';
+  return
+end
+units = {'B', 'KB', 'MB', 'GB', 'TB', 'PB'};
+k = 1;
+while bytes >= 1024 && k < numel(units)
+  bytes = bytes/1024;
+  k = k+1;
+end
+str = sprintf('%.1f %s', bytes, units{k});
+
+end
+
+
+
+function str = format_seconds(t)
+
+if t < 120
+  str = sprintf('%.0f s', t);
+elseif t < 7200
+  str = sprintf('%.0f min', t/60);
+elseif t < 172800
+  str = sprintf('%.1f h', t/3600);
+else
+  str = sprintf('%.1f days', t/86400);
+end
+
+end